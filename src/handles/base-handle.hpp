@@ -23,6 +23,7 @@
 #include "common.hpp"
 
 #include "storage/repo-storage.hpp"
+#include "response-signer.hpp"
 #include "repo-command-response.hpp"
 #include "repo-command-parameter.hpp"
 
@@ -55,7 +56,7 @@ public:
     : m_generator(generator)
     , m_face(face)
     , m_storageHandle(storageHandle)
-    , m_keyChain(keyChain)
+    , m_signer(keyChain)
     , m_scheduler(scheduler)
   {
   }
@@ -63,6 +64,15 @@ public:
   virtual void
   listen(const Name& prefix) = 0;
 
+  /**
+   * @brief set how command responses of this handle are signed
+   */
+  void
+  setSigningPolicy(const SigningPolicy& policy)
+  {
+    m_signer.setPolicy(policy);
+  }
+
 protected:
 
   inline Face&
@@ -113,7 +123,7 @@ private:
 
   Face& m_face;
   RepoStorage& m_storageHandle;
-  KeyChain& m_keyChain;
+  ResponseSigner m_signer;
   Scheduler& m_scheduler;
 };
 
@@ -122,7 +132,7 @@ BaseHandle::reply(const Interest& commandInterest, const RepoCommandResponse& re
 {
   shared_ptr<Data> rdata = make_shared<Data>(commandInterest.getName());
   rdata->setContent(response.wireEncode());
-  m_keyChain.sign(*rdata);
+  m_signer.sign(*rdata);
   m_face.put(*rdata);
 }
 
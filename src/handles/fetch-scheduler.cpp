@@ -0,0 +1,188 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fetch-scheduler.hpp"
+
+namespace repo {
+
+FetchScheduler::FetchScheduler(size_t maxInFlight, size_t quantum,
+                               uint64_t smallInsertSegments)
+  : m_maxInFlight(maxInFlight)
+  , m_quantum(quantum)
+  , m_smallInsertSegments(smallInsertSegments)
+  , m_nInFlight(0)
+{
+  BOOST_ASSERT(maxInFlight > 0 && quantum > 0);
+}
+
+void
+FetchScheduler::setLimits(size_t maxInFlight, size_t quantum, uint64_t smallInsertSegments)
+{
+  BOOST_ASSERT(maxInFlight > 0 && quantum > 0);
+  m_maxInFlight = maxInFlight;
+  m_quantum = quantum;
+  m_smallInsertSegments = smallInsertSegments;
+
+  for (FlowMap::iterator it = m_flows.begin(); it != m_flows.end(); ++it)
+    requeue(it->first, it->second);
+}
+
+void
+FetchScheduler::addProcess(ProcessId processId)
+{
+  m_flows[processId] = Flow();
+}
+
+void
+FetchScheduler::removeProcess(ProcessId processId)
+{
+  FlowMap::iterator it = m_flows.find(processId);
+  if (it == m_flows.end())
+    return;
+  dequeue(processId, it->second);
+  m_nInFlight -= it->second.nInFlight;
+  m_flows.erase(it);
+}
+
+void
+FetchScheduler::setRemaining(ProcessId processId, uint64_t nRemaining)
+{
+  FlowMap::iterator it = m_flows.find(processId);
+  if (it == m_flows.end())
+    return;
+  it->second.hasRemaining = true;
+  it->second.nRemaining = nRemaining;
+  requeue(processId, it->second);
+}
+
+void
+FetchScheduler::activate(ProcessId processId)
+{
+  FlowMap::iterator it = m_flows.find(processId);
+  if (it == m_flows.end() || it->second.isActive)
+    return;
+  enqueue(processId, it->second);
+}
+
+void
+FetchScheduler::deactivate(ProcessId processId)
+{
+  FlowMap::iterator it = m_flows.find(processId);
+  if (it == m_flows.end() || !it->second.isActive)
+    return;
+  dequeue(processId, it->second);
+}
+
+bool
+FetchScheduler::next(ProcessId& processId)
+{
+  if (!canSend())
+    return false;
+
+  if (!m_smallList.empty())
+    processId = m_smallList.front();
+  else if (!m_activeList.empty())
+    processId = m_activeList.front();
+  else
+    return false;
+  BOOST_ASSERT(m_flows.find(processId) != m_flows.end());
+  return true;
+}
+
+void
+FetchScheduler::onInterestSent(ProcessId processId)
+{
+  FlowMap::iterator it = m_flows.find(processId);
+  if (it == m_flows.end())
+    return;
+  Flow& flow = it->second;
+  ++flow.nInFlight;
+  ++m_nInFlight;
+
+  // small inserts are served ahead of the round and do not spend deficit
+  if (!flow.isActive || flow.isInSmallList)
+    return;
+
+  if (flow.deficit > 0)
+    --flow.deficit;
+  if (flow.deficit == 0 && m_activeList.front() == processId) {
+    m_activeList.pop_front();
+    m_activeList.push_back(processId);
+    flow.deficit = m_quantum;
+  }
+}
+
+void
+FetchScheduler::onInterestFinished(ProcessId processId)
+{
+  FlowMap::iterator it = m_flows.find(processId);
+  if (it == m_flows.end() || it->second.nInFlight == 0)
+    return;
+  --it->second.nInFlight;
+  --m_nInFlight;
+}
+
+void
+FetchScheduler::enqueue(ProcessId processId, Flow& flow)
+{
+  flow.isActive = true;
+  flow.isInSmallList = isSmall(flow);
+  if (flow.isInSmallList) {
+    m_smallList.push_back(processId);
+  }
+  else {
+    flow.deficit = m_quantum;
+    m_activeList.push_back(processId);
+  }
+}
+
+void
+FetchScheduler::dequeue(ProcessId processId, Flow& flow)
+{
+  if (!flow.isActive)
+    return;
+  // as in deficit round robin, an idle flow does not keep its unused deficit
+  if (flow.isInSmallList)
+    m_smallList.remove(processId);
+  else
+    m_activeList.remove(processId);
+  flow.isActive = false;
+  flow.isInSmallList = false;
+  flow.deficit = 0;
+}
+
+void
+FetchScheduler::requeue(ProcessId processId, Flow& flow)
+{
+  if (!flow.isActive || flow.isInSmallList == isSmall(flow))
+    return;
+  dequeue(processId, flow);
+  enqueue(processId, flow);
+}
+
+size_t
+FetchScheduler::getInFlight(ProcessId processId) const
+{
+  FlowMap::const_iterator it = m_flows.find(processId);
+  if (it == m_flows.end())
+    return 0;
+  return it->second.nInFlight;
+}
+
+} // namespace repo
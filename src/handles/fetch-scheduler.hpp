@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPO_HANDLES_FETCH_SCHEDULER_HPP
+#define REPO_HANDLES_FETCH_SCHEDULER_HPP
+
+#include "common.hpp"
+
+#include <list>
+#include <map>
+
+namespace repo {
+
+/**
+ * @brief FetchScheduler shares a repo-wide limit of outstanding Interests among
+ *        segmented insert processes.
+ *
+ * Processes that have Interests ready to send are activated and served by deficit
+ * round robin: the process at the head of the active list may send up to quantum
+ * Interests, then it moves to the tail. A process whose number of remaining segments
+ * is known and does not exceed the small insert threshold is kept in a list of its own
+ * instead, served before the round robin, so that small inserts are not delayed behind
+ * large ones.
+ *
+ * Each process still has its own congestion window; the scheduler only decides which
+ * process may use the next free slot.
+ */
+class FetchScheduler : noncopyable
+{
+public:
+  /**
+   * @param maxInFlight         repo-wide limit of outstanding Interests
+   * @param quantum             Interests a process may send in one round
+   * @param smallInsertSegments remaining segments under which a process is served first
+   */
+  explicit
+  FetchScheduler(size_t maxInFlight = 512, size_t quantum = 8,
+                 uint64_t smallInsertSegments = 64);
+
+  void
+  setLimits(size_t maxInFlight, size_t quantum, uint64_t smallInsertSegments);
+
+  void
+  addProcess(ProcessId processId);
+
+  /**
+   * @brief forget process and release its outstanding Interests
+   */
+  void
+  removeProcess(ProcessId processId);
+
+  /**
+   * @brief update number of segments process still has to request
+   */
+  void
+  setRemaining(ProcessId processId, uint64_t nRemaining);
+
+  /**
+   * @brief mark that process has Interests ready to send
+   */
+  void
+  activate(ProcessId processId);
+
+  /**
+   * @brief mark that process cannot send until its next Data or timeout
+   */
+  void
+  deactivate(ProcessId processId);
+
+  /**
+   * @brief pick the process that may send the next Interest
+   * @return false if repo-wide limit is reached or no process is active
+   */
+  bool
+  next(ProcessId& processId);
+
+  /**
+   * @brief called when an Interest of process is expressed
+   */
+  void
+  onInterestSent(ProcessId processId);
+
+  /**
+   * @brief called when an Interest of process is satisfied or times out
+   */
+  void
+  onInterestFinished(ProcessId processId);
+
+  bool
+  canSend() const
+  {
+    return m_nInFlight < m_maxInFlight;
+  }
+
+  size_t
+  getInFlight() const
+  {
+    return m_nInFlight;
+  }
+
+  size_t
+  getInFlight(ProcessId processId) const;
+
+private:
+  struct Flow
+  {
+    Flow()
+      : nInFlight(0)
+      , deficit(0)
+      , hasRemaining(false)
+      , nRemaining(0)
+      , isActive(false)
+      , isInSmallList(false)
+    {
+    }
+
+    size_t nInFlight;
+    size_t deficit;
+    bool hasRemaining;
+    uint64_t nRemaining;
+    bool isActive;
+    /// the flow is active and queued in m_smallList rather than m_activeList
+    bool isInSmallList;
+  };
+
+  bool
+  isSmall(const Flow& flow) const
+  {
+    return flow.hasRemaining && flow.nRemaining <= m_smallInsertSegments;
+  }
+
+  /**
+   * @brief queue an active flow at the tail of the list for its size
+   */
+  void
+  enqueue(ProcessId processId, Flow& flow);
+
+  /**
+   * @brief remove an active flow from the list it is queued in
+   */
+  void
+  dequeue(ProcessId processId, Flow& flow);
+
+  /**
+   * @brief move an active flow to the other list if its size class has changed
+   */
+  void
+  requeue(ProcessId processId, Flow& flow);
+
+private:
+  typedef std::map<ProcessId, Flow> FlowMap;
+
+  FlowMap m_flows;
+  /// active flows served by deficit round robin
+  std::list<ProcessId> m_activeList;
+  /// active flows of small inserts, served first
+  std::list<ProcessId> m_smallList;
+  size_t m_maxInFlight;
+  size_t m_quantum;
+  uint64_t m_smallInsertSegments;
+  size_t m_nInFlight;
+};
+
+} // namespace repo
+
+#endif // REPO_HANDLES_FETCH_SCHEDULER_HPP
@@ -0,0 +1,116 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fetch-window.hpp"
+
+#include <cmath>
+
+namespace repo {
+
+using namespace ndn::time;
+
+static const double MIN_WINDOW = 1.0;
+static const double MIN_RTO = 200.0;     // milliseconds
+static const double INITIAL_RTO = 1000.0; // milliseconds
+static const int MAX_BACKOFF = 6;
+
+FetchWindow::FetchWindow(double initialWindow, double maxWindow, const milliseconds& maxRto)
+  : m_window(std::max(initialWindow, MIN_WINDOW))
+  , m_maxWindow(std::max(maxWindow, MIN_WINDOW))
+  , m_ssthresh(std::max(maxWindow, MIN_WINDOW))
+  , m_nInFlight(0)
+  , m_hasRttSample(false)
+  , m_srtt(0)
+  , m_rttVar(0)
+  , m_nBackoff(0)
+  , m_maxRto(maxRto)
+  , m_lastDecrease(steady_clock::TimePoint())
+{
+  m_window = std::min(m_window, m_maxWindow);
+}
+
+void
+FetchWindow::onData(const milliseconds& rtt, bool isRttSample)
+{
+  if (m_nInFlight > 0)
+    --m_nInFlight;
+
+  if (isRttSample)
+    addRttSample(rtt);
+
+  if (m_window < m_ssthresh)
+    m_window += 1.0;           // slow start
+  else
+    m_window += 1.0 / m_window; // congestion avoidance
+
+  m_window = std::min(m_window, m_maxWindow);
+}
+
+void
+FetchWindow::onTimeout()
+{
+  if (m_nInFlight > 0)
+    --m_nInFlight;
+
+  m_nBackoff = std::min(m_nBackoff + 1, MAX_BACKOFF);
+
+  // timeouts of Interests from the same window are one congestion event
+  steady_clock::TimePoint now = steady_clock::now();
+  if (now - m_lastDecrease < getRto())
+    return;
+
+  m_ssthresh = std::max(m_window / 2, MIN_WINDOW);
+  m_window = m_ssthresh;
+  m_lastDecrease = now;
+}
+
+void
+FetchWindow::onDiscard()
+{
+  if (m_nInFlight > 0)
+    --m_nInFlight;
+}
+
+milliseconds
+FetchWindow::getRto() const
+{
+  double rto = INITIAL_RTO;
+  if (m_hasRttSample)
+    rto = std::max(m_srtt + 4 * m_rttVar, MIN_RTO);
+  rto *= (1 << m_nBackoff);
+  return std::min(milliseconds(static_cast<int64_t>(rto)), m_maxRto);
+}
+
+void
+FetchWindow::addRttSample(const milliseconds& rtt)
+{
+  double sample = static_cast<double>(rtt.count());
+  if (!m_hasRttSample) {
+    m_srtt = sample;
+    m_rttVar = sample / 2;
+    m_hasRttSample = true;
+  }
+  else {
+    m_rttVar = 0.75 * m_rttVar + 0.25 * std::abs(m_srtt - sample);
+    m_srtt = 0.875 * m_srtt + 0.125 * sample;
+  }
+  m_nBackoff = 0;
+}
+
+} // namespace repo
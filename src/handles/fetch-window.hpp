@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPO_HANDLES_FETCH_WINDOW_HPP
+#define REPO_HANDLES_FETCH_WINDOW_HPP
+
+#include "common.hpp"
+
+namespace repo {
+
+/**
+ * @brief FetchWindow provides AIMD congestion control for fetching segmented data.
+ *
+ * The window starts in slow start and grows by one Interest per Data until it reaches
+ * the slow start threshold, then grows by one Interest per window (congestion avoidance).
+ * A timeout halves the window, at most once per round trip.
+ *
+ * RTT is estimated as in RFC 6298 from Data that were not retransmitted (Karn's algorithm),
+ * and the retransmission timeout is used as lifetime of expressed Interests.
+ */
+class FetchWindow
+{
+public:
+  explicit
+  FetchWindow(double initialWindow = 1.0, double maxWindow = 1.0,
+              const ndn::time::milliseconds& maxRto = ndn::time::milliseconds(4000));
+
+  /**
+   * @brief whether one more Interest can be expressed
+   */
+  bool
+  canSend() const
+  {
+    return m_nInFlight < static_cast<int>(m_window);
+  }
+
+  /**
+   * @brief called when an Interest is expressed
+   */
+  void
+  onInterestSent()
+  {
+    ++m_nInFlight;
+  }
+
+  /**
+   * @brief called when Data arrives
+   * @param rtt         time elapsed since the Interest was expressed
+   * @param isRttSample false if the Interest was retransmitted, thus rtt is ambiguous
+   */
+  void
+  onData(const ndn::time::milliseconds& rtt, bool isRttSample);
+
+  /**
+   * @brief called when an Interest times out
+   */
+  void
+  onTimeout();
+
+  /**
+   * @brief called when an outstanding Interest is no longer needed
+   */
+  void
+  onDiscard();
+
+  /**
+   * @brief retransmission timeout, bounded by maxRto
+   */
+  ndn::time::milliseconds
+  getRto() const;
+
+  double
+  getWindow() const
+  {
+    return m_window;
+  }
+
+  int
+  getInFlight() const
+  {
+    return m_nInFlight;
+  }
+
+private:
+  void
+  addRttSample(const ndn::time::milliseconds& rtt);
+
+private:
+  double m_window;
+  double m_maxWindow;
+  double m_ssthresh;
+  int m_nInFlight;
+
+  bool m_hasRttSample;
+  double m_srtt;    ///< smoothed RTT in milliseconds
+  double m_rttVar;  ///< RTT variation in milliseconds
+  int m_nBackoff;   ///< number of RTO doublings since last RTT sample
+  ndn::time::milliseconds m_maxRto;
+  ndn::time::steady_clock::TimePoint m_lastDecrease;
+};
+
+} // namespace repo
+
+#endif // REPO_HANDLES_FETCH_WINDOW_HPP
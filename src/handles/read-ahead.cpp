@@ -0,0 +1,258 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "read-ahead.hpp"
+
+#include <algorithm>
+
+namespace repo {
+
+using ndn::time::steady_clock;
+
+static const size_t INITIAL_DEPTH = 4;
+static const size_t MAX_STREAMS = 1024;
+
+/// Data read ahead and not requested within this time are dropped
+static const ndn::time::milliseconds CACHE_LIFETIME(4000);
+
+/**
+ * @brief whether an Interest is answered by its name alone
+ *
+ * MustBeFresh is allowed, as the index does not match freshness.
+ */
+static bool
+isNameOnly(const Interest& interest)
+{
+  return interest.getMinSuffixComponents() < 0 &&
+         interest.getMaxSuffixComponents() < 0 &&
+         interest.getPublisherPublicKeyLocator().empty() &&
+         interest.getExclude().empty() &&
+         interest.getChildSelector() <= 0;
+}
+
+ReadAhead::ReadAhead(size_t maxDepth, size_t maxCachedPackets)
+  : m_maxDepth(maxDepth)
+  , m_maxCachedPackets(maxCachedPackets)
+{
+}
+
+void
+ReadAhead::setLimits(size_t maxDepth, size_t maxCachedPackets)
+{
+  m_maxDepth = maxDepth;
+  m_maxCachedPackets = maxCachedPackets;
+  if (!isEnabled()) {
+    m_streams.clear();
+    m_cache.clear();
+    m_cacheOrder.clear();
+  }
+  evictData();
+}
+
+bool
+ReadAhead::parseSegment(const Name& name, Name& object, uint64_t& segment)
+{
+  if (name.empty())
+    return false;
+  try {
+    segment = name.get(-1).toSegment();
+  }
+  catch (ndn::Tlv::Error&) {
+    return false;
+  }
+  object = name.getPrefix(-1);
+  return true;
+}
+
+shared_ptr<const Data>
+ReadAhead::find(const Interest& interest)
+{
+  Name fullName;
+  return find(interest, fullName);
+}
+
+shared_ptr<const Data>
+ReadAhead::find(const Interest& interest, Name& fullName)
+{
+  if (!isEnabled() || !isNameOnly(interest))
+    return shared_ptr<const Data>();
+
+  evictData();
+  std::map<Name, CachedData>::const_iterator it = m_cache.find(interest.getName());
+  if (it == m_cache.end())
+    return shared_ptr<const Data>();
+  fullName = it->second.fullName;
+  return it->second.data;
+}
+
+void
+ReadAhead::erase(const Name& fullName)
+{
+  if (fullName.empty())
+    return;
+  std::map<Name, CachedData>::iterator it = m_cache.find(fullName.getPrefix(-1));
+  // the name stays in m_cacheOrder until it is evicted
+  if (it != m_cache.end() && it->second.fullName == fullName)
+    m_cache.erase(it);
+}
+
+bool
+ReadAhead::onInterest(const Interest& interest, bool isCacheHit, Name& object)
+{
+  uint64_t segment = 0;
+  if (!isEnabled() || !isNameOnly(interest) ||
+      !parseSegment(interest.getName(), object, segment))
+    return false;
+
+  std::map<Name, Stream>::iterator it = m_streams.find(object);
+  if (it == m_streams.end()) {
+    if (m_streams.size() >= MAX_STREAMS)
+      evictStream();
+    Stream& stream = m_streams[object];
+    stream.highest = segment;
+    stream.frontier = segment + 1;
+    stream.start = segment + 1;
+    stream.lastRequest = steady_clock::now();
+    return false;
+  }
+
+  Stream& stream = it->second;
+  stream.lastRequest = steady_clock::now();
+  if (segment <= stream.highest) {
+    // a retransmission, or another consumer behind this one
+    return false;
+  }
+
+  if (segment != stream.highest + 1 && segment >= stream.frontier) {
+    // a jump past the read-ahead, start over
+    stream = Stream();
+    stream.highest = segment;
+    stream.frontier = segment + 1;
+    stream.start = segment + 1;
+    stream.lastRequest = steady_clock::now();
+    return false;
+  }
+
+  stream.highest = segment;
+  if (stream.depth == 0) {
+    stream.depth = std::min(INITIAL_DEPTH, m_maxDepth);
+    stream.frontier = segment + 1;
+    stream.start = segment + 1;
+  }
+  else if (segment >= stream.frontier) {
+    // the consumer has more Interests outstanding than were read ahead
+    stream.depth = std::min(stream.depth * 2, m_maxDepth);
+    stream.frontier = segment + 1;
+    stream.isEnded = false;
+  }
+  else if (!isCacheHit && segment >= stream.start) {
+    // read ahead, but dropped from the cache before the consumer came for it
+    stream.depth = std::max(stream.depth / 2, static_cast<size_t>(1));
+  }
+
+  if (stream.isReading || stream.isEnded ||
+      stream.frontier > stream.highest + stream.depth)
+    return false;
+  stream.isReading = true;
+  return true;
+}
+
+bool
+ReadAhead::getNextSegment(const Name& object, Name& name)
+{
+  std::map<Name, Stream>::iterator it = m_streams.find(object);
+  if (it == m_streams.end())
+    return false;
+
+  Stream& stream = it->second;
+  if (!isEnabled() || stream.isEnded || stream.frontier > stream.highest + stream.depth) {
+    stream.isReading = false;
+    return false;
+  }
+  name = Name(object).appendSegment(stream.frontier);
+  ++stream.frontier;
+  return true;
+}
+
+void
+ReadAhead::onSegmentRead(const Name& name, shared_ptr<const Data> data)
+{
+  if (!isEnabled())
+    return;
+
+  CachedData& cached = m_cache[name];
+  cached.data = data;
+  cached.fullName = data->getFullName();
+  cached.added = steady_clock::now();
+  m_cacheOrder.push_back(std::make_pair(cached.added, name));
+  evictData();
+}
+
+void
+ReadAhead::onSegmentMissing(const Name& name)
+{
+  Name object;
+  uint64_t segment = 0;
+  if (!parseSegment(name, object, segment))
+    return;
+
+  std::map<Name, Stream>::iterator it = m_streams.find(object);
+  if (it == m_streams.end())
+    return;
+  it->second.isEnded = true;
+  it->second.isReading = false;
+  it->second.frontier = std::min(it->second.frontier, segment);
+}
+
+size_t
+ReadAhead::getDepth(const Name& object) const
+{
+  std::map<Name, Stream>::const_iterator it = m_streams.find(object);
+  if (it == m_streams.end())
+    return 0;
+  return it->second.depth;
+}
+
+void
+ReadAhead::evictData()
+{
+  steady_clock::TimePoint expired = steady_clock::now() - CACHE_LIFETIME;
+  while (!m_cacheOrder.empty() &&
+         (m_cache.size() > m_maxCachedPackets || m_cacheOrder.front().first < expired)) {
+    std::map<Name, CachedData>::iterator it = m_cache.find(m_cacheOrder.front().second);
+    // skip names added again since, or erased
+    if (it != m_cache.end() && it->second.added == m_cacheOrder.front().first)
+      m_cache.erase(it);
+    m_cacheOrder.pop_front();
+  }
+}
+
+void
+ReadAhead::evictStream()
+{
+  std::map<Name, Stream>::iterator oldest = m_streams.begin();
+  for (std::map<Name, Stream>::iterator it = m_streams.begin(); it != m_streams.end(); ++it) {
+    if (it->second.lastRequest < oldest->second.lastRequest)
+      oldest = it;
+  }
+  if (oldest != m_streams.end())
+    m_streams.erase(oldest);
+}
+
+} // namespace repo
@@ -0,0 +1,181 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPO_HANDLES_READ_AHEAD_HPP
+#define REPO_HANDLES_READ_AHEAD_HPP
+
+#include "common.hpp"
+
+#include <map>
+#include <deque>
+
+namespace repo {
+
+/**
+ * @brief ReadAhead detects consumers reading the segments of an object in order, and keeps
+ *        the next segments read ahead of them in a cache of hot Data.
+ *
+ * Each object being read in segment order has a stream, whose read-ahead frontier is kept
+ * up to depth segments beyond the highest segment requested. The depth starts small and
+ * adapts to the window of the consumer: it doubles when a request reaches beyond the
+ * frontier, as the consumer has more Interests outstanding than were read ahead, and halves
+ * when a segment read ahead is requested after leaving the cache.
+ *
+ * Only Interests answered by their name alone use the cache, so that a cached segment is the
+ * Data the index would return for them.
+ */
+class ReadAhead : noncopyable
+{
+public:
+  /**
+   * @param maxDepth          most segments read ahead of a stream; 0 disables read-ahead
+   * @param maxCachedPackets  most Data kept in the cache
+   */
+  explicit
+  ReadAhead(size_t maxDepth = 0, size_t maxCachedPackets = 0);
+
+  void
+  setLimits(size_t maxDepth, size_t maxCachedPackets);
+
+  bool
+  isEnabled() const
+  {
+    return m_maxDepth > 0 && m_maxCachedPackets > 0;
+  }
+
+  /**
+   * @brief get cached Data for an Interest
+   * @return null if no Data for the Interest is cached
+   */
+  shared_ptr<const Data>
+  find(const Interest& interest);
+
+  /**
+   * @brief get cached Data for an Interest, and its full name
+   * @param[out] fullName  full name of the Data, if cached
+   * @return null if no Data for the Interest is cached
+   */
+  shared_ptr<const Data>
+  find(const Interest& interest, Name& fullName);
+
+  /**
+   * @brief remove the cached Data with full name fullName, once it is erased from storage
+   */
+  void
+  erase(const Name& fullName);
+
+  /**
+   * @brief record a read, and tell whether segments of its object should be read ahead
+   * @param isCacheHit  whether the Interest was answered from the cache
+   * @param[out] object  name of the object, without the segment number
+   * @return true if the stream of object has fallen short of its depth and has no read-ahead
+   *         in progress; the caller should then read ahead with getNextSegment
+   */
+  bool
+  onInterest(const Interest& interest, bool isCacheHit, Name& object);
+
+  /**
+   * @brief get the next segment to read ahead of a stream, advancing its frontier
+   * @param[out] name  name of the segment
+   * @return false if the stream is at its depth, which ends its read-ahead in progress
+   */
+  bool
+  getNextSegment(const Name& object, Name& name);
+
+  /**
+   * @brief add Data read ahead for the segment named name
+   */
+  void
+  onSegmentRead(const Name& name, shared_ptr<const Data> data);
+
+  /**
+   * @brief record that storage has no Data for the segment named name, the end of its object
+   */
+  void
+  onSegmentMissing(const Name& name);
+
+  size_t
+  getDepth(const Name& object) const;
+
+  size_t
+  getNCachedPackets() const
+  {
+    return m_cache.size();
+  }
+
+private:
+  struct Stream
+  {
+    Stream()
+      : highest(0)
+      , frontier(0)
+      , start(0)
+      , depth(0)
+      , isEnded(false)
+      , isReading(false)
+    {
+    }
+
+    uint64_t highest;   ///< highest segment requested
+    uint64_t frontier;  ///< segments from here on have not been read ahead
+    uint64_t start;     ///< first segment read ahead
+    size_t depth;       ///< 0 until requests are found to be in order
+    bool isEnded;       ///< the object has no segment at frontier
+    bool isReading;     ///< read-ahead is in progress
+    ndn::time::steady_clock::TimePoint lastRequest;
+  };
+
+  struct CachedData
+  {
+    shared_ptr<const Data> data;
+    Name fullName;
+    ndn::time::steady_clock::TimePoint added;
+  };
+
+  /**
+   * @brief split the name of a segment into object name and segment number
+   * @return false if the last component is not a segment number
+   */
+  static bool
+  parseSegment(const Name& name, Name& object, uint64_t& segment);
+
+  /**
+   * @brief remove Data added too long ago, and the oldest Data beyond the cache capacity
+   */
+  void
+  evictData();
+
+  /**
+   * @brief remove the least recently requested stream
+   */
+  void
+  evictStream();
+
+private:
+  size_t m_maxDepth;
+  size_t m_maxCachedPackets;
+  std::map<Name, Stream> m_streams;
+  std::map<Name, CachedData> m_cache;
+  /// names of cached Data in insertion order, with the time they were added
+  std::deque<std::pair<ndn::time::steady_clock::TimePoint, Name> > m_cacheOrder;
+};
+
+} // namespace repo
+
+#endif // REPO_HANDLES_READ_AHEAD_HPP
@@ -21,14 +21,47 @@
 
 namespace repo {
 
+/// segments read ahead in one turn of the scheduler
+static const size_t READ_AHEAD_BATCH = 8;
+
 void
 ReadHandle::onInterest(const Name& prefix, const Interest& interest)
 {
-
-  shared_ptr<ndn::Data> data = getStorageHandle().readData(interest);
+  // Data erased from storage are dropped from the cache as they are erased
+  Name fullName;
+  shared_ptr<const Data> data = m_readAhead.find(interest, fullName);
+  bool isCacheHit = (data != NULL);
+  // a read ahead is recorded for eviction once the Data is requested
+  if (isCacheHit)
+    getStorageHandle().recordRead(fullName);
+  else
+    data = getStorageHandle().readData(interest);
   if (data != NULL) {
       getFace().put(*data);
   }
+
+  Name object;
+  if (m_readAhead.onInterest(interest, isCacheHit, object))
+    getScheduler().scheduleEvent(ndn::time::milliseconds(0),
+                                 bind(&ReadHandle::readAhead, this, object));
+}
+
+void
+ReadHandle::readAhead(const Name& object)
+{
+  Name name;
+  for (size_t i = 0; i < READ_AHEAD_BATCH; ++i) {
+    if (!m_readAhead.getNextSegment(object, name))
+      return;
+    shared_ptr<Data> data = getStorageHandle().readData(Interest(name), true);
+    if (!data) {
+      m_readAhead.onSegmentMissing(name);
+      return;
+    }
+    m_readAhead.onSegmentRead(name, data);
+  }
+  getScheduler().scheduleEvent(ndn::time::milliseconds(0),
+                               bind(&ReadHandle::readAhead, this, object));
 }
 
 void
@@ -21,6 +21,7 @@
 #define REPO_HANDLES_READ_HANDLE_HPP
 
 #include "base-handle.hpp"
+#include "read-ahead.hpp"
 
 
 namespace repo {
@@ -33,11 +34,23 @@ public:
              Scheduler& scheduler)
     : BaseHandle(face, storageHandle, keyChain, scheduler)
   {
+    storageHandle.addEraseCallback(bind(&ReadAhead::erase, &m_readAhead, _1));
   }
 
   virtual void
   listen(const Name& prefix);
 
+  /**
+   * @brief read segments ahead of consumers fetching objects in segment order
+   * @param maxDepth          most segments read ahead of each consumer; 0 disables read-ahead
+   * @param maxCachedPackets  most Data read ahead kept in memory
+   */
+  void
+  setReadAhead(size_t maxDepth, size_t maxCachedPackets)
+  {
+    m_readAhead.setLimits(maxDepth, maxCachedPackets);
+  }
+
 private:
   /**
    * @brief Read data from backend storage
@@ -47,6 +60,18 @@ private:
 
   void
   onRegisterFailed(const Name& prefix, const std::string& reason);
+
+  /**
+   * @brief read a batch of segments ahead of the consumer of an object
+   *
+   * Runs from the scheduler after Interests are answered, and reschedules itself while the
+   * object has more segments to read ahead, so that reads ahead do not delay Interests.
+   */
+  void
+  readAhead(const Name& object);
+
+private:
+  ReadAhead m_readAhead;
 };
 
 } // namespace repo
@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "segment-tracker.hpp"
+
+#include <limits>
+
+namespace repo {
+
+static const size_t MIN_CAPACITY = 64;
+static const int MAX_RETRY_COUNT = 255;
+static const uint32_t MAX_WAIT_TIME = std::numeric_limits<uint32_t>::max();
+
+SegmentTracker::SegmentTracker(SegmentNo startSegment, size_t capacity)
+  : m_base(startSegment)
+  , m_capacity(MIN_CAPACITY)
+  , m_nReceived(0)
+{
+  while (m_capacity < capacity)
+    m_capacity <<= 1;
+
+  m_received.resize(m_capacity / 64, 0);
+  m_pending.resize(m_capacity / 64, 0);
+  m_retryCounts.resize(m_capacity, 0);
+  m_waitTimes.resize(m_capacity, 0);
+}
+
+void
+SegmentTracker::markPending(SegmentNo segment)
+{
+  BOOST_ASSERT(canTrack(segment));
+  setBit(m_pending, getSlot(segment));
+}
+
+void
+SegmentTracker::clearPending(SegmentNo segment)
+{
+  if (canTrack(segment))
+    clearBit(m_pending, getSlot(segment));
+}
+
+bool
+SegmentTracker::isPending(SegmentNo segment) const
+{
+  return canTrack(segment) && testBit(m_pending, getSlot(segment));
+}
+
+bool
+SegmentTracker::markReceived(SegmentNo segment)
+{
+  if (!canTrack(segment))
+    return false;
+
+  size_t slot = getSlot(segment);
+  if (testBit(m_received, slot))
+    return false;
+
+  setBit(m_received, slot);
+  clearBit(m_pending, slot);
+  ++m_nReceived;
+
+  // slide the window over received segments, their slots are reused for new segments
+  while (testBit(m_received, getSlot(m_base))) {
+    size_t baseSlot = getSlot(m_base);
+    clearBit(m_received, baseSlot);
+    m_retryCounts[baseSlot] = 0;
+    m_waitTimes[baseSlot] = 0;
+    ++m_base;
+  }
+  return true;
+}
+
+bool
+SegmentTracker::isReceived(SegmentNo segment) const
+{
+  if (segment < m_base)
+    return true;
+  return canTrack(segment) && testBit(m_received, getSlot(segment));
+}
+
+int
+SegmentTracker::getRetryCount(SegmentNo segment) const
+{
+  if (!canTrack(segment))
+    return 0;
+  return m_retryCounts[getSlot(segment)];
+}
+
+void
+SegmentTracker::incrementRetryCount(SegmentNo segment)
+{
+  BOOST_ASSERT(canTrack(segment));
+  uint8_t& retryCount = m_retryCounts[getSlot(segment)];
+  if (retryCount < MAX_RETRY_COUNT)
+    ++retryCount;
+}
+
+ndn::time::milliseconds
+SegmentTracker::getWaitTime(SegmentNo segment) const
+{
+  if (!canTrack(segment))
+    return ndn::time::milliseconds::zero();
+  return ndn::time::milliseconds(m_waitTimes[getSlot(segment)]);
+}
+
+void
+SegmentTracker::addWaitTime(SegmentNo segment, const ndn::time::milliseconds& lifetime)
+{
+  BOOST_ASSERT(canTrack(segment));
+  uint32_t& waitTime = m_waitTimes[getSlot(segment)];
+  uint64_t total = static_cast<uint64_t>(waitTime) + std::max<int64_t>(lifetime.count(), 0);
+  waitTime = static_cast<uint32_t>(std::min<uint64_t>(total, MAX_WAIT_TIME));
+}
+
+} // namespace repo
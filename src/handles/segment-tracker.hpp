@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPO_HANDLES_SEGMENT_TRACKER_HPP
+#define REPO_HANDLES_SEGMENT_TRACKER_HPP
+
+#include "common.hpp"
+
+namespace repo {
+
+/**
+ * @brief SegmentTracker keeps the state of segments of one segmented fetch.
+ *
+ * Segments are tracked in a sliding window starting at the lowest segment that has not
+ * been received. Each slot of the window has a received bit, a pending bit, a retry
+ * counter and the time spent waiting on timed out Interests, stored in fixed size arrays,
+ * so memory does not depend on the number of segments and no allocation happens per
+ * segment.
+ *
+ * Segments below the window have all been received. Segments at or beyond the end of
+ * the window cannot be tracked until the window slides.
+ */
+class SegmentTracker
+{
+public:
+  /**
+   * @param startSegment first segment to fetch
+   * @param capacity     minimum number of segments the window can hold,
+   *                     rounded up to a power of two
+   */
+  explicit
+  SegmentTracker(SegmentNo startSegment = 0, size_t capacity = 64);
+
+  /**
+   * @brief whether segment lies in the window and its state can be recorded
+   */
+  bool
+  canTrack(SegmentNo segment) const
+  {
+    return segment >= m_base && segment - m_base < m_capacity;
+  }
+
+  /**
+   * @brief record that an Interest for segment is outstanding
+   * @pre canTrack(segment)
+   */
+  void
+  markPending(SegmentNo segment);
+
+  /**
+   * @brief record that segment is no longer outstanding without receiving it
+   */
+  void
+  clearPending(SegmentNo segment);
+
+  bool
+  isPending(SegmentNo segment) const;
+
+  /**
+   * @brief record that segment has been received
+   * @return false if segment was already received or cannot be tracked
+   */
+  bool
+  markReceived(SegmentNo segment);
+
+  bool
+  isReceived(SegmentNo segment) const;
+
+  /**
+   * @brief number of times segment has been retransmitted
+   */
+  int
+  getRetryCount(SegmentNo segment) const;
+
+  void
+  incrementRetryCount(SegmentNo segment);
+
+  /**
+   * @brief total lifetime of the Interests for segment that timed out
+   */
+  ndn::time::milliseconds
+  getWaitTime(SegmentNo segment) const;
+
+  /**
+   * @brief record that an Interest for segment timed out after waiting lifetime
+   * @pre canTrack(segment)
+   */
+  void
+  addWaitTime(SegmentNo segment, const ndn::time::milliseconds& lifetime);
+
+  /**
+   * @brief lowest segment that has not been received
+   */
+  SegmentNo
+  getBase() const
+  {
+    return m_base;
+  }
+
+  /**
+   * @brief number of distinct segments received
+   */
+  uint64_t
+  getNReceived() const
+  {
+    return m_nReceived;
+  }
+
+private:
+  size_t
+  getSlot(SegmentNo segment) const
+  {
+    return static_cast<size_t>(segment & (m_capacity - 1));
+  }
+
+  static bool
+  testBit(const vector<uint64_t>& bitmap, size_t slot)
+  {
+    return (bitmap[slot >> 6] >> (slot & 63)) & 1;
+  }
+
+  static void
+  setBit(vector<uint64_t>& bitmap, size_t slot)
+  {
+    bitmap[slot >> 6] |= static_cast<uint64_t>(1) << (slot & 63);
+  }
+
+  static void
+  clearBit(vector<uint64_t>& bitmap, size_t slot)
+  {
+    bitmap[slot >> 6] &= ~(static_cast<uint64_t>(1) << (slot & 63));
+  }
+
+private:
+  SegmentNo m_base;
+  uint64_t m_capacity;
+  uint64_t m_nReceived;
+  vector<uint64_t> m_received;
+  vector<uint64_t> m_pending;
+  vector<uint8_t> m_retryCounts;
+  vector<uint32_t> m_waitTimes;  ///< in milliseconds
+};
+
+} // namespace repo
+
+#endif // REPO_HANDLES_SEGMENT_TRACKER_HPP
@@ -0,0 +1,90 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "status-handle.hpp"
+
+namespace repo {
+
+StatusHandle::StatusHandle(Face& face, RepoStorage& storageHandle, KeyChain& keyChain,
+                           Scheduler& scheduler, ValidatorConfig& validator)
+  : BaseHandle(face, storageHandle, keyChain, scheduler)
+  , m_validator(validator)
+{
+}
+
+void
+StatusHandle::onInterest(const Name& prefix, const Interest& interest)
+{
+  m_validator.validate(interest, bind(&StatusHandle::onValidated, this, _1, prefix),
+                       bind(&StatusHandle::onValidationFailed, this, _1, _2));
+}
+
+void
+StatusHandle::onRegisterFailed(const Name& prefix, const std::string& reason)
+{
+  throw Error("Status prefix registration failed");
+}
+
+void
+StatusHandle::onValidated(const shared_ptr<const Interest>& interest, const Name& prefix)
+{
+  RepoCommandParameter parameter;
+
+  try {
+    extractParameter(*interest, prefix, parameter);
+  }
+  catch (RepoCommandParameter::Error) {
+    negativeReply(*interest, 403);
+    return;
+  }
+
+  Index::Usage usage = getStorageHandle().getUsage(parameter.getName());
+
+  RepoCommandResponse response;
+  response.setStatusCode(200);
+  response.setDataNum(usage.nPackets);
+  response.setDataSize(usage.nBytes);
+  reply(*interest, response);
+}
+
+void
+StatusHandle::onValidationFailed(const shared_ptr<const Interest>& interest, const string& reason)
+{
+  std::cerr << reason << std::endl;
+  negativeReply(*interest, 401);
+}
+
+void
+StatusHandle::listen(const Name& prefix)
+{
+  Name statusPrefix = Name(prefix).append("status");
+  getFace().setInterestFilter(statusPrefix,
+                              bind(&StatusHandle::onInterest, this, _1, _2),
+                              bind(&StatusHandle::onRegisterFailed, this, _1, _2));
+}
+
+void
+StatusHandle::negativeReply(const Interest& interest, uint64_t statusCode)
+{
+  RepoCommandResponse response;
+  response.setStatusCode(statusCode);
+  reply(interest, response);
+}
+
+} // namespace repo
@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPO_HANDLES_STATUS_HANDLE_HPP
+#define REPO_HANDLES_STATUS_HANDLE_HPP
+
+#include "base-handle.hpp"
+#include <ndn-cxx/security/validator-config.hpp>
+
+namespace repo {
+
+/**
+ * @brief StatusHandle answers status commands with the usage of a prefix
+ *
+ * A status command carries the prefix as the Name of its RepoCommandParameter. The response
+ * has StatusCode 200 with the number (DataNum) and total encoded size (DataSize) of Data
+ * under that prefix, read from the counters maintained by the index.
+ */
+class StatusHandle : public BaseHandle
+{
+
+public:
+  class Error : public BaseHandle::Error
+  {
+  public:
+    explicit
+    Error(const std::string& what)
+      : BaseHandle::Error(what)
+    {
+    }
+  };
+
+public:
+  StatusHandle(Face& face, RepoStorage& storageHandle, KeyChain& keyChain,
+               Scheduler& scheduler, ValidatorConfig& validator);
+
+  virtual void
+  listen(const Name& prefix);
+
+private:
+  void
+  onInterest(const Name& prefix, const Interest& interest);
+
+  void
+  onRegisterFailed(const Name& prefix, const std::string& reason);
+
+  void
+  onValidated(const shared_ptr<const Interest>& interest, const Name& prefix);
+
+  void
+  onValidationFailed(const shared_ptr<const Interest>& interest, const string& reason);
+
+  void
+  negativeReply(const Interest& interest, uint64_t statusCode);
+
+private:
+  ValidatorConfig& m_validator;
+};
+
+} // namespace repo
+
+#endif // REPO_HANDLES_STATUS_HANDLE_HPP
@@ -18,11 +18,17 @@
  */
 
 #include "tcp-bulk-insert-handle.hpp"
+#include "repo-command-response.hpp"
 
 namespace repo {
 
 const size_t MAX_NDN_PACKET_SIZE = 8800;
 
+/**
+ * Room for several packets per receive, so that Data are inserted in batches
+ */
+const size_t INPUT_BUFFER_SIZE = 16 * MAX_NDN_PACKET_SIZE;
+
 namespace detail {
 
 class TcpBulkInsertClient : noncopyable
@@ -34,6 +40,8 @@ public:
     , m_socket(socket)
     , m_hasStarted(false)
     , m_inputBufferSize(0)
+    , m_nInserted(0)
+    , m_nFailed(0)
   {
   }
 
@@ -43,7 +51,7 @@ public:
     BOOST_ASSERT(!client->m_hasStarted);
 
     client->m_socket->async_receive(
-      boost::asio::buffer(client->m_inputBuffer, MAX_NDN_PACKET_SIZE), 0,
+      boost::asio::buffer(client->m_inputBuffer, INPUT_BUFFER_SIZE), 0,
       bind(&TcpBulkInsertClient::handleReceive, client, _1, _2, client));
 
     client->m_hasStarted = true;
@@ -55,12 +63,31 @@ private:
                 std::size_t nBytesReceived,
                 const shared_ptr<TcpBulkInsertClient>& client);
 
+  /**
+   * @brief insert Data decoded from the input buffer, and clear the batch
+   */
+  void
+  insertBatch(std::vector<shared_ptr<const Data> >& batch);
+
+  /**
+   * @brief reply to a confirmation request with the result of Data received so far
+   */
+  void
+  sendConfirmation(const shared_ptr<TcpBulkInsertClient>& client);
+
+  void
+  handleSend(const boost::system::error_code& error,
+             const Block& response,
+             const shared_ptr<TcpBulkInsertClient>& client);
+
 private:
   TcpBulkInsertHandle& m_writer;
   shared_ptr<boost::asio::ip::tcp::socket> m_socket;
   bool m_hasStarted;
-  uint8_t m_inputBuffer[MAX_NDN_PACKET_SIZE];
+  uint8_t m_inputBuffer[INPUT_BUFFER_SIZE];
   std::size_t m_inputBufferSize;
+  uint64_t m_nInserted;
+  uint64_t m_nFailed;
 };
 
 } // namespace detail
@@ -170,6 +197,7 @@ detail::TcpBulkInsertClient::handleReceive(const boost::system::error_code& erro
 
   bool isOk = true;
   Block element;
+  std::vector<shared_ptr<const Data> > batch;
   while (m_inputBufferSize - offset > 0)
     {
       isOk = Block::fromBuffer(m_inputBuffer + offset, m_inputBufferSize - offset, element);
@@ -182,22 +210,24 @@ detail::TcpBulkInsertClient::handleReceive(const boost::system::error_code& erro
       if (element.type() == ndn::Tlv::Data)
         {
           try {
-            Data data(element);
-            bool isOk = m_writer.getStorageHandle().insertData(data);
-            if (isOk) {
-              std::cerr << "Successfully injected " << data.getName() << std::endl;
-              m_writer.m_generator(data.getName(), "insertion");
-            }
-            else
-              std::cerr << "FAILED to inject " << data.getName() << std::endl;
+            batch.push_back(make_shared<Data>(element));
           }
           catch (std::runtime_error& error) {
             /// \todo Catch specific error after determining what wireDecode() can throw
             std::cerr << "Error decoding received Data packet" << std::endl;
+            ++m_nFailed;
           }
         }
+      else if (element.type() == ndn::Tlv::Interest)
+        {
+          // Data are inserted in order, so every Data sent before the Interest is stored
+          insertBatch(batch);
+          sendConfirmation(client);
+        }
     }
-  if (!isOk && m_inputBufferSize == MAX_NDN_PACKET_SIZE && offset == 0)
+  insertBatch(batch);
+
+  if (!isOk && m_inputBufferSize - offset >= MAX_NDN_PACKET_SIZE)
     {
       boost::system::error_code error;
       m_socket->shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
@@ -220,9 +250,61 @@ detail::TcpBulkInsertClient::handleReceive(const boost::system::error_code& erro
     }
 
   m_socket->async_receive(boost::asio::buffer(m_inputBuffer + m_inputBufferSize,
-                                              MAX_NDN_PACKET_SIZE - m_inputBufferSize), 0,
+                                              INPUT_BUFFER_SIZE - m_inputBufferSize), 0,
                           bind(&TcpBulkInsertClient::handleReceive, this, _1, _2, client));
 }
 
+void
+detail::TcpBulkInsertClient::insertBatch(std::vector<shared_ptr<const Data> >& batch)
+{
+  if (batch.empty())
+    return;
+
+  std::vector<bool> isInserted;
+  try {
+    isInserted = m_writer.getStorageHandle().insertData(batch);
+  }
+  catch (std::runtime_error& error) {
+    std::cerr << "FAILED to inject batch of " << batch.size() << " Data: "
+              << error.what() << std::endl;
+    isInserted.assign(batch.size(), false);
+  }
+
+  for (size_t i = 0; i < batch.size(); ++i) {
+    if (isInserted[i]) {
+      std::cerr << "Successfully injected " << batch[i]->getName() << std::endl;
+      m_writer.m_generator(batch[i]->getName(), "insertion");
+      ++m_nInserted;
+    }
+    else {
+      std::cerr << "FAILED to inject " << batch[i]->getName() << std::endl;
+      ++m_nFailed;
+    }
+  }
+  batch.clear();
+}
+
+void
+detail::TcpBulkInsertClient::sendConfirmation(const shared_ptr<TcpBulkInsertClient>& client)
+{
+  RepoCommandResponse response;
+  response.setStatusCode(m_nFailed == 0 ? 200 : 400);
+  response.setInsertNum(m_nInserted);
+
+  Block wire = response.wireEncode();
+  boost::asio::async_write(*m_socket, boost::asio::buffer(wire.wire(), wire.size()),
+                           bind(&TcpBulkInsertClient::handleSend, this, _1, wire, client));
+}
+
+void
+detail::TcpBulkInsertClient::handleSend(const boost::system::error_code& error,
+                                        const Block& response,
+                                        const shared_ptr<TcpBulkInsertClient>& client)
+{
+  // response is bound to the handler only to keep its buffer alive
+  if (error && error != boost::system::errc::operation_canceled)
+    std::cerr << "Error sending bulk insert confirmation: " << error.message() << std::endl;
+}
+
 
 } // namespace repo
@@ -27,6 +27,14 @@
 
 namespace repo {
 
+/**
+ * @brief TcpBulkInsertHandle inserts Data streamed over TCP connections
+ *
+ * Data packets are inserted in the order they arrive. An Interest sent on the same
+ * connection is a confirmation request: the handle replies with a RepoCommandResponse
+ * whose InsertNum is the number of Data of this connection inserted so far, and whose
+ * StatusCode is 200 if none of them failed or 400 otherwise.
+ */
 class TcpBulkInsertHandle : noncopyable
 {
 public:
@@ -23,11 +23,15 @@ namespace repo {
 
 static const milliseconds PROCESS_DELETE_TIME(10000);
 static const milliseconds DEFAULT_INTEREST_LIFETIME(4000);
+static const int DEFAULT_PIPELINE_DEPTH = 1;
+static const size_t MAX_GAPS_PER_PROCESS = 64;
+static const int MAX_GAP_RETRIES = 3;
 
 WatchHandle::WatchHandle(Face& face, RepoStorage& storageHandle, KeyChain& keyChain,
                          Scheduler& scheduler, ValidatorConfig& validator, ActionGenerate generator)
   : BaseHandle(face, storageHandle, keyChain, scheduler, generator)
   , m_validator(validator)
+  , m_pipelineDepth(DEFAULT_PIPELINE_DEPTH)
   , m_interestNum(0)
   , m_maxInterestNum(0)
   , m_interestLifetime(DEFAULT_INTEREST_LIFETIME)
@@ -37,6 +41,14 @@ WatchHandle::WatchHandle(Face& face, RepoStorage& storageHandle, KeyChain& keyCh
 {
 }
 
+void
+WatchHandle::setPipelineDepth(int depth)
+{
+  if (depth <= 0)
+    throw Error("Invalid watch pipeline depth");
+  m_pipelineDepth = depth;
+}
+
 void
 WatchHandle::deleteProcess(const Name& name)
 {
@@ -88,7 +100,7 @@ WatchHandle::onValidated(const shared_ptr<const Interest>& interest, const Name&
 
 void WatchHandle::watchStop(const Name& name)
 {
-  m_processes[name].second = false;
+  m_processes[name].isRunning = false;
   m_maxInterestNum = 0;
   m_interestNum = 0;
   m_startTime = steady_clock::now();
@@ -105,114 +117,265 @@ WatchHandle::onValidationFailed(const shared_ptr<const Interest>& interest, cons
 }
 
 void
-WatchHandle::onData(const Interest& interest, ndn::Data& data, const Name& name)
+WatchHandle::onData(const Interest& interest, ndn::Data& data, const Name& name,
+                    InterestKind kind, const Gap& gap)
 {
   m_validator.validate(data,
-                       bind(&WatchHandle::onDataValidated, this, interest, _1, name),
-                       bind(&WatchHandle::onDataValidationFailed, this, interest, _1, _2, name));
+                       bind(&WatchHandle::onDataValidated, this, interest, _1, name,
+                            kind, gap),
+                       bind(&WatchHandle::onDataValidationFailed, this, interest, _1, _2, name,
+                            kind, gap));
 }
 
 void
 WatchHandle::onDataValidated(const Interest& interest, const shared_ptr<const Data>& data,
-                             const Name& name)
+                             const Name& name, InterestKind kind, const Gap& gap)
 {
-  if (!m_processes[name].second) {
+  ProcessInfo& process = m_processes[name];
+  if (!process.isRunning) {
+    return;
+  }
+  if (process.nOutstanding > 0)
+    --process.nOutstanding;
+
+  // interests of the pipeline may overlap, e.g. the tail and a sequence interest
+  status dataStatus = getStorageHandle().getDataStatus(data->getFullName());
+  if (dataStatus != DELETED && dataStatus != NONE) {
+    advance(process, name, *data, kind, gap);
+    fillPipeline(name, process);
     return;
   }
+
   if (getStorageHandle().insertData(*data)) {
     m_generator(data->getName(), "insertion");
     m_size++;
-    if (!onRunning(name))
-      return;
+    process.response.setInsertNum(m_size);
 
-    Interest fetchInterest(interest.getName());
-    fetchInterest.setSelectors(interest.getSelectors());
-    fetchInterest.setInterestLifetime(m_interestLifetime);
-    fetchInterest.setChildSelector(1);
-
-    // update selectors
-    // if data name is equal to interest name, use MinSuffixComponents selecor to exclude this data
-    if (data->getName().size() == interest.getName().size()) {
-      fetchInterest.setMinSuffixComponents(2);
-    }
-    else {
-      Exclude exclude;
-      if (!interest.getExclude().empty()) {
-        exclude = interest.getExclude();
-      }
-
-      exclude.excludeBefore(data->getName()[interest.getName().size()]);
-      fetchInterest.setExclude(exclude);
-    }
-
-    ++m_interestNum;
-    getFace().expressInterest(fetchInterest,
-                              bind(&WatchHandle::onData, this, _1, _2, name),
-                              bind(&WatchHandle::onTimeout, this, _1, name));
+    advance(process, name, *data, kind, gap);
+    fillPipeline(name, process);
   }
   else {
-    throw Error("Insert into Repo Failed");
+    // e.g. a reject quota of the prefix is full, the following Data would be refused too
+    std::cerr << "Insert into Repo Failed, watch of " << name << " is stopped" << std::endl;
+    deferredDeleteProcess(name);
+    watchStop(name);
   }
-  m_processes[name].first.setInsertNum(m_size);
 }
 
 void
 WatchHandle::onDataValidationFailed(const Interest& interest, const shared_ptr<const Data>& data,
-                                    const std::string& reason, const Name& name)
+                                    const std::string& reason, const Name& name,
+                                    InterestKind kind, const Gap& gap)
 {
   std::cerr << reason << std::endl;
-  if (!m_processes[name].second) {
+  ProcessInfo& process = m_processes[name];
+  if (!process.isRunning) {
+    return;
+  }
+  if (process.nOutstanding > 0)
+    --process.nOutstanding;
+
+  // Only skip this data since other data whose names are smaller may be validated and satisfied
+  advance(process, name, *data, kind, gap);
+  fillPipeline(name, process);
+}
+
+void
+WatchHandle::onTimeout(const ndn::Interest& interest, const Name& name,
+                       InterestKind kind, const Gap& gap)
+{
+  std::cerr << "Timeout" << std::endl;
+  ProcessInfo& process = m_processes[name];
+  if (!process.isRunning) {
     return;
   }
-  if (!onRunning(name))
+  if (process.nOutstanding > 0)
+    --process.nOutstanding;
+
+  switch (kind) {
+  case TAIL_INTEREST:
+    // selectors do not need to be updated, tail interest is expressed again
+    process.isTailOutstanding = false;
+    break;
+  case GAP_INTEREST:
+    // the range is likely empty, but the interest or its Data may have been lost
+    if (gap.nRetries < MAX_GAP_RETRIES)
+      process.gaps.push_front(Gap(gap.first, gap.second, gap.nRetries + 1));
+    break;
+  case SEQUENCE_INTEREST:
+    {
+      uint64_t sequence = interest.getName().get(name.size()).toSequenceNumber();
+      // a later sequence number has arrived, the producer skipped this one
+      if (process.highestSequence > sequence)
+        break;
+      if (!onRunning(name))
+        return;
+      sendSequenceInterest(name, process, sequence);
+    }
+    break;
+  }
+
+  fillPipeline(name, process);
+}
+
+void
+WatchHandle::advance(ProcessInfo& process, const Name& name, const Data& data,
+                     InterestKind kind, const Gap& gap)
+{
+  // if data name is equal to interest name, use MinSuffixComponents selecor to exclude this data
+  if (data.getName().size() == name.size()) {
+    process.hasExactMatch = true;
+    if (kind == TAIL_INTEREST)
+      process.isTailOutstanding = false;
     return;
+  }
+
+  const Name::Component& child = data.getName()[name.size()];
+  bool hasRoom = process.gaps.size() < MAX_GAPS_PER_PROCESS;
+
+  switch (kind) {
+  case TAIL_INTEREST:
+    process.isTailOutstanding = false;
+    if (process.isSequenceMode && child.isSequenceNumber()) {
+      // the producer is ahead of the sequence interests, maybe after skipping numbers
+      uint64_t sequence = child.toSequenceNumber();
+      process.highestSequence = std::max(process.highestSequence, sequence);
+      if (sequence >= process.nextSequence) {
+        // numbers not requested yet below this one are fetched as a range
+        if (sequence > process.nextSequence && hasRoom)
+          process.gaps.push_back(Gap(Name::Component::fromSequenceNumber(process.nextSequence - 1),
+                                     child));
+        process.nextSequence = sequence + 1;
+      }
+    }
+    else if (m_pipelineDepth > 1) {
+      // children between the previous greatest child and this one are fetched separately
+      if (process.hasLast && hasRoom)
+        process.gaps.push_back(Gap(process.last, child));
+      if (child.isSequenceNumber()) {
+        process.isSequenceMode = true;
+        process.highestSequence = child.toSequenceNumber();
+        process.nextSequence = process.highestSequence + 1;
+      }
+    }
+    break;
+  case GAP_INTEREST:
+    if (hasRoom)
+      process.gaps.push_back(Gap(child, gap.second));
+    break;
+  case SEQUENCE_INTEREST:
+    process.highestSequence = std::max(process.highestSequence, child.toSequenceNumber());
+    break;
+  }
 
-  Interest fetchInterest(interest.getName());
-  fetchInterest.setSelectors(interest.getSelectors());
+  // the tail interest asks for children beyond every child received so far
+  if (kind != GAP_INTEREST && (!process.hasLast || process.last < child)) {
+    process.hasLast = true;
+    process.last = child;
+  }
+}
+
+void
+WatchHandle::fillPipeline(const Name& name, ProcessInfo& process)
+{
+  // kept in sequence mode too, so a producer skipping numbers or resuming further on is found
+  if (!process.isTailOutstanding) {
+    if (!onRunning(name))
+      return;
+    sendTailInterest(name, process);
+  }
+
+  while (process.nOutstanding < m_pipelineDepth) {
+    if (!process.gaps.empty()) {
+      if (!onRunning(name))
+        return;
+      Gap gap = process.gaps.front();
+      process.gaps.pop_front();
+      sendGapInterest(name, process, gap);
+    }
+    else if (process.isSequenceMode) {
+      // numbers excluded by the command are left to the tail interest
+      if (process.selectors.getExclude().isExcluded(
+            Name::Component::fromSequenceNumber(process.nextSequence)))
+        break;
+      if (!onRunning(name))
+        return;
+      sendSequenceInterest(name, process, process.nextSequence++);
+    }
+    else {
+      break;
+    }
+  }
+}
+
+void
+WatchHandle::sendTailInterest(const Name& name, ProcessInfo& process)
+{
+  Interest fetchInterest(name);
+  fetchInterest.setSelectors(process.selectors);
   fetchInterest.setInterestLifetime(m_interestLifetime);
   fetchInterest.setChildSelector(1);
 
   // update selectors
-  // if data name is equal to interest name, use MinSuffixComponents selecor to exclude this data
-  if (data->getName().size() == interest.getName().size()) {
+  if (process.hasExactMatch) {
     fetchInterest.setMinSuffixComponents(2);
   }
-  else {
-    Exclude exclude;
-    if (!interest.getExclude().empty()) {
-      exclude = interest.getExclude();
-    }
-    // Only exclude this data since other data whose names are smaller may be validated and satisfied
-    exclude.excludeBefore(data->getName()[interest.getName().size()]);
+  if (process.hasLast) {
+    // rebuilt from the command selectors each time, so it stays one range long
+    Exclude exclude = process.selectors.getExclude();
+    exclude.excludeBefore(process.last);
     fetchInterest.setExclude(exclude);
   }
 
-  ++m_interestNum;
-  getFace().expressInterest(fetchInterest,
-                            bind(&WatchHandle::onData, this, _1, _2, name),
-                            bind(&WatchHandle::onTimeout, this, _1, name));
+  process.isTailOutstanding = true;
+  expressWatchInterest(name, process, fetchInterest, TAIL_INTEREST, Gap());
 }
 
 void
-WatchHandle::onTimeout(const ndn::Interest& interest, const Name& name)
+WatchHandle::sendGapInterest(const Name& name, ProcessInfo& process, const Gap& gap)
 {
-  std::cerr << "Timeout" << std::endl;
-  if (!m_processes[name].second) {
-    return;
-  }
-  if (!onRunning(name))
-    return;
-  // selectors do not need to be updated
-  Interest fetchInterest(interest.getName());
-  fetchInterest.setSelectors(interest.getSelectors());
+  Interest fetchInterest(name);
+  fetchInterest.setSelectors(process.selectors);
   fetchInterest.setInterestLifetime(m_interestLifetime);
-  fetchInterest.setChildSelector(1);
+  fetchInterest.setChildSelector(0);
+  fetchInterest.setMinSuffixComponents(2);
 
-  ++m_interestNum;
-  getFace().expressInterest(fetchInterest,
-                            bind(&WatchHandle::onData, this, _1, _2, name),
-                            bind(&WatchHandle::onTimeout, this, _1, name));
+  Exclude exclude = process.selectors.getExclude();
+  exclude.excludeBefore(gap.first);
+  exclude.excludeAfter(gap.second);
+  fetchInterest.setExclude(exclude);
+
+  expressWatchInterest(name, process, fetchInterest, GAP_INTEREST, gap);
+}
+
+void
+WatchHandle::sendSequenceInterest(const Name& name, ProcessInfo& process, uint64_t sequence)
+{
+  const Selectors& selectors = process.selectors;
+  Interest fetchInterest(Name(name).appendSequenceNumber(sequence));
+  fetchInterest.setInterestLifetime(m_interestLifetime);
+  fetchInterest.setMustBeFresh(selectors.getMustBeFresh());
+  fetchInterest.setPublisherPublicKeyLocator(selectors.getPublisherPublicKeyLocator());
+
+  // the command selectors count suffix components from the watched prefix, one more
+  if (selectors.getMinSuffixComponents() >= 0)
+    fetchInterest.setMinSuffixComponents(std::max(selectors.getMinSuffixComponents() - 1, 0));
+  if (selectors.getMaxSuffixComponents() >= 0)
+    fetchInterest.setMaxSuffixComponents(std::max(selectors.getMaxSuffixComponents() - 1, 0));
+
+  expressWatchInterest(name, process, fetchInterest, SEQUENCE_INTEREST, Gap());
+}
 
+void
+WatchHandle::expressWatchInterest(const Name& name, ProcessInfo& process,
+                                  const Interest& interest,
+                                  InterestKind kind, const Gap& gap)
+{
+  ++m_interestNum;
+  ++process.nOutstanding;
+  getFace().expressInterest(interest,
+                            bind(&WatchHandle::onData, this, _1, _2, name, kind, gap),
+                            bind(&WatchHandle::onTimeout, this, _1, name, kind, gap));
 }
 
 void
@@ -289,8 +452,8 @@ WatchHandle::onCheckValidated(const shared_ptr<const Interest>& interest, const
     return;
   }
 
-  RepoCommandResponse& response = m_processes[name].first;
-    if (!m_processes[name].second) {
+  RepoCommandResponse& response = m_processes[name].response;
+  if (!m_processes[name].isRunning) {
     response.setStatusCode(101);
   }
 
@@ -339,19 +502,15 @@ WatchHandle::processWatchCommand(const Interest& interest,
 
   reply(interest, RepoCommandResponse().setStatusCode(100));
 
-  m_processes[parameter.getName()] =
-                std::make_pair(RepoCommandResponse().setStatusCode(300), true);
-  Interest fetchInterest(parameter.getName());
+  ProcessInfo& process = m_processes[parameter.getName()];
+  process = ProcessInfo();
+  process.response.setStatusCode(300);
+  process.isRunning = true;
   if (parameter.hasSelectors()) {
-    fetchInterest.setSelectors(parameter.getSelectors());
+    process.selectors = parameter.getSelectors();
   }
-  fetchInterest.setChildSelector(1);
-  fetchInterest.setInterestLifetime(m_interestLifetime);
   m_startTime = steady_clock::now();
-  m_interestNum++;
-  getFace().expressInterest(fetchInterest,
-                            bind(&WatchHandle::onData, this, _1, _2, parameter.getName()),
-                            bind(&WatchHandle::onTimeout, this, _1, parameter.getName()));
+  sendTailInterest(parameter.getName(), process);
 }
 
 
@@ -22,6 +22,7 @@
 
 #include "base-handle.hpp"
 
+#include <deque>
 #include <queue>
 
 namespace repo {
@@ -40,6 +41,14 @@ using namespace ndn::time;
  * watching the prefix until a command interest tell it to stop, the total
  *
  * amount of sent interests reaches a specific number or time out.
+ *
+ * With a pipeline depth larger than one, several interests of a watch process are
+ * outstanding at the same time, each on a disjoint range of the first component after
+ * the watched prefix. The tail interest asks for the rightmost child beyond the greatest
+ * child seen so far, and every gap opened between two received children is walked from
+ * the left by its own interest. Once a child is a sequence number, the process requests
+ * following sequence numbers directly by name. The tail interest stays outstanding in
+ * sequence mode, so that the process follows a producer that skips ahead.
  */
 class WatchHandle : public BaseHandle
 {
@@ -65,6 +74,74 @@ public:
   virtual void
   listen(const Name& prefix);
 
+  /**
+   * @brief set the number of interests a watch process keeps outstanding
+   *
+   * Depth 1 keeps a single rightmost-child interest, as without pipelining.
+   */
+  void
+  setPipelineDepth(int depth);
+
+private:
+  enum InterestKind {
+    TAIL_INTEREST,     ///< rightmost child beyond the greatest child received
+    GAP_INTEREST,      ///< leftmost child in an open range between two received children
+    SEQUENCE_INTEREST  ///< exact name with a sequence number
+  };
+
+  /**
+   * @brief open range of children between two received children, both excluded
+   */
+  struct Gap
+  {
+    Gap()
+      : nRetries(0)
+    {
+    }
+
+    Gap(const Name::Component& first, const Name::Component& second, int nRetries = 0)
+      : first(first)
+      , second(second)
+      , nRetries(nRetries)
+    {
+    }
+
+    Name::Component first;
+    Name::Component second;
+    int nRetries;  ///< times the interest for the range has timed out
+  };
+
+  /**
+   * @brief state of watch process of one prefix
+   */
+  struct ProcessInfo
+  {
+    ProcessInfo()
+      : isRunning(false)
+      , nOutstanding(0)
+      , isTailOutstanding(false)
+      , hasLast(false)
+      , hasExactMatch(false)
+      , isSequenceMode(false)
+      , nextSequence(0)
+      , highestSequence(0)
+    {
+    }
+
+    RepoCommandResponse response;
+    bool isRunning;
+    Selectors selectors;  ///< selectors given in watch command
+    int nOutstanding;
+    bool isTailOutstanding;
+    bool hasLast;
+    Name::Component last;  ///< greatest child received by tail interests
+    bool hasExactMatch;  ///< Data named exactly by the prefix has been received
+    std::deque<Gap> gaps;  ///< ranges waiting for a free slot of the pipeline
+    bool isSequenceMode;
+    uint64_t nextSequence;  ///< next sequence number to request
+    uint64_t highestSequence;  ///< highest sequence number received
+  };
+
 private: // watch-insert command
   /**
    * @brief handle watch commands
@@ -89,24 +166,55 @@ private: // data fetching
    * @brief fetch data and send next interest
    */
   void
-  onData(const Interest& interest, Data& data, const Name& name);
+  onData(const Interest& interest, Data& data, const Name& name,
+         InterestKind kind, const Gap& gap);
 
   /**
    * @brief handle when fetching one data timeout
    */
   void
-  onTimeout(const Interest& interest, const Name& name);
+  onTimeout(const Interest& interest, const Name& name,
+            InterestKind kind, const Gap& gap);
 
   void
   onDataValidated(const Interest& interest, const shared_ptr<const Data>& data,
-                  const Name& name);
+                  const Name& name, InterestKind kind, const Gap& gap);
 
   /**
    * @brief failure of validation
    */
   void
   onDataValidationFailed(const Interest& interest, const shared_ptr<const Data>& data,
-                         const std::string& reason, const Name& name);
+                         const std::string& reason, const Name& name,
+                         InterestKind kind, const Gap& gap);
+
+  /**
+   * @brief update ranges of process after Data of an interest is received
+   *
+   * Ranges move past the Data whether or not it could be validated.
+   */
+  void
+  advance(ProcessInfo& process, const Name& name, const Data& data,
+          InterestKind kind, const Gap& gap);
+
+  /**
+   * @brief express interests until the pipeline of process is full
+   */
+  void
+  fillPipeline(const Name& name, ProcessInfo& process);
+
+  void
+  sendTailInterest(const Name& name, ProcessInfo& process);
+
+  void
+  sendGapInterest(const Name& name, ProcessInfo& process, const Gap& gap);
+
+  void
+  sendSequenceInterest(const Name& name, ProcessInfo& process, uint64_t sequence);
+
+  void
+  expressWatchInterest(const Name& name, ProcessInfo& process, const Interest& interest,
+                       InterestKind kind, const Gap& gap);
 
 
   void
@@ -158,7 +266,8 @@ private:
 
   ValidatorConfig& m_validator;
 
-  map<Name, std::pair<RepoCommandResponse, bool> > m_processes;
+  map<Name, ProcessInfo> m_processes;
+  int m_pipelineDepth;
   int64_t m_interestNum;
   int64_t m_maxInterestNum;
   milliseconds m_interestLifetime;
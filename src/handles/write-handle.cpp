@@ -23,7 +23,8 @@ namespace repo {
 using namespace ndn::time;
 
 static const int RETRY_TIMEOUT = 3;
-static const int DEFAULT_CREDIT = 12;
+static const int DEFAULT_INITIAL_WINDOW = 12;
+static const int DEFAULT_MAX_WINDOW = 256;
 static const milliseconds NOEND_TIMEOUT(10000);
 static const milliseconds PROCESS_DELETE_TIME(10000);
 static const milliseconds DEFAULT_INTEREST_LIFETIME(4000);
@@ -34,17 +35,36 @@ WriteHandle::WriteHandle(Face& face, RepoStorage& storageHandle, KeyChain& keyCh
   : BaseHandle(face, storageHandle, keyChain, scheduler, generator)
   , m_validator(validator)
   , m_retryTime(RETRY_TIMEOUT)
-  , m_credit(DEFAULT_CREDIT)
+  , m_initialWindow(DEFAULT_INITIAL_WINDOW)
+  , m_maxWindow(DEFAULT_MAX_WINDOW)
   , m_noEndTimeout(NOEND_TIMEOUT)
   , m_interestLifetime(DEFAULT_INTEREST_LIFETIME)
+  , m_packObjects(false)
 {
 }
 
+void
+WriteHandle::setWindowLimits(int initialWindow, int maxWindow)
+{
+  if (initialWindow <= 0 || maxWindow < initialWindow)
+    throw Error("Invalid segmented insert window limits");
+  m_initialWindow = initialWindow;
+  m_maxWindow = maxWindow;
+}
+
+void
+WriteHandle::setSchedulerLimits(int maxInFlight, int quantum, int smallInsertSegments)
+{
+  if (maxInFlight <= 0 || quantum <= 0 || smallInsertSegments < 0)
+    throw Error("Invalid segmented insert scheduler limits");
+  m_fetchScheduler.setLimits(maxInFlight, quantum, smallInsertSegments);
+}
 
 void
 WriteHandle::deleteProcess(ProcessId processId)
 {
   m_processes.erase(processId);
+  m_fetchScheduler.removeProcess(processId);
 }
 
 // Interest.
@@ -140,22 +160,34 @@ WriteHandle::onDataValidationFailed(const shared_ptr<const Data>& data, const st
 }
 
 void
-WriteHandle::onSegmentData(const Interest& interest, Data& data, ProcessId processId)
+WriteHandle::onSegmentData(const Interest& interest, Data& data, ProcessId processId,
+                           const steady_clock::TimePoint& sendTime)
 {
+  // measure RTT before validation, which may need to fetch certificates
+  milliseconds rtt = duration_cast<milliseconds>(steady_clock::now() - sendTime);
+  if (m_processes.count(processId) != 0)
+    m_fetchScheduler.onInterestFinished(processId);
   m_validator.validate(data,
-                       bind(&WriteHandle::onSegmentDataValidated, this, interest, _1, processId),
-                       bind(&WriteHandle::onDataValidationFailed, this, _1, _2));
+                       bind(&WriteHandle::onSegmentDataValidated, this, interest, _1, processId,
+                            rtt),
+                       bind(&WriteHandle::onSegmentDataValidationFailed, this, interest, _1, _2,
+                            processId));
 }
 
 void
 WriteHandle::onSegmentDataValidated(const Interest& interest,
                                     const shared_ptr<const Data>& data,
-                                    ProcessId processId)
+                                    ProcessId processId, const milliseconds& rtt)
 {
   if (m_processes.count(processId) == 0) {
     return;
   }
-  RepoCommandResponse& response = m_processes[processId].response;
+  ProcessInfo& process = m_processes[processId];
+  RepoCommandResponse& response = process.response;
+
+  //process has ended, waiting for deletion
+  if (response.getStatusCode() != 300)
+    return;
 
   //refresh endBlockId
   Name::Component finalBlockId = data->getFinalBlockId();
@@ -172,13 +204,71 @@ WriteHandle::onSegmentDataValidated(const Interest& interest,
     }
   }
 
-  //insert data
-  if (getStorageHandle().insertData(*data)) {
+  SegmentNo fetchedSegment =
+    interest.getName().get(interest.getName().size() - 1).toSegment();
+
+  //RTT of a retransmitted segment is ambiguous, so it is not sampled
+  process.window.onData(rtt, process.segments.getRetryCount(fetchedSegment) == 0);
+
+  //segments beyond FinalBlockId are not part of the object
+  if (response.hasEndBlockId() && fetchedSegment > response.getEndBlockId()) {
+    process.segments.clearPending(fetchedSegment);
+    onSegmentDataControl(processId);
+    return;
+  }
+
+  //insert data, a segment received more than once is inserted and counted only once
+  if (!process.segments.isReceived(fetchedSegment)) {
+    bool isInserted = false;
+    try {
+      isInserted = getStorageHandle().insertData(*data);
+    }
+    catch (std::runtime_error& e) {
+      std::cerr << "Cannot insert " << data->getName() << ": " << e.what() << std::endl;
+    }
+    if (!isInserted) {
+      //the object cannot be complete, StatusCode is refreshed as 400
+      response.setStatusCode(400);
+      deferredDeleteProcess(processId);
+      m_fetchScheduler.deactivate(processId);
+      dispatchSegments();
+      return;
+    }
+    process.segments.markReceived(fetchedSegment);
     m_generator(data->getName(), "insertion");
     response.setInsertNum(response.getInsertNum() + 1);
   }
 
-  onSegmentDataControl(processId, interest);
+  onSegmentDataControl(processId);
+}
+
+void
+WriteHandle::onSegmentDataValidationFailed(const Interest& interest,
+                                           const shared_ptr<const Data>& data,
+                                           const std::string& reason, ProcessId processId)
+{
+  std::cerr << reason << std::endl;
+
+  if (m_processes.count(processId) == 0) {
+    return;
+  }
+  ProcessInfo& process = m_processes[processId];
+  RepoCommandResponse& response = process.response;
+  SegmentTracker& segments = process.segments;
+
+  SegmentNo failedSegment = interest.getName().get(-1).toSegment();
+  process.window.onDiscard();
+
+  //the segment is not needed anymore, or was received from another interest
+  if (!segments.isPending(failedSegment) ||
+      (response.hasEndBlockId() && failedSegment > response.getEndBlockId())) {
+    segments.clearPending(failedSegment);
+    m_fetchScheduler.activate(processId);
+    dispatchSegments();
+    return;
+  }
+
+  retrySegment(processId, process, failedSegment, interest.getInterestLifetime());
 }
 
 void
@@ -217,60 +307,110 @@ void
 WriteHandle::segInit(ProcessId processId, const RepoCommandParameter& parameter)
 {
   ProcessInfo& process = m_processes[processId];
-  process.credit = 0;
-
-  map<SegmentNo, int>& processRetry = process.retryCounts;
-
-  Name name = parameter.getName();
-  SegmentNo startBlockId = parameter.getStartBlockId();
-
-  uint64_t initialCredit = m_credit;
-
-  if (parameter.hasEndBlockId()) {
-    initialCredit =
-      std::min(initialCredit, parameter.getEndBlockId() - parameter.getStartBlockId() + 1);
-  }
-  else {
+  m_fetchScheduler.addProcess(processId);
+  process.name = parameter.getName();
+  process.nextSegment = parameter.getStartBlockId();
+  process.window = FetchWindow(m_initialWindow, m_maxWindow, m_interestLifetime);
+  // twice the max window, so that a retrying segment does not block the window too soon
+  process.segments = SegmentTracker(process.nextSegment, 2 * m_maxWindow);
+
+  if (!parameter.hasEndBlockId()) {
     // set noEndTimeout timer
     process.noEndTime = ndn::time::steady_clock::now() +
                         m_noEndTimeout;
   }
-  process.credit = initialCredit;
-  SegmentNo segment = startBlockId;
 
-  for (; segment < startBlockId + initialCredit; ++segment) {
-    Name fetchName = name;
-    fetchName.appendSegment(segment);
-    Interest interest(fetchName);
-    interest.setInterestLifetime(m_interestLifetime);
-    getFace().expressInterest(interest,
-                              bind(&WriteHandle::onSegmentData, this, _1, _2, processId),
-                              bind(&WriteHandle::onSegmentTimeout, this, _1, processId));
-    process.credit--;
-    processRetry[segment] = 0;
+  updateRemaining(processId, process);
+  m_fetchScheduler.activate(processId);
+  dispatchSegments();
+}
+
+void
+WriteHandle::dispatchSegments()
+{
+  ProcessId processId;
+  while (m_fetchScheduler.next(processId)) {
+    map<ProcessId, ProcessInfo>::iterator it = m_processes.find(processId);
+    if (it == m_processes.end() || !sendNextSegment(processId, it->second))
+      m_fetchScheduler.deactivate(processId);
+  }
+}
+
+bool
+WriteHandle::sendNextSegment(ProcessId processId, ProcessInfo& process)
+{
+  RepoCommandResponse& response = process.response;
+
+  //process has ended, waiting for deletion
+  if (response.getStatusCode() != 300)
+    return false;
+
+  if (!process.window.canSend())
+    return false;
+
+  //retransmissions go before new segments
+  while (!process.retrySegments.empty()) {
+    SegmentNo segment = process.retrySegments.front();
+    process.retrySegments.pop();
+    if (!process.segments.isPending(segment))
+      continue;
+    if (response.hasEndBlockId() && segment > response.getEndBlockId()) {
+      process.segments.clearPending(segment);
+      continue;
+    }
+    sendSegmentInterest(processId, process, segment);
+    return true;
   }
 
-  queue<SegmentNo>& nextSegmentQueue = process.nextSegmentQueue;
+  //check whether next segment exceeds
+  if (response.hasEndBlockId() && process.nextSegment > response.getEndBlockId())
+    return false;
+
+  //wait for the oldest missing segment before going too far ahead
+  if (!process.segments.canTrack(process.nextSegment))
+    return false;
+
+  process.segments.markPending(process.nextSegment);
+  sendSegmentInterest(processId, process, process.nextSegment);
+  ++process.nextSegment;
+  updateRemaining(processId, process);
+  return true;
+}
 
-  process.nextSegment = segment;
-  nextSegmentQueue.push(segment);
+void
+WriteHandle::updateRemaining(ProcessId processId, const ProcessInfo& process)
+{
+  const RepoCommandResponse& response = process.response;
+  if (!response.hasEndBlockId())
+    return;
+  SegmentNo endBlockId = response.getEndBlockId();
+  m_fetchScheduler.setRemaining(processId, process.nextSegment > endBlockId ?
+                                           0 : endBlockId - process.nextSegment + 1);
 }
 
 void
-WriteHandle::onSegmentDataControl(ProcessId processId, const Interest& interest)
+WriteHandle::sendSegmentInterest(ProcessId processId, ProcessInfo& process, SegmentNo segment)
+{
+  Name fetchName = process.name;
+  fetchName.appendSegment(segment);
+  Interest fetchInterest(fetchName);
+  fetchInterest.setInterestLifetime(process.window.getRto());
+  getFace().expressInterest(fetchInterest,
+                            bind(&WriteHandle::onSegmentData, this, _1, _2, processId,
+                                 steady_clock::now()),
+                            bind(&WriteHandle::onSegmentTimeout, this, _1, processId));
+  process.window.onInterestSent();
+  m_fetchScheduler.onInterestSent(processId);
+}
+
+void
+WriteHandle::onSegmentDataControl(ProcessId processId)
 {
   if (m_processes.count(processId) == 0) {
     return;
   }
   ProcessInfo& process = m_processes[processId];
   RepoCommandResponse& response = process.response;
-  int& processCredit = process.credit;
-  //onSegmentDataControl is called when a data returns.
-  //When data returns, processCredit++
-  processCredit++;
-  SegmentNo& nextSegment = process.nextSegment;
-  queue<SegmentNo>& nextSegmentQueue = process.nextSegmentQueue;
-  map<SegmentNo, int>& retryCounts = process.retryCounts;
 
   //read whether notime timeout
   if (!response.hasEndBlockId()) {
@@ -285,76 +425,39 @@ WriteHandle::onSegmentDataControl(ProcessId processId, const Interest& interest)
       response.setStatusCode(405);
       //schedule a delete event
       deferredDeleteProcess(processId);
+      m_fetchScheduler.deactivate(processId);
+      dispatchSegments();
       return;
     }
   }
 
-  //read whether this process has total ends, if ends, remove control info from the maps
+  //read whether this process has total ends, i.e. every segment up to EndBlockId is received
   if (response.hasEndBlockId()) {
-    uint64_t nSegments =
-      response.getEndBlockId() - response.getStartBlockId() + 1;
-    if (response.getInsertNum() >= nSegments) {
+    if (process.segments.getBase() > response.getEndBlockId()) {
       //m_processes.erase(processId);
       //All the data has been inserted, StatusCode is refreshed as 200
+      if (response.getInsertNum() !=
+          response.getEndBlockId() - response.getStartBlockId() + 1) {
+        response.setStatusCode(400);
+        deferredDeleteProcess(processId);
+        m_fetchScheduler.deactivate(processId);
+        dispatchSegments();
+        return;
+      }
       response.setStatusCode(200);
+      // segments are moved in bounded steps by Repo::packObjects
+      if (m_packObjects)
+        getStorageHandle().addObjectToPack(process.name);
       deferredDeleteProcess(processId);
+      m_fetchScheduler.deactivate(processId);
+      dispatchSegments();
       return;
     }
   }
 
-  //check whether there is any credit
-  if (processCredit == 0)
-    return;
-
-
-  //check whether sent queue empty
-  if (nextSegmentQueue.empty()) {
-    //do not do anything
-    return;
-  }
-
-  //pop the queue
-  SegmentNo sendingSegment = nextSegmentQueue.front();
-  nextSegmentQueue.pop();
-
-  //check whether sendingSegment exceeds
-  if (response.hasEndBlockId() && sendingSegment > response.getEndBlockId()) {
-    //do not do anything
-    return;
-  }
-
-  //read whether this is retransmitted data;
-  SegmentNo fetchedSegment =
-    interest.getName().get(interest.getName().size() - 1).toSegment();
-
-  BOOST_ASSERT(retryCounts.count(fetchedSegment) != 0);
-
-  //find this fetched data, remove it from this map
-  //rit->second.erase(oit);
-  retryCounts.erase(fetchedSegment);
-  //express the interest of the top of the queue
-  Name fetchName(interest.getName().getPrefix(-1));
-  fetchName.appendSegment(sendingSegment);
-  Interest fetchInterest(fetchName);
-  fetchInterest.setInterestLifetime(m_interestLifetime);
-  getFace().expressInterest(fetchInterest,
-                            bind(&WriteHandle::onSegmentData, this, _1, _2, processId),
-                            bind(&WriteHandle::onSegmentTimeout, this, _1, processId));
-  //When an interest is expressed, processCredit--
-  processCredit--;
-  if (retryCounts.count(sendingSegment) == 0) {
-    //not found
-    retryCounts[sendingSegment] = 0;
-  }
-  else {
-    //found
-    retryCounts[sendingSegment] = retryCounts[sendingSegment] + 1;
-  }
-  //increase the next seg and put it into the queue
-  if (!response.hasEndBlockId() || (nextSegment + 1) <= response.getEndBlockId()) {
-    nextSegment++;
-    nextSegmentQueue.push(nextSegment);
-  }
+  updateRemaining(processId, process);
+  m_fetchScheduler.activate(processId);
+  dispatchSegments();
 }
 
 void
@@ -364,35 +467,51 @@ WriteHandle::onSegmentTimeoutControl(ProcessId processId, const Interest& intere
     return;
   }
   ProcessInfo& process = m_processes[processId];
-  // RepoCommandResponse& response = process.response;
-  // SegmentNo& nextSegment = process.nextSegment;
-  // queue<SegmentNo>& nextSegmentQueue = process.nextSegmentQueue;
-  map<SegmentNo, int>& retryCounts = process.retryCounts;
+  RepoCommandResponse& response = process.response;
+  SegmentTracker& segments = process.segments;
 
   SegmentNo timeoutSegment = interest.getName().get(-1).toSegment();
+  m_fetchScheduler.onInterestFinished(processId);
 
   std::cerr << "timeoutSegment: " << timeoutSegment << std::endl;
 
-  BOOST_ASSERT(retryCounts.count(timeoutSegment) != 0);
+  //segments beyond FinalBlockId were sent before it was known, do not retry them
+  if (response.hasEndBlockId() && timeoutSegment > response.getEndBlockId()) {
+    segments.clearPending(timeoutSegment);
+    process.window.onDiscard();
+    dispatchSegments();
+    return;
+  }
 
-  //read the retry time. If retry out of time, fail the process. if not, plus
-  int& retryTime = retryCounts[timeoutSegment];
-  if (retryTime >= m_retryTime) {
+  BOOST_ASSERT(segments.isPending(timeoutSegment));
+
+  process.window.onTimeout();
+
+  retrySegment(processId, process, timeoutSegment, interest.getInterestLifetime());
+}
+
+void
+WriteHandle::retrySegment(ProcessId processId, ProcessInfo& process, SegmentNo segment,
+                          const milliseconds& lifetime)
+{
+  SegmentTracker& segments = process.segments;
+
+  //the retry time is a time budget, as interest lifetime follows the RTO: with short
+  //lifetimes, a segment is retried more often before the process fails
+  segments.addWaitTime(segment, lifetime);
+  if (segments.getWaitTime(segment) >= m_interestLifetime * (m_retryTime + 1)) {
     //fail this process
     std::cerr << "Retry timeout: " << processId << std::endl;
-    m_processes.erase(processId);
+    deleteProcess(processId);
+    dispatchSegments();
     return;
   }
-  else {
-    //Reput it in the queue, retryTime++
-    retryTime++;
-    Interest retryInterest(interest.getName());
-    retryInterest.setInterestLifetime(m_interestLifetime);
-    getFace().expressInterest(retryInterest,
-                              bind(&WriteHandle::onSegmentData, this, _1, _2, processId),
-                              bind(&WriteHandle::onSegmentTimeout, this, _1, processId));
-  }
 
+  //resend it with backed off lifetime once the window and the scheduler allow
+  segments.incrementRetryCount(segment);
+  process.retrySegments.push(segment);
+  m_fetchScheduler.activate(processId);
+  dispatchSegments();
 }
 
 void
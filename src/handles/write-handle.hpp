@@ -21,6 +21,9 @@
 #define REPO_HANDLES_WRITE_HANDLE_HPP
 
 #include "base-handle.hpp"
+#include "fetch-scheduler.hpp"
+#include "fetch-window.hpp"
+#include "segment-tracker.hpp"
 
 #include <ndn-cxx/security/validator-config.hpp>
 
@@ -33,15 +36,20 @@ using std::pair;
 using std::queue;
 
 /**
- * @brief WriteHandle provides basic credit based congestion control.
+ * @brief WriteHandle provides window based congestion control.
  *
- * First repo sends interests of credit number and then credit will be 0.
+ * Each segmented insert process keeps its own FetchWindow. Repo first sends as many
+ * interests as the initial window allows.
  *
- * If a data comes, credit++ and sends a interest then credit--.
+ * If a data comes, the window grows (slow start, then additive increase) and repo sends
+ * interests for the next segments while the window allows.
  *
- * If the interest timeout, repo will retry and send interest in retrytimes.
+ * If the interest timeout, the window is halved and repo will retry in retrytimes.
+ * Interest lifetime follows the retransmission timeout estimated from RTT samples.
+ * Retransmissions wait for the window and the scheduler like other interests.
  *
- * If one interest timeout beyond retrytimes, the fetching process will terminate.
+ * If one segment has waited longer than retrytimes more interest lifetimes, the fetching
+ * process will terminate. Data failing validation counts as a timeout of its segment.
  *
  * Another case is that if command will insert segmented data without EndBlockId.
  *
@@ -52,6 +60,10 @@ using std::queue;
  * If client sends a insert check command, the noendTimeout timer will be set to 0.
  *
  * If repo cannot get FinalBlockId in noendTimeout time, the fetching process will terminate.
+ *
+ * All segmented insert processes share one FetchScheduler, which bounds the number of
+ * outstanding interests of the repo and hands free slots to processes in round robin,
+ * serving processes with few remaining segments first.
  */
 class WriteHandle : public BaseHandle
 {
@@ -75,20 +87,46 @@ public:
   virtual void
   listen(const Name& prefix);
 
+  /**
+   * @brief set initial and maximum congestion window of segmented insert processes
+   */
+  void
+  setWindowLimits(int initialWindow, int maxWindow);
+
+  /**
+   * @brief set repo-wide scheduling of segmented insert processes
+   * @param maxInFlight         limit of outstanding interests of all processes
+   * @param quantum             interests a process may send before the next process is served
+   * @param smallInsertSegments processes with no more remaining segments are served first
+   */
+  void
+  setSchedulerLimits(int maxInFlight, int quantum, int smallInsertSegments);
+
+  /**
+   * @brief enable packing of segments into one contiguous object when an insert completes
+   *
+   * Completed objects are queued in the storage, and moved by Repo::packObjects.
+   */
+  void
+  setObjectPacking(bool isEnabled)
+  {
+    m_packObjects = isEnabled;
+  }
+
 private:
   /**
   * @brief Information of insert process including variables for response
-  *        and credit based flow control
+  *        and window based congestion control
   */
   struct ProcessInfo
   {
     //ProcessId id;
     RepoCommandResponse response;
-    queue<SegmentNo> nextSegmentQueue;  ///< queue of waiting segment
-                                        ///  to be sent when having credits
-    SegmentNo nextSegment;  ///< last segment put into the nextSegmentQueue
-    map<SegmentNo, int> retryCounts;  ///< to store retrying times of timeout segment
-    int credit;  ///< congestion control credits of process
+    Name name;  ///< name prefix of segmented data
+    SegmentNo nextSegment;  ///< next segment to be sent when window allows
+    SegmentTracker segments;  ///< received, pending and retrying state of segments
+    FetchWindow window;  ///< congestion window and RTT estimation of process
+    queue<SegmentNo> retrySegments;  ///< pending segments to request again when allowed
 
     /**
      * @brief the latest time point at which EndBlockId must be determined
@@ -145,14 +183,23 @@ private:  // segmented data fetching
    * @brief fetch segmented data
    */
   void
-  onSegmentData(const Interest& interest, Data& data, ProcessId processId);
+  onSegmentData(const Interest& interest, Data& data, ProcessId processId,
+                const ndn::time::steady_clock::TimePoint& sendTime);
 
   void
   onSegmentDataValidated(const Interest& interest, const shared_ptr<const Data>& data,
-                         ProcessId processId);
+                         ProcessId processId, const ndn::time::milliseconds& rtt);
+
+  /**
+   * @brief validation of segmented data failed, the segment is requested again
+   */
+  void
+  onSegmentDataValidationFailed(const Interest& interest, const shared_ptr<const Data>& data,
+                                const std::string& reason, ProcessId processId);
 
   /**
-   * @brief Timeout when fetching segmented data. Data can be fetched RETRY_TIMEOUT times.
+   * @brief Timeout when fetching segmented data. A segment is requested again until it has
+   *        waited RETRY_TIMEOUT more Interest lifetimes than one Interest would.
    */
   void
   onSegmentTimeout(const Interest& interest, ProcessId processId);
@@ -167,7 +214,32 @@ private:  // segmented data fetching
    * @brief control for sending interests in function onSegmentData()
    */
   void
-  onSegmentDataControl(ProcessId processId, const Interest& interest);
+  onSegmentDataControl(ProcessId processId);
+
+  /**
+   * @brief express interests of active processes while the scheduler has free slots
+   */
+  void
+  dispatchSegments();
+
+  /**
+   * @brief express interest for the next segment of process if its window allows
+   * @return false if process cannot send now
+   */
+  bool
+  sendNextSegment(ProcessId processId, ProcessInfo& process);
+
+  /**
+   * @brief tell the scheduler how many segments process still has to request
+   */
+  void
+  updateRemaining(ProcessId processId, const ProcessInfo& process);
+
+  /**
+   * @brief express interest for one segment of process
+   */
+  void
+  sendSegmentInterest(ProcessId processId, ProcessInfo& process, SegmentNo segment);
 
   /**
    * @brief control for sending interest in function onSegmentTimeout
@@ -175,6 +247,15 @@ private:  // segmented data fetching
   void
   onSegmentTimeoutControl(ProcessId processId, const Interest& interest);
 
+  /**
+   * @brief queue a pending segment to be requested again through the scheduler,
+   *        or fail the process if the segment has used up its retry time
+   * @param lifetime  time the segment waited on its last Interest
+   */
+  void
+  retrySegment(ProcessId processId, ProcessInfo& process, SegmentNo segment,
+               const ndn::time::milliseconds& lifetime);
+
   void
   processSegmentedInsertCommand(const Interest& interest, RepoCommandParameter& parameter);
 
@@ -231,11 +312,14 @@ private:
   ValidatorConfig& m_validator;
 
   map<ProcessId, ProcessInfo> m_processes;
+  FetchScheduler m_fetchScheduler;
 
   int m_retryTime;
-  int m_credit;
+  int m_initialWindow;
+  int m_maxWindow;
   ndn::time::milliseconds m_noEndTimeout;
   ndn::time::milliseconds m_interestLifetime;
+  bool m_packObjects;
 };
 
 } // namespace repo
@@ -56,6 +56,8 @@ public:
     , m_hasProcessId(false)
     , m_hasInsertNum(false)
     , m_hasDeleteNum(false)
+    , m_hasDataNum(false)
+    , m_hasDataSize(false)
     , m_hasStatusCode(false)
   {
   }
@@ -194,6 +196,48 @@ public:
     return m_hasDeleteNum;
   }
 
+  uint64_t
+  getDataNum() const
+  {
+    return m_dataNum;
+  }
+
+  RepoCommandResponse&
+  setDataNum(uint64_t dataNum)
+  {
+    m_dataNum = dataNum;
+    m_hasDataNum = true;
+    m_wire.reset();
+    return *this;
+  }
+
+  bool
+  hasDataNum() const
+  {
+    return m_hasDataNum;
+  }
+
+  uint64_t
+  getDataSize() const
+  {
+    return m_dataSize;
+  }
+
+  RepoCommandResponse&
+  setDataSize(uint64_t dataSize)
+  {
+    m_dataSize = dataSize;
+    m_hasDataSize = true;
+    m_wire.reset();
+    return *this;
+  }
+
+  bool
+  hasDataSize() const
+  {
+    return m_hasDataSize;
+  }
+
   template<bool T>
   size_t
   wireEncode(EncodingImpl<T>& block) const;
@@ -211,12 +255,16 @@ private:
   uint64_t m_processId;
   uint64_t m_insertNum;
   uint64_t m_deleteNum;
+  uint64_t m_dataNum;
+  uint64_t m_dataSize;
 
   bool m_hasStartBlockId;
   bool m_hasEndBlockId;
   bool m_hasProcessId;
   bool m_hasInsertNum;
   bool m_hasDeleteNum;
+  bool m_hasDataNum;
+  bool m_hasDataSize;
   bool m_hasStatusCode;
 
   mutable Block m_wire;
@@ -229,6 +277,20 @@ RepoCommandResponse::wireEncode(EncodingImpl<T>& encoder) const
   size_t totalLength = 0;
   size_t variableLength = 0;
 
+  if (m_hasDataSize) {
+    variableLength = encoder.prependNonNegativeInteger(m_dataSize);
+    totalLength += variableLength;
+    totalLength += encoder.prependVarNumber(variableLength);
+    totalLength += encoder.prependVarNumber(tlv::DataSize);
+  }
+
+  if (m_hasDataNum) {
+    variableLength = encoder.prependNonNegativeInteger(m_dataNum);
+    totalLength += variableLength;
+    totalLength += encoder.prependVarNumber(variableLength);
+    totalLength += encoder.prependVarNumber(tlv::DataNum);
+  }
+
   if (m_hasDeleteNum) {
     variableLength = encoder.prependNonNegativeInteger(m_deleteNum);
     totalLength += variableLength;
@@ -303,6 +365,8 @@ RepoCommandResponse::wireDecode(const Block& wire)
   m_hasStatusCode = false;
   m_hasInsertNum = false;
   m_hasDeleteNum = false;
+  m_hasDataNum = false;
+  m_hasDataSize = false;
 
   m_wire = wire;
 
@@ -363,6 +427,22 @@ RepoCommandResponse::wireDecode(const Block& wire)
     m_hasDeleteNum = true;
     m_deleteNum = readNonNegativeInteger(*val);
   }
+
+  // DataNum
+  val = m_wire.find(tlv::DataNum);
+  if (val != m_wire.elements_end())
+  {
+    m_hasDataNum = true;
+    m_dataNum = readNonNegativeInteger(*val);
+  }
+
+  // DataSize
+  val = m_wire.find(tlv::DataSize);
+  if (val != m_wire.elements_end())
+  {
+    m_hasDataSize = true;
+    m_dataSize = readNonNegativeInteger(*val);
+  }
 }
 
 inline std::ostream&
@@ -389,6 +469,12 @@ operator<<(std::ostream& os, const RepoCommandResponse& repoCommandResponse)
     os << " DeleteNum: " << repoCommandResponse.getDeleteNum();
 
   }
+  if (repoCommandResponse.hasDataNum()) {
+    os << " DataNum: " << repoCommandResponse.getDataNum();
+  }
+  if (repoCommandResponse.hasDataSize()) {
+    os << " DataSize: " << repoCommandResponse.getDataSize();
+  }
   os << " )";
   return os;
 }
@@ -37,7 +37,9 @@ enum {
   InsertNum            = 209,
   DeleteNum            = 210,
   MaxInterestNum       = 211,
-  WatchTimeout         = 212
+  WatchTimeout         = 212,
+  DataNum              = 213,
+  DataSize             = 214
 };
 
 } // tlv
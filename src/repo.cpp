@@ -19,8 +19,22 @@
 
 #include "repo.hpp"
 #include "storage/sqlite-storage.hpp"
+#include "storage/sharded-storage.hpp"
 namespace repo {
 
+static bool
+parseYesNo(const boost::property_tree::ptree::value_type& option,
+           const std::string& sectionName, const std::string& configPath)
+{
+  std::string value = option.second.get_value<std::string>();
+  if (value == "yes" || value == "true")
+    return true;
+  if (value == "no" || value == "false")
+    return false;
+  throw Repo::Error("Invalid value '" + value + "' for option '" + option.first + "' in '" +
+                    sectionName + "' section in configuration file '" + configPath + "'");
+}
+
 RepoConfig
 parseConfig(const std::string& configPath)
 {
@@ -107,8 +121,359 @@ parseConfig(const std::string& configPath)
 
   repoConfig.nMaxPackets = repoConf.get<int>("storage.max-packets");
 
+  repoConfig.dedupMinSize = repoConf.get<size_t>("storage.dedup-min-size", 0);
+
+  repoConfig.lookupFilterSize = repoConf.get<size_t>("storage.lookup-filter-size", 0);
+  repoConfig.usageDepth = repoConf.get<size_t>("storage.usage-depth", 0);
+
+  // storage {
+  //   shards {
+  //     path "/mnt/disk1/ndn-repo-ng"  ; Data spread with storage.path by hash of name
+  //     prefix {
+  //       name "ndn:/example/data/1"
+  //       path "/mnt/disk2/ndn-repo-ng"
+  //     }
+  //   }
+  // }
+  // storage {
+  //   maintenance {  ; omitted, checkpoints are left to sqlite
+  //     interval 1  ; seconds between checkpoints, 0 leaves them to sqlite
+  //     wal-truncate-size 67108864  ; log is truncated once larger
+  //     vacuum-pages 1024  ; free pages returned to the file system per run
+  //     checkpoint-pages 128  ; pages a checkpoint writes between pauses, 0 never pauses
+  //     checkpoint-pause 10  ; milliseconds of each pause
+  //   }
+  // }
+  repoConfig.maintenanceInterval = milliseconds::zero();
+  repoConfig.walTruncateSize = 64 * 1024 * 1024;
+  repoConfig.vacuumPages = 1024;
+  repoConfig.checkpointPages = 128;
+  repoConfig.checkpointPause = milliseconds(10);
+  boost::optional<ptree&> maintenanceConf =
+    repoConf.get_child_optional("storage.maintenance");
+  if (maintenanceConf) {
+    repoConfig.maintenanceInterval = seconds(1);
+    for (ptree::const_iterator it = maintenanceConf->begin();
+         it != maintenanceConf->end();
+         ++it)
+    {
+      if (it->first == "interval")
+        repoConfig.maintenanceInterval = milliseconds(it->second.get_value<uint64_t>() * 1000);
+      else if (it->first == "wal-truncate-size")
+        repoConfig.walTruncateSize = it->second.get_value<uint64_t>();
+      else if (it->first == "vacuum-pages")
+        repoConfig.vacuumPages = it->second.get_value<size_t>();
+      else if (it->first == "checkpoint-pages")
+        repoConfig.checkpointPages = it->second.get_value<size_t>();
+      else if (it->first == "checkpoint-pause")
+        repoConfig.checkpointPause = milliseconds(it->second.get_value<uint64_t>());
+      else
+        throw Repo::Error("Unrecognized '" + it->first + "' option in 'storage.maintenance' "
+                          "section in configuration file '"+ configPath +"'");
+    }
+  }
+
+  // storage {
+  //   index {
+  //     path "/var/db/ndn-repo-ng-index"  ; index kept on disk instead of in memory
+  //     cache-pages 16384  ; index pages of 64 entries kept in memory
+  //   }
+  // }
+  repoConfig.indexCachePages = 16384;
+  boost::optional<ptree&> indexConf = repoConf.get_child_optional("storage.index");
+  if (indexConf) {
+    for (ptree::const_iterator it = indexConf->begin();
+         it != indexConf->end();
+         ++it)
+    {
+      if (it->first == "path")
+        repoConfig.indexPath = it->second.get_value<std::string>();
+      else if (it->first == "cache-pages")
+        repoConfig.indexCachePages = it->second.get_value<size_t>();
+      else
+        throw Repo::Error("Unrecognized '" + it->first + "' option in 'storage.index' "
+                          "section in configuration file '"+ configPath +"'");
+    }
+    if (repoConfig.indexPath.empty())
+      throw Repo::Error("'storage.index' section requires 'path' option "
+                        "in configuration file '"+ configPath +"'");
+  }
+
+  boost::optional<ptree&> shardsConf = repoConf.get_child_optional("storage.shards");
+  if (shardsConf) {
+    for (ptree::const_iterator it = shardsConf->begin();
+         it != shardsConf->end();
+         ++it)
+    {
+      if (it->first == "path") {
+        repoConfig.shardPaths.push_back(it->second.get_value<std::string>());
+        continue;
+      }
+      if (it->first != "prefix")
+        throw Repo::Error("Unrecognized '" + it->first + "' option in 'storage.shards' "
+                          "section in configuration file '"+ configPath +"'");
+
+      boost::optional<std::string> name = it->second.get_optional<std::string>("name");
+      boost::optional<std::string> path = it->second.get_optional<std::string>("path");
+      if (!name || !path)
+        throw Repo::Error("'storage.shards.prefix' section requires 'name' and 'path' options "
+                          "in configuration file '"+ configPath +"'");
+      repoConfig.shardPrefixes.push_back(std::make_pair(Name(*name), *path));
+    }
+  }
+
   repoConfig.syncPrefix = repoConf.get<std::string>("syncPrefix");
 
+  // insert {
+  //   initial-window 12  ; interests expressed when a segmented insert starts
+  //   max-window 256  ; upper bound of congestion window of each insert process
+  //   max-in-flight 512  ; outstanding interests of all insert processes
+  //   quantum 8  ; interests an insert process sends before the next one is served
+  //   small-insert-segments 64  ; inserts with fewer remaining segments go first
+  //   pack-objects yes  ; store completed segmented inserts contiguously
+  // }
+  repoConfig.insertInitialWindow = 12;
+  repoConfig.insertMaxWindow = 256;
+  repoConfig.insertMaxInFlight = 512;
+  repoConfig.insertQuantum = 8;
+  repoConfig.insertSmallSegments = 64;
+  repoConfig.insertPackObjects = false;
+  boost::optional<ptree&> insertConf = repoConf.get_child_optional("insert");
+  if (insertConf) {
+    for (ptree::const_iterator it = insertConf->begin();
+         it != insertConf->end();
+         ++it)
+    {
+      if (it->first == "initial-window")
+        repoConfig.insertInitialWindow = it->second.get_value<int>();
+      else if (it->first == "max-window")
+        repoConfig.insertMaxWindow = it->second.get_value<int>();
+      else if (it->first == "max-in-flight")
+        repoConfig.insertMaxInFlight = it->second.get_value<int>();
+      else if (it->first == "quantum")
+        repoConfig.insertQuantum = it->second.get_value<int>();
+      else if (it->first == "small-insert-segments")
+        repoConfig.insertSmallSegments = it->second.get_value<int>();
+      else if (it->first == "pack-objects")
+        repoConfig.insertPackObjects = parseYesNo(*it, "insert", configPath);
+      else
+        throw Repo::Error("Unrecognized '" + it->first + "' option in 'insert' section in "
+                          "configuration file '"+ configPath +"'");
+    }
+  }
+
+  // watch {
+  //   pipeline-depth 8  ; interests kept outstanding by each watch process
+  // }
+  repoConfig.watchPipelineDepth = 1;
+  boost::optional<ptree&> watchConf = repoConf.get_child_optional("watch");
+  if (watchConf) {
+    for (ptree::const_iterator it = watchConf->begin();
+         it != watchConf->end();
+         ++it)
+    {
+      if (it->first == "pipeline-depth")
+        repoConfig.watchPipelineDepth = it->second.get_value<int>();
+      else
+        throw Repo::Error("Unrecognized '" + it->first + "' option in 'watch' section in "
+                          "configuration file '"+ configPath +"'");
+    }
+  }
+
+  // read {
+  //   read-ahead 64  ; most segments read ahead of a consumer, 0 disables read-ahead
+  //   cache-packets 2048  ; Data read ahead kept in memory
+  // }
+  repoConfig.readAheadDepth = 64;
+  repoConfig.readCachePackets = 2048;
+  boost::optional<ptree&> readConf = repoConf.get_child_optional("read");
+  if (readConf) {
+    for (ptree::const_iterator it = readConf->begin();
+         it != readConf->end();
+         ++it)
+    {
+      if (it->first == "read-ahead")
+        repoConfig.readAheadDepth = it->second.get_value<size_t>();
+      else if (it->first == "cache-packets")
+        repoConfig.readCachePackets = it->second.get_value<size_t>();
+      else
+        throw Repo::Error("Unrecognized '" + it->first + "' option in 'read' section in "
+                          "configuration file '"+ configPath +"'");
+    }
+  }
+
+  // signing {
+  //   method "digest-sha256"  ; "default", "identity" or "digest-sha256"
+  //   identity "/example/repo"  ; required by "identity"
+  //   cache-sync-replies yes
+  // }
+  boost::optional<ptree&> signingConf = repoConf.get_child_optional("signing");
+  if (signingConf) {
+    for (ptree::const_iterator it = signingConf->begin();
+         it != signingConf->end();
+         ++it)
+    {
+      if (it->first == "method") {
+        std::string method = it->second.get_value<std::string>();
+        if (method == "default")
+          repoConfig.signingPolicy.method = SigningPolicy::SIGN_WITH_DEFAULT_IDENTITY;
+        else if (method == "identity")
+          repoConfig.signingPolicy.method = SigningPolicy::SIGN_WITH_IDENTITY;
+        else if (method == "digest-sha256")
+          repoConfig.signingPolicy.method = SigningPolicy::SIGN_WITH_DIGEST_SHA256;
+        else
+          throw Repo::Error("Unrecognized signing method '" + method + "' in "
+                            "configuration file '"+ configPath +"'");
+      }
+      else if (it->first == "identity") {
+        repoConfig.signingPolicy.identity = Name(it->second.get_value<std::string>());
+      }
+      else if (it->first == "cache-sync-replies") {
+        repoConfig.signingPolicy.shouldCacheSyncReplies = parseYesNo(*it, "signing", configPath);
+      }
+      else
+        throw Repo::Error("Unrecognized '" + it->first + "' option in 'signing' section in "
+                          "configuration file '"+ configPath +"'");
+    }
+    if (repoConfig.signingPolicy.method == SigningPolicy::SIGN_WITH_IDENTITY &&
+        repoConfig.signingPolicy.identity.empty())
+      throw Repo::Error("Signing method 'identity' requires 'identity' option in "
+                        "configuration file '"+ configPath +"'");
+  }
+
+  // quota {
+  //   prefix {
+  //     name "ndn:/example/data/1"
+  //     max-packets 100000
+  //     max-bytes 1000000000
+  //     policy "evict-oldest"  ; "reject", "evict-oldest" or "evict-lru"
+  //   }
+  // }
+  boost::optional<ptree&> quotaConf = repoConf.get_child_optional("quota");
+  if (quotaConf) {
+    for (ptree::const_iterator it = quotaConf->begin();
+         it != quotaConf->end();
+         ++it)
+    {
+      if (it->first != "prefix")
+        throw Repo::Error("Unrecognized '" + it->first + "' option in 'quota' section in "
+                          "configuration file '"+ configPath +"'");
+
+      Quota quota;
+      bool hasName = false;
+      for (ptree::const_iterator option = it->second.begin();
+           option != it->second.end();
+           ++option)
+      {
+        if (option->first == "name") {
+          quota.prefix = Name(option->second.get_value<std::string>());
+          hasName = true;
+        }
+        else if (option->first == "max-packets")
+          quota.maxPackets = option->second.get_value<uint64_t>();
+        else if (option->first == "max-bytes")
+          quota.maxBytes = option->second.get_value<uint64_t>();
+        else if (option->first == "policy") {
+          std::string policy = option->second.get_value<std::string>();
+          if (policy == "reject")
+            quota.policy = Quota::REJECT;
+          else if (policy == "evict-oldest")
+            quota.policy = Quota::EVICT_OLDEST;
+          else if (policy == "evict-lru")
+            quota.policy = Quota::EVICT_LRU;
+          else
+            throw Repo::Error("Unrecognized quota policy '" + policy + "' in "
+                              "configuration file '"+ configPath +"'");
+        }
+        else
+          throw Repo::Error("Unrecognized '" + option->first + "' option in 'quota.prefix' "
+                            "section in configuration file '"+ configPath +"'");
+      }
+      if (!hasName)
+        throw Repo::Error("'quota.prefix' section requires 'name' option in "
+                          "configuration file '"+ configPath +"'");
+      repoConfig.quotas.push_back(quota);
+    }
+  }
+
+  // retention {
+  //   prefix {
+  //     name "ndn:/example/data/2"
+  //     max-age 86400  ; seconds Data are kept after insertion
+  //   }
+  // }
+  boost::optional<ptree&> retentionConf = repoConf.get_child_optional("retention");
+  if (retentionConf) {
+    for (ptree::const_iterator it = retentionConf->begin();
+         it != retentionConf->end();
+         ++it)
+    {
+      if (it->first != "prefix")
+        throw Repo::Error("Unrecognized '" + it->first + "' option in 'retention' section in "
+                          "configuration file '"+ configPath +"'");
+
+      boost::optional<std::string> name = it->second.get_optional<std::string>("name");
+      boost::optional<uint64_t> maxAge = it->second.get_optional<uint64_t>("max-age");
+      if (!name || !maxAge)
+        throw Repo::Error("'retention.prefix' section requires 'name' and 'max-age' options in "
+                          "configuration file '"+ configPath +"'");
+      repoConfig.retentions.push_back(std::make_pair(Name(*name),
+                                                     milliseconds(*maxAge * 1000)));
+    }
+  }
+
+  // compression {
+  //   prefix {
+  //     name "ndn:/example/data/3"
+  //     level 6  ; zlib level, 1 (fastest) to 9 (smallest)
+  //     dictionary "/usr/local/etc/ndn/data-3.dict"  ; optional preset dictionary
+  //   }
+  // }
+  boost::optional<ptree&> compressionConf = repoConf.get_child_optional("compression");
+  if (compressionConf) {
+    if (!Compression::isSupported())
+      throw Repo::Error("'compression' section requires repo-ng built with zlib, in "
+                        "configuration file '"+ configPath +"'");
+    for (ptree::const_iterator it = compressionConf->begin();
+         it != compressionConf->end();
+         ++it)
+    {
+      if (it->first != "prefix")
+        throw Repo::Error("Unrecognized '" + it->first + "' option in 'compression' section in "
+                          "configuration file '"+ configPath +"'");
+
+      boost::optional<std::string> name;
+      int level = 6;
+      std::string dictionary;
+      for (ptree::const_iterator option = it->second.begin();
+           option != it->second.end();
+           ++option)
+      {
+        if (option->first == "name")
+          name = option->second.get_value<std::string>();
+        else if (option->first == "level")
+          level = option->second.get_value<int>();
+        else if (option->first == "dictionary")
+          dictionary = option->second.get_value<std::string>();
+        else
+          throw Repo::Error("Unrecognized '" + option->first + "' option in "
+                            "'compression.prefix' section in configuration file '" +
+                            configPath + "'");
+      }
+      if (!name)
+        throw Repo::Error("'compression.prefix' section requires 'name' option in "
+                          "configuration file '"+ configPath +"'");
+      try {
+        repoConfig.compression.addPrefix(Name(*name), level,
+                                         dictionary.empty() ? dictionary :
+                                           Compression::readDictionary(dictionary));
+      }
+      catch (Compression::Error& e) {
+        throw Repo::Error(std::string(e.what()) + " in configuration file '" + configPath + "'");
+      }
+    }
+  }
+
   std::string str = repoConf.get<std::string>("creatorName");
 
   repoConfig.creatorName = Name(str).appendNumber(ndn::random::generateWord64());
@@ -116,18 +481,57 @@ parseConfig(const std::string& configPath)
   return repoConfig;
 }
 
+/**
+ * @brief open the database at dbPath, or every shard if shards are configured
+ */
+static shared_ptr<Storage>
+makeStorage(const RepoConfig& config)
+{
+  if (config.shardPaths.empty() && config.shardPrefixes.empty())
+    return make_shared<SqliteStorage>(config.dbPath, config.dedupMinSize, config.compression);
+
+  shared_ptr<ShardedStorage> storage = make_shared<ShardedStorage>();
+  std::map<std::string, size_t> shards;
+  shards[config.dbPath] =
+    storage->addShard(make_shared<SqliteStorage>(config.dbPath, config.dedupMinSize,
+                                                 config.compression), true);
+  for (vector<std::string>::const_iterator it = config.shardPaths.begin();
+       it != config.shardPaths.end(); ++it) {
+    if (shards.count(*it) == 0)
+      shards[*it] =
+        storage->addShard(make_shared<SqliteStorage>(*it, config.dedupMinSize,
+                                                     config.compression), true);
+  }
+  for (vector<pair<Name, std::string> >::const_iterator it = config.shardPrefixes.begin();
+       it != config.shardPrefixes.end(); ++it) {
+    if (shards.count(it->second) == 0)
+      shards[it->second] =
+        storage->addShard(make_shared<SqliteStorage>(it->second, config.dedupMinSize,
+                                                     config.compression), false);
+    storage->addPrefix(it->first, shards[it->second]);
+  }
+  return storage;
+}
+
 static void
 generateAction(RepoSync* sync, const Name& name, const std::string action)
 {
   sync->insertAction(name, action);
 }
 
+static void
+runService(boost::asio::io_service* ioService)
+{
+  ioService->run();
+}
+
 Repo::Repo(boost::asio::io_service& ioService, const RepoConfig& config)
   : m_config(config)
+  , m_ioService(ioService)
   , m_scheduler(ioService)
   , m_face(ioService)
-  , m_store(make_shared<SqliteStorage>(config.dbPath))
-  , m_storageHandle(config.nMaxPackets, *m_store)
+  , m_store(makeStorage(config))
+  , m_storageHandle(config.nMaxPackets, *m_store, config.indexPath, config.indexCachePages)
   , m_validator(m_face)
   , m_sync(config.syncPrefix, config.creatorName, config.dbPath,
            m_face, m_keyChain, m_validator, m_storageHandle)
@@ -138,11 +542,68 @@ Repo::Repo(boost::asio::io_service& ioService, const RepoConfig& config)
                   bind(&generateAction, &m_sync, _1, _2))
   , m_deleteHandle(m_face, m_storageHandle, m_keyChain, m_scheduler, m_validator,
                    bind(&generateAction, &m_sync, _1, _2))
+  , m_statusHandle(m_face, m_storageHandle, m_keyChain, m_scheduler, m_validator)
   , m_tcpBulkInsertHandle(ioService, m_storageHandle, bind(&generateAction, &m_sync, _1, _2))
 
 {
   m_validator.load(config.validatorNode, config.repoConfigPath);
-  m_scheduler.scheduleEvent(seconds(50), bind(&Repo::removeIndexEntry, this));
+
+  m_sync.setSigningPolicy(config.signingPolicy);
+  m_readHandle.setSigningPolicy(config.signingPolicy);
+  m_writeHandle.setSigningPolicy(config.signingPolicy);
+  m_watchHandle.setSigningPolicy(config.signingPolicy);
+  m_deleteHandle.setSigningPolicy(config.signingPolicy);
+  m_statusHandle.setSigningPolicy(config.signingPolicy);
+
+  m_writeHandle.setWindowLimits(config.insertInitialWindow, config.insertMaxWindow);
+  m_writeHandle.setSchedulerLimits(config.insertMaxInFlight, config.insertQuantum,
+                                   config.insertSmallSegments);
+  m_writeHandle.setObjectPacking(config.insertPackObjects);
+  m_watchHandle.setPipelineDepth(config.watchPipelineDepth);
+  m_readHandle.setReadAhead(config.readAheadDepth, config.readCachePackets);
+
+  m_storageHandle.setLookupFilter(config.lookupFilterSize);
+
+  // quotas are checked often, so their prefixes keep counters
+  size_t usageDepth = config.usageDepth;
+  for (vector<Quota>::const_iterator it = config.quotas.begin();
+       it != config.quotas.end();
+       ++it)
+    {
+      m_storageHandle.addQuota(*it);
+      if (usageDepth > 0)
+        usageDepth = std::max(usageDepth, it->prefix.size());
+    }
+  m_storageHandle.setUsageDepth(usageDepth);
+
+  for (vector<pair<Name, milliseconds> >::const_iterator it = config.retentions.begin();
+       it != config.retentions.end();
+       ++it)
+    {
+      m_storageHandle.addRetention(it->first, it->second);
+    }
+
+  m_scheduler.scheduleEvent(seconds(1), bind(&Repo::removeIndexEntry, this));
+  if (!config.quotas.empty())
+    m_scheduler.scheduleEvent(seconds(1), bind(&Repo::evictOverQuota, this));
+  // Data inserted before a retention was removed from the configuration still expire
+  m_scheduler.scheduleEvent(seconds(1), bind(&Repo::removeExpiredData, this));
+  if (config.insertPackObjects)
+    m_scheduler.scheduleEvent(seconds(1), bind(&Repo::packObjects, this));
+  if (config.maintenanceInterval > milliseconds::zero()) {
+    m_maintenanceWork.reset(new boost::asio::io_service::work(m_maintenanceService));
+    m_maintenanceThread = boost::thread(bind(&runService, &m_maintenanceService));
+    m_scheduler.scheduleEvent(config.maintenanceInterval, bind(&Repo::maintainStorage, this));
+  }
+}
+
+Repo::~Repo()
+{
+  // the step in progress finishes before the storage is closed, later steps do not start
+  m_maintenanceWork.reset();
+  m_maintenanceService.stop();
+  if (m_maintenanceThread.joinable())
+    m_maintenanceThread.join();
 }
 
 void
@@ -175,6 +636,7 @@ Repo::enableListening()
       m_writeHandle.listen(*it);
       m_watchHandle.listen(*it);
       m_deleteHandle.listen(*it);
+      m_statusHandle.listen(*it);
       m_sync.listen(*it);
     }
 
@@ -196,8 +658,131 @@ Repo::enableValidation()
 void
 Repo::removeIndexEntry()
 {
-  m_storageHandle.removeDeletedEntry();
-  m_scheduler.scheduleEvent(seconds(50), bind(&Repo::removeIndexEntry, this));
+  // entries stay DELETED for at least the former purge period
+  static const seconds GRACE_PERIOD = seconds(50);
+  static const size_t REMOVAL_BATCH = 1000;
+
+  size_t nVisited = m_storageHandle.removeDeletedEntries(GRACE_PERIOD, REMOVAL_BATCH);
+  if (nVisited == REMOVAL_BATCH)
+    m_scheduler.scheduleEvent(milliseconds(10), bind(&Repo::removeIndexEntry, this));
+  else
+    m_scheduler.scheduleEvent(seconds(1), bind(&Repo::removeIndexEntry, this));
+}
+
+void
+Repo::evictOverQuota()
+{
+  static const size_t EVICTION_BATCH = 256;
+
+  size_t nEvicted = m_storageHandle.evictOverQuota(EVICTION_BATCH,
+                                                   bind(&generateAction, &m_sync, _1, _2));
+  // come back soon while a quota is still exceeded, keeping each run short
+  if (nEvicted == EVICTION_BATCH)
+    m_scheduler.scheduleEvent(milliseconds(10), bind(&Repo::evictOverQuota, this));
+  else
+    m_scheduler.scheduleEvent(seconds(1), bind(&Repo::evictOverQuota, this));
+}
+
+void
+Repo::removeExpiredData()
+{
+  static const size_t REMOVAL_BATCH = 1000;
+
+  size_t nRemoved = m_storageHandle.removeExpiredData(REMOVAL_BATCH,
+                                                      bind(&generateAction, &m_sync, _1, _2));
+  if (nRemoved == REMOVAL_BATCH)
+    m_scheduler.scheduleEvent(milliseconds(10), bind(&Repo::removeExpiredData, this));
+  else
+    m_scheduler.scheduleEvent(seconds(1), bind(&Repo::removeExpiredData, this));
+}
+
+void
+Repo::packObjects()
+{
+  // about 2 MB of segments are read and written again in each run
+  static const size_t PACKING_BATCH = 256;
+
+  size_t nVisited = m_storageHandle.packObjects(PACKING_BATCH);
+  if (nVisited >= PACKING_BATCH)
+    m_scheduler.scheduleEvent(milliseconds(10), bind(&Repo::packObjects, this));
+  else
+    m_scheduler.scheduleEvent(seconds(1), bind(&Repo::packObjects, this));
+}
+
+void
+Repo::maintainStorage()
+{
+  try {
+    m_store->prepareMaintenance();
+  }
+  catch (std::runtime_error& e) {
+    onStorageMaintained(Storage::MaintenanceStatus(), e.what());
+    return;
+  }
+  m_maintenanceService.post(bind(&Repo::runStorageMaintenance, this));
+}
+
+void
+Repo::runStorageMaintenance()
+{
+  Storage::MaintenanceStatus status;
+  std::string error;
+  try {
+    status = m_store->maintain(m_config.checkpointPages, m_config.checkpointPause);
+  }
+  catch (std::runtime_error& e) {
+    error = e.what();
+  }
+  m_ioService.post(bind(&Repo::onStorageMaintained, this, status, error));
+}
+
+void
+Repo::onStorageMaintained(const Storage::MaintenanceStatus& status, const std::string& error)
+{
+  if (!error.empty())
+    std::cerr << "storage maintenance failed: " << error << std::endl;
+
+  if (status.walSize > m_config.walTruncateSize ||
+      (m_config.vacuumPages > 0 && status.nFreePages > 0))
+    reclaimStorageSpace(0);
+  else
+    m_scheduler.scheduleEvent(m_config.maintenanceInterval, bind(&Repo::maintainStorage, this));
+}
+
+void
+Repo::reclaimStorageSpace(size_t nReclaimed)
+{
+  // runs on this thread since it holds the write lock of the database; inserts go on
+  // between batches
+  static const size_t VACUUM_BATCH = 64;
+
+  Storage::MaintenanceStatus status;
+  try {
+    status = m_store->reclaimSpace(m_config.walTruncateSize,
+                                   std::min(VACUUM_BATCH, m_config.vacuumPages - nReclaimed));
+  }
+  catch (std::runtime_error& e) {
+    std::cerr << "storage maintenance failed: " << e.what() << std::endl;
+  }
+  nReclaimed += status.nReclaimedPages;
+  if (status.nReclaimedPages > 0 && status.nFreePages > 0 &&
+      nReclaimed < m_config.vacuumPages) {
+    m_scheduler.scheduleEvent(milliseconds(10),
+                              bind(&Repo::reclaimStorageSpace, this, nReclaimed));
+    return;
+  }
+
+  if (nReclaimed > 0)
+    std::cerr << "storage maintenance: WAL " << status.walSize << " bytes, "
+              << status.nFreePages << " free pages, "
+              << nReclaimed << " pages reclaimed" << std::endl;
+
+  // come back soon while free pages are left after a full batch, keeping each run short
+  if (nReclaimed >= m_config.vacuumPages && status.nFreePages > 0)
+    m_scheduler.scheduleEvent(std::min(m_config.maintenanceInterval, milliseconds(100)),
+                              bind(&Repo::maintainStorage, this));
+  else
+    m_scheduler.scheduleEvent(m_config.maintenanceInterval, bind(&Repo::maintainStorage, this));
 }
 
 } // namespace repo
@@ -28,6 +28,7 @@
 #include "handles/write-handle.hpp"
 #include "handles/watch-handle.hpp"
 #include "handles/delete-handle.hpp"
+#include "handles/status-handle.hpp"
 #include "handles/tcp-bulk-insert-handle.hpp"
 #include "sync/repo-sync.hpp"
 
@@ -35,6 +36,7 @@
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/info_parser.hpp>
+#include <boost/thread/thread.hpp>
 
 namespace repo {
 
@@ -51,9 +53,34 @@ struct RepoConfig
   vector<ndn::Name> repoPrefixes;
   vector<pair<string, string> > tcpBulkInsertEndpoints;
   int64_t nMaxPackets;
+  size_t dedupMinSize;
+  size_t lookupFilterSize;
+  size_t usageDepth;
+  vector<std::string> shardPaths;
+  vector<pair<Name, std::string> > shardPrefixes;
+  ndn::time::milliseconds maintenanceInterval;
+  uint64_t walTruncateSize;
+  size_t vacuumPages;
+  size_t checkpointPages;
+  ndn::time::milliseconds checkpointPause;
+  std::string indexPath;
+  size_t indexCachePages;
   boost::property_tree::ptree validatorNode;
   std::string syncPrefix;
   Name creatorName;
+  SigningPolicy signingPolicy;
+  int insertInitialWindow;
+  int insertMaxWindow;
+  int insertMaxInFlight;
+  int insertQuantum;
+  int insertSmallSegments;
+  bool insertPackObjects;
+  int watchPipelineDepth;
+  size_t readAheadDepth;
+  size_t readCachePackets;
+  vector<Quota> quotas;
+  vector<pair<Name, ndn::time::milliseconds> > retentions;
+  Compression compression;
 };
 
 RepoConfig
@@ -75,6 +102,11 @@ public:
 public:
   Repo(boost::asio::io_service& ioService, const RepoConfig& config);
 
+  /**
+   * @brief  wait for a storage maintenance step in progress
+   */
+  ~Repo();
+
   //@brief rebuild index from storage file when repo starts.
   void
   initializeStorage();
@@ -86,13 +118,61 @@ public:
   enableValidation();
 
   /**
-   * @brief  periodically trigger the index to remove the entry with Deleted flag
+   * @brief  periodically trigger the index to remove the entry with Deleted flag,
+   *         a batch of the earliest deleted entries at a time
    */
   void
   removeIndexEntry();
 
+  /**
+   * @brief  periodically evict Data under exceeded quotas, a batch at a time
+   */
+  void
+  evictOverQuota();
+
+  /**
+   * @brief  periodically remove expired Data, a batch at a time
+   */
+  void
+  removeExpiredData();
+
+  /**
+   * @brief  periodically move segments of completed inserts into objects, a batch at a time
+   */
+  void
+  packObjects();
+
+  /**
+   * @brief  periodically checkpoint the storage log and reclaim free pages, a batch at a time
+   *
+   * The step runs on the maintenance thread, so that the event loop does not wait for disk
+   * writes of the checkpoint.
+   */
+  void
+  maintainStorage();
+
+  /**
+   * @brief  run a storage maintenance step, on the maintenance thread
+   */
+  void
+  runStorageMaintenance();
+
+  /**
+   * @brief  reclaim space after a maintenance step, or schedule the next one
+   */
+  void
+  onStorageMaintained(const Storage::MaintenanceStatus& status, const std::string& error);
+
+  /**
+   * @brief  truncate the log and reclaim a small batch of free pages between inserts, until
+   *         vacuumPages are reclaimed, then schedule the next maintenance step
+   */
+  void
+  reclaimStorageSpace(size_t nReclaimed);
+
 private:
   RepoConfig m_config;
+  boost::asio::io_service& m_ioService;
   ndn::Scheduler m_scheduler;
   ndn::Face m_face;
   shared_ptr<Storage> m_store;
@@ -104,7 +184,11 @@ private:
   WriteHandle m_writeHandle;
   WatchHandle m_watchHandle;
   DeleteHandle m_deleteHandle;
+  StatusHandle m_statusHandle;
   TcpBulkInsertHandle m_tcpBulkInsertHandle;
+  boost::asio::io_service m_maintenanceService;
+  shared_ptr<boost::asio::io_service::work> m_maintenanceWork;
+  boost::thread m_maintenanceThread;
 };
 
 } // namespace repo
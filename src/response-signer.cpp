@@ -0,0 +1,56 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "response-signer.hpp"
+
+namespace repo {
+
+ResponseSigner::ResponseSigner(KeyChain& keyChain)
+  : m_keyChain(keyChain)
+{
+}
+
+void
+ResponseSigner::setPolicy(const SigningPolicy& policy)
+{
+  m_policy = policy;
+  m_certificateName.clear();
+}
+
+void
+ResponseSigner::sign(Data& data)
+{
+  switch (m_policy.method) {
+  case SigningPolicy::SIGN_WITH_DIGEST_SHA256:
+    m_keyChain.signWithSha256(data);
+    break;
+  case SigningPolicy::SIGN_WITH_IDENTITY:
+    if (m_certificateName.empty()) {
+      Name keyName = m_keyChain.getDefaultKeyNameForIdentity(m_policy.identity);
+      m_certificateName = m_keyChain.getDefaultCertificateNameForKey(keyName);
+    }
+    m_keyChain.sign(data, m_certificateName);
+    break;
+  default:
+    m_keyChain.sign(data);
+    break;
+  }
+}
+
+} // namespace repo
@@ -0,0 +1,84 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPO_RESPONSE_SIGNER_HPP
+#define REPO_RESPONSE_SIGNER_HPP
+
+#include "common.hpp"
+
+namespace repo {
+
+/**
+ * @brief Signing policy for Data packets generated by the repo itself
+ *
+ * Command responses, sync replies and snapshots are produced by the repo, not by
+ * data producers, so they do not have to be signed with the default RSA key.
+ */
+struct SigningPolicy
+{
+  enum Method {
+    SIGN_WITH_DEFAULT_IDENTITY,
+    SIGN_WITH_IDENTITY,
+    SIGN_WITH_DIGEST_SHA256
+  };
+
+  SigningPolicy()
+    : method(SIGN_WITH_DEFAULT_IDENTITY)
+    , shouldCacheSyncReplies(true)
+  {
+  }
+
+  Method method;
+  Name identity;  ///< used only by SIGN_WITH_IDENTITY
+  bool shouldCacheSyncReplies;
+};
+
+/**
+ * @brief ResponseSigner signs repo generated Data according to a SigningPolicy
+ *
+ * The certificate name is resolved once and reused, so the KeyChain does not need to
+ * look up the default identity for every response.
+ */
+class ResponseSigner
+{
+public:
+  explicit
+  ResponseSigner(KeyChain& keyChain);
+
+  void
+  setPolicy(const SigningPolicy& policy);
+
+  const SigningPolicy&
+  getPolicy() const
+  {
+    return m_policy;
+  }
+
+  void
+  sign(Data& data);
+
+private:
+  KeyChain& m_keyChain;
+  SigningPolicy m_policy;
+  Name m_certificateName;
+};
+
+} // namespace repo
+
+#endif // REPO_RESPONSE_SIGNER_HPP
@@ -0,0 +1,225 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef REPO_STORAGE_COMPRESSION_HPP
+#define REPO_STORAGE_COMPRESSION_HPP
+
+#include "../common.hpp"
+#include "config.hpp"
+
+#include <ndn-cxx/encoding/buffer.hpp>
+
+#include <fstream>
+#include <iterator>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace repo {
+
+/**
+ * @brief zlib compression of stored encodings of Data under configured prefixes
+ *
+ * A prefix may have a preset dictionary, such as concatenated samples of its typical
+ * content, so that even small Data compress well. zlib records the Adler-32 checksum of the
+ * dictionary in the compressed stream, so any dictionary that is still known can decompress
+ * a stream, whichever prefix it was compressed for.
+ *
+ * Everything is inline, so that tools reading the database directly can decompress too.
+ * Without zlib at build time, nothing is compressed and decompression throws.
+ */
+class Compression
+{
+public:
+  class Error : public std::runtime_error
+  {
+  public:
+    explicit
+    Error(const std::string& what)
+      : std::runtime_error(what)
+    {
+    }
+  };
+
+  class Rule
+  {
+  public:
+    Name prefix;
+    int level;
+    std::string dictionary;
+  };
+
+public:
+  /**
+   * @brief compress stored encodings of Data under prefix
+   * @param level       zlib level, 1 (fastest) to 9 (smallest)
+   * @param dictionary  preset dictionary, empty for none
+   */
+  void
+  addPrefix(const Name& prefix, int level, const std::string& dictionary = "")
+  {
+    if (level < 1 || level > 9)
+      throw Error("Compression level must be from 1 to 9");
+    Rule rule;
+    rule.prefix = prefix;
+    rule.level = level;
+    rule.dictionary = dictionary;
+    m_rules.push_back(rule);
+    if (!dictionary.empty())
+      addDictionary(dictionary);
+  }
+
+  /**
+   * @brief make a dictionary available for decompression only
+   */
+  void
+  addDictionary(const std::string& dictionary)
+  {
+#ifdef HAVE_ZLIB
+    uLong id = adler32(adler32(0, Z_NULL, 0),
+                       reinterpret_cast<const Bytef*>(dictionary.data()), dictionary.size());
+    m_dictionaries[id] = dictionary;
+#endif
+  }
+
+  bool
+  empty() const
+  {
+    return m_rules.empty();
+  }
+
+  static bool
+  isSupported()
+  {
+#ifdef HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * @brief read a dictionary file
+   */
+  static std::string
+  readDictionary(const std::string& path)
+  {
+    std::ifstream fin(path.c_str(), std::ios::binary);
+    if (!fin.is_open())
+      throw Error("Cannot open compression dictionary '" + path + "'");
+    return std::string(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+  }
+
+  /**
+   * @brief compress the stored encoding of Data named name
+   * @return true if name is under a compressed prefix and the output is smaller than input
+   */
+  bool
+  compress(const Name& name, const uint8_t* input, size_t inputSize, ndn::Buffer& output) const
+  {
+    const Rule* rule = 0;
+    for (std::vector<Rule>::const_iterator it = m_rules.begin(); it != m_rules.end(); ++it) {
+      if (it->prefix.isPrefixOf(name) && (rule == 0 || rule->prefix.size() < it->prefix.size()))
+        rule = &*it;
+    }
+    if (rule == 0 || inputSize == 0)
+      return false;
+
+#ifdef HAVE_ZLIB
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    if (deflateInit(&stream, rule->level) != Z_OK)
+      throw Error("Compression initialization failure");
+    if (!rule->dictionary.empty() &&
+        deflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(rule->dictionary.data()),
+                             rule->dictionary.size()) != Z_OK) {
+      deflateEnd(&stream);
+      throw Error("Compression dictionary failure");
+    }
+
+    // nothing is gained once the output reaches the input size
+    output.resize(inputSize);
+    stream.next_in = const_cast<Bytef*>(input);
+    stream.avail_in = inputSize;
+    stream.next_out = &output[0];
+    stream.avail_out = output.size();
+    int rc = deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return rc == Z_STREAM_END && output.size() < inputSize;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * @brief decompress a stored encoding
+   * @param outputSize  size of the encoding before compression
+   */
+  void
+  decompress(const uint8_t* input, size_t inputSize, size_t outputSize,
+             ndn::Buffer& output) const
+  {
+#ifdef HAVE_ZLIB
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = const_cast<Bytef*>(input);
+    stream.avail_in = inputSize;
+    if (inflateInit(&stream) != Z_OK)
+      throw Error("Decompression initialization failure");
+
+    output.resize(outputSize);
+    stream.next_out = outputSize == 0 ? Z_NULL : &output[0];
+    stream.avail_out = outputSize;
+    int rc = inflate(&stream, Z_FINISH);
+    if (rc == Z_NEED_DICT) {
+      std::map<uLong, std::string>::const_iterator dictionary = m_dictionaries.find(stream.adler);
+      if (dictionary == m_dictionaries.end()) {
+        inflateEnd(&stream);
+        throw Error("Compression dictionary of stored Data is not configured");
+      }
+      inflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dictionary->second.data()),
+                           dictionary->second.size());
+      rc = inflate(&stream, Z_FINISH);
+    }
+    size_t decompressedSize = stream.total_out;
+    inflateEnd(&stream);
+    if (rc != Z_STREAM_END || decompressedSize != outputSize)
+      throw Error("Decompression failure");
+#else
+    throw Error("Stored Data are compressed, but zlib is not available");
+#endif
+  }
+
+private:
+  std::vector<Rule> m_rules;
+#ifdef HAVE_ZLIB
+  std::map<uLong, std::string> m_dictionaries;
+#endif
+};
+
+} // namespace repo
+
+#endif // REPO_STORAGE_COMPRESSION_HPP
@@ -0,0 +1,446 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "disk-index-list.hpp"
+#include <ndn-cxx/encoding/encoding-buffer.hpp>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+
+namespace repo {
+
+/// entries read by one page query
+static const int PAGE_ENTRIES = 64;
+
+/// writes batched into one transaction
+static const size_t COMMIT_INTERVAL = 1024;
+
+static const char* const ENTRY_COLUMNS = "key, id, keylocatorHash, dataSize, status, deletionTime";
+
+/**
+ * @brief bind key to a statement parameter; an empty key is an empty BLOB rather than NULL
+ */
+static void
+bindKey(sqlite3_stmt* stmt, int index, const ndn::Buffer& key)
+{
+  if (key.empty())
+    sqlite3_bind_zeroblob(stmt, index, 0);
+  else
+    sqlite3_bind_blob(stmt, index, key.buf(), key.size(), SQLITE_STATIC);
+}
+
+static Name
+decodeName(const uint8_t* key, size_t keySize)
+{
+  ndn::EncodingBuffer encoder(keySize + 16, 0);
+  if (keySize > 0)
+    encoder.prependByteArray(key, keySize);
+  encoder.prependVarNumber(keySize);
+  encoder.prependVarNumber(ndn::Tlv::Name);
+  Name name;
+  name.wireDecode(encoder.block());
+  return name;
+}
+
+DiskIndexList::DiskIndexList(const std::string& dirPath, size_t nCachedPages)
+  : m_db(0)
+  , m_pageStmt(0)
+  , m_pageBeforeStmt(0)
+  , m_lastPageStmt(0)
+  , m_findStmt(0)
+  , m_insertStmt(0)
+  , m_eraseStmt(0)
+  , m_nCachedPages(nCachedPages)
+  , m_nPendingWrites(0)
+{
+  boost::filesystem::path fsPath(dirPath);
+  if (!boost::filesystem::is_directory(boost::filesystem::status(fsPath))) {
+    if (!boost::filesystem::create_directory(fsPath))
+      throw Error("Folder '" + dirPath + "' does not exists and cannot be created");
+  }
+  m_dbPath = dirPath + "/ndn_repo_index.db";
+  boost::filesystem::remove(m_dbPath);
+
+  if (sqlite3_open_v2(m_dbPath.c_str(), &m_db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+#ifdef DISABLE_SQLITE3_FS_LOCKING
+                      "unix-dotfile"
+#else
+                      0
+#endif
+                      ) != SQLITE_OK) {
+    std::cerr << "Index file open failure: " << sqlite3_errmsg(m_db) << std::endl;
+    sqlite3_close(m_db);
+    throw Error("Index file open failure");
+  }
+  sqlite3_exec(m_db, "PRAGMA journal_mode = OFF", 0, 0, 0);
+  sqlite3_exec(m_db, "PRAGMA synchronous = OFF", 0, 0, 0);
+  if (sqlite3_exec(m_db, "CREATE TABLE NDN_REPO_INDEX ("
+                         "key BLOB NOT NULL PRIMARY KEY, "
+                         "id INTEGER, "
+                         "keylocatorHash BLOB, "
+                         "dataSize INTEGER, "
+                         "status INTEGER, "
+                         "deletionTime INTEGER) WITHOUT ROWID;",
+                   0, 0, 0) != SQLITE_OK) {
+    std::cerr << "Index table creation failure: " << sqlite3_errmsg(m_db) << std::endl;
+    sqlite3_close(m_db);
+    throw Error("Index table creation failure");
+  }
+
+  std::string columns(ENTRY_COLUMNS);
+  prepareStatement(("SELECT " + columns + " FROM NDN_REPO_INDEX "
+                    "WHERE key >= ? ORDER BY key LIMIT ?;").c_str(), &m_pageStmt);
+  prepareStatement(("SELECT " + columns + " FROM NDN_REPO_INDEX "
+                    "WHERE key < ? ORDER BY key DESC LIMIT ?;").c_str(), &m_pageBeforeStmt);
+  prepareStatement(("SELECT " + columns + " FROM NDN_REPO_INDEX "
+                    "ORDER BY key DESC LIMIT ?;").c_str(), &m_lastPageStmt);
+  prepareStatement(("SELECT " + columns + " FROM NDN_REPO_INDEX WHERE key = ?;").c_str(),
+                   &m_findStmt);
+  prepareStatement(("INSERT OR IGNORE INTO NDN_REPO_INDEX (" + columns + ") "
+                    "VALUES (?, ?, ?, ?, ?, ?);").c_str(), &m_insertStmt);
+  prepareStatement("DELETE FROM NDN_REPO_INDEX WHERE key = ?;", &m_eraseStmt);
+
+  sqlite3_exec(m_db, "BEGIN;", 0, 0, 0);
+}
+
+DiskIndexList::~DiskIndexList()
+{
+  sqlite3_exec(m_db, "COMMIT;", 0, 0, 0);
+  sqlite3_finalize(m_pageStmt);
+  sqlite3_finalize(m_pageBeforeStmt);
+  sqlite3_finalize(m_lastPageStmt);
+  sqlite3_finalize(m_findStmt);
+  sqlite3_finalize(m_insertStmt);
+  sqlite3_finalize(m_eraseStmt);
+  sqlite3_close(m_db);
+  boost::system::error_code ec;
+  boost::filesystem::remove(m_dbPath, ec);
+}
+
+void
+DiskIndexList::prepareStatement(const char* sql, sqlite3_stmt** stmt)
+{
+  if (sqlite3_prepare_v2(m_db, sql, -1, stmt, 0) != SQLITE_OK) {
+    std::cerr << "Index statement failure: " << sqlite3_errmsg(m_db) << std::endl;
+    throw Error("Index statement failure");
+  }
+}
+
+ndn::Buffer
+DiskIndexList::makeKey(const Name& name)
+{
+  const Block& block = name.wireEncode();
+  return ndn::Buffer(block.value_begin(), block.value_end());
+}
+
+DiskIndexList::const_iterator
+DiskIndexList::begin() const
+{
+  return seek(ndn::Buffer());
+}
+
+DiskIndexList::const_iterator
+DiskIndexList::lower_bound(const Entry& entry) const
+{
+  return seek(makeKey(entry.getName()));
+}
+
+DiskIndexList::const_iterator
+DiskIndexList::find(const Entry& entry) const
+{
+  ndn::Buffer key = makeKey(entry.getName());
+  PageMap::iterator cached = findCachedPage(key);
+  if (cached != m_pages.end()) {
+    const Page& page = *cached->second.page;
+    std::vector<ndn::Buffer>::const_iterator it =
+      std::lower_bound(page.keys.begin(), page.keys.end(), key);
+    if (it == page.keys.end() || *it != key)
+      return end();
+    touchPage(cached);
+    return const_iterator(this, cached->second.page, it - page.keys.begin());
+  }
+
+  // a single entry is read by itself, so that point lookups do not fill the cache
+  shared_ptr<Page> page = make_shared<Page>();
+  bindKey(m_findStmt, 1, key);
+  readRows(m_findStmt, false, *page);
+  if (page->entries.empty())
+    return end();
+  return const_iterator(this, page, 0);
+}
+
+bool
+DiskIndexList::insert(const Entry& entry)
+{
+  ndn::Buffer key = makeKey(entry.getName());
+  const ndn::ConstBufferPtr& hash = entry.getKeyLocatorHash();
+  bindKey(m_insertStmt, 1, key);
+  sqlite3_bind_int64(m_insertStmt, 2, entry.getId());
+  if (hash)
+    sqlite3_bind_blob(m_insertStmt, 3, hash->buf(), hash->size(), SQLITE_STATIC);
+  else
+    sqlite3_bind_null(m_insertStmt, 3);
+  sqlite3_bind_int64(m_insertStmt, 4, entry.getDataSize());
+  sqlite3_bind_int(m_insertStmt, 5, entry.getStatus());
+  sqlite3_bind_int64(m_insertStmt, 6, entry.getDeletionTime().time_since_epoch().count());
+  int rc = sqlite3_step(m_insertStmt);
+  sqlite3_reset(m_insertStmt);
+  if (rc != SQLITE_DONE) {
+    std::cerr << "Index insert failure: " << sqlite3_errmsg(m_db) << std::endl;
+    throw Error("Index insert failure");
+  }
+  if (sqlite3_changes(m_db) == 0)
+    return false;
+
+  PageMap::iterator cached = findCachedPage(key);
+  if (cached != m_pages.end())
+    uncachePage(cached);
+  countWrite();
+  return true;
+}
+
+void
+DiskIndexList::erase(const_iterator it)
+{
+  BOOST_ASSERT(it != end());
+  const ndn::Buffer& key = it.m_page->keys[it.m_position];
+  bindKey(m_eraseStmt, 1, key);
+  int rc = sqlite3_step(m_eraseStmt);
+  sqlite3_reset(m_eraseStmt);
+  if (rc != SQLITE_DONE) {
+    std::cerr << "Index erase failure: " << sqlite3_errmsg(m_db) << std::endl;
+    throw Error("Index erase failure");
+  }
+
+  PageMap::iterator cached = findCachedPage(key);
+  if (cached != m_pages.end())
+    uncachePage(cached);
+  countWrite();
+}
+
+DiskIndexList::const_iterator
+DiskIndexList::seek(const ndn::Buffer& key) const
+{
+  ndn::Buffer from = key;
+  while (true) {
+    shared_ptr<const Page> page;
+    PageMap::iterator cached = findCachedPage(from);
+    if (cached != m_pages.end()) {
+      touchPage(cached);
+      page = cached->second.page;
+    }
+    else {
+      shared_ptr<Page> loaded = make_shared<Page>();
+      loaded->from = from;
+      bindKey(m_pageStmt, 1, from);
+      sqlite3_bind_int(m_pageStmt, 2, PAGE_ENTRIES);
+      readRows(m_pageStmt, false, *loaded);
+      loaded->isLast = loaded->entries.size() < static_cast<size_t>(PAGE_ENTRIES);
+      if (!loaded->isLast) {
+        // the successor of the last key: nothing sorts between them
+        loaded->until = loaded->keys.back();
+        loaded->until.push_back(0);
+      }
+      cachePage(loaded);
+      page = loaded;
+    }
+
+    size_t position = std::lower_bound(page->keys.begin(), page->keys.end(), from) -
+                      page->keys.begin();
+    if (position < page->keys.size())
+      return const_iterator(this, page, position);
+    if (page->isLast)
+      return end();
+    // from lies after the last entry of a page that is complete up to until
+    from = page->until;
+  }
+}
+
+DiskIndexList::const_iterator
+DiskIndexList::seekBefore(const ndn::Buffer& to, bool isEnd) const
+{
+  // a cached page reaching up to to holds the preceding entry, unless that entry comes
+  // before the page
+  PageMap::iterator cached = isEnd ? m_pages.end() : m_pages.lower_bound(to);
+  if (cached != m_pages.begin()) {
+    --cached;
+    const Page& page = *cached->second.page;
+    if (page.isLast || (!isEnd && to <= page.until)) {
+      size_t position = isEnd ? page.keys.size() :
+                        std::lower_bound(page.keys.begin(), page.keys.end(), to) -
+                        page.keys.begin();
+      if (position > 0) {
+        touchPage(cached);
+        return const_iterator(this, cached->second.page, position - 1);
+      }
+    }
+  }
+
+  shared_ptr<Page> loaded = make_shared<Page>();
+  if (isEnd) {
+    sqlite3_bind_int(m_lastPageStmt, 1, PAGE_ENTRIES);
+    readRows(m_lastPageStmt, true, *loaded);
+  }
+  else {
+    bindKey(m_pageBeforeStmt, 1, to);
+    sqlite3_bind_int(m_pageBeforeStmt, 2, PAGE_ENTRIES);
+    readRows(m_pageBeforeStmt, true, *loaded);
+  }
+  if (loaded->entries.empty())
+    return end();
+  loaded->from = loaded->keys.front();
+  loaded->isLast = isEnd;
+  loaded->until = to;
+  cachePage(loaded);
+  return const_iterator(this, loaded, loaded->entries.size() - 1);
+}
+
+void
+DiskIndexList::readRows(sqlite3_stmt* stmt, bool isDescending, Page& page) const
+{
+  int rc;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    const uint8_t* key = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 0));
+    size_t keySize = sqlite3_column_bytes(stmt, 0);
+    ndn::ConstBufferPtr hash;
+    if (sqlite3_column_type(stmt, 2) != SQLITE_NULL) {
+      const uint8_t* hashValue = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 2));
+      hash = make_shared<ndn::Buffer>(hashValue, sqlite3_column_bytes(stmt, 2));
+    }
+    Entry entry(decodeName(key, keySize), hash, sqlite3_column_int64(stmt, 1),
+                static_cast<size_t>(sqlite3_column_int64(stmt, 3)));
+    entry.setStatus(static_cast<status>(sqlite3_column_int(stmt, 4)));
+    entry.setDeletionTime(ndn::time::steady_clock::TimePoint(
+      ndn::time::steady_clock::TimePoint::duration(sqlite3_column_int64(stmt, 5))));
+    page.keys.push_back(ndn::Buffer(key, keySize));
+    page.entries.push_back(entry);
+  }
+  sqlite3_reset(stmt);
+  if (rc != SQLITE_DONE) {
+    std::cerr << "Index read failure: " << sqlite3_errmsg(m_db) << std::endl;
+    throw Error("Index read failure");
+  }
+  if (isDescending) {
+    std::reverse(page.keys.begin(), page.keys.end());
+    std::reverse(page.entries.begin(), page.entries.end());
+  }
+}
+
+DiskIndexList::PageMap::iterator
+DiskIndexList::findCachedPage(const ndn::Buffer& key) const
+{
+  PageMap::iterator it = m_pages.upper_bound(key);
+  if (it == m_pages.begin())
+    return m_pages.end();
+  --it;
+  const Page& page = *it->second.page;
+  if (page.isLast || key < page.until)
+    return it;
+  return m_pages.end();
+}
+
+void
+DiskIndexList::cachePage(const shared_ptr<const Page>& page) const
+{
+  if (m_nCachedPages == 0)
+    return;
+
+  // drop the pages overlapping the new one, so that cached ranges stay disjoint
+  PageMap::iterator it = m_pages.lower_bound(page->from);
+  if (it != m_pages.begin()) {
+    PageMap::iterator prev = it;
+    --prev;
+    if (prev->second.page->isLast || page->from < prev->second.page->until)
+      uncachePage(prev);
+  }
+  while (it != m_pages.end() && (page->isLast || it->first < page->until)) {
+    PageMap::iterator next = it;
+    ++next;
+    uncachePage(it);
+    it = next;
+  }
+
+  while (m_pages.size() >= m_nCachedPages)
+    uncachePage(m_pages.find(m_lru.back()));
+
+  m_lru.push_front(page->from);
+  CachedPage& cached = m_pages[page->from];
+  cached.page = page;
+  cached.lruPosition = m_lru.begin();
+}
+
+void
+DiskIndexList::touchPage(PageMap::iterator it) const
+{
+  m_lru.splice(m_lru.begin(), m_lru, it->second.lruPosition);
+}
+
+void
+DiskIndexList::uncachePage(PageMap::iterator it) const
+{
+  m_lru.erase(it->second.lruPosition);
+  m_pages.erase(it);
+}
+
+void
+DiskIndexList::countWrite()
+{
+  if (++m_nPendingWrites < COMMIT_INTERVAL)
+    return;
+  sqlite3_exec(m_db, "COMMIT; BEGIN;", 0, 0, 0);
+  m_nPendingWrites = 0;
+}
+
+DiskIndexList::const_iterator&
+DiskIndexList::const_iterator::operator++()
+{
+  BOOST_ASSERT(m_page);
+  if (++m_position < m_page->entries.size())
+    return *this;
+  if (m_page->isLast)
+    *this = m_list->end();
+  else
+    *this = m_list->seek(m_page->until);
+  return *this;
+}
+
+DiskIndexList::const_iterator&
+DiskIndexList::const_iterator::operator--()
+{
+  if (m_page && m_position > 0) {
+    --m_position;
+    return *this;
+  }
+  if (m_page)
+    *this = m_list->seekBefore(m_page->keys[m_position], false);
+  else
+    *this = m_list->seekBefore(ndn::Buffer(), true);
+  return *this;
+}
+
+bool
+DiskIndexList::const_iterator::operator==(const const_iterator& other) const
+{
+  if (!m_page || !other.m_page)
+    return !m_page && !other.m_page;
+  if (m_page == other.m_page)
+    return m_position == other.m_position;
+  return m_page->keys[m_position] == other.m_page->keys[other.m_position];
+}
+
+} // namespace repo
@@ -0,0 +1,269 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPO_STORAGE_DISK_INDEX_LIST_HPP
+#define REPO_STORAGE_DISK_INDEX_LIST_HPP
+
+#include "index.hpp"
+#include <sqlite3.h>
+#include <list>
+#include <map>
+
+namespace repo {
+
+/**
+ * @brief ordered list of index entries kept in a sqlite file, for indexes larger than memory
+ *
+ * Entries are stored in a table keyed by the TLV-VALUE of their full name. Since Name
+ * components are compared by length first and then byte by byte, and their TLV-LENGTH
+ * encoding preserves the order of lengths, the byte order of keys is the canonical order of
+ * names, so the B-tree of the table answers lower_bound like SkipList does.
+ *
+ * Lookups read pages of consecutive entries. A bounded number of recently used pages is kept
+ * in memory, so walking the children of a hot prefix costs no database access. Cached pages
+ * never overlap, and an insert or erase only drops the page covering its key.
+ *
+ * The file is a scratch copy rebuilt from storage at startup, so it is written without
+ * journal or sync. Building it still enumerates every record of storage.
+ */
+class DiskIndexList : noncopyable
+{
+public:
+  class Error : public std::runtime_error
+  {
+  public:
+    explicit
+    Error(const std::string& what)
+      : std::runtime_error(what)
+    {
+    }
+  };
+
+private:
+  typedef Index::Entry Entry;
+
+  /**
+   * @brief consecutive entries, holding every entry from the key from up to the key until
+   */
+  class Page
+  {
+  public:
+    Page()
+      : isLast(false)
+    {
+    }
+
+  public:
+    ndn::Buffer from;
+    /// end of the range, excluded; unused if isLast
+    ndn::Buffer until;
+    std::vector<ndn::Buffer> keys;
+    std::vector<Entry> entries;
+    /// the range extends past the last entry in the list
+    bool isLast;
+  };
+
+  typedef std::list<ndn::Buffer> LruList;
+
+  class CachedPage
+  {
+  public:
+    shared_ptr<const Page> page;
+    LruList::iterator lruPosition;
+  };
+
+  /// cached pages by their from key
+  typedef std::map<ndn::Buffer, CachedPage> PageMap;
+
+public:
+  class const_iterator : public std::iterator<std::bidirectional_iterator_tag, const Entry>
+  {
+  public:
+    const_iterator()
+      : m_list(0)
+      , m_position(0)
+    {
+    }
+
+    const Entry&
+    operator*() const
+    {
+      return m_page->entries[m_position];
+    }
+
+    const Entry*
+    operator->() const
+    {
+      return &m_page->entries[m_position];
+    }
+
+    const_iterator&
+    operator++();
+
+    const_iterator
+    operator++(int)
+    {
+      const_iterator it = *this;
+      ++*this;
+      return it;
+    }
+
+    const_iterator&
+    operator--();
+
+    const_iterator
+    operator--(int)
+    {
+      const_iterator it = *this;
+      --*this;
+      return it;
+    }
+
+    bool
+    operator==(const const_iterator& other) const;
+
+    bool
+    operator!=(const const_iterator& other) const
+    {
+      return !(*this == other);
+    }
+
+  private:
+    const_iterator(const DiskIndexList* list, shared_ptr<const Page> page, size_t position)
+      : m_list(list)
+      , m_page(page)
+      , m_position(position)
+    {
+    }
+
+  private:
+    const DiskIndexList* m_list;
+    /// null at end
+    shared_ptr<const Page> m_page;
+    size_t m_position;
+
+    friend class DiskIndexList;
+  };
+
+public:
+  /**
+   * @brief create an empty list in dirPath/ndn_repo_index.db, replacing any earlier file
+   * @param nCachedPages  most pages kept in memory
+   */
+  DiskIndexList(const std::string& dirPath, size_t nCachedPages);
+
+  ~DiskIndexList();
+
+  const_iterator
+  begin() const;
+
+  const_iterator
+  end() const
+  {
+    return const_iterator(this, shared_ptr<const Page>(), 0);
+  }
+
+  /**
+   * @brief get the first entry whose name is not less than the name of entry
+   */
+  const_iterator
+  lower_bound(const Entry& entry) const;
+
+  const_iterator
+  find(const Entry& entry) const;
+
+  /**
+   * @brief insert entry unless an entry with the same name exists
+   * @return whether the entry was inserted
+   *
+   * Unlike SkipList, no iterator is returned, since positioning it would read a page.
+   */
+  bool
+  insert(const Entry& entry);
+
+  /**
+   * @brief remove the entry at it
+   */
+  void
+  erase(const_iterator it);
+
+private:
+  void
+  prepareStatement(const char* sql, sqlite3_stmt** stmt);
+
+  static ndn::Buffer
+  makeKey(const Name& name);
+
+  /**
+   * @brief get the first entry whose key is not less than key, reading a page if needed
+   */
+  const_iterator
+  seek(const ndn::Buffer& key) const;
+
+  /**
+   * @brief get the last entry whose key is less than to, or the last entry if isEnd
+   */
+  const_iterator
+  seekBefore(const ndn::Buffer& to, bool isEnd) const;
+
+  /**
+   * @brief find the cached page whose range contains key
+   */
+  PageMap::iterator
+  findCachedPage(const ndn::Buffer& key) const;
+
+  void
+  cachePage(const shared_ptr<const Page>& page) const;
+
+  void
+  touchPage(PageMap::iterator it) const;
+
+  void
+  uncachePage(PageMap::iterator it) const;
+
+  /**
+   * @brief read the rows returned by stmt into page, reversing them if isDescending
+   */
+  void
+  readRows(sqlite3_stmt* stmt, bool isDescending, Page& page) const;
+
+  /**
+   * @brief commit the pending writes once enough of them are batched
+   */
+  void
+  countWrite();
+
+private:
+  sqlite3* m_db;
+  std::string m_dbPath;
+  sqlite3_stmt* m_pageStmt;
+  sqlite3_stmt* m_pageBeforeStmt;
+  sqlite3_stmt* m_lastPageStmt;
+  sqlite3_stmt* m_findStmt;
+  sqlite3_stmt* m_insertStmt;
+  sqlite3_stmt* m_eraseStmt;
+  size_t m_nCachedPages;
+  size_t m_nPendingWrites;
+  mutable PageMap m_pages;
+  mutable LruList m_lru;
+};
+
+} // namespace repo
+
+#endif // REPO_STORAGE_DISK_INDEX_LIST_HPP
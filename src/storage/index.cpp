@@ -19,6 +19,7 @@
 
 #include "index.hpp"
 #include "skiplist.hpp"
+#include "disk-index-list.hpp"
 
 #include <ndn-cxx/util/crypto.hpp>
 #include "ndn-cxx/security/signature-sha256-with-rsa.hpp"
@@ -29,7 +30,7 @@ namespace repo {
  *  @param hash SHA256 hash of PublisherPublicKeyLocator if exists in interest, otherwise ignored
  */
 static bool
-matchesSimpleSelectors(const Interest& interest, ndn::ConstBufferPtr& hash,
+matchesSimpleSelectors(const Interest& interest, const ndn::ConstBufferPtr& hash,
                        const Index::Entry& entry)
 {
   if (entry.getStatus() == DELETED)
@@ -53,78 +54,340 @@ matchesSimpleSelectors(const Interest& interest, ndn::ConstBufferPtr& hash,
     return false;
   if (!interest.getPublisherPublicKeyLocator().empty())
     {
-      if (*entry.getKeyLocatorHash() != *hash)
+      if (!entry.getKeyLocatorHash() || *entry.getKeyLocatorHash() != *hash)
           return false;
     }
   return true;
 }
 
-Index::Index(const size_t nMaxPackets)
+/** @brief find the smallest component of the excluded range containing an excluded component
+ *
+ *  Exclude keeps its components in descending order; a component marked "any" also excludes
+ *  every component up to the next larger one.
+ */
+static Name::Component
+findExcludedRangeStart(const ndn::Exclude& exclude, const Name::Component& component)
+{
+  ndn::Exclude::const_iterator it = exclude.begin();
+  while (it != exclude.end() && it->first > component)
+    ++it;
+  if (it == exclude.end())
+    return component;
+
+  // extend towards smaller components while ranges stay open up to the current start
+  Name::Component start = it->first;
+  for (++it; it != exclude.end() && it->second; ++it)
+    start = it->first;
+  return start;
+}
+
+/** @brief find where names under prefix resume after the excluded range containing a
+ *         component
+ *  @param[out] next  the first name after the range
+ *  @return false if every following component is excluded
+ */
+static bool
+findAfterExcludedRange(const ndn::Exclude& exclude, const Name& prefix,
+                       const Name::Component& component, Name& next)
+{
+  ndn::Exclude::const_iterator it = exclude.begin();
+  while (it != exclude.end() && it->first > component)
+    ++it;
+  if (it == exclude.end())
+    return false;
+
+  // walk towards larger components while ranges are open
+  while (it->second) {
+    if (it == exclude.begin())
+      return false;
+    --it;
+  }
+  next = Name(prefix).append(it->first).getSuccessor();
+  return true;
+}
+
+/** @brief find the first entry under prefix at or after startingPoint that is not DELETED
+ *  @return ID and name of the entry, or (0,ignored) if not found
+ */
+template<class List>
+static std::pair<int64_t, Name>
+findFirstEntry(const List& list, const Name& prefix, typename List::const_iterator startingPoint)
+{
+  BOOST_ASSERT(startingPoint != list.end());
+  for (typename List::const_iterator iter = startingPoint; iter != list.end(); iter++) {
+    if (iter->getStatus() == DELETED)
+      continue;
+    if (prefix.isPrefixOf(iter->getName()))
+    {
+      return std::make_pair(iter->getId(), iter->getName());
+    }
+    else
+    {
+      return std::make_pair(0, Name());
+    }
+  }
+  return std::make_pair(0, Name());
+}
+
+/**
+ *  @brief select entries which satisfy the selectors in interest and return their name
+ *  @param  interest   used to select entries by comparing the name and checking selectors
+ *  @param  hash       sha256 of the PublisherPublicKeyLocator of interest, if any
+ *  @param  startingPoint the entry whose name is equal or larger than the interest name
+ *
+ *  Excluded children are skipped a whole excluded range at a time, with one lookup per
+ *  range, so the cost depends on the children visited rather than on entries under them.
+ */
+template<class List>
+static std::pair<int64_t, Name>
+selectChild(const List& list, const Interest& interest, const ndn::ConstBufferPtr& hash,
+            typename List::const_iterator startingPoint)
+{
+  BOOST_ASSERT(startingPoint != list.end());
+  bool isLeftmost = (interest.getChildSelector() <= 0);
+  const Name& prefix = interest.getName();
+  const ndn::Exclude& exclude = interest.getExclude();
+
+  if (isLeftmost)
+    {
+      typename List::const_iterator it = startingPoint;
+      while (it != list.end())
+        {
+          if (!prefix.isPrefixOf(it->getName()))
+            return std::make_pair(0, Name());
+          if (!exclude.empty() && it->getName().size() > prefix.size() &&
+              exclude.isExcluded(it->getName()[prefix.size()]))
+            {
+              // skip every child in the excluded range at once
+              Name next;
+              if (!findAfterExcludedRange(exclude, prefix, it->getName()[prefix.size()], next))
+                return std::make_pair(0, Name());
+              it = list.lower_bound(next);
+              continue;
+            }
+          if (matchesSimpleSelectors(interest, hash, (*it)))
+            return std::make_pair(it->getId(), it->getName());
+          ++it;
+        }
+    }
+  else
+    {
+      typename List::const_iterator first = startingPoint;
+      typename List::const_iterator last = prefix.size() == 0 ?
+                    list.end() : list.lower_bound(prefix.getSuccessor());
+      // each round visits the rightmost remaining child, or skips an excluded range of children
+      while (last != first)
+        {
+          typename List::const_iterator prev = last;
+          --prev;
+          const Name& name = prev->getName();
+          if (!exclude.empty() && name.size() > prefix.size() &&
+              exclude.isExcluded(name[prefix.size()]))
+            {
+              last = list.lower_bound(Name(prefix).append(
+                       findExcludedRangeStart(exclude, name[prefix.size()])));
+              continue;
+            }
+          typename List::const_iterator childFirst =
+            list.lower_bound(name.getPrefix(prefix.size() + 1));
+          for (typename List::const_iterator match = childFirst; match != last; ++match)
+            {
+              if (matchesSimpleSelectors(interest, hash, *match))
+                return std::make_pair(match->getId(), match->getName());
+            }
+          last = childFirst;
+        }
+    }
+  return std::make_pair(0, Name());
+}
+
+static bool
+insertIntoList(SkipList<Index::Entry>& list, const Index::Entry& entry)
+{
+  return list.insert(entry).second;
+}
+
+static bool
+insertIntoList(DiskIndexList& list, const Index::Entry& entry)
+{
+  return list.insert(entry);
+}
+
+template<class List>
+static std::vector<std::pair<int64_t, Name> >
+findSegments(const List& list, const Name& prefix)
+{
+  std::vector<std::pair<int64_t, Name> > segments;
+  for (typename List::const_iterator it = list.lower_bound(prefix);
+       it != list.end() && prefix.isPrefixOf(it->getName()); ++it) {
+    if (it->getStatus() == DELETED)
+      continue;
+    // segment numbers sort in numeric order, so segment N is the N-th live entry
+    const Name& name = it->getName();
+    try {
+      if (name.size() != prefix.size() + 2 ||
+          name.get(prefix.size()).toSegment() != segments.size())
+        return std::vector<std::pair<int64_t, Name> >();
+    }
+    catch (ndn::Tlv::Error&) {
+      return std::vector<std::pair<int64_t, Name> >();
+    }
+    segments.push_back(std::make_pair(it->getId(), name));
+  }
+  return segments;
+}
+
+template<class List>
+static bool
+updateEntryId(List& list, const Name& fullName, const int64_t id)
+{
+  typename List::const_iterator result = list.find(Index::Entry(fullName));
+  if (result == list.end())
+    return false;
+  Index::Entry entry(*result);
+  entry.setId(id);
+  list.erase(result);
+  if (!insertIntoList(list, entry))
+    throw Index::Error("Update Entry: Cannot change id!");
+  return true;
+}
+
+template<class List>
+static status
+getEntryStatus(const List& list, const Name& name)
+{
+  typename List::const_iterator result = list.lower_bound(name);
+  if (result == list.end())
+    return NONE;
+  if (name.isPrefixOf(result->getName()))
+    return result->getStatus();
+  else
+    return NONE;
+}
+
+template<class List>
+static bool
+hasLiveEntry(const List& list, const Index::Entry& entry)
+{
+  typename List::const_iterator result = list.find(entry);
+  return result != list.end() && result->getStatus() != DELETED;
+}
+
+template<class List>
+static Index::Usage
+sumUsage(const List& list, const Name& prefix)
+{
+  Index::Usage result;
+  for (typename List::const_iterator it = list.lower_bound(prefix);
+       it != list.end() && prefix.isPrefixOf(it->getName()); ++it) {
+    if (it->getStatus() == DELETED)
+      continue;
+    ++result.nPackets;
+    result.nBytes += it->getDataSize();
+  }
+  return result;
+}
+
+Index::Index(const size_t nMaxPackets, const std::string& diskPath, size_t nCachedPages)
   : m_maxPackets(nMaxPackets)
   , m_size(0)
+  , m_maxUsageDepth(std::numeric_limits<size_t>::max())
 {
+  if (!diskPath.empty())
+    m_diskList = make_shared<DiskIndexList>(diskPath, nCachedPages);
 }
 
+template<class List>
 void
-Index::entryEnumeration(ndn::function< void (const Name &, const status &) > f) const
+Index::enumerateEntries(const List& list,
+                        ndn::function< void (const Name &, const status &) > f) const
 {
-  for (IndexSkipList::const_iterator iter = m_skipList.begin(); iter != m_skipList.end(); ++iter)
+  for (typename List::const_iterator iter = list.begin(); iter != list.end(); ++iter)
   {
     f(iter->getName(), iter->getStatus());
   }
 }
 
+void
+Index::entryEnumeration(ndn::function< void (const Name &, const status &) > f) const
+{
+  if (m_diskList)
+    enumerateEntries(*m_diskList, f);
+  else
+    enumerateEntries(m_skipList, f);
+}
+
+template<class List>
 bool
-Index::insert(const Data& data, const int64_t id)
+Index::insertEntry(List& list, Entry& entry)
 {
-  if (isFull())
-    throw Error("The Index is Full. Cannot Insert Any Data!");
-  Entry entry(data, id);
-  IndexSkipList::const_iterator result = m_skipList.find(entry);
+  typename List::const_iterator result = list.find(entry);
   bool isInserted = false;
-  if (result == m_skipList.end()) {
-    isInserted = m_skipList.insert(entry).second;
+  if (result == list.end()) {
+    isInserted = insertIntoList(list, entry);
   }
   else if (result->getStatus() == DELETED) {
-    m_skipList.erase(result);
+    list.erase(result);
     entry.setStatus(INSERTED);
-    isInserted = m_skipList.insert(entry).second;
+    isInserted = insertIntoList(list, entry);
   }
-  if (isInserted)
+  if (isInserted) {
     ++m_size;
+    updateUsage(entry, true);
+    m_prefixFilter.insert(entry.getName());
+  }
   return isInserted;
 }
 
+bool
+Index::insert(const Data& data, const int64_t id)
+{
+  if (isFull())
+    throw Error("The Index is Full. Cannot Insert Any Data!");
+  Entry entry(data, id);
+  return m_diskList ? insertEntry(*m_diskList, entry) : insertEntry(m_skipList, entry);
+}
+
 bool
 Index::insert(const Name& fullName, const int64_t id,
-              const ndn::ConstBufferPtr& keyLocatorHash)
+              const ndn::ConstBufferPtr& keyLocatorHash, const size_t dataSize)
 {
   if (isFull())
     throw Error("The Index is Full. Cannot Insert Any Data!");
-  Entry entry(fullName, keyLocatorHash, id);
-  IndexSkipList::const_iterator result = m_skipList.find(entry);
-  bool isInserted = false;
-  if (result == m_skipList.end()) {
-    isInserted = m_skipList.insert(entry).second;
-  }
-  else if (result->getStatus() == DELETED) {
-    m_skipList.erase(result);
-    entry.setStatus(INSERTED);
-    isInserted = m_skipList.insert(entry).second;
-  }
-  if (isInserted)
-    ++m_size;
-  return isInserted;
+  Entry entry(fullName, keyLocatorHash, id, dataSize);
+  return m_diskList ? insertEntry(*m_diskList, entry) : insertEntry(m_skipList, entry);
+}
+
+template<class List>
+std::pair<int64_t,Name>
+Index::findMatch(const List& list, const Interest& interest) const
+{
+  typename List::const_iterator result = list.lower_bound(interest.getName());
+  if (result == list.end())
+    return std::make_pair(0, Name());
+
+  ndn::ConstBufferPtr hash;
+  if (!interest.getPublisherPublicKeyLocator().empty())
+    hash = getCachedKeyLocatorHash(interest.getPublisherPublicKeyLocator());
+  return selectChild(list, interest, hash, result);
 }
 
 std::pair<int64_t,Name>
 Index::find(const Interest& interest) const
 {
-  Name name = interest.getName();
-  IndexSkipList::const_iterator result = m_skipList.lower_bound(name);
-  if (result != m_skipList.end())
+  if (!m_prefixFilter.mayContain(interest.getName()))
+    return std::make_pair(0, Name());
+  return m_diskList ? findMatch(*m_diskList, interest) : findMatch(m_skipList, interest);
+}
+
+template<class List>
+static std::pair<int64_t,Name>
+findUnderPrefix(const List& list, const Name& name)
+{
+  typename List::const_iterator result = list.lower_bound(name);
+  if (result != list.end())
     {
-      return selectChild(interest, result);
+      return findFirstEntry(list, name, result);
     }
   else
     {
@@ -135,69 +398,65 @@ Index::find(const Interest& interest) const
 std::pair<int64_t,Name>
 Index::find(const Name& name) const
 {
-  IndexSkipList::const_iterator result = m_skipList.lower_bound(name);
-  if (result != m_skipList.end())
-    {
-      return findFirstEntry(name, result);
-    }
-  else
-    {
-      return std::make_pair(0, Name());
-    }
+  if (!m_prefixFilter.mayContain(name))
+    return std::make_pair(0, Name());
+  return m_diskList ? findUnderPrefix(*m_diskList, name) : findUnderPrefix(m_skipList, name);
+}
+
+std::vector<std::pair<int64_t, Name> >
+Index::getSegments(const Name& prefix) const
+{
+  return m_diskList ? findSegments(*m_diskList, prefix) : findSegments(m_skipList, prefix);
+}
+
+bool
+Index::updateId(const Name& fullName, const int64_t id)
+{
+  return m_diskList ? updateEntryId(*m_diskList, fullName, id) :
+                      updateEntryId(m_skipList, fullName, id);
 }
 
 status
 Index::getStatus(const Name& name) const
 {
-  IndexSkipList::const_iterator result = m_skipList.lower_bound(name);
-  if (result == m_skipList.end())
-    return NONE;
-  if (name.isPrefixOf(result->getName()))
-    return result->getStatus();
-  else
-    return NONE;
+  return m_diskList ? getEntryStatus(*m_diskList, name) : getEntryStatus(m_skipList, name);
 }
 
 bool
 Index::hasData(const Data& data) const
 {
   Index::Entry entry(data, -1); // the id number is useless
-  IndexSkipList::const_iterator result = m_skipList.find(entry);
-  return result != m_skipList.end() && result->getStatus() != DELETED;
+  return m_diskList ? hasLiveEntry(*m_diskList, entry) : hasLiveEntry(m_skipList, entry);
 }
 
-std::pair<int64_t,Name>
-Index::findFirstEntry(const Name& prefix,
-                      IndexSkipList::const_iterator startingPoint) const
+bool
+Index::hasEntry(const Name& fullName) const
 {
-  BOOST_ASSERT(startingPoint != m_skipList.end());
-  for (IndexSkipList::const_iterator iter = startingPoint; iter != m_skipList.end(); iter++) {
-    if (iter->getStatus() == DELETED)
-      continue;
-    if (prefix.isPrefixOf(iter->getName()))
-    {
-      return std::make_pair(iter->getId(), iter->getName());
-    }
-    else
-    {
-      return std::make_pair(0, Name());
-    }
-  }
-  return std::make_pair(0, Name());
+  Entry entry(fullName);
+  return m_diskList ? hasLiveEntry(*m_diskList, entry) : hasLiveEntry(m_skipList, entry);
 }
 
+template<class List>
 bool
-Index::erase(const Name& fullName)
+Index::eraseEntry(List& list, const Name& fullName)
 {
   Entry entry(fullName);
-  IndexSkipList::const_iterator findIterator = m_skipList.find(entry);
-  if (findIterator != m_skipList.end())
+  typename List::const_iterator findIterator = list.find(entry);
+  if (findIterator != list.end())
     {
+      if (findIterator->getStatus() == DELETED)
+        return true;
+
       Entry remove(*findIterator);
+      updateUsage(remove, false);
+      m_prefixFilter.remove(fullName);
       remove.setStatus(DELETED);
-      m_skipList.erase(findIterator);
-      if (!m_skipList.insert(remove).second)
+      remove.setDeletionTime(ndn::time::steady_clock::now());
+      list.erase(findIterator);
+      if (!insertIntoList(list, remove))
         throw Error("Delete Entry: Cannot change status!");
+      // the entry is only removed once the queued time is its latest deletion
+      m_deletedNames.push_back(std::make_pair(remove.getDeletionTime(), fullName));
       m_size--;
       return true;
     }
@@ -205,16 +464,102 @@ Index::erase(const Name& fullName)
     return false;
 }
 
+bool
+Index::erase(const Name& fullName)
+{
+  return m_diskList ? eraseEntry(*m_diskList, fullName) : eraseEntry(m_skipList, fullName);
+}
+
+template<class List>
+size_t
+Index::removeDeletedFromList(List& list,
+                             const ndn::time::steady_clock::TimePoint& deletedBefore,
+                             size_t maxEntries)
+{
+  size_t nVisited = 0;
+  while (nVisited < maxEntries && !m_deletedNames.empty() &&
+         m_deletedNames.front().first < deletedBefore) {
+    typename List::const_iterator iter = list.find(Entry(m_deletedNames.front().second));
+    if (iter != list.end() && iter->getStatus() == DELETED &&
+        iter->getDeletionTime() == m_deletedNames.front().first)
+      list.erase(iter);
+    m_deletedNames.pop_front();
+    ++nVisited;
+  }
+  return nVisited;
+}
+
+size_t
+Index::removeDeletedEntries(const ndn::time::steady_clock::TimePoint& deletedBefore,
+                            size_t maxEntries)
+{
+  return m_diskList ? removeDeletedFromList(*m_diskList, deletedBefore, maxEntries) :
+                      removeDeletedFromList(m_skipList, deletedBefore, maxEntries);
+}
+
+static void
+addToFilter(PrefixFilter* filter, const Name& name, const status& entryStatus)
+{
+  if (entryStatus != DELETED)
+    filter->insert(name);
+}
+
 void
-Index::removeDeletedEntry()
+Index::setPrefixFilter(size_t nCounters)
 {
-  IndexSkipList::const_iterator iter = m_skipList.begin();
-  while(iter != m_skipList.end()) {
-    if (iter->getStatus() == DELETED) {
-      iter = m_skipList.erase(iter);
+  m_prefixFilter.reset(nCounters);
+  entryEnumeration(bind(&addToFilter, &m_prefixFilter, _1, _2));
+}
+
+Index::Usage
+Index::getUsage(const Name& prefix) const
+{
+  UsageMap::const_iterator usage = m_usage.find(prefix);
+  if (usage != m_usage.end())
+    return usage->second;
+
+  return m_diskList ? sumUsage(*m_diskList, prefix) : sumUsage(m_skipList, prefix);
+}
+
+void
+Index::setUsageDepth(size_t maxDepth)
+{
+  m_maxUsageDepth = maxDepth > 0 ? maxDepth : std::numeric_limits<size_t>::max();
+  for (UsageMap::iterator usage = m_usage.begin(); usage != m_usage.end();) {
+    if (usage->first.size() > m_maxUsageDepth)
+      m_usage.erase(usage++);
+    else
+      ++usage;
+  }
+}
+
+void
+Index::updateUsage(const Entry& entry, bool isInsert)
+{
+  const Name& fullName = entry.getName();
+  for (size_t i = 0; i + 1 <= fullName.size() && i <= m_maxUsageDepth; ++i) {
+    Name prefix = fullName.getPrefix(i);
+    UsageMap::iterator usage = m_usage.find(prefix);
+    if (usage == m_usage.end()) {
+      // the Data name itself is only counted if deeper Data made it a prefix
+      if (!isInsert || i + 1 == fullName.size())
+        continue;
+      // entries under a prefix without counters can only be Data named exactly by it,
+      // and the entry, which is already in the list
+      m_usage[prefix] = m_diskList ? sumUsage(*m_diskList, prefix) : sumUsage(m_skipList, prefix);
       continue;
     }
-    iter++;
+
+    if (isInsert) {
+      ++usage->second.nPackets;
+      usage->second.nBytes += entry.getDataSize();
+    }
+    else {
+      --usage->second.nPackets;
+      usage->second.nBytes -= entry.getDataSize();
+      if (usage->second.nPackets == 0)
+        m_usage.erase(usage);
+    }
   }
 }
 
@@ -226,78 +571,24 @@ Index::computeKeyLocatorHash(const KeyLocator& keyLocator)
   return keyLocatorHash;
 }
 
-std::pair<int64_t,Name>
-Index::selectChild(const Interest& interest,
-                   IndexSkipList::const_iterator startingPoint) const
+const ndn::ConstBufferPtr&
+Index::getCachedKeyLocatorHash(const KeyLocator& keyLocator) const
 {
-  BOOST_ASSERT(startingPoint != m_skipList.end());
-  bool isLeftmost = (interest.getChildSelector() <= 0);
-  ndn::ConstBufferPtr hash;
-  if (!interest.getPublisherPublicKeyLocator().empty())
-    {
-      KeyLocator keyLocator = interest.getPublisherPublicKeyLocator();
-      const Block& block = keyLocator.wireEncode();
-      hash = ndn::crypto::sha256(block.wire(), block.size());
-    }
-
-  if (isLeftmost)
-    {
-      for (IndexSkipList::const_iterator it = startingPoint;
-           it != m_skipList.end(); ++it)
-        {
-          if (it->getStatus() == DELETED)
-            continue;
-          if (!interest.getName().isPrefixOf(it->getName()))
-            return std::make_pair(0, Name());
-          if (matchesSimpleSelectors(interest, hash, (*it)))
-            return std::make_pair(it->getId(), it->getName());
-        }
-    }
-  else
+  const Block& block = keyLocator.wireEncode();
+  if (!m_cachedKeyLocatorHash ||
+      m_cachedKeyLocator.size() != block.size() ||
+      !std::equal(block.begin(), block.end(), m_cachedKeyLocator.begin()))
     {
-      IndexSkipList::const_iterator boundary = m_skipList.lower_bound(interest.getName());
-      while (boundary != m_skipList.end() && boundary->getStatus() == DELETED)
-        boundary++;
-      if (boundary == m_skipList.end() || !interest.getName().isPrefixOf(boundary->getName()))
-        return std::make_pair(0, Name());
-      Name successor = interest.getName().getSuccessor();
-      IndexSkipList::const_iterator last = interest.getName().size() == 0 ?
-                    m_skipList.end() : m_skipList.lower_bound(interest.getName().getSuccessor());
-      while (last != m_skipList.end() && last->getStatus() == DELETED)
-        last++;
-      while (true)
-        {
-          IndexSkipList::const_iterator prev = last;
-          --prev;
-          if (prev == boundary && prev->getStatus() != DELETED)
-            {
-              bool isMatch = matchesSimpleSelectors(interest, hash, (*prev));
-              if (isMatch)
-                {
-                  return std::make_pair(prev->getId(), prev->getName());
-                }
-              else
-                return std::make_pair(0, Name());
-            }
-          IndexSkipList::const_iterator first =
-            m_skipList.lower_bound(prev->getName().getPrefix(interest.getName().size() + 1));
-          while (first != m_skipList.end() && first->getStatus() == DELETED)
-            first++;
-          IndexSkipList::const_iterator match =
-                     std::find_if(first, last, bind(&matchesSimpleSelectors, interest, hash, _1));
-          if (match != last)
-            {
-              return std::make_pair(match->getId(), match->getName());
-            }
-          last = first;
-        }
+      m_cachedKeyLocator.assign(block.begin(), block.end());
+      m_cachedKeyLocatorHash = ndn::crypto::sha256(block.wire(), block.size());
     }
-  return std::make_pair(0, Name());
+  return m_cachedKeyLocatorHash;
 }
 
 Index::Entry::Entry(const Data& data, const int64_t id)
   : m_name(data.getFullName())
   , m_id(id)
+  , m_dataSize(data.wireEncode().size())
   , m_status(EXISTED)
 {
   const ndn::Signature& signature = data.getSignature();
@@ -309,21 +600,26 @@ Index::Entry::Entry(const Name& fullName, const KeyLocator& keyLocator, const in
   : m_name(fullName)
   , m_keyLocatorHash(computeKeyLocatorHash(keyLocator))
   , m_id(id)
+  , m_dataSize(0)
   , m_status(EXISTED)
 {
 }
 
 Index::Entry::Entry(const Name& fullName,
-                    const ndn::ConstBufferPtr& keyLocatorHash, const int64_t id)
+                    const ndn::ConstBufferPtr& keyLocatorHash, const int64_t id,
+                    const size_t dataSize)
   : m_name(fullName)
   , m_keyLocatorHash(keyLocatorHash)
   , m_id(id)
+  , m_dataSize(dataSize)
   , m_status(EXISTED)
 {
 }
 
 Index::Entry::Entry(const Name& name)
   : m_name(name)
+  , m_id(0)
+  , m_dataSize(0)
   , m_status(EXISTED)
 {
 }
@@ -22,7 +22,11 @@
 
 #include "common.hpp"
 #include "skiplist.hpp"
+#include "prefix-filter.hpp"
 #include <queue>
+#include <map>
+#include <deque>
+#include <limits>
 
 namespace repo {
 
@@ -34,6 +38,23 @@ enum status
   NONE
 };
 
+class DiskIndexList;
+
+/**
+ * @brief ordered index of the Data names in storage
+ *
+ * Entries are kept in a SkipList in memory, or with a disk path given, in a DiskIndexList
+ * with a bounded cache of hot pages, for repos whose index does not fit in memory. Lookups
+ * run the same algorithms on either list, so they match the same Data.
+ *
+ * With the list on disk, memory still grows with the number of Data through the usage
+ * counters, one per counted prefix unless setUsageDepth limits them, and the names deleted
+ * within the grace period of removeDeletedEntries. The prefix filter has the fixed size it
+ * is given.
+ *
+ * With a prefix filter set, lookups of names under which no entry was inserted are
+ * answered without walking the list.
+ */
 class Index : noncopyable
 {
 public:
@@ -84,8 +105,10 @@ public:
      * @param  fullName        full name with digest computed from data
      * @param  keyLocatorHash  keyLocator hashed by sha256
      * @param  id              record ID from database
+     * @param  dataSize        size of the Data encoding
      */
-    Entry(const Name& fullName, const ndn::ConstBufferPtr& keyLocatorHash, const int64_t id);
+    Entry(const Name& fullName, const ndn::ConstBufferPtr& keyLocatorHash, const int64_t id,
+          const size_t dataSize = 0);
 
     /**
      *  @brief implicit construct Entry by full name
@@ -121,6 +144,21 @@ public:
       return m_id;
     }
 
+    /**
+     *  @brief get the size of the Data encoding
+     */
+    const size_t
+    getDataSize() const
+    {
+      return m_dataSize;
+    }
+
+    void
+    setId(const int64_t id)
+    {
+      m_id = id;
+    }
+
     const status
     getStatus() const
     {
@@ -133,6 +171,21 @@ public:
       m_status = stat;
     }
 
+    /**
+     *  @brief get the time the entry was last DELETED
+     */
+    const ndn::time::steady_clock::TimePoint&
+    getDeletionTime() const
+    {
+      return m_deletionTime;
+    }
+
+    void
+    setDeletionTime(const ndn::time::steady_clock::TimePoint& deletionTime)
+    {
+      m_deletionTime = deletionTime;
+    }
+
     bool
     operator>(const Entry& entry) const
     {
@@ -161,7 +214,26 @@ public:
     Name m_name;
     ndn::ConstBufferPtr m_keyLocatorHash;
     int64_t m_id;
+    size_t m_dataSize;
     status m_status;
+    ndn::time::steady_clock::TimePoint m_deletionTime;
+  };
+
+  /**
+   * @brief number of Data and total size of their encoding under a prefix
+   */
+  class Usage
+  {
+  public:
+    Usage()
+      : nPackets(0)
+      , nBytes(0)
+    {
+    }
+
+  public:
+    uint64_t nPackets;
+    uint64_t nBytes;
   };
 
 private:
@@ -169,8 +241,14 @@ private:
   typedef SkipList<Entry> IndexSkipList;
 
 public:
+  /**
+   * @param  nMaxPackets   most entries in the index
+   * @param  diskPath      folder of the index file, or empty to keep the index in memory
+   * @param  nCachedPages  most index pages kept in memory when the index is on disk
+   */
   explicit
-  Index(const size_t nMaxPackets);
+  Index(const size_t nMaxPackets, const std::string& diskPath = std::string(),
+        size_t nCachedPages = 0);
 
   void
   entryEnumeration(ndn::function< void (const Name &, const status &) > f) const;
@@ -188,10 +266,11 @@ public:
    *  @param  fullname       fullname with digest used to construct entries
    *  @param  id             obtained from database
    *  @param  keyLocatorHash hash value of keylocator
+   *  @param  dataSize       size of the Data encoding
    */
   bool
   insert(const Name& fullName, const int64_t id,
-         const ndn::ConstBufferPtr& keyLocatorHash);
+         const ndn::ConstBufferPtr& keyLocatorHash, const size_t dataSize = 0);
 
   /**
    *  @brief erase the entry in index by its fullname
@@ -211,6 +290,21 @@ public:
   std::pair<int64_t, Name>
   find(const Name& name) const;
 
+  /** @brief get the segments of the object named prefix
+   *
+   *  Entries named prefix/<segment>/<digest> are returned in segment order.
+   *  @return IDs and full names of segments 0 to N, or empty if any segment is missing,
+   *          repeated or not a segment number
+   */
+  std::vector<std::pair<int64_t, Name> >
+  getSegments(const Name& prefix) const;
+
+  /** @brief change the record ID of an entry, keeping its status
+   *  @return false if no entry has the full name
+   */
+  bool
+  updateId(const Name& fullName, const int64_t id);
+
   /** @brief get the status of the entry with fullname
    * @param  name  full name of the entry
    */
@@ -224,8 +318,58 @@ public:
   bool
   hasData(const Data& data) const;
 
+  /**
+   *  @brief determine whether Data with the full name is already in the index
+   *  @return true if the entry exists and is not DELETED, false otherwise
+   */
+  bool
+  hasEntry(const Name& fullName) const;
+
+  /**
+   *  @brief remove entries that have stayed DELETED since before a time point
+   *
+   *  DELETED entries are kept for a while, so that sync snapshots carry the deletion and
+   *  RepoSync::processSnapshot does not fetch deleted Data back. Erased names are queued in
+   *  deletion order, so each call only visits the oldest ones instead of the whole index.
+   *  Entries inserted again since their deletion are left in place, and entries deleted
+   *  again are left until their latest deletion is old enough.
+   *
+   *  @param  deletedBefore  only entries deleted before this time are removed
+   *  @param  maxEntries     most queued names to visit in this call
+   *  @return number of visited names
+   */
+  size_t
+  removeDeletedEntries(const ndn::time::steady_clock::TimePoint& deletedBefore,
+                       size_t maxEntries);
+
+  /**
+   *  @brief get number and size of Data under a prefix
+   *
+   *  Usage of every prefix except the last two levels of each full name (Data name and
+   *  implicit digest), and of no more components than the usage depth, is kept up to date
+   *  on insert and erase, and includes Data named exactly by the prefix. Usage of other
+   *  prefixes is summed from the entries under them.
+   */
+  Usage
+  getUsage(const Name& prefix) const;
+
+  /**
+   *  @brief keep usage counters only for prefixes of at most maxDepth components
+   *  @param  maxDepth  0 keeps counters at every depth
+   *
+   *  Deeper prefixes cost no memory, but getUsage walks the entries under them.
+   */
   void
-  removeDeletedEntry();
+  setUsageDepth(size_t maxDepth);
+
+  /**
+   *  @brief answer lookups of names not in the index from a prefix filter
+   *  @param  nCounters  size of the filter in bytes, 0 disables it
+   *
+   *  Entries already in the index are added to the new filter.
+   */
+  void
+  setPrefixFilter(size_t nCounters);
 
   /**
     *  @brief compute the hash value of keyLocator
@@ -241,14 +385,11 @@ public:
 
 private:
   /**
-   *  @brief select entries which satisfy the selectors in interest and return their name
-   *  @param  interest   used to select entries by comparing the name and checking selectors
-   *  @param  idName    save the id and name of found entries
-   *  @param  startingPoint the entry whose name is equal or larger than the interest name
+   *  @brief get sha256 of the keyLocator, reusing the hash of the previous lookup
+   *         when Interests carry the same keyLocator
    */
-  std::pair<int64_t, Name>
-  selectChild(const Interest& interest,
-              IndexSkipList::const_iterator startingPoint) const;
+  const ndn::ConstBufferPtr&
+  getCachedKeyLocatorHash(const KeyLocator& keyLocator) const;
 
   /**
    *  @brief check whether the index is full
@@ -259,21 +400,49 @@ private:
     return m_size >= m_maxPackets;
   }
 
+  template<class List>
+  void
+  enumerateEntries(const List& list,
+                   ndn::function< void (const Name &, const status &) > f) const;
+
+  template<class List>
+  bool
+  insertEntry(List& list, Entry& entry);
+
+  template<class List>
+  std::pair<int64_t, Name>
+  findMatch(const List& list, const Interest& interest) const;
+
+  template<class List>
+  bool
+  eraseEntry(List& list, const Name& fullName);
+
+  template<class List>
+  size_t
+  removeDeletedFromList(List& list, const ndn::time::steady_clock::TimePoint& deletedBefore,
+                        size_t maxEntries);
+
   /**
-   *  @brief find the first entry with the prefix
-   *  @param  prefix        used to request the entries
-   *  @param  startingPoint the entry whose name is equal or larger than the interest name
-   *  @return int64_t  the id number of found entry
-   *  @return Name     the name of found entry
+   *  @brief add or subtract an entry from usage of its prefixes
    */
-  std::pair<int64_t, Name>
-  findFirstEntry(const Name& prefix,
-                 IndexSkipList::const_iterator startingPoint) const;
+  void
+  updateUsage(const Entry& entry, bool isInsert);
 
 private:
+  typedef std::map<Name, Usage> UsageMap;
+
   IndexSkipList m_skipList;
+  /// replaces m_skipList when the index is on disk
+  shared_ptr<DiskIndexList> m_diskList;
   size_t m_maxPackets;
   size_t m_size;
+  UsageMap m_usage;
+  size_t m_maxUsageDepth;
+  /// every entry that is not DELETED
+  PrefixFilter m_prefixFilter;
+  std::deque<std::pair<ndn::time::steady_clock::TimePoint, Name> > m_deletedNames;
+  mutable ndn::Buffer m_cachedKeyLocator;
+  mutable ndn::ConstBufferPtr m_cachedKeyLocatorHash;
 };
 
 } // namespace repo
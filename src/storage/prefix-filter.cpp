@@ -0,0 +1,124 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "prefix-filter.hpp"
+
+#include <limits>
+
+namespace repo {
+
+/// counters set for each prefix
+static const int N_HASHES = 4;
+
+static const uint8_t MAX_COUNT = std::numeric_limits<uint8_t>::max();
+
+static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+/**
+ * @brief extend the FNV-1a hash of a prefix by one component
+ *
+ * The length of the component is hashed first, so that component boundaries count.
+ */
+static uint64_t
+hashComponent(uint64_t hash, const Name::Component& component)
+{
+  uint64_t size = component.value_size();
+  for (int i = 0; i < 8; ++i) {
+    hash ^= static_cast<uint8_t>(size >> (8 * i));
+    hash *= 1099511628211ULL;
+  }
+  for (Block::const_iterator it = component.value_begin(); it != component.value_end(); ++it) {
+    hash ^= *it;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/**
+ * @brief get the i-th counter of a prefix hash, by double hashing
+ */
+static size_t
+getPosition(uint64_t hash, int i, size_t nCounters)
+{
+  uint64_t step = ((hash >> 32) | (hash << 32)) | 1;
+  return static_cast<size_t>((hash + i * step) % nCounters);
+}
+
+PrefixFilter::PrefixFilter(size_t nCounters)
+  : m_counters(nCounters, 0)
+{
+}
+
+void
+PrefixFilter::reset(size_t nCounters)
+{
+  std::vector<uint8_t>(nCounters, 0).swap(m_counters);
+}
+
+void
+PrefixFilter::insert(const Name& name)
+{
+  update(name, true);
+}
+
+void
+PrefixFilter::remove(const Name& name)
+{
+  update(name, false);
+}
+
+void
+PrefixFilter::update(const Name& name, bool isInsert)
+{
+  if (!isEnabled())
+    return;
+
+  // the empty prefix is not stored; every name is under it
+  uint64_t hash = FNV_OFFSET_BASIS;
+  for (size_t depth = 0; depth < name.size(); ++depth) {
+    hash = hashComponent(hash, name.get(depth));
+    for (int i = 0; i < N_HASHES; ++i) {
+      uint8_t& counter = m_counters[getPosition(hash, i, m_counters.size())];
+      if (counter == MAX_COUNT)
+        continue;
+      if (isInsert)
+        ++counter;
+      else if (counter > 0)
+        --counter;
+    }
+  }
+}
+
+bool
+PrefixFilter::mayContain(const Name& prefix) const
+{
+  if (!isEnabled() || prefix.empty())
+    return true;
+
+  uint64_t hash = FNV_OFFSET_BASIS;
+  for (size_t depth = 0; depth < prefix.size(); ++depth)
+    hash = hashComponent(hash, prefix.get(depth));
+  for (int i = 0; i < N_HASHES; ++i) {
+    if (m_counters[getPosition(hash, i, m_counters.size())] == 0)
+      return false;
+  }
+  return true;
+}
+
+} // namespace repo
@@ -0,0 +1,85 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPO_STORAGE_PREFIX_FILTER_HPP
+#define REPO_STORAGE_PREFIX_FILTER_HPP
+
+#include "../common.hpp"
+
+namespace repo {
+
+/**
+ * @brief counting Bloom filter of every prefix of the names in a set
+ *
+ * Inserting a name adds each of its prefixes, so whether any name lies under a prefix is
+ * answered by hashing the prefix once, whatever its depth. The answer may be a false
+ * positive, but never a false negative. Counters saturate instead of overflowing, and a
+ * saturated counter is no longer decremented, so removals never cause false negatives.
+ */
+class PrefixFilter : noncopyable
+{
+public:
+  /**
+   * @param nCounters  number of one-byte counters; 0 disables the filter
+   */
+  explicit
+  PrefixFilter(size_t nCounters = 0);
+
+  /**
+   * @brief empty the filter and resize it to nCounters
+   */
+  void
+  reset(size_t nCounters);
+
+  bool
+  isEnabled() const
+  {
+    return !m_counters.empty();
+  }
+
+  /**
+   * @brief add name and its prefixes
+   */
+  void
+  insert(const Name& name);
+
+  /**
+   * @brief remove name and its prefixes, which must have been inserted
+   */
+  void
+  remove(const Name& name);
+
+  /**
+   * @brief check whether an inserted name may have prefix as a prefix
+   * @return false only if no inserted name is under prefix; always true if disabled
+   */
+  bool
+  mayContain(const Name& prefix) const;
+
+private:
+  void
+  update(const Name& name, bool isInsert);
+
+private:
+  std::vector<uint8_t> m_counters;
+};
+
+} // namespace repo
+
+#endif // REPO_STORAGE_PREFIX_FILTER_HPP
@@ -0,0 +1,101 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quota.hpp"
+
+namespace repo {
+
+void
+QuotaManager::addQuota(const Quota& quota)
+{
+  m_quotas.push_back(quota);
+  m_trackers.push_back(Tracker());
+}
+
+size_t
+QuotaManager::findQuotaIndex(const Name& name) const
+{
+  size_t found = m_quotas.size();
+  for (size_t i = 0; i < m_quotas.size(); ++i) {
+    if (m_quotas[i].prefix.isPrefixOf(name) &&
+        (found == m_quotas.size() || m_quotas[found].prefix.size() < m_quotas[i].prefix.size()))
+      found = i;
+  }
+  return found;
+}
+
+const Quota*
+QuotaManager::findQuota(const Name& name) const
+{
+  size_t i = findQuotaIndex(name);
+  return i < m_quotas.size() ? &m_quotas[i] : 0;
+}
+
+void
+QuotaManager::onInsert(const Name& fullName)
+{
+  size_t i = findQuotaIndex(fullName);
+  if (i == m_quotas.size() || m_quotas[i].policy == Quota::REJECT)
+    return;
+
+  Tracker& tracker = m_trackers[i];
+  if (tracker.positions.count(fullName) > 0)
+    return;
+  tracker.positions[fullName] = tracker.order.insert(tracker.order.end(), fullName);
+}
+
+void
+QuotaManager::onRead(const Name& fullName)
+{
+  size_t i = findQuotaIndex(fullName);
+  if (i == m_quotas.size() || m_quotas[i].policy != Quota::EVICT_LRU)
+    return;
+
+  Tracker& tracker = m_trackers[i];
+  std::map<Name, EvictionList::iterator>::iterator position = tracker.positions.find(fullName);
+  if (position != tracker.positions.end())
+    tracker.order.splice(tracker.order.end(), tracker.order, position->second);
+}
+
+void
+QuotaManager::onErase(const Name& fullName)
+{
+  size_t i = findQuotaIndex(fullName);
+  if (i == m_quotas.size())
+    return;
+
+  Tracker& tracker = m_trackers[i];
+  std::map<Name, EvictionList::iterator>::iterator position = tracker.positions.find(fullName);
+  if (position != tracker.positions.end()) {
+    tracker.order.erase(position->second);
+    tracker.positions.erase(position);
+  }
+}
+
+bool
+QuotaManager::getEvictionCandidate(const Quota& quota, Name& fullName) const
+{
+  const Tracker& tracker = m_trackers[&quota - &m_quotas[0]];
+  if (tracker.order.empty())
+    return false;
+  fullName = tracker.order.front();
+  return true;
+}
+
+} // namespace repo
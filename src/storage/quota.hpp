@@ -0,0 +1,126 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPO_STORAGE_QUOTA_HPP
+#define REPO_STORAGE_QUOTA_HPP
+
+#include "../common.hpp"
+
+#include <limits>
+
+namespace repo {
+
+/**
+ * @brief limits on number and size of Data stored under a prefix
+ */
+class Quota
+{
+public:
+  enum Policy {
+    /// refuse Data that would exceed the limits
+    REJECT,
+    /// accept Data and evict the earliest inserted Data under the prefix
+    EVICT_OLDEST,
+    /// accept Data and evict the least recently read Data under the prefix
+    EVICT_LRU
+  };
+
+  Quota()
+    : maxPackets(std::numeric_limits<uint64_t>::max())
+    , maxBytes(std::numeric_limits<uint64_t>::max())
+    , policy(REJECT)
+  {
+  }
+
+  bool
+  isExceeded(uint64_t nPackets, uint64_t nBytes) const
+  {
+    return nPackets > maxPackets || nBytes > maxBytes;
+  }
+
+public:
+  Name prefix;
+  uint64_t maxPackets;
+  uint64_t maxBytes;
+  Policy policy;
+};
+
+/**
+ * @brief keeps the quotas of a repo and the eviction order of Data under them
+ *
+ * A Data is governed by the quota with the longest prefix of its name. For quotas that evict,
+ * full names of governed Data are kept in eviction order: insertion order, which reads
+ * also refresh under EVICT_LRU.
+ */
+class QuotaManager : noncopyable
+{
+public:
+  void
+  addQuota(const Quota& quota);
+
+  const std::vector<Quota>&
+  getQuotas() const
+  {
+    return m_quotas;
+  }
+
+  /**
+   * @brief find the quota governing a name
+   * @return the quota, or 0 if the name is not under any quota
+   */
+  const Quota*
+  findQuota(const Name& name) const;
+
+  void
+  onInsert(const Name& fullName);
+
+  void
+  onRead(const Name& fullName);
+
+  void
+  onErase(const Name& fullName);
+
+  /**
+   * @brief get the next Data to evict under a quota
+   * @return false if no Data under the quota is known
+   */
+  bool
+  getEvictionCandidate(const Quota& quota, Name& fullName) const;
+
+private:
+  size_t
+  findQuotaIndex(const Name& name) const;
+
+private:
+  typedef std::list<Name> EvictionList;
+
+  class Tracker
+  {
+  public:
+    EvictionList order;
+    std::map<Name, EvictionList::iterator> positions;
+  };
+
+  std::vector<Quota> m_quotas;
+  std::vector<Tracker> m_trackers;
+};
+
+} // namespace repo
+
+#endif // REPO_STORAGE_QUOTA_HPP
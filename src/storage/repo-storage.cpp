@@ -18,41 +18,153 @@
  */
 
 #include "repo-storage.hpp"
+#include "sha256-batch.hpp"
 #include "../../build/src/config.hpp"
 #include <istream>
 
 namespace repo {
 
 static void
-insertItemToIndex(Index* index, const Storage::ItemMeta& item,
+insertItemToIndex(Index* index, QuotaManager* quotas, const Storage::ItemMeta& item,
                   const ndn::function< void (const Name &,const std::string & ) >& generateAction)
 {
-  index->insert(item.fullName, item.id, item.keyLocatorHash);
+  index->insert(item.fullName, item.id, item.keyLocatorHash, item.dataSize);
+  quotas->onInsert(item.fullName);
   generateAction(item.fullName, "insertion");
 }
 
-RepoStorage::RepoStorage(const int64_t& nMaxPackets, Storage& store)
-  : m_index(nMaxPackets)
+RepoStorage::RepoStorage(const int64_t& nMaxPackets, Storage& store,
+                         const std::string& indexPath, size_t nCachedIndexPages)
+  : m_index(nMaxPackets, indexPath, nCachedIndexPages)
   , m_storage(store)
+  , m_nPackedSegments(0)
 {
 }
 
 void
 RepoStorage::initialize(const ndn::function< void (const Name &,const std::string & ) >& generateAction)
 {
-  m_storage.fullEnumerate(bind(&insertItemToIndex, &m_index, _1, generateAction));
+  m_storage.fullEnumerate(bind(&insertItemToIndex, &m_index, &m_quotas, _1, generateAction));
 }
 
 bool
 RepoStorage::insertData(const Data& data)
 {
-   bool isExist = m_index.hasData(data);
+   // full name, keyLocator hash and size are computed once here and passed down
+   Storage::ItemMeta item;
+   {
+     Index::Entry entry(data, 0);
+     item.fullName = entry.getName();
+     item.keyLocatorHash = entry.getKeyLocatorHash();
+     item.dataSize = entry.getDataSize();
+   }
+
+   bool isExist = m_index.hasEntry(item.fullName);
    if (isExist)
      throw Error("The Entry Has Already In the Skiplist. Cannot be Inserted!");
-   int64_t id = m_storage.insert(data);
+
+   return insertItem(data, item);
+}
+
+std::vector<bool>
+RepoStorage::insertData(const std::vector<shared_ptr<const Data> >& data)
+{
+  std::vector<Storage::ItemMeta> items(data.size());
+  Sha256Batch digests;
+  std::vector<size_t> keyLocatorPositions(data.size(), 0);
+  // copies keep the keyLocator encodings alive until digests are computed
+  std::vector<Block> keyLocators;
+  for (size_t i = 0; i < data.size(); ++i) {
+    const Block& wire = data[i]->wireEncode();
+    items[i].dataSize = wire.size();
+    digests.add(wire);
+
+    // Data of a batch are mostly signed by the same key, so its locator is hashed once
+    const ndn::Signature& signature = data[i]->getSignature();
+    if (!signature.hasKeyLocator())
+      continue;
+    Block keyLocator = signature.getKeyLocator().wireEncode();
+    if (i > 0 && data[i - 1]->getSignature().hasKeyLocator() &&
+        keyLocators.back().size() == keyLocator.size() &&
+        std::equal(keyLocator.begin(), keyLocator.end(), keyLocators.back().begin()))
+      {
+        keyLocatorPositions[i] = keyLocatorPositions[i - 1];
+      }
+    else
+      {
+        keyLocators.push_back(keyLocator);
+        keyLocatorPositions[i] = digests.add(keyLocators.back());
+      }
+  }
+  digests.compute();
+
+  std::vector<bool> isInserted(data.size(), false);
+  for (size_t i = 0; i < data.size(); ++i) {
+    Storage::ItemMeta& item = items[i];
+    item.fullName = data[i]->getName();
+    item.fullName.append(digests.getDigest(i)->buf(), Sha256Batch::DIGEST_SIZE);
+    if (data[i]->getSignature().hasKeyLocator())
+      item.keyLocatorHash = digests.getDigest(keyLocatorPositions[i]);
+
+    if (m_index.hasEntry(item.fullName))
+      continue;
+    // a failure is reported for its Data only, the Data before it stay inserted
+    try {
+      isInserted[i] = insertItem(*data[i], item);
+    }
+    catch (std::runtime_error& e) {
+      std::cerr << "Cannot insert " << data[i]->getName() << ": " << e.what() << std::endl;
+    }
+  }
+  return isInserted;
+}
+
+bool
+RepoStorage::insertItem(const Data& data, const Storage::ItemMeta& item)
+{
+   const Quota* quota = m_quotas.findQuota(data.getName());
+   if (quota != 0 && quota->policy == Quota::REJECT) {
+     Index::Usage usage = getQuotaUsage(*quota);
+     if (quota->isExceeded(usage.nPackets + 1, usage.nBytes + item.dataSize)) {
+       std::cerr << "Quota of " << quota->prefix << " is exceeded, "
+                 << data.getName() << " is rejected" << std::endl;
+       return false;
+     }
+   }
+
+   int64_t id = m_storage.insert(data, item, computeExpiry(data.getName()));
    if (id == -1)
      return false;
-   return m_index.insert(data, id);
+   bool isIndexed = false;
+   try {
+     isIndexed = m_index.insert(item.fullName, id, item.keyLocatorHash, item.dataSize);
+   }
+   catch (Index::Error&) {
+     // the record would be unreachable without an index entry
+     m_storage.erase(id);
+     throw;
+   }
+   if (!isIndexed)
+     return false;
+   m_quotas.onInsert(item.fullName);
+   return true;
+}
+
+bool
+RepoStorage::eraseEntry(int64_t id, const Name& fullName)
+{
+  bool resultDb = m_storage.erase(id);
+  bool resultIndex = m_index.erase(fullName);
+  onErase(fullName);
+  return resultDb && resultIndex;
+}
+
+void
+RepoStorage::onErase(const Name& fullName)
+{
+  m_quotas.onErase(fullName);
+  for (size_t i = 0; i < m_eraseCallbacks.size(); ++i)
+    m_eraseCallbacks[i](fullName);
 }
 
 ssize_t
@@ -64,9 +176,7 @@ RepoStorage::deleteData(const Name& name)
     return false;
   int64_t count = 0;
   while (idName.first != 0) {
-    bool resultDb = m_storage.erase(idName.first);
-    bool resultIndex = m_index.erase(idName.second); //full name
-    if (resultDb && resultIndex)
+    if (eraseEntry(idName.first, idName.second))
       count++;
     else
       hasError = true;
@@ -87,9 +197,7 @@ RepoStorage::deleteData(const Interest& interest)
   bool hasError = false;
   std::pair<int64_t,ndn::Name> idName = m_index.find(interestDelete);
   while (idName.first != 0) {
-    bool resultDb = m_storage.erase(idName.first);
-    bool resultIndex = m_index.erase(idName.second); //full name
-    if (resultDb && resultIndex)
+    if (eraseEntry(idName.first, idName.second))
       count++;
     else
       hasError = true;
@@ -102,12 +210,14 @@ RepoStorage::deleteData(const Interest& interest)
 }
 
 shared_ptr<Data>
-RepoStorage::readData(const Interest& interest) const
+RepoStorage::readData(const Interest& interest, bool isPrefetch)
 {
   std::pair<int64_t,ndn::Name> idName = m_index.find(interest);
   if (idName.first != 0) {
     shared_ptr<Data> data = m_storage.read(idName.first);
     if (data) {
+      if (!isPrefetch)
+        m_quotas.onRead(idName.second);
       return data;
     }
   }
@@ -120,10 +230,161 @@ RepoStorage::dataEnumeration(ndn::function< void (const Name &, const status&) >
   m_index.entryEnumeration(f);
 }
 
-void
-RepoStorage::removeDeletedEntry()
+Index::Usage
+RepoStorage::getQuotaUsage(const Quota& quota) const
+{
+  Index::Usage usage = m_index.getUsage(quota.prefix);
+  const std::vector<Quota>& quotas = m_quotas.getQuotas();
+  for (std::vector<Quota>::const_iterator nested = quotas.begin();
+       nested != quotas.end(); ++nested) {
+    // a quota is directly nested if the parent of its prefix is governed by quota
+    if (nested->prefix.size() <= quota.prefix.size() ||
+        !quota.prefix.isPrefixOf(nested->prefix) ||
+        m_quotas.findQuota(nested->prefix.getPrefix(-1)) != &quota)
+      continue;
+    Index::Usage nestedUsage = m_index.getUsage(nested->prefix);
+    usage.nPackets -= std::min(usage.nPackets, nestedUsage.nPackets);
+    usage.nBytes -= std::min(usage.nBytes, nestedUsage.nBytes);
+  }
+  return usage;
+}
+
+size_t
+RepoStorage::evictOverQuota(size_t maxEvictions,
+                            const ndn::function< void (const Name &,const std::string & ) >&
+                              generateAction)
+{
+  size_t nEvicted = 0;
+  const std::vector<Quota>& quotas = m_quotas.getQuotas();
+  for (std::vector<Quota>::const_iterator quota = quotas.begin();
+       quota != quotas.end() && nEvicted < maxEvictions; ++quota) {
+    if (quota->policy == Quota::REJECT)
+      continue;
+
+    Index::Usage usage = getQuotaUsage(*quota);
+    Name fullName;
+    while (nEvicted < maxEvictions && quota->isExceeded(usage.nPackets, usage.nBytes) &&
+           m_quotas.getEvictionCandidate(*quota, fullName)) {
+      std::pair<int64_t, Name> idName = m_index.find(fullName);
+      if (idName.first == 0 || idName.second != fullName) {
+        // stale candidate, nothing to erase
+        m_quotas.onErase(fullName);
+        continue;
+      }
+      eraseEntry(idName.first, fullName);
+      generateAction(fullName, "deletion");
+      ++nEvicted;
+      usage = getQuotaUsage(*quota);
+    }
+  }
+  return nEvicted;
+}
+
+int64_t
+RepoStorage::computeExpiry(const Name& name) const
+{
+  if (m_retentions.empty())
+    return 0;
+
+  for (ssize_t length = name.size(); length >= 0; --length) {
+    std::map<Name, ndn::time::milliseconds>::const_iterator retention =
+      m_retentions.find(name.getPrefix(length));
+    if (retention != m_retentions.end())
+      return (ndn::time::toUnixTimestamp(ndn::time::system_clock::now()) +
+              retention->second).count();
+  }
+  return 0;
+}
+
+size_t
+RepoStorage::removeExpiredData(size_t maxRemovals,
+                               const ndn::function< void (const Name &,const std::string & ) >&
+                                 generateAction)
+{
+  int64_t now = ndn::time::toUnixTimestamp(ndn::time::system_clock::now()).count();
+  std::vector<std::pair<int64_t, Name> > expired = m_storage.getExpired(now, maxRemovals);
+  if (expired.empty())
+    return 0;
+
+  std::vector<int64_t> ids;
+  ids.reserve(expired.size());
+  for (std::vector<std::pair<int64_t, Name> >::const_iterator it = expired.begin();
+       it != expired.end(); ++it)
+    ids.push_back(it->first);
+  m_storage.erase(ids);
+
+  for (std::vector<std::pair<int64_t, Name> >::const_iterator it = expired.begin();
+       it != expired.end(); ++it) {
+    m_index.erase(it->second);
+    onErase(it->second);
+    generateAction(it->second, "deletion");
+  }
+  return expired.size();
+}
+
+bool
+RepoStorage::addObjectToPack(const Name& prefix)
+{
+  std::vector<std::pair<int64_t, Name> > segments = m_index.getSegments(prefix);
+  if (segments.size() < 2)
+    return false;
+  m_objectsToPack.push_back(std::vector<std::pair<int64_t, Name> >());
+  m_objectsToPack.back().swap(segments);
+  return true;
+}
+
+size_t
+RepoStorage::packObjects(size_t maxSegments)
+{
+  size_t nVisited = 0;
+  while (nVisited < maxSegments && !m_objectsToPack.empty()) {
+    const std::vector<std::pair<int64_t, Name> >& segments = m_objectsToPack.front();
+    size_t begin = m_nPackedSegments;
+    // a run holds at least two segments, and does not leave a single one behind
+    size_t end = std::min(segments.size(),
+                          begin + std::max<size_t>(maxSegments - nVisited, 2));
+    if (segments.size() - end == 1)
+      ++end;
+
+    std::vector<int64_t> ids;
+    ids.reserve(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+      // the entry may have been erased, or inserted again, since the object was queued
+      if (m_index.find(segments[i].second).first != segments[i].first)
+        break;
+      ids.push_back(segments[i].first);
+    }
+
+    // a run left short by a changed segment, or by its keyLocator or retention, is not
+    // packed, and ends the packing of its object
+    std::vector<int64_t> newIds;
+    if (ids.size() == end - begin) {
+      try {
+        newIds = m_storage.packObject(ids);
+      }
+      catch (std::runtime_error& e) {
+        // segments stay stored one record each
+        std::cerr << "Cannot pack " << segments[begin].second.getPrefix(-2) << ": "
+                  << e.what() << std::endl;
+      }
+    }
+    for (size_t i = 0; i < newIds.size(); ++i)
+      m_index.updateId(segments[begin + i].second, newIds[i]);
+
+    nVisited += end - begin;
+    m_nPackedSegments = end;
+    if (newIds.size() != end - begin || end == segments.size()) {
+      m_objectsToPack.pop_front();
+      m_nPackedSegments = 0;
+    }
+  }
+  return nVisited;
+}
+
+size_t
+RepoStorage::removeDeletedEntries(const ndn::time::milliseconds& gracePeriod, size_t maxEntries)
 {
-  m_index.removeDeletedEntry();
+  return m_index.removeDeletedEntries(ndn::time::steady_clock::now() - gracePeriod, maxEntries);
 }
 
 } // namespace repo
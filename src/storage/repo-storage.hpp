@@ -23,11 +23,13 @@
 #include "../common.hpp"
 #include "storage.hpp"
 #include "index.hpp"
+#include "quota.hpp"
 #include "../repo-command-parameter.hpp"
 
 #include <ndn-cxx/exclude.hpp>
 
 #include <queue>
+#include <deque>
 
 namespace repo {
 
@@ -49,7 +51,12 @@ public:
   };
 
 public:
-  RepoStorage(const int64_t& nMaxPackets, Storage& store);
+  /**
+   *  @param  indexPath        folder of the index file, or empty to keep the index in memory
+   *  @param  nCachedIndexPages  most index pages kept in memory when the index is on disk
+   */
+  RepoStorage(const int64_t& nMaxPackets, Storage& store,
+              const std::string& indexPath = std::string(), size_t nCachedIndexPages = 0);
 
   /**
    *  @brief  rebuild index from database
@@ -63,6 +70,17 @@ public:
   bool
   insertData(const Data& data);
 
+  /**
+   *  @brief  insert a batch of data into repo
+   *
+   *  Implicit digests and keyLocator hashes of the whole batch are computed together by
+   *  Sha256Batch. Data already in the repo, and Data whose insertion fails, e.g. because
+   *  the index is full, are reported as not inserted instead of throwing.
+   *  @return  whether each Data is inserted
+   */
+  std::vector<bool>
+  insertData(const std::vector<shared_ptr<const Data> >& data);
+
   /**
    *  @brief   delete data from repo
    *  @param   name     used to find entry needed to be erased in repo
@@ -83,11 +101,22 @@ public:
 
   /**
    *  @brief  read data from repo
-   *  @param   interest  used to request data
+   *  @param   interest    used to request data
+   *  @param   isPrefetch  whether Data are read ahead of any request, which is then not
+   *                       recorded as a read for eviction under a quota
    *  @return  std::pair<bool,shared_ptr<Data> >
    */
   shared_ptr<Data>
-  readData(const Interest& interest) const;
+  readData(const Interest& interest, bool isPrefetch = false);
+
+  /**
+   *  @brief  record a read of Data served without reading storage, e.g. from a cache
+   */
+  void
+  recordRead(const Name& fullName)
+  {
+    m_quotas.onRead(fullName);
+  }
 
   status
   getDataStatus(const Name& name) const
@@ -98,8 +127,56 @@ public:
   void
   dataEnumeration(ndn::function< void (const Name &, const status &) > f) const;
 
+  /**
+   *  @brief  call f with the full name of each Data erased, whether deleted, expired or evicted
+   */
   void
-  removeDeletedEntry();
+  addEraseCallback(const ndn::function< void (const Name &) >& f)
+  {
+    m_eraseCallbacks.push_back(f);
+  }
+
+  /**
+   *  @brief  queue the segments of a completed object to be stored contiguously
+   *
+   *  Only applies when the Data under prefix are exactly segments 0 to N, N > 0. The
+   *  segments are moved by later packObjects calls, in runs that must each be signed with
+   *  the same keyLocator and all be under a retention or none.
+   *
+   *  Only the storage records are merged: the index still has an entry per segment.
+   *  @return false if the object is left as it is
+   */
+  bool
+  addObjectToPack(const Name& prefix);
+
+  /**
+   *  @brief  move queued segments into objects, a bounded step at a time
+   *
+   *  Segments deleted or replaced since their object was queued end the packing of that
+   *  object.
+   *  @param  maxSegments  segments to move in this call, exceeded by up to two so that no run
+   *                       of an object holds a single segment
+   *  @return number of visited segments; at least maxSegments if more may be queued
+   */
+  size_t
+  packObjects(size_t maxSegments);
+
+  /**
+   *  @brief  remove index entries DELETED for longer than gracePeriod
+   *  @param  maxEntries  most entries to visit in this call
+   *  @return number of visited entries; equal to maxEntries if more may be removable
+   */
+  size_t
+  removeDeletedEntries(const ndn::time::milliseconds& gracePeriod, size_t maxEntries);
+
+  /**
+   *  @brief  get number and size of Data under a prefix
+   */
+  Index::Usage
+  getUsage(const Name& prefix) const
+  {
+    return m_index.getUsage(prefix);
+  }
 
   const size_t
   size() const
@@ -107,9 +184,114 @@ public:
     return m_index.size();
   }
 
+  /**
+   *  @brief  limit Data under quota.prefix
+   *
+   *  Quotas should be added before initialize, so that Data already stored are
+   *  tracked for eviction.
+   */
+  void
+  addQuota(const Quota& quota)
+  {
+    m_quotas.addQuota(quota);
+  }
+
+  /**
+   *  @brief  get number and size of Data governed by quota
+   *
+   *  Data under a nested quota count against the nested quota only, so the usage of
+   *  quota.prefix less the usage of the quotas directly nested in it.
+   */
+  Index::Usage
+  getQuotaUsage(const Quota& quota) const;
+
+  /**
+   *  @brief   evict Data under quotas that are exceeded
+   *  @param   maxEvictions   most Data to evict in this call
+   *  @param   generateAction called with the full name of each evicted Data
+   *  @return  number of evicted Data; equal to maxEvictions if more need eviction
+   */
+  size_t
+  evictOverQuota(size_t maxEvictions,
+                 const ndn::function< void (const Name &,const std::string & ) >& generateAction);
+
+  /**
+   *  @brief  answer reads of names the repo does not have without an index walk
+   *  @param  nCounters  size of the prefix filter in bytes, 0 disables it
+   *
+   *  About 10 bytes per distinct prefix of the stored names keep false positives near 1%.
+   */
+  void
+  setLookupFilter(size_t nCounters)
+  {
+    m_index.setPrefixFilter(nCounters);
+  }
+
+  /**
+   *  @brief  keep usage counters only for prefixes of at most maxDepth components
+   *  @param  maxDepth  0 keeps counters at every depth
+   */
+  void
+  setUsageDepth(size_t maxDepth)
+  {
+    m_index.setUsageDepth(maxDepth);
+  }
+
+  /**
+   *  @brief  keep Data under prefix for at most maxAge after insertion
+   *
+   *  Data are governed by the retention with the longest prefix of their name. The expiry
+   *  time is recorded when Data are inserted, so a retention only applies to later inserts.
+   */
+  void
+  addRetention(const Name& prefix, const ndn::time::milliseconds& maxAge)
+  {
+    m_retentions[prefix] = maxAge;
+  }
+
+  /**
+   *  @brief   remove Data whose expiry time has passed, earliest expiry first
+   *  @param   maxRemovals    most Data to remove in this call
+   *  @param   generateAction called with the full name of each removed Data
+   *  @return  number of removed Data; equal to maxRemovals if more may have expired
+   */
+  size_t
+  removeExpiredData(size_t maxRemovals,
+                    const ndn::function< void (const Name &,const std::string & ) >&
+                      generateAction);
+
+private:
+  /**
+   *  @brief  get expiry time of Data inserted now, 0 if no retention applies
+   */
+  int64_t
+  computeExpiry(const Name& name) const;
+
+private:
+  /**
+   *  @brief  insert Data known to be absent, with precomputed full name, hash and size
+   */
+  bool
+  insertItem(const Data& data, const Storage::ItemMeta& item);
+
+  /**
+   *  @brief  erase one entry from database, index and quota tracking
+   */
+  bool
+  eraseEntry(int64_t id, const Name& fullName);
+
+  void
+  onErase(const Name& fullName);
+
 private:
   Index m_index;
   Storage& m_storage;
+  QuotaManager m_quotas;
+  std::map<Name, ndn::time::milliseconds> m_retentions;
+  std::vector<ndn::function< void (const Name &) > > m_eraseCallbacks;
+  /// segments of objects to pack, and the position of the next segment in the first one
+  std::deque<std::vector<std::pair<int64_t, Name> > > m_objectsToPack;
+  size_t m_nPackedSegments;
 
 };
 
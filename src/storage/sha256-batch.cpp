@@ -0,0 +1,346 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sha256-batch.hpp"
+
+#include <ndn-cxx/util/crypto.hpp>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define REPO_HAVE_SHA256_AVX2 1
+#include <immintrin.h>
+#include <cpuid.h>
+#endif
+
+namespace repo {
+
+const size_t Sha256Batch::DIGEST_SIZE;
+const size_t Sha256Batch::N_LANES;
+
+namespace {
+
+#ifdef REPO_HAVE_SHA256_AVX2
+
+const size_t BLOCK_SIZE = 64;
+
+const uint32_t ROUND_CONSTANTS[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+const uint32_t INITIAL_STATE[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+/**
+ * @brief blocks of a message after SHA-256 padding
+ *
+ * Whole blocks are read from the message itself; only the last one or two blocks, which
+ * hold the padding and the message length, are copied.
+ */
+class PaddedMessage
+{
+public:
+  PaddedMessage(const uint8_t* buffer, size_t size)
+    : m_buffer(buffer)
+    , m_nWholeBlocks(size / BLOCK_SIZE)
+    , m_nBlocks((size + 9 + BLOCK_SIZE - 1) / BLOCK_SIZE)
+  {
+    size_t tailSize = size - m_nWholeBlocks * BLOCK_SIZE;
+    size_t paddedTailSize = (m_nBlocks - m_nWholeBlocks) * BLOCK_SIZE;
+    std::fill(m_tail, m_tail + sizeof(m_tail), 0);
+    std::copy(buffer + m_nWholeBlocks * BLOCK_SIZE, buffer + size, m_tail);
+    m_tail[tailSize] = 0x80;
+    uint64_t nBits = static_cast<uint64_t>(size) * 8;
+    for (int i = 0; i < 8; ++i)
+      m_tail[paddedTailSize - 1 - i] = static_cast<uint8_t>(nBits >> (8 * i));
+  }
+
+  size_t
+  getNBlocks() const
+  {
+    return m_nBlocks;
+  }
+
+  const uint8_t*
+  getBlock(size_t i) const
+  {
+    if (i < m_nWholeBlocks)
+      return m_buffer + i * BLOCK_SIZE;
+    return m_tail + (i - m_nWholeBlocks) * BLOCK_SIZE;
+  }
+
+private:
+  const uint8_t* m_buffer;
+  size_t m_nWholeBlocks;
+  size_t m_nBlocks;
+  uint8_t m_tail[2 * BLOCK_SIZE];
+};
+
+void
+storeDigest(const uint32_t state[8], ndn::ConstBufferPtr& digest)
+{
+  shared_ptr<ndn::Buffer> buffer = make_shared<ndn::Buffer>(Sha256Batch::DIGEST_SIZE);
+  for (int j = 0; j < 8; ++j) {
+    (*buffer)[4 * j] = static_cast<uint8_t>(state[j] >> 24);
+    (*buffer)[4 * j + 1] = static_cast<uint8_t>(state[j] >> 16);
+    (*buffer)[4 * j + 2] = static_cast<uint8_t>(state[j] >> 8);
+    (*buffer)[4 * j + 3] = static_cast<uint8_t>(state[j]);
+  }
+  digest = buffer;
+}
+
+__attribute__((target("avx2"))) inline __m256i
+rotateRight8(__m256i x, int n)
+{
+  return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+/**
+ * @brief turn eight rows of eight words into eight columns
+ */
+__attribute__((target("avx2"))) inline void
+transpose8(__m256i r[8])
+{
+  __m256i t[8];
+  for (int i = 0; i < 8; i += 2) {
+    t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+    t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+  }
+  __m256i u[8];
+  for (int i = 0; i < 8; i += 4) {
+    u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+    u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+    u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+    u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+  }
+  for (int i = 0; i < 4; ++i) {
+    r[i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+    r[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+  }
+}
+
+/**
+ * @brief load the 16 words of one block of each of eight messages, one message per lane
+ */
+__attribute__((target("avx2"))) inline void
+loadBlock8(const uint8_t* const blocks[8], __m256i w[16])
+{
+  const __m256i byteSwap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8,
+                                            15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4,
+                                            11, 10, 9, 8, 15, 14, 13, 12);
+  for (int half = 0; half < 2; ++half) {
+    __m256i* rows = w + 8 * half;
+    for (int i = 0; i < 8; ++i)
+      rows[i] = _mm256_shuffle_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blocks[i] + 32 * half)),
+        byteSwap);
+    transpose8(rows);
+  }
+}
+
+/**
+ * @brief compress all blocks of eight messages, one message per lane
+ *
+ * Lanes of messages with fewer blocks keep their state while the others go on, so no
+ * message is left to finish on its own.
+ */
+__attribute__((target("avx2"))) void
+compressMessages8(uint32_t states[8][8], const PaddedMessage* const messages[8])
+{
+  __m256i state[8];
+  for (int j = 0; j < 8; ++j)
+    state[j] = _mm256_setr_epi32(states[0][j], states[1][j], states[2][j], states[3][j],
+                                 states[4][j], states[5][j], states[6][j], states[7][j]);
+
+  size_t nMaxBlocks = 0;
+  for (int i = 0; i < 8; ++i)
+    nMaxBlocks = std::max(nMaxBlocks, messages[i]->getNBlocks());
+  __m256i nBlocks = _mm256_setr_epi32(messages[0]->getNBlocks(), messages[1]->getNBlocks(),
+                                      messages[2]->getNBlocks(), messages[3]->getNBlocks(),
+                                      messages[4]->getNBlocks(), messages[5]->getNBlocks(),
+                                      messages[6]->getNBlocks(), messages[7]->getNBlocks());
+
+  for (size_t block = 0; block < nMaxBlocks; ++block) {
+    // a finished lane hashes its last block again, and the result is discarded
+    const uint8_t* blocks[8];
+    for (int i = 0; i < 8; ++i)
+      blocks[i] = messages[i]->getBlock(std::min(block, messages[i]->getNBlocks() - 1));
+    __m256i isActive = _mm256_cmpgt_epi32(nBlocks, _mm256_set1_epi32(block));
+
+    __m256i w[64];
+    loadBlock8(blocks, w);
+    for (int t = 16; t < 64; ++t) {
+      __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotateRight8(w[t - 15], 7),
+                                                     rotateRight8(w[t - 15], 18)),
+                                    _mm256_srli_epi32(w[t - 15], 3));
+      __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotateRight8(w[t - 2], 17),
+                                                     rotateRight8(w[t - 2], 19)),
+                                    _mm256_srli_epi32(w[t - 2], 10));
+      w[t] = _mm256_add_epi32(_mm256_add_epi32(w[t - 16], s0),
+                              _mm256_add_epi32(w[t - 7], s1));
+    }
+
+    __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+    __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int t = 0; t < 64; ++t) {
+      __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotateRight8(e, 6), rotateRight8(e, 11)),
+                                    rotateRight8(e, 25));
+      __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+      __m256i temp1 = _mm256_add_epi32(_mm256_add_epi32(h, s1),
+                                       _mm256_add_epi32(ch, w[t]));
+      temp1 = _mm256_add_epi32(temp1, _mm256_set1_epi32(ROUND_CONSTANTS[t]));
+      __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotateRight8(a, 2), rotateRight8(a, 13)),
+                                    rotateRight8(a, 22));
+      __m256i maj = _mm256_xor_si256(_mm256_xor_si256(_mm256_and_si256(a, b),
+                                                      _mm256_and_si256(a, c)),
+                                     _mm256_and_si256(b, c));
+      h = g;
+      g = f;
+      f = e;
+      e = _mm256_add_epi32(d, temp1);
+      d = c;
+      c = b;
+      b = a;
+      a = _mm256_add_epi32(temp1, _mm256_add_epi32(s0, maj));
+    }
+    __m256i result[8] = {a, b, c, d, e, f, g, h};
+    for (int j = 0; j < 8; ++j)
+      state[j] = _mm256_blendv_epi8(state[j], _mm256_add_epi32(state[j], result[j]),
+                                    isActive);
+  }
+
+  for (int j = 0; j < 8; ++j) {
+    uint32_t lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), state[j]);
+    for (int i = 0; i < 8; ++i)
+      states[i][j] = lanes[i];
+  }
+}
+
+/**
+ * @brief whether the CPU has SHA extensions, with which the crypto library hashes one
+ *        message faster than eight lanes of AVX2 hash eight
+ */
+bool
+hasShaExtensions()
+{
+  unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+  if (__get_cpuid_max(0, 0) < 7)
+    return false;
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  return (ebx >> 29) & 1;
+}
+
+bool
+hasParallelLanes()
+{
+  static const bool result = __builtin_cpu_supports("avx2") && !hasShaExtensions();
+  return result;
+}
+
+bool
+hasFewerBlocks(const PaddedMessage* a, const PaddedMessage* b)
+{
+  return a->getNBlocks() < b->getNBlocks();
+}
+
+#endif // REPO_HAVE_SHA256_AVX2
+
+} // anonymous namespace
+
+size_t
+Sha256Batch::add(const uint8_t* buffer, size_t size)
+{
+  m_messages.push_back(std::make_pair(buffer, size));
+  return m_messages.size() - 1;
+}
+
+void
+Sha256Batch::clear()
+{
+  m_messages.clear();
+  m_digests.clear();
+}
+
+bool
+Sha256Batch::isParallel()
+{
+#ifdef REPO_HAVE_SHA256_AVX2
+  return hasParallelLanes();
+#else
+  return false;
+#endif
+}
+
+void
+Sha256Batch::compute()
+{
+  m_digests.assign(m_messages.size(), ndn::ConstBufferPtr());
+
+  size_t next = 0;
+#ifdef REPO_HAVE_SHA256_AVX2
+  if (hasParallelLanes() && m_messages.size() >= N_LANES / 2) {
+    std::vector<PaddedMessage> padded;
+    padded.reserve(m_messages.size());
+    for (size_t i = 0; i < m_messages.size(); ++i)
+      padded.push_back(PaddedMessage(m_messages[i].first, m_messages[i].second));
+
+    // messages with similar lengths go to the same group, so few lanes sit idle
+    std::vector<const PaddedMessage*> order(padded.size());
+    for (size_t i = 0; i < padded.size(); ++i)
+      order[i] = &padded[i];
+    std::stable_sort(order.begin(), order.end(), &hasFewerBlocks);
+
+    // a partial group is worth hashing in parallel with idle lanes repeating its last message
+    for (; next + N_LANES / 2 <= order.size(); next += N_LANES) {
+      size_t nMessages = std::min(N_LANES, order.size() - next);
+      const PaddedMessage* lanes[N_LANES];
+      uint32_t states[N_LANES][8];
+      for (size_t i = 0; i < N_LANES; ++i) {
+        lanes[i] = order[next + std::min(i, nMessages - 1)];
+        std::copy(INITIAL_STATE, INITIAL_STATE + 8, states[i]);
+      }
+
+      compressMessages8(states, lanes);
+      for (size_t i = 0; i < nMessages; ++i)
+        storeDigest(states[i], m_digests[lanes[i] - &padded[0]]);
+    }
+
+    // the few messages left go to the scalar implementation
+    for (; next < order.size(); ++next) {
+      size_t position = order[next] - &padded[0];
+      m_digests[position] = ndn::crypto::sha256(m_messages[position].first,
+                                                m_messages[position].second);
+    }
+    return;
+  }
+#endif // REPO_HAVE_SHA256_AVX2
+
+  for (; next < m_messages.size(); ++next)
+    m_digests[next] = ndn::crypto::sha256(m_messages[next].first, m_messages[next].second);
+}
+
+} // namespace repo
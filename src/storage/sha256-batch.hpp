@@ -0,0 +1,99 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef REPO_STORAGE_SHA256_BATCH_HPP
+#define REPO_STORAGE_SHA256_BATCH_HPP
+
+#include "../common.hpp"
+
+#include <ndn-cxx/encoding/buffer.hpp>
+
+namespace repo {
+
+/**
+ * @brief computes SHA-256 digests of many independent messages at once
+ *
+ * Messages are hashed in groups of N_LANES, one message per 32-bit lane of an AVX2
+ * register, when the CPU supports AVX2 but not SHA extensions. Messages are grouped by
+ * length, and lanes of shorter messages keep their state while longer ones finish.
+ * Messages left out of the groups, and every message on other CPUs, are hashed by
+ * ndn::crypto::sha256, so that the crypto library can use its fastest implementation.
+ *
+ * Messages are not copied, so their buffers must stay valid until compute() returns.
+ */
+class Sha256Batch : noncopyable
+{
+public:
+  static const size_t DIGEST_SIZE = 32;
+  static const size_t N_LANES = 8;
+
+public:
+  /**
+   * @brief add a message to the batch
+   * @return position of the message, to be passed to getDigest
+   */
+  size_t
+  add(const uint8_t* buffer, size_t size);
+
+  size_t
+  add(const Block& block)
+  {
+    return add(block.wire(), block.size());
+  }
+
+  /**
+   * @brief compute digests of all messages added since the last clear()
+   */
+  void
+  compute();
+
+  /**
+   * @brief get digest of the message at position
+   * @pre compute() has been called after the message was added
+   */
+  const ndn::ConstBufferPtr&
+  getDigest(size_t position) const
+  {
+    return m_digests.at(position);
+  }
+
+  size_t
+  size() const
+  {
+    return m_messages.size();
+  }
+
+  void
+  clear();
+
+  /**
+   * @brief whether messages are hashed in parallel lanes on this CPU
+   */
+  static bool
+  isParallel();
+
+private:
+  std::vector<std::pair<const uint8_t*, size_t> > m_messages;
+  std::vector<ndn::ConstBufferPtr> m_digests;
+};
+
+} // namespace repo
+
+#endif // REPO_STORAGE_SHA256_BATCH_HPP
@@ -0,0 +1,143 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPO_STORAGE_SHARD_PLACEMENT_HPP
+#define REPO_STORAGE_SHARD_PLACEMENT_HPP
+
+#include "../common.hpp"
+
+#include <map>
+
+namespace repo {
+
+/**
+ * @brief rule placing Data in shards by name
+ *
+ * Data under a prefix added by addPrefix go to the shard of the longest such prefix. Other
+ * Data are placed among hashed shards by a hash of their name without a trailing segment
+ * number, so all segments of an object are placed in the same shard.
+ *
+ * Everything is inline, so that tools writing shard databases directly place Data as the
+ * repo does.
+ */
+class ShardPlacement
+{
+public:
+  class Error : public std::runtime_error
+  {
+  public:
+    explicit
+    Error(const std::string& what)
+      : std::runtime_error(what)
+    {
+    }
+  };
+
+  ShardPlacement()
+    : m_nShards(0)
+  {
+  }
+
+  /**
+   *  @brief  add a shard
+   *  @param  isHashed  whether Data not under a prefix may be placed in this shard
+   *  @return index of the shard
+   */
+  size_t
+  addShard(bool isHashed)
+  {
+    if (isHashed)
+      m_hashedShards.push_back(m_nShards);
+    return m_nShards++;
+  }
+
+  /**
+   *  @brief  place Data under prefix in a shard
+   */
+  void
+  addPrefix(const Name& prefix, size_t shardIndex)
+  {
+    if (shardIndex >= m_nShards)
+      throw Error("Shard of prefix " + prefix.toUri() + " does not exist");
+    m_prefixes[prefix] = shardIndex;
+  }
+
+  /**
+   *  @brief  get the index of the shard a Data name is placed in
+   */
+  size_t
+  findShard(const Name& name) const
+  {
+    if (!m_prefixes.empty()) {
+      for (ssize_t length = name.size(); length >= 0; --length) {
+        std::map<Name, size_t>::const_iterator prefix =
+          m_prefixes.find(name.getPrefix(length));
+        if (prefix != m_prefixes.end())
+          return prefix->second;
+      }
+    }
+    if (m_hashedShards.empty())
+      throw Error("No shard for " + name.toUri());
+    if (m_hashedShards.size() == 1)
+      return m_hashedShards[0];
+
+    // segments of one object share a shard, so that they can be packed together
+    Name objectName = name;
+    try {
+      if (!name.empty()) {
+        name.get(-1).toSegment();
+        objectName = name.getPrefix(-1);
+      }
+    }
+    catch (ndn::Tlv::Error&) {
+    }
+    return m_hashedShards[hashName(objectName) % m_hashedShards.size()];
+  }
+
+  size_t
+  size() const
+  {
+    return m_nShards;
+  }
+
+private:
+  /**
+   * @brief FNV-1a hash of the name encoding, stable across restarts and platforms
+   */
+  static uint64_t
+  hashName(const Name& name)
+  {
+    uint64_t hash = 14695981039346656037ULL;
+    const Block& wire = name.wireEncode();
+    for (Block::const_iterator it = wire.value_begin(); it != wire.value_end(); ++it) {
+      hash ^= *it;
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+private:
+  size_t m_nShards;
+  std::vector<size_t> m_hashedShards;
+  std::map<Name, size_t> m_prefixes;
+};
+
+} // namespace repo
+
+#endif // REPO_STORAGE_SHARD_PLACEMENT_HPP
@@ -0,0 +1,364 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sharded-storage.hpp"
+
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <deque>
+
+namespace repo {
+
+/**
+ * @brief entries a shard thread may enumerate ahead of the caller
+ */
+static const size_t ENUMERATION_QUEUE_SIZE = 4096;
+
+/**
+ * @brief bounded queue carrying entries from the threads enumerating shards to the caller
+ *
+ * A shard thread waits while the queue is full, so memory does not grow with the number
+ * of entries. Once the queue is stopped, because the caller failed or a shard failed,
+ * pushing throws Stopped to end the enumeration of the shard.
+ */
+class EnumerationQueue : noncopyable
+{
+public:
+  class Stopped
+  {
+  };
+
+  typedef std::pair<size_t, Storage::ItemMeta> Item;
+
+  explicit
+  EnumerationQueue(size_t nShards)
+    : m_nRunning(nShards)
+    , m_isStopping(false)
+  {
+  }
+
+  void
+  push(size_t shardIndex, const Storage::ItemMeta& item)
+  {
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    while (!m_isStopping && m_items.size() >= ENUMERATION_QUEUE_SIZE)
+      m_space.wait(lock);
+    if (m_isStopping)
+      throw Stopped();
+    m_items.push_back(Item(shardIndex, item));
+    m_produced.notify_one();
+  }
+
+  /**
+   * @brief record that a shard thread has ended
+   * @param error  reason of failure, empty if the shard is fully enumerated
+   */
+  void
+  finish(const std::string& error)
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    --m_nRunning;
+    if (!error.empty() && m_error.empty()) {
+      m_error = error;
+      m_isStopping = true;
+      m_space.notify_all();
+    }
+    m_produced.notify_one();
+  }
+
+  /**
+   * @brief take the next entry, waiting for shard threads if necessary
+   * @return false if all shards are enumerated, or the queue is stopped
+   */
+  bool
+  pop(Item& item)
+  {
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    while (!m_isStopping && m_items.empty() && m_nRunning > 0)
+      m_produced.wait(lock);
+    if (m_isStopping || m_items.empty())
+      return false;
+    item = m_items.front();
+    m_items.pop_front();
+    m_space.notify_one();
+    return true;
+  }
+
+  void
+  stop()
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    m_isStopping = true;
+    m_space.notify_all();
+  }
+
+  std::string
+  getError()
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    return m_error;
+  }
+
+private:
+  boost::mutex m_mutex;
+  boost::condition_variable m_space;
+  boost::condition_variable m_produced;
+  std::deque<Item> m_items;
+  size_t m_nRunning;
+  bool m_isStopping;
+  std::string m_error;
+};
+
+static void
+enumerateShard(Storage* shard, size_t shardIndex, EnumerationQueue* queue)
+{
+  std::string error;
+  try {
+    shard->fullEnumerate(bind(&EnumerationQueue::push, queue, shardIndex, _1));
+  }
+  catch (EnumerationQueue::Stopped&) {
+  }
+  catch (std::exception& e) {
+    error = "Enumeration of shard " + boost::lexical_cast<std::string>(shardIndex) +
+            " failed: " + e.what();
+  }
+  queue->finish(error);
+}
+
+size_t
+ShardedStorage::addShard(const shared_ptr<Storage>& shard, bool isHashed)
+{
+  m_shards.push_back(shard);
+  return m_placement.addShard(isHashed);
+}
+
+void
+ShardedStorage::addPrefix(const Name& prefix, size_t shardIndex)
+{
+  try {
+    m_placement.addPrefix(prefix, shardIndex);
+  }
+  catch (ShardPlacement::Error& e) {
+    throw Error(e.what());
+  }
+}
+
+size_t
+ShardedStorage::findShard(const Name& name) const
+{
+  try {
+    return m_placement.findShard(name);
+  }
+  catch (ShardPlacement::Error& e) {
+    throw Error(e.what());
+  }
+}
+
+int64_t
+ShardedStorage::encodeId(size_t shardIndex, int64_t shardId) const
+{
+  int64_t n = m_shards.size();
+  if (shardId < 0)
+    return -(-shardId * n + shardIndex);
+  return shardId * n + shardIndex;
+}
+
+size_t
+ShardedStorage::getShardIndex(int64_t id) const
+{
+  return static_cast<size_t>((id < 0 ? -id : id) % static_cast<int64_t>(m_shards.size()));
+}
+
+int64_t
+ShardedStorage::getShardId(int64_t id) const
+{
+  int64_t n = m_shards.size();
+  if (id < 0)
+    return -(-id / n);
+  return id / n;
+}
+
+int64_t
+ShardedStorage::insert(const Data& data)
+{
+  size_t shardIndex = findShard(data.getName());
+  int64_t id = m_shards[shardIndex]->insert(data);
+  if (id == -1)
+    return -1;
+  return encodeId(shardIndex, id);
+}
+
+int64_t
+ShardedStorage::insert(const Data& data, const ItemMeta& item, const int64_t expiry)
+{
+  size_t shardIndex = findShard(data.getName());
+  int64_t id = m_shards[shardIndex]->insert(data, item, expiry);
+  if (id == -1)
+    return -1;
+  return encodeId(shardIndex, id);
+}
+
+bool
+ShardedStorage::erase(const int64_t id)
+{
+  return m_shards[getShardIndex(id)]->erase(getShardId(id));
+}
+
+size_t
+ShardedStorage::erase(const std::vector<int64_t>& ids)
+{
+  std::vector<std::vector<int64_t> > shardIds(m_shards.size());
+  for (std::vector<int64_t>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+    shardIds[getShardIndex(*it)].push_back(getShardId(*it));
+
+  size_t nErased = 0;
+  for (size_t i = 0; i < m_shards.size(); ++i) {
+    if (!shardIds[i].empty())
+      nErased += m_shards[i]->erase(shardIds[i]);
+  }
+  return nErased;
+}
+
+std::vector<std::pair<int64_t, Name> >
+ShardedStorage::getExpired(const int64_t now, const size_t limit)
+{
+  std::vector<std::vector<std::pair<int64_t, Name> > > shardExpired(m_shards.size());
+  for (size_t i = 0; i < m_shards.size(); ++i)
+    shardExpired[i] = m_shards[i]->getExpired(now, limit);
+
+  std::vector<std::pair<int64_t, Name> > expired;
+  for (size_t position = 0; expired.size() < limit; ++position) {
+    bool hasMore = false;
+    for (size_t i = 0; i < m_shards.size() && expired.size() < limit; ++i) {
+      if (position >= shardExpired[i].size())
+        continue;
+      hasMore = true;
+      expired.push_back(std::make_pair(encodeId(i, shardExpired[i][position].first),
+                                       shardExpired[i][position].second));
+    }
+    if (!hasMore)
+      break;
+  }
+  return expired;
+}
+
+shared_ptr<Data>
+ShardedStorage::read(const int64_t id)
+{
+  return m_shards[getShardIndex(id)]->read(getShardId(id));
+}
+
+int64_t
+ShardedStorage::size()
+{
+  int64_t size = 0;
+  for (size_t i = 0; i < m_shards.size(); ++i)
+    size += m_shards[i]->size();
+  return size;
+}
+
+void
+ShardedStorage::fullEnumerate(const ndn::function<void(const Storage::ItemMeta)>& f)
+{
+  EnumerationQueue queue(m_shards.size());
+  boost::thread_group threads;
+  for (size_t i = 0; i < m_shards.size(); ++i)
+    threads.create_thread(bind(&enumerateShard, m_shards[i].get(), i, &queue));
+
+  EnumerationQueue::Item item;
+  try {
+    while (queue.pop(item)) {
+      item.second.id = encodeId(item.first, item.second.id);
+      f(item.second);
+    }
+  }
+  catch (...) {
+    queue.stop();
+    threads.join_all();
+    throw;
+  }
+  threads.join_all();
+
+  std::string error = queue.getError();
+  if (!error.empty())
+    throw Error(error);
+}
+
+std::vector<int64_t>
+ShardedStorage::packObject(const std::vector<int64_t>& ids)
+{
+  std::vector<int64_t> newIds;
+  if (ids.empty())
+    return newIds;
+
+  size_t shardIndex = getShardIndex(ids[0]);
+  std::vector<int64_t> shardIds;
+  shardIds.reserve(ids.size());
+  for (std::vector<int64_t>::const_iterator it = ids.begin(); it != ids.end(); ++it) {
+    if (getShardIndex(*it) != shardIndex)
+      return newIds;
+    shardIds.push_back(getShardId(*it));
+  }
+
+  std::vector<int64_t> newShardIds = m_shards[shardIndex]->packObject(shardIds);
+  newIds.reserve(newShardIds.size());
+  for (std::vector<int64_t>::const_iterator it = newShardIds.begin();
+       it != newShardIds.end(); ++it)
+    newIds.push_back(encodeId(shardIndex, *it));
+  return newIds;
+}
+
+void
+ShardedStorage::prepareMaintenance()
+{
+  for (size_t i = 0; i < m_shards.size(); ++i)
+    m_shards[i]->prepareMaintenance();
+}
+
+Storage::MaintenanceStatus
+ShardedStorage::maintain(size_t checkpointPages, const ndn::time::milliseconds& checkpointPause)
+{
+  MaintenanceStatus status;
+  for (size_t i = 0; i < m_shards.size(); ++i) {
+    MaintenanceStatus shardStatus = m_shards[i]->maintain(checkpointPages, checkpointPause);
+    status.walSize += shardStatus.walSize;
+    status.nFreePages += shardStatus.nFreePages;
+    status.nReclaimedPages += shardStatus.nReclaimedPages;
+  }
+  return status;
+}
+
+Storage::MaintenanceStatus
+ShardedStorage::reclaimSpace(uint64_t walTruncateSize, size_t maxReclaimedPages)
+{
+  MaintenanceStatus status;
+  for (size_t i = 0; i < m_shards.size(); ++i) {
+    MaintenanceStatus shardStatus = m_shards[i]->reclaimSpace(walTruncateSize,
+                                                              maxReclaimedPages);
+    status.walSize += shardStatus.walSize;
+    status.nFreePages += shardStatus.nFreePages;
+    status.nReclaimedPages += shardStatus.nReclaimedPages;
+  }
+  return status;
+}
+
+} // namespace repo
@@ -0,0 +1,145 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPO_STORAGE_SHARDED_STORAGE_HPP
+#define REPO_STORAGE_SHARDED_STORAGE_HPP
+
+#include "storage.hpp"
+#include "shard-placement.hpp"
+
+namespace repo {
+
+/**
+ * @brief Storage spreading Data over several storages, usually databases on different disks
+ *
+ * Data are placed in shards by a ShardPlacement, so all segments of an object are stored in
+ * the same shard.
+ *
+ * Each shard numbers its own entries. An ID of the sharded storage keeps the sign of the
+ * shard ID, and its magnitude is the magnitude of the shard ID times the number of shards
+ * plus the shard index, so routing an ID is one division.
+ */
+class ShardedStorage : public Storage
+{
+public:
+  class Error : public std::runtime_error
+  {
+  public:
+    explicit
+    Error(const std::string& what)
+      : std::runtime_error(what)
+    {
+    }
+  };
+
+  /**
+   *  @brief  add a shard, before any Data is inserted or enumerated
+   *  @param  isHashed  whether Data not under a prefix may be placed in this shard
+   *  @return index of the shard
+   */
+  size_t
+  addShard(const shared_ptr<Storage>& shard, bool isHashed);
+
+  /**
+   *  @brief  place Data under prefix in a shard
+   */
+  void
+  addPrefix(const Name& prefix, size_t shardIndex);
+
+  /**
+   *  @brief  get the index of the shard a Data name is placed in
+   */
+  size_t
+  findShard(const Name& name) const;
+
+  virtual int64_t
+  insert(const Data& data);
+
+  virtual int64_t
+  insert(const Data& data, const ItemMeta& item, const int64_t expiry);
+
+  virtual bool
+  erase(const int64_t id);
+
+  virtual size_t
+  erase(const std::vector<int64_t>& ids);
+
+  /**
+   *  @brief  get expired entries of all shards
+   *
+   *  Entries are taken from the shards in turn, so they are earliest first within each
+   *  shard only.
+   */
+  virtual std::vector<std::pair<int64_t, Name> >
+  getExpired(const int64_t now, const size_t limit);
+
+  virtual shared_ptr<Data>
+  read(const int64_t id);
+
+  virtual int64_t
+  size();
+
+  /**
+   *  @brief  enumerate the shards in parallel, one thread each
+   *
+   *  f is called from the calling thread as entries arrive through a bounded queue, while
+   *  shards are still being enumerated, so it must not use the shards.
+   */
+  virtual void
+  fullEnumerate(const ndn::function<void(const Storage::ItemMeta)>& f);
+
+  /**
+   *  @brief  pack an object whose entries are all in one shard
+   */
+  virtual std::vector<int64_t>
+  packObject(const std::vector<int64_t>& ids);
+
+  virtual void
+  prepareMaintenance();
+
+  /**
+   *  @brief  maintain every shard in turn
+   */
+  virtual MaintenanceStatus
+  maintain(size_t checkpointPages, const ndn::time::milliseconds& checkpointPause);
+
+  /**
+   *  @brief  reclaim space of every shard in turn, each reclaiming at most maxReclaimedPages
+   */
+  virtual MaintenanceStatus
+  reclaimSpace(uint64_t walTruncateSize, size_t maxReclaimedPages);
+
+private:
+  int64_t
+  encodeId(size_t shardIndex, int64_t shardId) const;
+
+  size_t
+  getShardIndex(int64_t id) const;
+
+  int64_t
+  getShardId(int64_t id) const;
+
+private:
+  std::vector<shared_ptr<Storage> > m_shards;
+  ShardPlacement m_placement;
+};
+
+} // namespace repo
+
+#endif // REPO_STORAGE_SHARDED_STORAGE_HPP
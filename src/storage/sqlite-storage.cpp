@@ -20,13 +20,153 @@
 
 #include "sqlite-storage.hpp"
 #include "index.hpp"
+#include "throttled-vfs.hpp"
+#include <ndn-cxx/util/crypto.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
 #include <istream>
 
 namespace repo {
 
-SqliteStorage::SqliteStorage(const string& dbPath)
-  : m_size(0)
+/**
+ * Data moved into an object get negative IDs that carry the object ID and segment index,
+ * so that a segment is found by arithmetic on the offset table of its object.
+ */
+static const int OBJECT_ID_SHIFT = 32;
+static const uint64_t MAX_OBJECT_SEGMENTS = static_cast<uint64_t>(1) << OBJECT_ID_SHIFT;
+
+/**
+ * A larger object is split into several extents, which also stay below the sqlite limit on
+ * the size of a BLOB
+ */
+static const uint64_t MAX_EXTENT_SIZE = 64 * 1024 * 1024;
+
+static const size_t OFFSET_SIZE = 8;
+
+/**
+ * Milliseconds a connection waits for a lock held by the other connection of the same
+ * storage; maintain, which may run on its own thread, never holds the write lock, so this
+ * is short and keeps the event loop going
+ */
+static const int WRITE_BUSY_TIMEOUT = 100;
+
+static bool
+isObjectSegment(int64_t id)
+{
+  return id < 0;
+}
+
+static int64_t
+makeSegmentId(int64_t objectId, size_t index)
+{
+  return -((objectId << OBJECT_ID_SHIFT) | static_cast<int64_t>(index));
+}
+
+static int64_t
+getObjectId(int64_t segmentId)
+{
+  return (-segmentId) >> OBJECT_ID_SHIFT;
+}
+
+static size_t
+getSegmentIndex(int64_t segmentId)
+{
+  return static_cast<size_t>((-segmentId) & (MAX_OBJECT_SEGMENTS - 1));
+}
+
+static void
+appendOffset(ndn::Buffer& buffer, uint64_t offset)
+{
+  for (int i = OFFSET_SIZE - 1; i >= 0; --i)
+    buffer.push_back(static_cast<uint8_t>(offset >> (8 * i)));
+}
+
+static bool
+isEarlierExpiry(const std::pair<int64_t, std::pair<int64_t, Name> >& a,
+                const std::pair<int64_t, std::pair<int64_t, Name> >& b)
+{
+  return a.first < b.first;
+}
+
+/**
+ * @return the first column of the first row returned by sql, or 0 if there is none
+ */
+static int64_t
+queryInteger(sqlite3* db, const char* sql)
+{
+  sqlite3_stmt* stmt = 0;
+  int64_t value = 0;
+  if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) == SQLITE_OK &&
+      sqlite3_step(stmt) == SQLITE_ROW)
+    value = sqlite3_column_int64(stmt, 0);
+  sqlite3_finalize(stmt);
+  return value;
+}
+
+static void
+decodeOffsets(const uint8_t* buffer, size_t size, std::vector<uint64_t>& offsets)
+{
+  offsets.resize(size / OFFSET_SIZE);
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    uint64_t offset = 0;
+    for (size_t j = 0; j < OFFSET_SIZE; ++j)
+      offset = (offset << 8) | buffer[i * OFFSET_SIZE + j];
+    offsets[i] = offset;
+  }
+}
+
+/**
+ * @return TLV-VALUE of the longest prefix shared by the names of an object, concatenated
+ *         in names, which lets prefix queries find the object through an index
+ */
+static ndn::Buffer
+getObjectNameKey(const uint8_t* names, size_t size)
+{
+  Name prefix;
+  size_t offset = 0;
+  Block nameBlock;
+  for (bool isFirst = true;
+       offset < size && Block::fromBuffer(names + offset, size - offset, nameBlock);
+       isFirst = false) {
+    offset += nameBlock.size();
+    Name name(nameBlock);
+    if (isFirst) {
+      prefix = name;
+      continue;
+    }
+    size_t length = 0;
+    while (length < prefix.size() && length < name.size() && prefix[length] == name[length])
+      ++length;
+    prefix = prefix.getPrefix(length);
+  }
+  const Block& prefixWire = prefix.wireEncode();
+  return ndn::Buffer(prefixWire.value_begin(), prefixWire.value_end());
+}
+
+/**
+ * @brief bind a nameKey, which is empty for an object without a shared prefix
+ *
+ * An empty buffer may have a null pointer, which sqlite would bind as NULL.
+ */
+static int
+bindNameKey(sqlite3_stmt* stmt, int index, const ndn::Buffer& nameKey)
+{
+  if (nameKey.empty())
+    return sqlite3_bind_zeroblob(stmt, index, 0);
+  return sqlite3_bind_blob(stmt, index, nameKey.buf(), nameKey.size(), 0);
+}
+
+SqliteStorage::SqliteStorage(const string& dbPath, size_t dedupMinSize,
+                             const Compression& compression)
+  : m_maintenanceDb(0)
+  , m_insertStmt(0)
+  , m_insertContentStmt(0)
+  , m_dedupMinSize(dedupMinSize)
+  , m_compression(compression)
+  , m_objectBlob(0)
+  , m_objectBlobId(0)
+  , m_objectOffsetsId(0)
+  , m_size(0)
 {
   if (dbPath.empty()) {
     std::cerr << "Create db file in local location [" << dbPath << "]. " << std::endl
@@ -63,11 +203,15 @@ SqliteStorage::initializeRepo()
                            );
 
   if (rc == SQLITE_OK) {
+    // only takes effect for a new database, before its first table is created
+    sqlite3_exec(m_db, "PRAGMA auto_vacuum = INCREMENTAL", 0, 0, &errMsg);
     sqlite3_exec(m_db, "CREATE TABLE NDN_REPO ("
                       "id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
                       "name BLOB, "
                       "data BLOB, "
-                      "keylocatorHash BLOB);\n "
+                      "keylocatorHash BLOB, "
+                      "nameKey BLOB, "
+                      "expiry INTEGER);\n "
                  , 0, 0, &errMsg);
     // Ignore errors (when database already exists, errors are expected)
   }
@@ -77,10 +221,169 @@ SqliteStorage::initializeRepo()
   }
   sqlite3_exec(m_db, "PRAGMA synchronous = OFF", 0, 0, &errMsg);
   sqlite3_exec(m_db, "PRAGMA journal_mode = WAL", 0, 0, &errMsg);
+
+  // databases created before nameKey existed get the column here (error is expected otherwise)
+  sqlite3_exec(m_db, "ALTER TABLE NDN_REPO ADD COLUMN nameKey BLOB;", 0, 0, &errMsg);
+  fillNameKeys();
+  sqlite3_exec(m_db, "CREATE INDEX IF NOT EXISTS NDN_REPO_NAME_KEY ON NDN_REPO (nameKey);",
+               0, 0, &errMsg);
+  sqlite3_exec(m_db, "ALTER TABLE NDN_REPO ADD COLUMN expiry INTEGER;", 0, 0, &errMsg);
+  sqlite3_exec(m_db, "CREATE INDEX IF NOT EXISTS NDN_REPO_EXPIRY ON NDN_REPO (expiry);",
+               0, 0, &errMsg);
+
+  // shared payloads; a record refers to one by contentHash, and has its data column
+  // stripped of the payload at contentOffset
+  sqlite3_exec(m_db, "ALTER TABLE NDN_REPO ADD COLUMN contentHash BLOB;", 0, 0, &errMsg);
+  sqlite3_exec(m_db, "ALTER TABLE NDN_REPO ADD COLUMN contentOffset INTEGER;", 0, 0, &errMsg);
+  // size of the data column before compression, NULL if it is not compressed
+  sqlite3_exec(m_db, "ALTER TABLE NDN_REPO ADD COLUMN rawSize INTEGER;", 0, 0, &errMsg);
+  sqlite3_exec(m_db, "CREATE TABLE IF NOT EXISTS NDN_REPO_CONTENT ("
+                     "hash BLOB NOT NULL PRIMARY KEY, "
+                     "content BLOB, "
+                     "refCount INTEGER NOT NULL);"
+                     "CREATE TRIGGER IF NOT EXISTS NDN_REPO_CONTENT_ACQUIRE "
+                     "AFTER INSERT ON NDN_REPO WHEN new.contentHash IS NOT NULL BEGIN "
+                     "UPDATE NDN_REPO_CONTENT SET refCount = refCount + 1 "
+                     "WHERE hash = new.contentHash; "
+                     "END;"
+                     "CREATE TRIGGER IF NOT EXISTS NDN_REPO_CONTENT_RELEASE "
+                     "AFTER DELETE ON NDN_REPO WHEN old.contentHash IS NOT NULL BEGIN "
+                     "UPDATE NDN_REPO_CONTENT SET refCount = refCount - 1 "
+                     "WHERE hash = old.contentHash; "
+                     "DELETE FROM NDN_REPO_CONTENT "
+                     "WHERE hash = old.contentHash AND refCount <= 0; "
+                     "END;"
+                     // payloads left unreferenced by an insert that failed after storing them
+                     "DELETE FROM NDN_REPO_CONTENT WHERE refCount <= 0;",
+               0, 0, &errMsg);
+
+  // objects packed from segments; see packObject
+  sqlite3_exec(m_db, "CREATE TABLE IF NOT EXISTS NDN_REPO_OBJECT ("
+                     "id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+                     "extent BLOB, "
+                     "offsets BLOB, "
+                     "names BLOB, "
+                     "keylocatorHash BLOB, "
+                     "live BLOB, "
+                     "nLive INTEGER NOT NULL, "
+                     "expiry INTEGER, "
+                     "nameKey BLOB);"
+                     "CREATE INDEX IF NOT EXISTS NDN_REPO_OBJECT_EXPIRY "
+                     "ON NDN_REPO_OBJECT (expiry);",
+               0, 0, &errMsg);
+  // objects packed before nameKey existed get the column here (error is expected otherwise)
+  sqlite3_exec(m_db, "ALTER TABLE NDN_REPO_OBJECT ADD COLUMN nameKey BLOB;", 0, 0, &errMsg);
+  fillObjectNameKeys();
+  sqlite3_exec(m_db, "CREATE INDEX IF NOT EXISTS NDN_REPO_OBJECT_NAME_KEY "
+                     "ON NDN_REPO_OBJECT (nameKey);",
+               0, 0, &errMsg);
+
+  prepareInsertStatement();
+}
+
+void
+SqliteStorage::prepareInsertStatement()
+{
+  string insertSql = string("INSERT INTO NDN_REPO "
+                            "(id, name, data, keylocatorHash, nameKey, expiry, "
+                            "contentHash, contentOffset, rawSize) "
+                            "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)");
+  string insertContentSql = string("INSERT OR IGNORE INTO NDN_REPO_CONTENT "
+                                   "(hash, content, refCount) VALUES (?, ?, 0)");
+
+  if (sqlite3_prepare_v2(m_db, insertSql.c_str(), -1, &m_insertStmt, 0) != SQLITE_OK ||
+      sqlite3_prepare_v2(m_db, insertContentSql.c_str(), -1, &m_insertContentStmt, 0)
+        != SQLITE_OK) {
+    sqlite3_finalize(m_insertStmt);
+    sqlite3_finalize(m_insertContentStmt);
+    m_insertStmt = 0;
+    m_insertContentStmt = 0;
+    std::cerr << "insert sql not prepared" << std::endl;
+    throw Error("insert sql not prepared");
+  }
+}
+
+void
+SqliteStorage::fillNameKeys()
+{
+  sqlite3_stmt* selectStmt = 0;
+  sqlite3_stmt* updateStmt = 0;
+  string selectSql("SELECT id, name FROM NDN_REPO WHERE nameKey IS NULL;");
+  string updateSql("UPDATE NDN_REPO SET nameKey = ? WHERE id = ?;");
+  if (sqlite3_prepare_v2(m_db, selectSql.c_str(), -1, &selectStmt, 0) != SQLITE_OK ||
+      sqlite3_prepare_v2(m_db, updateSql.c_str(), -1, &updateStmt, 0) != SQLITE_OK) {
+    sqlite3_finalize(selectStmt);
+    sqlite3_finalize(updateStmt);
+    throw Error("nameKey statement prepared failed");
+  }
+
+  sqlite3_exec(m_db, "BEGIN TRANSACTION;", 0, 0, 0);
+  int rc = SQLITE_DONE;
+  while ((rc = sqlite3_step(selectStmt)) == SQLITE_ROW) {
+    Block nameBlock(sqlite3_column_blob(selectStmt, 1), sqlite3_column_bytes(selectStmt, 1));
+    if (sqlite3_bind_blob(updateStmt, 1, nameBlock.value(), nameBlock.value_size(), 0)
+          != SQLITE_OK ||
+        sqlite3_bind_int64(updateStmt, 2, sqlite3_column_int64(selectStmt, 0)) != SQLITE_OK ||
+        sqlite3_step(updateStmt) != SQLITE_DONE) {
+      rc = SQLITE_ERROR;
+      break;
+    }
+    sqlite3_reset(updateStmt);
+  }
+  sqlite3_finalize(selectStmt);
+  sqlite3_finalize(updateStmt);
+  if (rc != SQLITE_DONE) {
+    sqlite3_exec(m_db, "ROLLBACK;", 0, 0, 0);
+    std::cerr << "nameKey update error rc:" << rc << std::endl;
+    throw Error("nameKey update error");
+  }
+  sqlite3_exec(m_db, "COMMIT;", 0, 0, 0);
+}
+
+void
+SqliteStorage::fillObjectNameKeys()
+{
+  sqlite3_stmt* selectStmt = 0;
+  sqlite3_stmt* updateStmt = 0;
+  string selectSql("SELECT id, names FROM NDN_REPO_OBJECT WHERE nameKey IS NULL;");
+  string updateSql("UPDATE NDN_REPO_OBJECT SET nameKey = ? WHERE id = ?;");
+  if (sqlite3_prepare_v2(m_db, selectSql.c_str(), -1, &selectStmt, 0) != SQLITE_OK ||
+      sqlite3_prepare_v2(m_db, updateSql.c_str(), -1, &updateStmt, 0) != SQLITE_OK) {
+    sqlite3_finalize(selectStmt);
+    sqlite3_finalize(updateStmt);
+    throw Error("object nameKey statement prepared failed");
+  }
+
+  sqlite3_exec(m_db, "BEGIN TRANSACTION;", 0, 0, 0);
+  int rc = SQLITE_DONE;
+  while ((rc = sqlite3_step(selectStmt)) == SQLITE_ROW) {
+    ndn::Buffer nameKey =
+      getObjectNameKey(static_cast<const uint8_t*>(sqlite3_column_blob(selectStmt, 1)),
+                       sqlite3_column_bytes(selectStmt, 1));
+    if (bindNameKey(updateStmt, 1, nameKey) != SQLITE_OK ||
+        sqlite3_bind_int64(updateStmt, 2, sqlite3_column_int64(selectStmt, 0)) != SQLITE_OK ||
+        sqlite3_step(updateStmt) != SQLITE_DONE) {
+      rc = SQLITE_ERROR;
+      break;
+    }
+    sqlite3_reset(updateStmt);
+  }
+  sqlite3_finalize(selectStmt);
+  sqlite3_finalize(updateStmt);
+  if (rc != SQLITE_DONE) {
+    sqlite3_exec(m_db, "ROLLBACK;", 0, 0, 0);
+    std::cerr << "object nameKey update error rc:" << rc << std::endl;
+    throw Error("object nameKey update error");
+  }
+  sqlite3_exec(m_db, "COMMIT;", 0, 0, 0);
 }
 
 SqliteStorage::~SqliteStorage()
 {
+  sqlite3_finalize(m_insertStmt);
+  sqlite3_finalize(m_insertContentStmt);
+  closeObjectBlob();
+  sqlite3_close(m_maintenanceDb);
   sqlite3_close(m_db);
 }
 
@@ -90,7 +393,9 @@ SqliteStorage::fullEnumerate(const ndn::function
 {
   sqlite3_stmt* m_stmt = 0;
   int rc = SQLITE_DONE;
-  string sql = string("SELECT id, name, keylocatorHash FROM NDN_REPO;");
+  string sql = string("SELECT id, name, keylocatorHash, ifnull(rawSize, length(data)) + "
+                      "ifnull((SELECT length(content) FROM NDN_REPO_CONTENT "
+                      "WHERE hash = NDN_REPO.contentHash), 0) FROM NDN_REPO;");
   rc = sqlite3_prepare_v2(m_db, sql.c_str(), -1, &m_stmt, 0);
   if (rc != SQLITE_OK)
     throw Error("Initiation Read Entries from Database Prepare error");
@@ -104,7 +409,8 @@ SqliteStorage::fullEnumerate(const ndn::function
                                      sqlite3_column_bytes(m_stmt, 1)));
       item.id = sqlite3_column_int(m_stmt, 0);
       item.keyLocatorHash = make_shared<const ndn::Buffer>
-        (ndn::Buffer(sqlite3_column_blob(m_stmt, 3), sqlite3_column_bytes(m_stmt, 3)));
+        (ndn::Buffer(sqlite3_column_blob(m_stmt, 2), sqlite3_column_bytes(m_stmt, 2)));
+      item.dataSize = sqlite3_column_int64(m_stmt, 3);
 
       try {
         f(item);
@@ -125,65 +431,129 @@ SqliteStorage::fullEnumerate(const ndn::function
       throw Error("Initiation Read Entries error");
     }
   }
+  entryNumber += enumerateObjects(f);
   m_size = entryNumber;
 }
 
 int64_t
 SqliteStorage::insert(const Data& data)
 {
-  Name name = data.getName();
+  return insert(data, 0);
+}
 
+int64_t
+SqliteStorage::insert(const Data& data, const int64_t expiry)
+{
   Index::Entry entry(data, 0); //the id is not used
-  int64_t id = -1;
-  if (name.empty()) {
+  ItemMeta item;
+  item.fullName = entry.getName();
+  item.keyLocatorHash = entry.getKeyLocatorHash();
+  item.dataSize = entry.getDataSize();
+  return insert(data, item, expiry);
+}
+
+int64_t
+SqliteStorage::insert(const Data& data, const ItemMeta& item, const int64_t expiry)
+{
+  if (data.getName().empty()) {
     std::cerr << "name is empty" << std::endl;
     return -1;
   }
+  closeObjectBlob();
 
-  int rc = 0;
+  // each encoding is taken once; Name and Data keep their wire encoding
+  const Block& nameWire = item.fullName.wireEncode();
+  const Block& dataWire = data.wireEncode();
+  const ndn::ConstBufferPtr& keyLocatorHash = item.keyLocatorHash;
 
-  sqlite3_stmt* insertStmt = 0;
+  ndn::Buffer stripped;
+  size_t contentOffset = 0;
+  ndn::ConstBufferPtr contentHash = storeContent(dataWire, stripped, contentOffset);
+  const uint8_t* stored = contentHash ? stripped.buf() : dataWire.wire();
+  size_t storedSize = contentHash ? stripped.size() : dataWire.size();
 
-  string insertSql = string("INSERT INTO NDN_REPO (id, name, data, keylocatorHash) "
-                            "VALUES (?, ?, ?, ?)");
+  ndn::Buffer compressed;
+  bool isCompressed = m_compression.compress(data.getName(), stored, storedSize, compressed);
 
-  if (sqlite3_prepare_v2(m_db, insertSql.c_str(), -1, &insertStmt, 0) != SQLITE_OK) {
-    sqlite3_finalize(insertStmt);
-    std::cerr << "insert sql not prepared" << std::endl;
-  }
   //Insert
-  if (sqlite3_bind_null(insertStmt, 1) == SQLITE_OK &&
-      sqlite3_bind_blob(insertStmt, 2,
-                        entry.getName().wireEncode().wire(),
-                        entry.getName().wireEncode().size(), 0) == SQLITE_OK &&
-      sqlite3_bind_blob(insertStmt, 3,
-                        data.wireEncode().wire(),
-                        data.wireEncode().size(),0 ) == SQLITE_OK &&
-      sqlite3_bind_blob(insertStmt, 4,
-                        (const void*)&(*entry.getKeyLocatorHash()),
-                        ndn::crypto::SHA256_DIGEST_SIZE,0) == SQLITE_OK) {
-    rc = sqlite3_step(insertStmt);
-    if (rc == SQLITE_CONSTRAINT) {
-      std::cerr << "Insert  failed" << std::endl;
-      sqlite3_finalize(insertStmt);
+  if (sqlite3_bind_null(m_insertStmt, 1) == SQLITE_OK &&
+      sqlite3_bind_blob(m_insertStmt, 2,
+                        nameWire.wire(), nameWire.size(), 0) == SQLITE_OK &&
+      (isCompressed ?
+         sqlite3_bind_blob(m_insertStmt, 3, compressed.buf(), compressed.size(), 0) :
+         sqlite3_bind_blob(m_insertStmt, 3, stored, storedSize, 0)) == SQLITE_OK &&
+      (keyLocatorHash ?
+         sqlite3_bind_blob(m_insertStmt, 4,
+                           keyLocatorHash->buf(), keyLocatorHash->size(), 0) :
+         sqlite3_bind_null(m_insertStmt, 4)) == SQLITE_OK &&
+      sqlite3_bind_blob(m_insertStmt, 5,
+                        nameWire.value(), nameWire.value_size(), 0) == SQLITE_OK &&
+      (expiry == 0 ? sqlite3_bind_null(m_insertStmt, 6) :
+                     sqlite3_bind_int64(m_insertStmt, 6, expiry)) == SQLITE_OK &&
+      (contentHash ?
+         sqlite3_bind_blob(m_insertStmt, 7, contentHash->buf(), contentHash->size(), 0) :
+         sqlite3_bind_null(m_insertStmt, 7)) == SQLITE_OK &&
+      (contentHash ? sqlite3_bind_int64(m_insertStmt, 8, contentOffset) :
+                     sqlite3_bind_null(m_insertStmt, 8)) == SQLITE_OK &&
+      (isCompressed ? sqlite3_bind_int64(m_insertStmt, 9, storedSize) :
+                      sqlite3_bind_null(m_insertStmt, 9)) == SQLITE_OK) {
+    int rc = sqlite3_step(m_insertStmt);
+    sqlite3_reset(m_insertStmt);
+    if (rc != SQLITE_DONE) {
+      std::cerr << "Insert  failed rc:" << rc << std::endl;
       throw Error("Insert failed");
-     }
-    sqlite3_reset(insertStmt);
-     m_size++;
-     id = sqlite3_last_insert_rowid(m_db);
+    }
+    m_size++;
+    return sqlite3_last_insert_rowid(m_db);
   }
   else {
+    sqlite3_reset(m_insertStmt);
     throw Error("Some error with insert");
   }
-
-  sqlite3_finalize(insertStmt);
-  return id;
 }
 
+ndn::ConstBufferPtr
+SqliteStorage::storeContent(const Block& dataWire, ndn::Buffer& stripped, size_t& offset)
+{
+  if (m_dedupMinSize == 0)
+    return ndn::ConstBufferPtr();
+
+  // elements of the parsed copy point into the same buffer as dataWire
+  Block wire = dataWire;
+  wire.parse();
+  Block::element_const_iterator content = wire.find(ndn::Tlv::Content);
+  if (content == wire.elements_end() || content->value_size() < m_dedupMinSize)
+    return ndn::ConstBufferPtr();
+
+  ndn::ConstBufferPtr hash = ndn::crypto::sha256(content->value(), content->value_size());
+  if (sqlite3_bind_blob(m_insertContentStmt, 1, hash->buf(), hash->size(), 0) != SQLITE_OK ||
+      sqlite3_bind_blob(m_insertContentStmt, 2,
+                        content->value(), content->value_size(), 0) != SQLITE_OK) {
+    sqlite3_reset(m_insertContentStmt);
+    throw Error("Some error with content insert");
+  }
+  int rc = sqlite3_step(m_insertContentStmt);
+  sqlite3_reset(m_insertContentStmt);
+  if (rc != SQLITE_DONE) {
+    std::cerr << "Content insert failed rc:" << rc << std::endl;
+    throw Error("Content insert failed");
+  }
+
+  offset = content->value() - dataWire.wire();
+  const uint8_t* valueEnd = content->value() + content->value_size();
+  stripped.reserve(dataWire.size() - content->value_size());
+  stripped.assign(dataWire.wire(), content->value());
+  stripped.insert(stripped.end(), valueEnd, dataWire.wire() + dataWire.size());
+  return hash;
+}
 
 bool
 SqliteStorage::erase(const int64_t id)
 {
+  closeObjectBlob();
+  if (isObjectSegment(id))
+    return eraseSegment(id);
+
   sqlite3_stmt* deleteStmt = 0;
 
   string deleteSql = string("DELETE from NDN_REPO where id = ?;");
@@ -201,8 +571,10 @@ SqliteStorage::erase(const int64_t id)
       sqlite3_finalize(deleteStmt);
       throw Error(" node delete error");
     }
-    if (sqlite3_changes(m_db) != 1)
+    if (sqlite3_changes(m_db) != 1) {
+      sqlite3_finalize(deleteStmt);
       return false;
+    }
     m_size--;
   }
   else {
@@ -215,19 +587,154 @@ SqliteStorage::erase(const int64_t id)
 }
 
 
+size_t
+SqliteStorage::erase(const std::vector<int64_t>& ids)
+{
+  sqlite3_stmt* deleteStmt = 0;
+
+  string deleteSql = string("DELETE from NDN_REPO where id = ?;");
+
+  if (sqlite3_prepare_v2(m_db, deleteSql.c_str(), -1, &deleteStmt, 0) != SQLITE_OK) {
+    sqlite3_finalize(deleteStmt);
+    std::cerr << "delete statement prepared failed" << std::endl;
+    throw Error("delete statement prepared failed");
+  }
+
+  closeObjectBlob();
+  size_t nErased = 0;
+  size_t nSegmentsErased = 0;
+  sqlite3_exec(m_db, "BEGIN TRANSACTION;", 0, 0, 0);
+  for (std::vector<int64_t>::const_iterator it = ids.begin(); it != ids.end(); ++it) {
+    if (isObjectSegment(*it)) {
+      try {
+        if (eraseSegment(*it))
+          ++nSegmentsErased;
+      }
+      catch (Error&) {
+        sqlite3_finalize(deleteStmt);
+        sqlite3_exec(m_db, "ROLLBACK;", 0, 0, 0);
+        m_size += nSegmentsErased;
+        throw;
+      }
+      continue;
+    }
+    if (sqlite3_bind_int64(deleteStmt, 1, *it) != SQLITE_OK) {
+      std::cerr << "delete bind error" << std::endl;
+      sqlite3_finalize(deleteStmt);
+      sqlite3_exec(m_db, "ROLLBACK;", 0, 0, 0);
+      throw Error("delete bind error");
+    }
+    int rc = sqlite3_step(deleteStmt);
+    if (rc != SQLITE_DONE && rc != SQLITE_ROW) {
+      std::cerr << " node delete error rc:" << rc << std::endl;
+      sqlite3_finalize(deleteStmt);
+      sqlite3_exec(m_db, "ROLLBACK;", 0, 0, 0);
+      throw Error(" node delete error");
+    }
+    nErased += sqlite3_changes(m_db);
+    sqlite3_reset(deleteStmt);
+  }
+  sqlite3_exec(m_db, "COMMIT;", 0, 0, 0);
+  sqlite3_finalize(deleteStmt);
+  m_size -= nErased;
+  return nErased + nSegmentsErased;
+}
+
+std::vector<std::pair<int64_t, Name> >
+SqliteStorage::getExpired(const int64_t now, const size_t limit)
+{
+  std::vector<std::pair<int64_t, Name> > expired;
+  sqlite3_stmt* queryStmt = 0;
+  string sql = string("SELECT id, name, expiry FROM NDN_REPO WHERE expiry <= ? "
+                      "ORDER BY expiry LIMIT ?;");
+  if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &queryStmt, 0) != SQLITE_OK) {
+    sqlite3_finalize(queryStmt);
+    std::cerr << "select statement prepared failed" << std::endl;
+    throw Error("select statement prepared failed");
+  }
+  if (sqlite3_bind_int64(queryStmt, 1, now) != SQLITE_OK ||
+      sqlite3_bind_int64(queryStmt, 2, limit) != SQLITE_OK) {
+    std::cerr << "select bind error" << std::endl;
+    sqlite3_finalize(queryStmt);
+    throw Error("select bind error");
+  }
+
+  // records and segments of objects are merged in expiry order
+  std::vector<std::pair<int64_t, std::pair<int64_t, Name> > > expiring;
+  int rc = SQLITE_DONE;
+  while ((rc = sqlite3_step(queryStmt)) == SQLITE_ROW) {
+    Name name;
+    name.wireDecode(Block(sqlite3_column_blob(queryStmt, 1),
+                          sqlite3_column_bytes(queryStmt, 1)));
+    expiring.push_back(std::make_pair(sqlite3_column_int64(queryStmt, 2),
+                                      std::make_pair(sqlite3_column_int64(queryStmt, 0), name)));
+  }
+  sqlite3_finalize(queryStmt);
+  if (rc != SQLITE_DONE) {
+    std::cerr << "Database query failure rc:" << rc << std::endl;
+    throw Error("Database query failure");
+  }
+
+  getExpiredSegments(now, limit, expiring);
+  std::stable_sort(expiring.begin(), expiring.end(), &isEarlierExpiry);
+  for (size_t i = 0; i < expiring.size() && i < limit; ++i)
+    expired.push_back(expiring[i].second);
+  return expired;
+}
+
 shared_ptr<Data>
 SqliteStorage::read(const int64_t id)
 {
+  if (isObjectSegment(id))
+    return readSegment(id);
+
   sqlite3_stmt* queryStmt = 0;
-  string sql = string("SELECT * FROM NDN_REPO WHERE id = ? ;");
+  string sql = string("SELECT NDN_REPO.data, NDN_REPO.contentOffset, NDN_REPO_CONTENT.content, "
+                      "NDN_REPO.rawSize "
+                      "FROM NDN_REPO LEFT JOIN NDN_REPO_CONTENT "
+                      "ON NDN_REPO.contentHash = NDN_REPO_CONTENT.hash "
+                      "WHERE NDN_REPO.id = ? ;");
   int rc = sqlite3_prepare_v2(m_db, sql.c_str(), -1, &queryStmt, 0);
   if (rc == SQLITE_OK) {
     if (sqlite3_bind_int64(queryStmt, 1, id) == SQLITE_OK) {
       rc = sqlite3_step(queryStmt);
       if (rc == SQLITE_ROW) {
         shared_ptr<Data> data(new Data());
-        data->wireDecode(Block(sqlite3_column_blob(queryStmt, 2),
-                              sqlite3_column_bytes(queryStmt, 2)));
+        const uint8_t* stored = static_cast<const uint8_t*>(sqlite3_column_blob(queryStmt, 0));
+        size_t storedSize = sqlite3_column_bytes(queryStmt, 0);
+        ndn::Buffer decompressed;
+        if (sqlite3_column_type(queryStmt, 3) != SQLITE_NULL) {
+          try {
+            m_compression.decompress(stored, storedSize, sqlite3_column_int64(queryStmt, 3),
+                                     decompressed);
+          }
+          catch (Compression::Error& e) {
+            sqlite3_finalize(queryStmt);
+            throw Error(e.what());
+          }
+          stored = decompressed.buf();
+          storedSize = decompressed.size();
+        }
+        if (sqlite3_column_type(queryStmt, 2) == SQLITE_NULL) {
+          data->wireDecode(Block(stored, storedSize));
+        }
+        else {
+          // put the shared payload back at its offset
+          size_t offset = sqlite3_column_int64(queryStmt, 1);
+          const uint8_t* content =
+            static_cast<const uint8_t*>(sqlite3_column_blob(queryStmt, 2));
+          size_t contentSize = sqlite3_column_bytes(queryStmt, 2);
+          if (offset > storedSize) {
+            sqlite3_finalize(queryStmt);
+            throw Error("Stored content offset is out of range");
+          }
+          shared_ptr<ndn::Buffer> wire = make_shared<ndn::Buffer>();
+          wire->reserve(storedSize + contentSize);
+          wire->assign(stored, stored + offset);
+          wire->insert(wire->end(), content, content + contentSize);
+          wire->insert(wire->end(), stored + offset, stored + storedSize);
+          data->wireDecode(Block(ndn::ConstBufferPtr(wire)));
+        }
         sqlite3_finalize(queryStmt);
         return data;
       }
@@ -259,7 +766,8 @@ int64_t
 SqliteStorage::size()
 {
   sqlite3_stmt* queryStmt = 0;
-  string sql("SELECT count(*) FROM NDN_REPO ");
+  string sql("SELECT (SELECT count(*) FROM NDN_REPO) + "
+             "ifnull((SELECT sum(nLive) FROM NDN_REPO_OBJECT), 0)");
   int rc = sqlite3_prepare_v2(m_db, sql.c_str(), -1, &queryStmt, 0);
   if (rc != SQLITE_OK)
     {
@@ -283,4 +791,504 @@ SqliteStorage::size()
   return nDatas;
 }
 
+std::vector<int64_t>
+SqliteStorage::packObject(const std::vector<int64_t>& ids)
+{
+  std::vector<int64_t> newIds;
+  if (ids.size() < 2)
+    return newIds;
+
+  // names, sizes, keyLocator hash and expiry are collected first, so that extents are
+  // allocated at their final size and filled one Data at a time
+  sqlite3_stmt* metaStmt = 0;
+  string metaSql("SELECT name, keylocatorHash, ifnull(rawSize, length(data)) + "
+                 "ifnull((SELECT length(content) FROM NDN_REPO_CONTENT "
+                 "WHERE hash = NDN_REPO.contentHash), 0), expiry FROM NDN_REPO WHERE id = ?;");
+  if (sqlite3_prepare_v2(m_db, metaSql.c_str(), -1, &metaStmt, 0) != SQLITE_OK) {
+    sqlite3_finalize(metaStmt);
+    throw Error("object statement prepared failed");
+  }
+  std::vector<ndn::Buffer> names(ids.size());
+  std::vector<uint64_t> sizes(ids.size());
+  ndn::Buffer keyLocatorHash;
+  bool hasKeyLocatorHash = false;
+  bool hasExpiry = false;
+  int64_t expiry = 0;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    if (isObjectSegment(ids[i]) ||
+        sqlite3_bind_int64(metaStmt, 1, ids[i]) != SQLITE_OK ||
+        sqlite3_step(metaStmt) != SQLITE_ROW) {
+      sqlite3_finalize(metaStmt);
+      return newIds;
+    }
+    const uint8_t* name = static_cast<const uint8_t*>(sqlite3_column_blob(metaStmt, 0));
+    names[i].assign(name, name + sqlite3_column_bytes(metaStmt, 0));
+    const uint8_t* hash = static_cast<const uint8_t*>(sqlite3_column_blob(metaStmt, 1));
+    ndn::Buffer thisHash(hash, sqlite3_column_bytes(metaStmt, 1));
+    bool hasThisHash = sqlite3_column_type(metaStmt, 1) != SQLITE_NULL;
+    sizes[i] = sqlite3_column_int64(metaStmt, 2);
+    bool hasThisExpiry = sqlite3_column_type(metaStmt, 3) != SQLITE_NULL;
+    int64_t thisExpiry = sqlite3_column_int64(metaStmt, 3);
+    sqlite3_reset(metaStmt);
+
+    // an object keeps one keyLocator hash for all its segments, and expires with its
+    // earliest expiring segment
+    if (i == 0) {
+      keyLocatorHash = thisHash;
+      hasKeyLocatorHash = hasThisHash;
+      hasExpiry = hasThisExpiry;
+      expiry = thisExpiry;
+    }
+    else if (hasThisHash != hasKeyLocatorHash || thisHash != keyLocatorHash ||
+             hasThisExpiry != hasExpiry) {
+      sqlite3_finalize(metaStmt);
+      return newIds;
+    }
+    else if (thisExpiry < expiry) {
+      expiry = thisExpiry;
+    }
+  }
+  sqlite3_finalize(metaStmt);
+
+  closeObjectBlob();
+  sqlite3_exec(m_db, "BEGIN TRANSACTION;", 0, 0, 0);
+  try {
+    size_t begin = 0;
+    while (begin < ids.size()) {
+      // an extent holds at least one Data, and more while it stays under MAX_EXTENT_SIZE
+      size_t end = begin + 1;
+      uint64_t extentSize = sizes[begin];
+      while (end < ids.size() && end - begin < MAX_OBJECT_SEGMENTS &&
+             extentSize + sizes[end] <= MAX_EXTENT_SIZE)
+        extentSize += sizes[end++];
+
+      std::vector<int64_t> extentIds(ids.begin() + begin, ids.begin() + end);
+      int64_t objectId = insertObject(extentIds,
+                                      std::vector<ndn::Buffer>(names.begin() + begin,
+                                                               names.begin() + end),
+                                      std::vector<uint64_t>(sizes.begin() + begin,
+                                                            sizes.begin() + end),
+                                      hasKeyLocatorHash ? &keyLocatorHash : 0,
+                                      hasExpiry ? expiry : 0);
+      for (size_t i = begin; i < end; ++i)
+        newIds.push_back(makeSegmentId(objectId, i - begin));
+      begin = end;
+    }
+  }
+  catch (Error&) {
+    sqlite3_exec(m_db, "ROLLBACK;", 0, 0, 0);
+    throw;
+  }
+  sqlite3_exec(m_db, "COMMIT;", 0, 0, 0);
+  return newIds;
+}
+
+int64_t
+SqliteStorage::insertObject(const std::vector<int64_t>& ids,
+                            const std::vector<ndn::Buffer>& names,
+                            const std::vector<uint64_t>& sizes,
+                            const ndn::Buffer* keyLocatorHash, int64_t expiry)
+{
+  ndn::Buffer offsets;
+  ndn::Buffer nameBlob;
+  uint64_t extentSize = 0;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    appendOffset(offsets, extentSize);
+    extentSize += sizes[i];
+    nameBlob.insert(nameBlob.end(), names[i].begin(), names[i].end());
+  }
+  appendOffset(offsets, extentSize);
+  std::vector<uint8_t> live(ids.size(), 1);
+  ndn::Buffer nameKey = getObjectNameKey(nameBlob.buf(), nameBlob.size());
+
+  sqlite3_stmt* insertStmt = 0;
+  string insertSql("INSERT INTO NDN_REPO_OBJECT "
+                   "(extent, offsets, names, keylocatorHash, live, nLive, expiry, nameKey) "
+                   "VALUES (?, ?, ?, ?, ?, ?, ?, ?);");
+  if (sqlite3_prepare_v2(m_db, insertSql.c_str(), -1, &insertStmt, 0) != SQLITE_OK ||
+      sqlite3_bind_zeroblob(insertStmt, 1, extentSize) != SQLITE_OK ||
+      sqlite3_bind_blob(insertStmt, 2, offsets.buf(), offsets.size(), 0) != SQLITE_OK ||
+      sqlite3_bind_blob(insertStmt, 3, nameBlob.buf(), nameBlob.size(), 0) != SQLITE_OK ||
+      (keyLocatorHash != 0 ?
+         sqlite3_bind_blob(insertStmt, 4, keyLocatorHash->buf(), keyLocatorHash->size(), 0) :
+         sqlite3_bind_null(insertStmt, 4)) != SQLITE_OK ||
+      sqlite3_bind_blob(insertStmt, 5, &live[0], live.size(), 0) != SQLITE_OK ||
+      sqlite3_bind_int64(insertStmt, 6, ids.size()) != SQLITE_OK ||
+      (expiry == 0 ? sqlite3_bind_null(insertStmt, 7) :
+                     sqlite3_bind_int64(insertStmt, 7, expiry)) != SQLITE_OK ||
+      bindNameKey(insertStmt, 8, nameKey) != SQLITE_OK ||
+      sqlite3_step(insertStmt) != SQLITE_DONE) {
+    sqlite3_finalize(insertStmt);
+    throw Error("object insert failed");
+  }
+  sqlite3_finalize(insertStmt);
+  int64_t objectId = sqlite3_last_insert_rowid(m_db);
+
+  // Data are copied into the extent in order, then their records are dropped
+  sqlite3_blob* extent = 0;
+  if (sqlite3_blob_open(m_db, "main", "NDN_REPO_OBJECT", "extent", objectId, 1, &extent)
+        != SQLITE_OK) {
+    sqlite3_blob_close(extent);
+    throw Error("object extent open failed");
+  }
+  uint64_t offset = 0;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    shared_ptr<Data> data = read(ids[i]);
+    if (!data || data->wireEncode().size() != sizes[i] ||
+        sqlite3_blob_write(extent, data->wireEncode().wire(), sizes[i], offset) != SQLITE_OK) {
+      sqlite3_blob_close(extent);
+      throw Error("object extent write failed");
+    }
+    offset += sizes[i];
+  }
+  sqlite3_blob_close(extent);
+
+  sqlite3_stmt* deleteStmt = 0;
+  string deleteSql("DELETE FROM NDN_REPO WHERE id = ?;");
+  if (sqlite3_prepare_v2(m_db, deleteSql.c_str(), -1, &deleteStmt, 0) != SQLITE_OK) {
+    sqlite3_finalize(deleteStmt);
+    throw Error("delete statement prepared failed");
+  }
+  for (size_t i = 0; i < ids.size(); ++i) {
+    if (sqlite3_bind_int64(deleteStmt, 1, ids[i]) != SQLITE_OK ||
+        sqlite3_step(deleteStmt) != SQLITE_DONE) {
+      sqlite3_finalize(deleteStmt);
+      throw Error("delete of packed records failed");
+    }
+    sqlite3_reset(deleteStmt);
+  }
+  sqlite3_finalize(deleteStmt);
+  return objectId;
+}
+
+void
+SqliteStorage::closeObjectBlob()
+{
+  // an open BLOB handle holds a read transaction, so it is only kept between reads
+  sqlite3_blob_close(m_objectBlob);
+  m_objectBlob = 0;
+  m_objectBlobId = 0;
+}
+
+bool
+SqliteStorage::loadObjectOffsets(int64_t objectId)
+{
+  if (objectId == m_objectOffsetsId)
+    return true;
+
+  sqlite3_stmt* queryStmt = 0;
+  string sql("SELECT offsets, live FROM NDN_REPO_OBJECT WHERE id = ?;");
+  if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &queryStmt, 0) != SQLITE_OK ||
+      sqlite3_bind_int64(queryStmt, 1, objectId) != SQLITE_OK) {
+    sqlite3_finalize(queryStmt);
+    throw Error("object statement prepared failed");
+  }
+  int rc = sqlite3_step(queryStmt);
+  if (rc != SQLITE_ROW) {
+    sqlite3_finalize(queryStmt);
+    if (rc == SQLITE_DONE)
+      return false;
+    throw Error("Database query failure");
+  }
+  decodeOffsets(static_cast<const uint8_t*>(sqlite3_column_blob(queryStmt, 0)),
+                sqlite3_column_bytes(queryStmt, 0), m_objectOffsets);
+  const uint8_t* live = static_cast<const uint8_t*>(sqlite3_column_blob(queryStmt, 1));
+  m_objectLive.assign(live, live + sqlite3_column_bytes(queryStmt, 1));
+  sqlite3_finalize(queryStmt);
+  m_objectOffsetsId = objectId;
+  return true;
+}
+
+shared_ptr<Data>
+SqliteStorage::readSegment(const int64_t id)
+{
+  int64_t objectId = getObjectId(id);
+  size_t index = getSegmentIndex(id);
+  if (!loadObjectOffsets(objectId) || index + 1 >= m_objectOffsets.size() ||
+      index >= m_objectLive.size() || m_objectLive[index] == 0)
+    return shared_ptr<Data>();
+
+  uint64_t offset = m_objectOffsets[index];
+  uint64_t size = m_objectOffsets[index + 1] - offset;
+  shared_ptr<ndn::Buffer> wire = make_shared<ndn::Buffer>(size);
+
+  // the handle stays open, so that reads of consecutive segments continue in the extent
+  // instead of seeking from its beginning
+  int rc = SQLITE_OK;
+  if (m_objectBlobId != objectId) {
+    if (m_objectBlob != 0)
+      rc = sqlite3_blob_reopen(m_objectBlob, objectId);
+    else
+      rc = sqlite3_blob_open(m_db, "main", "NDN_REPO_OBJECT", "extent", objectId, 0,
+                             &m_objectBlob);
+    m_objectBlobId = objectId;
+  }
+  if (rc == SQLITE_OK)
+    rc = sqlite3_blob_read(m_objectBlob, wire->buf(), size, offset);
+  if (rc != SQLITE_OK) {
+    closeObjectBlob();
+    std::cerr << "Object extent read failure rc:" << rc << std::endl;
+    throw Error("Object extent read failure");
+  }
+
+  shared_ptr<Data> data = make_shared<Data>();
+  data->wireDecode(Block(ndn::ConstBufferPtr(wire)));
+  return data;
+}
+
+bool
+SqliteStorage::eraseSegment(const int64_t id)
+{
+  int64_t objectId = getObjectId(id);
+  size_t index = getSegmentIndex(id);
+
+  // one byte per segment is flipped in place, without rewriting the rest of the row
+  sqlite3_blob* live = 0;
+  if (sqlite3_blob_open(m_db, "main", "NDN_REPO_OBJECT", "live", objectId, 1, &live)
+        != SQLITE_OK) {
+    sqlite3_blob_close(live);
+    return false;
+  }
+  uint8_t isLive = 0;
+  if (static_cast<int>(index) >= sqlite3_blob_bytes(live) ||
+      sqlite3_blob_read(live, &isLive, 1, index) != SQLITE_OK || isLive == 0) {
+    sqlite3_blob_close(live);
+    return false;
+  }
+  isLive = 0;
+  if (sqlite3_blob_write(live, &isLive, 1, index) != SQLITE_OK) {
+    sqlite3_blob_close(live);
+    throw Error("object segment erase failed");
+  }
+  sqlite3_blob_close(live);
+
+  sqlite3_stmt* updateStmt = 0;
+  string updateSql("UPDATE NDN_REPO_OBJECT SET nLive = nLive - 1 WHERE id = ?;"
+                   "DELETE FROM NDN_REPO_OBJECT WHERE id = ? AND nLive <= 0;");
+  const char* next = updateSql.c_str();
+  for (int i = 0; i < 2; ++i) {
+    if (sqlite3_prepare_v2(m_db, next, -1, &updateStmt, &next) != SQLITE_OK ||
+        sqlite3_bind_int64(updateStmt, 1, objectId) != SQLITE_OK ||
+        sqlite3_step(updateStmt) != SQLITE_DONE) {
+      sqlite3_finalize(updateStmt);
+      throw Error("object segment erase failed");
+    }
+    sqlite3_finalize(updateStmt);
+  }
+  if (objectId == m_objectOffsetsId) {
+    if (sqlite3_changes(m_db) > 0)
+      m_objectOffsetsId = 0;
+    else if (index < m_objectLive.size())
+      m_objectLive[index] = 0;
+  }
+  m_size--;
+  return true;
+}
+
+size_t
+SqliteStorage::enumerateObjects(const ndn::function<void(const Storage::ItemMeta)>& f)
+{
+  sqlite3_stmt* queryStmt = 0;
+  string sql("SELECT id, offsets, names, keylocatorHash, live FROM NDN_REPO_OBJECT;");
+  if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &queryStmt, 0) != SQLITE_OK) {
+    sqlite3_finalize(queryStmt);
+    throw Error("Initiation Read Objects from Database Prepare error");
+  }
+
+  size_t nSegments = 0;
+  int rc = SQLITE_DONE;
+  std::vector<uint64_t> offsets;
+  while ((rc = sqlite3_step(queryStmt)) == SQLITE_ROW) {
+    int64_t objectId = sqlite3_column_int64(queryStmt, 0);
+    decodeOffsets(static_cast<const uint8_t*>(sqlite3_column_blob(queryStmt, 1)),
+                  sqlite3_column_bytes(queryStmt, 1), offsets);
+    const uint8_t* names = static_cast<const uint8_t*>(sqlite3_column_blob(queryStmt, 2));
+    size_t namesSize = sqlite3_column_bytes(queryStmt, 2);
+    ndn::ConstBufferPtr keyLocatorHash;
+    if (sqlite3_column_type(queryStmt, 3) != SQLITE_NULL)
+      keyLocatorHash = make_shared<const ndn::Buffer>
+        (ndn::Buffer(sqlite3_column_blob(queryStmt, 3), sqlite3_column_bytes(queryStmt, 3)));
+    const uint8_t* live = static_cast<const uint8_t*>(sqlite3_column_blob(queryStmt, 4));
+    size_t nLive = sqlite3_column_bytes(queryStmt, 4);
+
+    size_t nameOffset = 0;
+    for (size_t i = 0; i + 1 < offsets.size() && i < nLive; ++i) {
+      Block nameBlock;
+      if (!Block::fromBuffer(names + nameOffset, namesSize - nameOffset, nameBlock)) {
+        sqlite3_finalize(queryStmt);
+        throw Error("Object names are corrupted");
+      }
+      nameOffset += nameBlock.size();
+      if (live[i] == 0)
+        continue;
+
+      ItemMeta item;
+      item.id = makeSegmentId(objectId, i);
+      item.fullName.wireDecode(nameBlock);
+      item.keyLocatorHash = keyLocatorHash;
+      item.dataSize = offsets[i + 1] - offsets[i];
+      try {
+        f(item);
+      }
+      catch (...) {
+        sqlite3_finalize(queryStmt);
+        throw;
+      }
+      ++nSegments;
+    }
+  }
+  sqlite3_finalize(queryStmt);
+  if (rc != SQLITE_DONE) {
+    std::cerr << "Initiation Read Objects rc:" << rc << std::endl;
+    throw Error("Initiation Read Objects error");
+  }
+  return nSegments;
+}
+
+void
+SqliteStorage::getExpiredSegments(const int64_t now, const size_t limit,
+                                  std::vector<std::pair<int64_t,
+                                                        std::pair<int64_t, Name> > >& expiring)
+{
+  sqlite3_stmt* queryStmt = 0;
+  string sql("SELECT id, names, live, expiry FROM NDN_REPO_OBJECT WHERE expiry <= ? "
+             "ORDER BY expiry;");
+  if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &queryStmt, 0) != SQLITE_OK ||
+      sqlite3_bind_int64(queryStmt, 1, now) != SQLITE_OK) {
+    sqlite3_finalize(queryStmt);
+    throw Error("select statement prepared failed");
+  }
+
+  size_t nFound = 0;
+  int rc = SQLITE_DONE;
+  while (nFound < limit && (rc = sqlite3_step(queryStmt)) == SQLITE_ROW) {
+    int64_t objectId = sqlite3_column_int64(queryStmt, 0);
+    const uint8_t* names = static_cast<const uint8_t*>(sqlite3_column_blob(queryStmt, 1));
+    size_t namesSize = sqlite3_column_bytes(queryStmt, 1);
+    const uint8_t* live = static_cast<const uint8_t*>(sqlite3_column_blob(queryStmt, 2));
+    size_t nSegments = sqlite3_column_bytes(queryStmt, 2);
+    int64_t expiry = sqlite3_column_int64(queryStmt, 3);
+
+    size_t nameOffset = 0;
+    Block nameBlock;
+    for (size_t i = 0; i < nSegments && nFound < limit &&
+           Block::fromBuffer(names + nameOffset, namesSize - nameOffset, nameBlock); ++i) {
+      nameOffset += nameBlock.size();
+      if (live[i] == 0)
+        continue;
+      Name name;
+      name.wireDecode(nameBlock);
+      expiring.push_back(std::make_pair(expiry,
+                                        std::make_pair(makeSegmentId(objectId, i), name)));
+      ++nFound;
+    }
+  }
+  sqlite3_finalize(queryStmt);
+  if (rc != SQLITE_DONE && rc != SQLITE_ROW) {
+    std::cerr << "Database query failure rc:" << rc << std::endl;
+    throw Error("Database query failure");
+  }
+}
+
+void
+SqliteStorage::openMaintenanceConnection()
+{
+#ifdef DISABLE_SQLITE3_FS_LOCKING
+  const char* baseVfs = "unix-dotfile";
+#else
+  const char* baseVfs = 0;
+#endif
+  // without the throttled VFS, checkpoints run without pauses
+  const char* vfs = registerThrottledVfs(baseVfs);
+  int rc = sqlite3_open_v2(m_dbPath.c_str(), &m_maintenanceDb,
+                           SQLITE_OPEN_READWRITE, vfs != 0 ? vfs : baseVfs);
+  if (rc != SQLITE_OK) {
+    sqlite3_close(m_maintenanceDb);
+    m_maintenanceDb = 0;
+    std::cerr << "Maintenance connection open failure rc:" << rc << std::endl;
+    throw Error("Maintenance connection open failure");
+  }
+  sqlite3_exec(m_maintenanceDb, "PRAGMA synchronous = OFF", 0, 0, 0);
+  // a connection finds the database in WAL mode once it has read it, and only then
+  // checkpoints
+  sqlite3_exec(m_maintenanceDb, "SELECT count(*) FROM sqlite_master;", 0, 0, 0);
+  sqlite3_busy_timeout(m_maintenanceDb, WRITE_BUSY_TIMEOUT);
+  sqlite3_busy_timeout(m_db, WRITE_BUSY_TIMEOUT);
+  // checkpoints are left to maintain from now on, so that no insert pays for them
+  sqlite3_exec(m_db, "PRAGMA wal_autocheckpoint = 0", 0, 0, 0);
+}
+
+void
+SqliteStorage::prepareMaintenance()
+{
+  if (m_maintenanceDb == 0)
+    openMaintenanceConnection();
+  // an open BLOB handle keeps a read transaction, which would hold the checkpoint back
+  closeObjectBlob();
+}
+
+Storage::MaintenanceStatus
+SqliteStorage::maintain(size_t checkpointPages, const ndn::time::milliseconds& checkpointPause)
+{
+  if (m_maintenanceDb == 0)
+    throw Error("Maintenance is not prepared");
+
+  // a passive checkpoint takes no lock that inserts wait for
+  setWriteThrottle(m_maintenanceDb, checkpointPages, checkpointPause);
+  int rc = sqlite3_wal_checkpoint_v2(m_maintenanceDb, 0, SQLITE_CHECKPOINT_PASSIVE, 0, 0);
+  setWriteThrottle(m_maintenanceDb, 0, ndn::time::milliseconds::zero());
+  if (rc != SQLITE_OK && rc != SQLITE_BUSY && rc != SQLITE_LOCKED)
+    std::cerr << "Checkpoint failure rc:" << rc << std::endl;
+
+  MaintenanceStatus status;
+  status.nFreePages = queryInteger(m_maintenanceDb, "PRAGMA freelist_count");
+  boost::system::error_code error;
+  uintmax_t walSize = boost::filesystem::file_size(m_dbPath + "-wal", error);
+  status.walSize = error ? 0 : walSize;
+  return status;
+}
+
+Storage::MaintenanceStatus
+SqliteStorage::reclaimSpace(uint64_t walTruncateSize, size_t maxReclaimedPages)
+{
+  MaintenanceStatus status;
+  boost::filesystem::path walPath(m_dbPath + "-wal");
+  boost::system::error_code error;
+  uintmax_t walSize = boost::filesystem::file_size(walPath, error);
+  // an open BLOB handle keeps a read transaction, and pages of its extent may be moved
+  closeObjectBlob();
+
+  // after the checkpoint of maintain, truncation only copies the frames written since and
+  // resets the log; it gives up at once instead of waiting for readers
+  if (!error && walSize > walTruncateSize) {
+    sqlite3_busy_timeout(m_db, 0);
+#ifdef SQLITE_CHECKPOINT_TRUNCATE
+    int rc = sqlite3_wal_checkpoint_v2(m_db, 0, SQLITE_CHECKPOINT_TRUNCATE, 0, 0);
+#else
+    int rc = sqlite3_wal_checkpoint_v2(m_db, 0, SQLITE_CHECKPOINT_RESTART, 0, 0);
+#endif
+    sqlite3_busy_timeout(m_db, WRITE_BUSY_TIMEOUT);
+    if (rc != SQLITE_OK && rc != SQLITE_BUSY && rc != SQLITE_LOCKED)
+      std::cerr << "Checkpoint truncation failure rc:" << rc << std::endl;
+  }
+
+  status.nFreePages = queryInteger(m_db, "PRAGMA freelist_count");
+  // without incremental auto-vacuum, free pages are only reused by later inserts
+  if (maxReclaimedPages > 0 && status.nFreePages > 0 &&
+      queryInteger(m_db, "PRAGMA auto_vacuum") == 2) {
+    string sql = "PRAGMA incremental_vacuum(" +
+                 boost::lexical_cast<string>(maxReclaimedPages) + ");";
+    if (sqlite3_exec(m_db, sql.c_str(), 0, 0, 0) == SQLITE_OK) {
+      uint64_t nFreePages = queryInteger(m_db, "PRAGMA freelist_count");
+      if (nFreePages < status.nFreePages)
+        status.nReclaimedPages = status.nFreePages - nFreePages;
+      status.nFreePages = nFreePages;
+    }
+  }
+
+  walSize = boost::filesystem::file_size(walPath, error);
+  status.walSize = error ? 0 : walSize;
+  return status;
+}
+
 } //namespace repo
@@ -22,6 +22,7 @@
 
 #include "storage.hpp"
 #include "index.hpp"
+#include "compression.hpp"
 #include <string>
 #include <iostream>
 #include <sqlite3.h>
@@ -34,6 +35,37 @@ namespace repo {
 
 using std::queue;
 
+/**
+ * @brief Storage of Data packets in a sqlite database
+ *
+ * Besides the encoded full name, each record keeps the TLV-VALUE of the full name in an
+ * indexed nameKey column. Since a Name prefix is a byte prefix of that value, all Data
+ * under a prefix form one contiguous nameKey range that can be queried without a full scan.
+ * Records with a retention time also keep their expiry time in an indexed expiry column, so
+ * expired records are found in expiry order without a full scan.
+ *
+ * With deduplication enabled, large payloads are kept once in the NDN_REPO_CONTENT table,
+ * keyed by their sha256 and counted by the records referring to them. Such a record stores
+ * its encoding without the Content value, together with the offset of the value, and is
+ * reassembled byte for byte on read. Triggers keep the reference counts, so any deletion of
+ * records releases their payloads.
+ *
+ * Records of Data under compressed prefixes keep the data column compressed, together with
+ * its size before compression in the rawSize column, and are decompressed on read only.
+ *
+ * Records of a completed segmented object can be packed into NDN_REPO_OBJECT rows, each
+ * holding the encodings of consecutive segments back to back in one extent together with
+ * their offsets, names and a live flag per segment. Packed segments get negative IDs made of
+ * the object ID and segment index, so they are read by one offset lookup and one BLOB read,
+ * and consecutive reads keep the same BLOB handle open.
+ *
+ * New databases are created with incremental auto-vacuum. Once prepareMaintenance is called,
+ * the write-ahead log is checkpointed by maintain on a second connection instead of by
+ * whichever insert crosses the sqlite threshold. maintain may run on its own thread, and
+ * takes no lock inserts wait for. Truncation of the log and return of free pages hold the
+ * write lock, so reclaimSpace runs them on the first connection, a bounded batch at a time
+ * between inserts.
+ */
 class SqliteStorage : public Storage
 {
 public:
@@ -47,8 +79,15 @@ public:
     }
   };
 
+  /**
+   *  @param  dbPath        folder of the database file
+   *  @param  dedupMinSize  smallest Content value stored once for all Data carrying it,
+   *                        0 to store every Data as is
+   *  @param  compression   prefixes whose Data are stored compressed
+   */
   explicit
-  SqliteStorage(const string& dbPath);
+  SqliteStorage(const string& dbPath, size_t dedupMinSize = 0,
+                const Compression& compression = Compression());
 
   virtual
   ~SqliteStorage();
@@ -61,6 +100,25 @@ public:
   virtual int64_t
   insert(const Data& data);
 
+  /**
+   *  @brief  put the data into database with an expiry time
+   *  @param  data     the data should be inserted into databse
+   *  @param  expiry   milliseconds since epoch after which data is removed, 0 for never
+   *  @return int64_t  the id number of each entry in the database
+   */
+  int64_t
+  insert(const Data& data, const int64_t expiry);
+
+  /**
+   *  @brief  put the data into database with an expiry time
+   *  @param  data     the data should be inserted into databse
+   *  @param  item     full name, keyLocator hash and size already computed from data
+   *  @param  expiry   milliseconds since epoch after which data is removed, 0 for never
+   *  @return int64_t  the id number of each entry in the database
+   */
+  virtual int64_t
+  insert(const Data& data, const ItemMeta& item, const int64_t expiry);
+
   /**
    *  @brief  remove the entry in the database by using id
    *  @param  id   id number of each entry in the database
@@ -68,6 +126,19 @@ public:
   virtual bool
   erase(const int64_t id);
 
+  /**
+   *  @brief  remove entries in the database in one transaction
+   *  @param  ids   id numbers of entries in the database
+   */
+  virtual size_t
+  erase(const std::vector<int64_t>& ids);
+
+  /**
+   *  @brief  get entries whose expiry time has passed through the expiry index
+   */
+  virtual std::vector<std::pair<int64_t, Name> >
+  getExpired(const int64_t now, const size_t limit);
+
   /**
    *  @brief  get the data from database
    *  @para   id   id number of each entry in the database, used to find the data
@@ -88,12 +159,132 @@ public:
   void
   fullEnumerate(const ndn::function<void(const Storage::ItemMeta)>& f);
 
+  /**
+   *  @brief  move records of consecutive segments into contiguous object extents
+   *  @param  ids   id numbers of the records in segment order
+   *  @return new id numbers of the segments, or empty if the records were left as they are
+   */
+  virtual std::vector<int64_t>
+  packObject(const std::vector<int64_t>& ids);
+
+  /**
+   *  @brief  open the connection used by maintain, unless it is open, and release the
+   *          read transaction of an open BLOB handle, which would hold the checkpoint back
+   */
+  virtual void
+  prepareMaintenance();
+
+  /**
+   *  @brief  run a passive checkpoint pausing after every checkpointPages pages
+   *
+   *  Only the connection opened by prepareMaintenance is used.
+   */
+  virtual MaintenanceStatus
+  maintain(size_t checkpointPages, const ndn::time::milliseconds& checkpointPause);
+
+  /**
+   *  @brief  truncate the log once larger than walTruncateSize, and run an incremental
+   *          vacuum of at most maxReclaimedPages
+   *
+   *  The truncation is skipped until the next call if it would wait for a reader.
+   */
+  virtual MaintenanceStatus
+  reclaimSpace(uint64_t walTruncateSize, size_t maxReclaimedPages);
+
 private:
   void
   initializeRepo();
 
+  /**
+   *  @brief prepare the statement reused by every insert
+   */
+  void
+  prepareInsertStatement();
+
+  /**
+   *  @brief store Content value of data in NDN_REPO_CONTENT if it is large enough
+   *  @param  dataWire  encoding of the Data
+   *  @param  stripped  set to the encoding without Content value if stored
+   *  @param  offset    set to the offset of Content value if stored
+   *  @return hash of the stored Content value, or null if the value is stored inline
+   */
+  ndn::ConstBufferPtr
+  storeContent(const Block& dataWire, ndn::Buffer& stripped, size_t& offset);
+
+  /**
+   *  @brief fill nameKey of records inserted before the column existed
+   */
+  void
+  fillNameKeys();
+
+  /**
+   *  @brief fill nameKey of objects packed before the column existed
+   */
+  void
+  fillObjectNameKeys();
+
+  /**
+   *  @brief create one object row from records and remove the records
+   *  @return ID of the object
+   */
+  int64_t
+  insertObject(const std::vector<int64_t>& ids, const std::vector<ndn::Buffer>& names,
+               const std::vector<uint64_t>& sizes, const ndn::Buffer* keyLocatorHash,
+               int64_t expiry);
+
+  /**
+   *  @brief open the connection used by maintain, through a VFS that can pause its writes
+   */
+  void
+  openMaintenanceConnection();
+
+  /**
+   *  @brief close the extent BLOB handle kept open between segment reads
+   */
+  void
+  closeObjectBlob();
+
+  /**
+   *  @brief load the offset table and live flags of an object unless already loaded
+   *  @return false if the object does not exist
+   */
+  bool
+  loadObjectOffsets(int64_t objectId);
+
+  shared_ptr<Data>
+  readSegment(const int64_t id);
+
+  /**
+   *  @brief mark a segment erased, and remove its object once no segment is left
+   */
+  bool
+  eraseSegment(const int64_t id);
+
+  /**
+   *  @return number of live segments enumerated
+   */
+  size_t
+  enumerateObjects(const ndn::function<void(const Storage::ItemMeta)>& f);
+
+  /**
+   *  @brief append live segments of expired objects, at most limit of them
+   */
+  void
+  getExpiredSegments(const int64_t now, const size_t limit,
+                     std::vector<std::pair<int64_t, std::pair<int64_t, Name> > >& expiring);
+
 private:
   sqlite3* m_db;
+  sqlite3* m_maintenanceDb;
+  sqlite3_stmt* m_insertStmt;
+  sqlite3_stmt* m_insertContentStmt;
+  size_t m_dedupMinSize;
+  Compression m_compression;
+  sqlite3_blob* m_objectBlob;
+  int64_t m_objectBlobId;
+  int64_t m_objectOffsetsId;
+  std::vector<uint64_t> m_objectOffsets;
+  std::vector<uint8_t> m_objectLive;
   string m_dbPath;
   int64_t m_size;
 };
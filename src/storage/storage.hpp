@@ -49,6 +49,29 @@ public:
     int64_t id;
     Name fullName;
     ndn::ConstBufferPtr keyLocatorHash;
+    size_t dataSize;
+  };
+
+  /**
+   * @brief  state of the storage files after a maintenance step
+   */
+  class MaintenanceStatus
+  {
+  public:
+    MaintenanceStatus()
+      : walSize(0)
+      , nFreePages(0)
+      , nReclaimedPages(0)
+    {
+    }
+
+  public:
+    /// bytes in write-ahead logs not yet truncated
+    uint64_t walSize;
+    /// unused pages left in database files
+    uint64_t nFreePages;
+    /// pages returned to the file system by this step
+    uint64_t nReclaimedPages;
   };
 
 public :
@@ -65,6 +88,16 @@ public :
   virtual int64_t
   insert(const Data& data) = 0;
 
+  /**
+   *  @brief  put the data into database with an expiry time
+   *  @param  data     the data should be inserted into databse
+   *  @param  item     full name, keyLocator hash and size already computed from data;
+   *                   id is ignored
+   *  @param  expiry   milliseconds since epoch after which data is removed, 0 for never
+   */
+  virtual int64_t
+  insert(const Data& data, const ItemMeta& item, const int64_t expiry) = 0;
+
   /**
    *  @brief  remove the entry in the database by using id
    *  @param  id   id number of entry in the database
@@ -72,6 +105,23 @@ public :
   virtual bool
   erase(const int64_t id) = 0;
 
+  /**
+   *  @brief  remove entries in the database in one batch
+   *  @param  ids   id numbers of entries in the database
+   *  @return number of removed entries
+   */
+  virtual size_t
+  erase(const std::vector<int64_t>& ids) = 0;
+
+  /**
+   *  @brief  get entries whose expiry time has passed, earliest expiry first
+   *  @param  now     milliseconds since epoch
+   *  @param  limit   most entries to return
+   *  @return id numbers and full names of the entries
+   */
+  virtual std::vector<std::pair<int64_t, Name> >
+  getExpired(const int64_t now, const size_t limit) = 0;
+
   /**
    *  @brief  get the data from database
    *  @param  id   id number of each entry in the database, used to find the data
@@ -92,6 +142,45 @@ public :
   virtual void
   fullEnumerate(const ndn::function<void(const Storage::ItemMeta)>& f) = 0;
 
+  /**
+   *  @brief  store the entries of one segmented object contiguously
+   *  @param  ids   id numbers of the entries in segment order
+   *  @return new id numbers of the entries in the same order, or empty if they are unchanged
+   */
+  virtual std::vector<int64_t>
+  packObject(const std::vector<int64_t>& ids) = 0;
+
+  /**
+   *  @brief  prepare a maintain call, from the thread using the storage
+   *
+   *  Once called, checkpoints are no longer made by inserts, so maintain should be called
+   *  periodically from then on.
+   */
+  virtual void
+  prepareMaintenance() = 0;
+
+  /**
+   *  @brief  checkpoint the write-ahead log without holding off writes
+   *
+   *  It may run on another thread while the storage is used, after prepareMaintenance and
+   *  before the next prepareMaintenance or reclaimSpace.
+   *  @param  checkpointPages    pages the checkpoint writes between pauses, 0 for no pause
+   *  @param  checkpointPause    length of each pause
+   */
+  virtual MaintenanceStatus
+  maintain(size_t checkpointPages, const ndn::time::milliseconds& checkpointPause) = 0;
+
+  /**
+   *  @brief  truncate the write-ahead log and return free pages to the file system, from
+   *          the thread using the storage
+   *
+   *  Both hold the write lock, so they run between writes, a small step at a time.
+   *  @param  walTruncateSize    the log is truncated once larger than this many bytes
+   *  @param  maxReclaimedPages  most free pages to return to the file system in this step
+   */
+  virtual MaintenanceStatus
+  reclaimSpace(uint64_t walTruncateSize, size_t maxReclaimedPages) = 0;
+
 };
 
 } // namespace repo
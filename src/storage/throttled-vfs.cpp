@@ -0,0 +1,413 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "throttled-vfs.hpp"
+
+#include <boost/thread/thread.hpp>
+
+#include <cstring>
+
+namespace repo {
+
+/**
+ * File control opcode carrying a WriteThrottle to the main database file. It is far above
+ * the opcodes of sqlite, which passes unknown opcodes on to the file.
+ */
+static const int FCNTL_WRITE_THROTTLE = 0x52455030;
+
+static const char* THROTTLED_VFS_PREFIX = "repo-throttled-";
+
+/// versions of file methods this VFS implements, memory-mapped reads being the third
+#if SQLITE_VERSION_NUMBER >= 3007017
+static const int N_IO_VERSIONS = 3;
+#else
+static const int N_IO_VERSIONS = 2;
+#endif
+
+struct WriteThrottle
+{
+  size_t pagesPerStep;
+  ndn::time::milliseconds pause;
+};
+
+/**
+ * The file of the base VFS is allocated right after this struct, in the space sqlite
+ * allocates for a file of the throttled VFS.
+ */
+struct ThrottledFile
+{
+  sqlite3_file base;
+  sqlite3_file* real;
+  WriteThrottle throttle;
+  size_t nWrittenPages;
+};
+
+/**
+ * A VFS and its name are registered for the life of the process. The VFS finds this struct
+ * through its pAppData.
+ */
+struct ThrottledVfs
+{
+  sqlite3_vfs vfs;
+  sqlite3_vfs* base;
+  std::string name;
+  sqlite3_io_methods methods[N_IO_VERSIONS];
+};
+
+static std::list<ThrottledVfs> g_throttledVfses;
+
+static sqlite3_file*
+getReal(sqlite3_file* file)
+{
+  return reinterpret_cast<ThrottledFile*>(file)->real;
+}
+
+static sqlite3_vfs*
+getBase(sqlite3_vfs* vfs)
+{
+  return static_cast<ThrottledVfs*>(vfs->pAppData)->base;
+}
+
+static int
+throttledClose(sqlite3_file* file)
+{
+  sqlite3_file* real = getReal(file);
+  return real->pMethods->xClose(real);
+}
+
+static int
+throttledRead(sqlite3_file* file, void* buffer, int amount, sqlite3_int64 offset)
+{
+  sqlite3_file* real = getReal(file);
+  return real->pMethods->xRead(real, buffer, amount, offset);
+}
+
+static int
+throttledWrite(sqlite3_file* file, const void* buffer, int amount, sqlite3_int64 offset)
+{
+  ThrottledFile* throttled = reinterpret_cast<ThrottledFile*>(file);
+  const WriteThrottle& throttle = throttled->throttle;
+  if (throttle.pagesPerStep > 0 && ++throttled->nWrittenPages > throttle.pagesPerStep) {
+    throttled->nWrittenPages = 1;
+    boost::this_thread::sleep_for(throttle.pause);
+  }
+  return throttled->real->pMethods->xWrite(throttled->real, buffer, amount, offset);
+}
+
+static int
+throttledTruncate(sqlite3_file* file, sqlite3_int64 size)
+{
+  sqlite3_file* real = getReal(file);
+  return real->pMethods->xTruncate(real, size);
+}
+
+static int
+throttledSync(sqlite3_file* file, int flags)
+{
+  sqlite3_file* real = getReal(file);
+  return real->pMethods->xSync(real, flags);
+}
+
+static int
+throttledFileSize(sqlite3_file* file, sqlite3_int64* size)
+{
+  sqlite3_file* real = getReal(file);
+  return real->pMethods->xFileSize(real, size);
+}
+
+static int
+throttledLock(sqlite3_file* file, int lock)
+{
+  sqlite3_file* real = getReal(file);
+  return real->pMethods->xLock(real, lock);
+}
+
+static int
+throttledUnlock(sqlite3_file* file, int lock)
+{
+  sqlite3_file* real = getReal(file);
+  return real->pMethods->xUnlock(real, lock);
+}
+
+static int
+throttledCheckReservedLock(sqlite3_file* file, int* isReserved)
+{
+  sqlite3_file* real = getReal(file);
+  return real->pMethods->xCheckReservedLock(real, isReserved);
+}
+
+static int
+throttledFileControl(sqlite3_file* file, int op, void* arg)
+{
+  if (op == FCNTL_WRITE_THROTTLE) {
+    ThrottledFile* throttled = reinterpret_cast<ThrottledFile*>(file);
+    throttled->throttle = *static_cast<const WriteThrottle*>(arg);
+    throttled->nWrittenPages = 0;
+    return SQLITE_OK;
+  }
+  sqlite3_file* real = getReal(file);
+  return real->pMethods->xFileControl(real, op, arg);
+}
+
+static int
+throttledSectorSize(sqlite3_file* file)
+{
+  sqlite3_file* real = getReal(file);
+  return real->pMethods->xSectorSize(real);
+}
+
+static int
+throttledDeviceCharacteristics(sqlite3_file* file)
+{
+  sqlite3_file* real = getReal(file);
+  return real->pMethods->xDeviceCharacteristics(real);
+}
+
+static int
+throttledShmMap(sqlite3_file* file, int region, int size, int isExtending,
+                void volatile** memory)
+{
+  sqlite3_file* real = getReal(file);
+  return real->pMethods->xShmMap(real, region, size, isExtending, memory);
+}
+
+static int
+throttledShmLock(sqlite3_file* file, int offset, int n, int flags)
+{
+  sqlite3_file* real = getReal(file);
+  return real->pMethods->xShmLock(real, offset, n, flags);
+}
+
+static void
+throttledShmBarrier(sqlite3_file* file)
+{
+  sqlite3_file* real = getReal(file);
+  real->pMethods->xShmBarrier(real);
+}
+
+static int
+throttledShmUnmap(sqlite3_file* file, int isDeleting)
+{
+  sqlite3_file* real = getReal(file);
+  return real->pMethods->xShmUnmap(real, isDeleting);
+}
+
+#if SQLITE_VERSION_NUMBER >= 3007017
+static int
+throttledFetch(sqlite3_file* file, sqlite3_int64 offset, int amount, void** pointer)
+{
+  sqlite3_file* real = getReal(file);
+  return real->pMethods->xFetch(real, offset, amount, pointer);
+}
+
+static int
+throttledUnfetch(sqlite3_file* file, sqlite3_int64 offset, void* pointer)
+{
+  sqlite3_file* real = getReal(file);
+  return real->pMethods->xUnfetch(real, offset, pointer);
+}
+#endif // SQLITE_VERSION_NUMBER >= 3007017
+
+static int
+throttledOpen(sqlite3_vfs* vfs, const char* name, sqlite3_file* file, int flags,
+              int* outFlags)
+{
+  sqlite3_vfs* base = getBase(vfs);
+  ThrottledFile* throttled = reinterpret_cast<ThrottledFile*>(file);
+  throttled->real = reinterpret_cast<sqlite3_file*>(throttled + 1);
+  throttled->throttle.pagesPerStep = 0;
+  throttled->throttle.pause = ndn::time::milliseconds::zero();
+  throttled->nWrittenPages = 0;
+  throttled->real->pMethods = 0;
+  file->pMethods = 0;
+
+  int rc = base->xOpen(base, name, throttled->real, flags, outFlags);
+  if (rc != SQLITE_OK) {
+    // a file the base VFS failed to open is closed by this VFS, which sqlite does not call
+    if (throttled->real->pMethods != 0)
+      throttled->real->pMethods->xClose(throttled->real);
+    return rc;
+  }
+  // methods of the same version as the base file, so sqlite calls only what it supports
+  ThrottledVfs* throttledVfs = static_cast<ThrottledVfs*>(vfs->pAppData);
+  int version = std::min(std::max(throttled->real->pMethods->iVersion, 1), N_IO_VERSIONS);
+  file->pMethods = &throttledVfs->methods[version - 1];
+  return SQLITE_OK;
+}
+
+static int
+throttledDelete(sqlite3_vfs* vfs, const char* name, int isSyncDir)
+{
+  return getBase(vfs)->xDelete(getBase(vfs), name, isSyncDir);
+}
+
+static int
+throttledAccess(sqlite3_vfs* vfs, const char* name, int flags, int* result)
+{
+  return getBase(vfs)->xAccess(getBase(vfs), name, flags, result);
+}
+
+static int
+throttledFullPathname(sqlite3_vfs* vfs, const char* name, int size, char* fullName)
+{
+  return getBase(vfs)->xFullPathname(getBase(vfs), name, size, fullName);
+}
+
+static void*
+throttledDlOpen(sqlite3_vfs* vfs, const char* name)
+{
+  return getBase(vfs)->xDlOpen(getBase(vfs), name);
+}
+
+static void
+throttledDlError(sqlite3_vfs* vfs, int size, char* message)
+{
+  getBase(vfs)->xDlError(getBase(vfs), size, message);
+}
+
+static void
+(*throttledDlSym(sqlite3_vfs* vfs, void* handle, const char* symbol))(void)
+{
+  return getBase(vfs)->xDlSym(getBase(vfs), handle, symbol);
+}
+
+static void
+throttledDlClose(sqlite3_vfs* vfs, void* handle)
+{
+  getBase(vfs)->xDlClose(getBase(vfs), handle);
+}
+
+static int
+throttledRandomness(sqlite3_vfs* vfs, int size, char* output)
+{
+  return getBase(vfs)->xRandomness(getBase(vfs), size, output);
+}
+
+static int
+throttledSleep(sqlite3_vfs* vfs, int microseconds)
+{
+  return getBase(vfs)->xSleep(getBase(vfs), microseconds);
+}
+
+static int
+throttledCurrentTime(sqlite3_vfs* vfs, double* time)
+{
+  return getBase(vfs)->xCurrentTime(getBase(vfs), time);
+}
+
+static int
+throttledGetLastError(sqlite3_vfs* vfs, int size, char* message)
+{
+  return getBase(vfs)->xGetLastError(getBase(vfs), size, message);
+}
+
+static int
+throttledCurrentTimeInt64(sqlite3_vfs* vfs, sqlite3_int64* time)
+{
+  return getBase(vfs)->xCurrentTimeInt64(getBase(vfs), time);
+}
+
+const char*
+registerThrottledVfs(const char* baseName)
+{
+  sqlite3_vfs* base = sqlite3_vfs_find(baseName);
+  if (base == 0)
+    return 0;
+  std::string name = THROTTLED_VFS_PREFIX + std::string(base->zName);
+  for (std::list<ThrottledVfs>::iterator it = g_throttledVfses.begin();
+       it != g_throttledVfses.end(); ++it) {
+    if (it->name == name)
+      return it->name.c_str();
+  }
+
+  g_throttledVfses.push_back(ThrottledVfs());
+  ThrottledVfs& throttledVfs = g_throttledVfses.back();
+  throttledVfs.base = base;
+  throttledVfs.name = name;
+
+  sqlite3_vfs& vfs = throttledVfs.vfs;
+  std::memset(&vfs, 0, sizeof(vfs));
+  // system calls of the base VFS are not exposed, and the time in 64 bits needs version 2
+  vfs.iVersion = base->iVersion >= 2 && base->xCurrentTimeInt64 != 0 ? 2 : 1;
+  vfs.szOsFile = sizeof(ThrottledFile) + base->szOsFile;
+  vfs.mxPathname = base->mxPathname;
+  vfs.zName = throttledVfs.name.c_str();
+  vfs.pAppData = &throttledVfs;
+  vfs.xOpen = &throttledOpen;
+  vfs.xDelete = &throttledDelete;
+  vfs.xAccess = &throttledAccess;
+  vfs.xFullPathname = &throttledFullPathname;
+  vfs.xDlOpen = &throttledDlOpen;
+  vfs.xDlError = &throttledDlError;
+  vfs.xDlSym = &throttledDlSym;
+  vfs.xDlClose = &throttledDlClose;
+  vfs.xRandomness = &throttledRandomness;
+  vfs.xSleep = &throttledSleep;
+  vfs.xCurrentTime = &throttledCurrentTime;
+  vfs.xGetLastError = &throttledGetLastError;
+  if (vfs.iVersion >= 2)
+    vfs.xCurrentTimeInt64 = &throttledCurrentTimeInt64;
+
+  for (int i = 0; i < N_IO_VERSIONS; ++i) {
+    sqlite3_io_methods& methods = throttledVfs.methods[i];
+    std::memset(&methods, 0, sizeof(methods));
+    methods.iVersion = i + 1;
+    methods.xClose = &throttledClose;
+    methods.xRead = &throttledRead;
+    methods.xWrite = &throttledWrite;
+    methods.xTruncate = &throttledTruncate;
+    methods.xSync = &throttledSync;
+    methods.xFileSize = &throttledFileSize;
+    methods.xLock = &throttledLock;
+    methods.xUnlock = &throttledUnlock;
+    methods.xCheckReservedLock = &throttledCheckReservedLock;
+    methods.xFileControl = &throttledFileControl;
+    methods.xSectorSize = &throttledSectorSize;
+    methods.xDeviceCharacteristics = &throttledDeviceCharacteristics;
+    if (methods.iVersion >= 2) {
+      methods.xShmMap = &throttledShmMap;
+      methods.xShmLock = &throttledShmLock;
+      methods.xShmBarrier = &throttledShmBarrier;
+      methods.xShmUnmap = &throttledShmUnmap;
+    }
+#if SQLITE_VERSION_NUMBER >= 3007017
+    if (methods.iVersion >= 3) {
+      methods.xFetch = &throttledFetch;
+      methods.xUnfetch = &throttledUnfetch;
+    }
+#endif // SQLITE_VERSION_NUMBER >= 3007017
+  }
+
+  if (sqlite3_vfs_register(&vfs, 0) != SQLITE_OK) {
+    g_throttledVfses.pop_back();
+    return 0;
+  }
+  return throttledVfs.name.c_str();
+}
+
+bool
+setWriteThrottle(sqlite3* db, size_t pagesPerStep, const ndn::time::milliseconds& pause)
+{
+  WriteThrottle throttle;
+  throttle.pagesPerStep = pagesPerStep;
+  throttle.pause = pause;
+  return sqlite3_file_control(db, "main", FCNTL_WRITE_THROTTLE, &throttle) == SQLITE_OK;
+}
+
+} // namespace repo
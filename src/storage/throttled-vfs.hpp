@@ -0,0 +1,55 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPO_STORAGE_THROTTLED_VFS_HPP
+#define REPO_STORAGE_THROTTLED_VFS_HPP
+
+#include "../common.hpp"
+
+#include <sqlite3.h>
+
+namespace repo {
+
+/**
+ * @brief  register a sqlite VFS that delegates to another VFS and can pause writes
+ *
+ * In WAL mode only checkpoints write to the database file, so pausing those writes spreads
+ * a checkpoint over time instead of flooding the disk. Registering again returns the VFS
+ * already registered for the same base VFS. It is not thread-safe.
+ *
+ * @param  baseName  name of the VFS to delegate to, or null for the default VFS
+ * @return name of the VFS to open connections with, or null if baseName is unknown
+ */
+const char*
+registerThrottledVfs(const char* baseName);
+
+/**
+ * @brief  make writes to the main database file of db pause for pause after every
+ *         pagesPerStep pages
+ *
+ * db must have been opened with a VFS returned by registerThrottledVfs. 0 pages leaves
+ * writes unthrottled.
+ * @return false if the database file of db does not accept the setting
+ */
+bool
+setWriteThrottle(sqlite3* db, size_t pagesPerStep, const ndn::time::milliseconds& pause);
+
+} // namespace repo
+
+#endif // REPO_STORAGE_THROTTLED_VFS_HPP
@@ -0,0 +1,46 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "reply-cache.hpp"
+
+namespace repo {
+
+ReplyCache::ReplyCache(size_t nMaxReplies)
+  : m_nMaxReplies(nMaxReplies)
+{
+}
+
+shared_ptr<Data>
+ReplyCache::find(const Name& name) const
+{
+  ReplyMap::const_iterator it = m_replies.find(name);
+  if (it == m_replies.end())
+    return shared_ptr<Data>();
+  return it->second;
+}
+
+void
+ReplyCache::insert(const shared_ptr<Data>& data)
+{
+  if (m_replies.size() >= m_nMaxReplies && m_replies.count(data->getName()) == 0)
+    m_replies.clear();
+  m_replies[data->getName()] = data;
+}
+
+} // namespace repo
@@ -0,0 +1,80 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPO_SYNC_REPLY_CACHE_HPP
+#define REPO_SYNC_REPLY_CACHE_HPP
+
+#include "common.hpp"
+
+#include <map>
+
+namespace repo {
+
+/**
+ * @brief signed replies to sync, fetch and recovery interests, keyed by interest name
+ *
+ * The reply to an interest does not change until local sync state changes, so RepoSync
+ * puts the kept Data again instead of signing a new one, and clears the cache whenever
+ * its sync tree, action list or snapshot changes.
+ */
+class ReplyCache : noncopyable
+{
+public:
+  /**
+   * @param nMaxReplies  most replies kept; all are dropped when a reply is inserted
+   *                     into a full cache
+   */
+  explicit
+  ReplyCache(size_t nMaxReplies);
+
+  /**
+   * @brief get the reply kept for an interest name
+   * @return the reply, or null if none is kept
+   */
+  shared_ptr<Data>
+  find(const Name& name) const;
+
+  /**
+   * @brief keep a signed reply under its name
+   */
+  void
+  insert(const shared_ptr<Data>& data);
+
+  void
+  clear()
+  {
+    m_replies.clear();
+  }
+
+  size_t
+  size() const
+  {
+    return m_replies.size();
+  }
+
+private:
+  typedef std::map<Name, shared_ptr<Data> > ReplyMap;
+
+  ReplyMap m_replies;
+  size_t m_nMaxReplies;
+};
+
+} // namespace repo
+
+#endif // REPO_SYNC_REPLY_CACHE_HPP
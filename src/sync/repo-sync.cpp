@@ -26,6 +26,7 @@ const int syncInterestReexpress = 4;
 const int defaultRecoveryRetransmitInterval = 200; // milliseconds
 const int retrytimes = 4;
 const int pipeline = 3;
+const size_t maxCachedReplies = 256;
 static const milliseconds DEFAULT_INTEREST_LIFETIME(4000);
 
 static bool
@@ -54,7 +55,7 @@ RepoSync::RepoSync(const Name& syncPrefix, const Name& creatorName, const std::s
   , m_isSynchronized(false)
   , m_isRunning(false)
   , m_face(face)
-  , m_keyChain(keyChain)
+  , m_signer(keyChain)
   , m_scheduler(face.getIoService())
   , m_validator(validator)
   , m_storageHandle(storageHandle)
@@ -66,6 +67,7 @@ RepoSync::RepoSync(const Name& syncPrefix, const Name& creatorName, const std::s
   , m_syncInterestTable(face.getIoService(), seconds(syncInterestReexpress))
   , m_snapshot(SyncStateMsg::SNAPSHOT)
   , m_snapshotNo(0)
+  , m_replyCache(maxCachedReplies)
 {
   init();
 }
@@ -78,6 +80,7 @@ RepoSync::~RepoSync()
 void
 RepoSync::init()
 {
+  invalidateReplyCache();
   m_actionList.clear();
   Name rootName("/");
   ActionEntry entry(rootName, -1);
@@ -95,6 +98,13 @@ RepoSync::listen(const Name& prefix)
                            bind(&RepoSync::onRegisterFailed, this, _1, _2));
 }
 
+void
+RepoSync::setSigningPolicy(const SigningPolicy& policy)
+{
+  m_signer.setPolicy(policy);
+  invalidateReplyCache();
+}
+
 void
 RepoSync::onRegistered(const Name& prefix)
 {
@@ -210,7 +220,7 @@ RepoSync::reply(const Interest& commandInterest, const int statusCode)
   response.setStatusCode(statusCode);
   shared_ptr<Data> rdata = make_shared<Data>(commandInterest.getName());
   rdata->setContent(response.wireEncode());
-  m_keyChain.sign(*rdata);
+  m_signer.sign(*rdata);
   m_face.put(*rdata);
 }
 
@@ -242,6 +252,7 @@ RepoSync::insertAction(const Name& dataName, const std::string& status)
   entry.constructName();
   m_syncTree.update(entry);
   m_actionList.push_back(std::make_pair(m_syncTree.getDigest(), entry));
+  invalidateReplyCache();
   m_nodeSeq[m_creatorName].current = m_seq;
   m_nodeSeq[m_creatorName].final = m_seq;
   processPendingSyncInterests();
@@ -572,6 +583,17 @@ void
 RepoSync::sendData(const Name &name, Msg& ssm)
 {
   //std::cout<<m_creatorName<<"on send data = "<<name<<std::endl;
+  // the reply to the same interest name does not change until local sync state changes,
+  // so the signed Data can be reused instead of being signed again
+  bool shouldCache = m_signer.getPolicy().shouldCacheSyncReplies;
+  if (shouldCache) {
+    shared_ptr<Data> cachedReply = m_replyCache.find(name);
+    if (cachedReply) {
+      m_face.put(*cachedReply);
+      return;
+    }
+  }
+
   int size = ssm.getMsg().ByteSize();
   char *wireData = new char[size];
   ssm.getMsg().SerializeToArray(wireData, size);
@@ -580,12 +602,20 @@ RepoSync::sendData(const Name &name, Msg& ssm)
   data->setContent(reinterpret_cast<const uint8_t*>(wireData), size);
   data->setFreshnessPeriod(milliseconds(syncResponseFreshness));
 
-  m_keyChain.sign(*data);
+  m_signer.sign(*data);
 
   m_face.put(*data);
 
   delete []wireData;
 
+  if (shouldCache)
+    m_replyCache.insert(data);
+}
+
+void
+RepoSync::invalidateReplyCache()
+{
+  m_replyCache.clear();
 }
 
 void
@@ -749,6 +779,7 @@ RepoSync::prepareFetchForSync(const Name& name, const uint64_t seq)
   {
     m_nodeSeq[name].current = 0;
     m_syncTree.addNode(name);
+    invalidateReplyCache();
     uint64_t lastSendSeq = (pipeline < seq ? pipeline : seq);
     for (uint64_t seqno = 1; seqno <= lastSendSeq; seqno++) {
       sendFetchInterest(name, seqno);
@@ -781,6 +812,7 @@ RepoSync::prepareFetchForRecovery(const Name& name, const uint64_t seq)
   {
     m_nodeSeq[name].current = 0;
     m_syncTree.addNode(name);
+    invalidateReplyCache();
     uint64_t lastSendSeq = (pipeline < seq ? pipeline : seq);
     for (uint64_t seqno = 1; seqno <= lastSendSeq; seqno++) {
       sendFetchInterest(name, seqno);
@@ -876,6 +908,7 @@ RepoSync::applyAction(const ActionEntry& action)
   m_syncTree.update(action);
   // std::cout<<"update applyaction digest is = "<<m_syncTree.getDigest()<<std::endl;;
   m_actionList.push_back(std::make_pair(m_syncTree.getDigest(), action));
+  invalidateReplyCache();
   if (action.getAction() == INSERTION) {
     Interest fetchInterest(action.getDataName());
     fetchInterest.setInterestLifetime(DEFAULT_INTEREST_LIFETIME);
@@ -945,12 +978,14 @@ RepoSync::createSnapshot()
   m_snapshot.setMsg(message.getMsg());
   m_snapshotNo++;
   m_syncTree.updateForSnapshot();
+  invalidateReplyCache();
 }
 
 void
 RepoSync::updateSyncTree(const ActionEntry& entry)
 {
   m_syncTree.update(entry);
+  invalidateReplyCache();
   pipelineEntrySeq &node = m_nodeSeq[entry.getCreatorName()];
   node.current = entry.getSeqNo();
   node.sending = entry.getSeqNo();
@@ -31,8 +31,10 @@
 #include "storage/repo-storage.hpp"
 #include "storage/index.hpp"
 #include "sync-interest-table.hpp"
+#include "reply-cache.hpp"
 #include "repo-command-response.hpp"
 #include "repo-command-parameter.hpp"
+#include "response-signer.hpp"
 
 namespace repo {
 using namespace ndn::time;
@@ -89,6 +91,21 @@ public:
   void
   listen(const Name& prefix);
 
+  /**
+   * @brief  set how command responses, sync replies and snapshots are signed
+   */
+  void
+  setSigningPolicy(const SigningPolicy& policy);
+
+  /**
+   * @brief  get the signed replies kept for repeated sync, fetch and recovery interests
+   */
+  ReplyCache&
+  getReplyCache()
+  {
+    return m_replyCache;
+  }
+
 private:
 
   void
@@ -249,6 +266,13 @@ private:  // process different kinds of interests
   void
   sendData(const Name &name, Msg& ssm);
 
+  /**
+   * @brief  drop the signed replies kept by sendData, called whenever the action list,
+   *         sync tree or snapshot changes
+   */
+  void
+  invalidateReplyCache();
+
 private:  // send different kinds of interests
 
   void
@@ -355,7 +379,7 @@ private:
   bool m_isRunning;
 
   Face& m_face;
-  KeyChain& m_keyChain;
+  ResponseSigner m_signer;
   Scheduler m_scheduler;
   ValidatorConfig& m_validator;
   RepoStorage& m_storageHandle;
@@ -389,6 +413,8 @@ private:
   Msg m_snapshot;
   uint64_t m_snapshotNo;
   std::list<std::pair<Name, uint64_t> > m_snapshotList;
+
+  ReplyCache m_replyCache;
 };
 
 //
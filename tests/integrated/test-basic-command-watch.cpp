@@ -244,6 +244,26 @@ Fixture<T>::scheduleWatchEvent()
                               bind(&Fixture<T>::onRegisterFailed, this, _2));
 }
 
+template<class Dataset>
+class QuotaFixture : public Fixture<Dataset>
+{
+public:
+  QuotaFixture()
+  {
+    Quota quota;
+    quota.prefix = Name("/a/b");
+    quota.maxPackets = 2;
+    quota.policy = Quota::REJECT;
+    this->handle->addQuota(quota);
+  }
+
+  void
+  checkQuotaKept()
+  {
+    BOOST_CHECK_LE(this->handle->getUsage(Name("/a/b")).nPackets, 2);
+  }
+};
+
 typedef boost::mpl::vector< BasicDataset > Dataset;
 
 BOOST_FIXTURE_TEST_CASE_TEMPLATE(WatchDelete, T, Dataset, Fixture<T>)
@@ -261,6 +281,25 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(WatchDelete, T, Dataset, Fixture<T>)
   this->repoFace.getIoService().run();
 }
 
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(WatchRejectQuota, T, Dataset, QuotaFixture<T>)
+{
+  this->generateDefaultCertificateFile();
+  this->validator.load("tests/integrated/insert-delete-validator-config.conf");
+
+  // schedule events
+  this->scheduler.scheduleEvent(seconds(0),
+                                bind(&Fixture<T>::scheduleWatchEvent, this));
+
+  // the watch stops once the quota refuses Data, and the repo keeps running
+  this->scheduler.scheduleEvent(seconds(30),
+                                bind(&QuotaFixture<T>::checkQuotaKept, this));
+
+  // schedule an event to terminate IO
+  this->scheduler.scheduleEvent(seconds(40),
+                                bind(&Fixture<T>::stopFaceProcess, this));
+  this->repoFace.getIoService().run();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } //namespace tests
@@ -0,0 +1,73 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "storage/compression.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+namespace repo {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(CompressionTest)
+
+BOOST_AUTO_TEST_CASE(Dictionary)
+{
+  if (!Compression::isSupported())
+    return;
+
+  std::string dictionary;
+  for (int i = 0; i < 20; ++i)
+    dictionary += "{\"sensor\":\"temperature\",\"unit\":\"C\",\"value\":21.5}\n";
+  std::string message("{\"sensor\":\"temperature\",\"unit\":\"C\",\"value\":22.25}");
+  const uint8_t* input = reinterpret_cast<const uint8_t*>(message.data());
+
+  Compression compression;
+  compression.addPrefix(Name("ndn:/A"), 1);
+  compression.addPrefix(Name("ndn:/A/B"), 9, dictionary);
+
+  ndn::Buffer compressed;
+  BOOST_CHECK_EQUAL(compression.compress(Name("ndn:/C/1"), input, message.size(), compressed),
+                    false);
+  // too short to compress without the dictionary
+  BOOST_CHECK_EQUAL(compression.compress(Name("ndn:/A/1"), input, message.size(), compressed),
+                    false);
+  BOOST_REQUIRE_EQUAL(compression.compress(Name("ndn:/A/B/1"), input, message.size(),
+                                           compressed), true);
+  BOOST_CHECK_LT(compressed.size(), message.size() / 2);
+
+  ndn::Buffer decompressed;
+  compression.decompress(compressed.buf(), compressed.size(), message.size(), decompressed);
+  BOOST_CHECK_EQUAL_COLLECTIONS(decompressed.begin(), decompressed.end(),
+                                message.begin(), message.end());
+
+  // the dictionary is found by its checksum, not by prefix
+  Compression reader;
+  BOOST_CHECK_THROW(reader.decompress(compressed.buf(), compressed.size(), message.size(),
+                                      decompressed), Compression::Error);
+  reader.addDictionary(dictionary);
+  reader.decompress(compressed.buf(), compressed.size(), message.size(), decompressed);
+  BOOST_CHECK_EQUAL_COLLECTIONS(decompressed.begin(), decompressed.end(),
+                                message.begin(), message.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace repo
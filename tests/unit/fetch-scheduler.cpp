@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "handles/fetch-scheduler.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+namespace repo {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(FetchScheduler)
+
+BOOST_AUTO_TEST_CASE(GlobalLimit)
+{
+  repo::FetchScheduler scheduler(4, 8, 0);
+  scheduler.addProcess(1);
+  scheduler.activate(1);
+
+  ProcessId processId = 0;
+  for (int i = 0; i < 4; ++i) {
+    BOOST_REQUIRE(scheduler.next(processId));
+    BOOST_CHECK_EQUAL(processId, 1);
+    scheduler.onInterestSent(processId);
+  }
+  BOOST_CHECK(!scheduler.canSend());
+  BOOST_CHECK(!scheduler.next(processId));
+
+  scheduler.onInterestFinished(1);
+  BOOST_CHECK(scheduler.next(processId));
+
+  scheduler.removeProcess(1);
+  BOOST_CHECK_EQUAL(scheduler.getInFlight(), 0);
+  BOOST_CHECK(!scheduler.next(processId));
+}
+
+BOOST_AUTO_TEST_CASE(RoundRobin)
+{
+  repo::FetchScheduler scheduler(100, 2, 0);
+  scheduler.addProcess(1);
+  scheduler.addProcess(2);
+  scheduler.activate(1);
+  scheduler.activate(2);
+
+  ProcessId expected[] = {1, 1, 2, 2, 1, 1, 2, 2};
+  ProcessId processId = 0;
+  for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i) {
+    BOOST_REQUIRE(scheduler.next(processId));
+    BOOST_CHECK_EQUAL(processId, expected[i]);
+    scheduler.onInterestSent(processId);
+  }
+  BOOST_CHECK_EQUAL(scheduler.getInFlight(1), 4);
+  BOOST_CHECK_EQUAL(scheduler.getInFlight(2), 4);
+
+  scheduler.deactivate(1);
+  for (int i = 0; i < 3; ++i) {
+    BOOST_REQUIRE(scheduler.next(processId));
+    BOOST_CHECK_EQUAL(processId, 2);
+    scheduler.onInterestSent(processId);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SmallFirst)
+{
+  repo::FetchScheduler scheduler(100, 2, 10);
+  scheduler.addProcess(1);
+  scheduler.addProcess(2);
+  scheduler.activate(1);
+  scheduler.activate(2);
+  scheduler.setRemaining(1, 1000);
+  scheduler.setRemaining(2, 5);
+
+  ProcessId processId = 0;
+  for (int i = 0; i < 5; ++i) {
+    BOOST_REQUIRE(scheduler.next(processId));
+    BOOST_CHECK_EQUAL(processId, 2);
+    scheduler.onInterestSent(processId);
+  }
+  scheduler.deactivate(2);
+
+  BOOST_REQUIRE(scheduler.next(processId));
+  BOOST_CHECK_EQUAL(processId, 1);
+}
+
+BOOST_AUTO_TEST_CASE(SmallListFollowsLimits)
+{
+  repo::FetchScheduler scheduler(100, 2, 10);
+  scheduler.addProcess(1);
+  scheduler.addProcess(2);
+  scheduler.setRemaining(2, 5);
+  scheduler.activate(1);
+  scheduler.activate(2);
+
+  ProcessId processId = 0;
+  BOOST_REQUIRE(scheduler.next(processId));
+  BOOST_CHECK_EQUAL(processId, 2);
+
+  // without a small insert threshold, process 2 joins the round after process 1
+  scheduler.setLimits(100, 2, 0);
+  ProcessId expected[] = {1, 1, 2, 2, 1};
+  for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i) {
+    BOOST_REQUIRE(scheduler.next(processId));
+    BOOST_CHECK_EQUAL(processId, expected[i]);
+    scheduler.onInterestSent(processId);
+  }
+
+  scheduler.removeProcess(1);
+  scheduler.removeProcess(2);
+  BOOST_CHECK(!scheduler.next(processId));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace repo
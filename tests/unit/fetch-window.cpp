@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "handles/fetch-window.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+namespace repo {
+namespace tests {
+
+using ndn::time::milliseconds;
+
+BOOST_AUTO_TEST_SUITE(FetchWindow)
+
+BOOST_AUTO_TEST_CASE(InitialWindow)
+{
+  repo::FetchWindow window(3, 10);
+  BOOST_CHECK(window.canSend());
+  window.onInterestSent();
+  window.onInterestSent();
+  window.onInterestSent();
+  BOOST_CHECK(!window.canSend());
+  BOOST_CHECK_EQUAL(window.getInFlight(), 3);
+
+  // initial window is bounded by max window
+  repo::FetchWindow bounded(20, 5);
+  BOOST_CHECK_EQUAL(bounded.getWindow(), 5);
+}
+
+BOOST_AUTO_TEST_CASE(IncreaseAndDecrease)
+{
+  repo::FetchWindow window(2, 8);
+
+  // slow start grows the window by one per Data up to max window
+  for (int i = 0; i < 10; ++i) {
+    window.onInterestSent();
+    window.onData(milliseconds(50), true);
+  }
+  BOOST_CHECK_EQUAL(window.getWindow(), 8);
+  BOOST_CHECK_EQUAL(window.getInFlight(), 0);
+
+  // timeout halves the window once per round trip
+  window.onInterestSent();
+  window.onInterestSent();
+  window.onTimeout();
+  BOOST_CHECK_EQUAL(window.getWindow(), 4);
+  window.onTimeout();
+  BOOST_CHECK_EQUAL(window.getWindow(), 4);
+  BOOST_CHECK_EQUAL(window.getInFlight(), 0);
+
+  // congestion avoidance grows the window by about one per window
+  for (int i = 0; i < 4; ++i) {
+    window.onInterestSent();
+    window.onData(milliseconds(50), true);
+  }
+  BOOST_CHECK_GT(window.getWindow(), 4.9);
+  BOOST_CHECK_LT(window.getWindow(), 5.1);
+}
+
+BOOST_AUTO_TEST_CASE(Rto)
+{
+  repo::FetchWindow window(1, 1, milliseconds(4000));
+  BOOST_CHECK_EQUAL(window.getRto(), milliseconds(1000));
+
+  window.onInterestSent();
+  window.onData(milliseconds(100), true);
+  // srtt + 4 * rttvar = 100 + 4 * 50
+  BOOST_CHECK_EQUAL(window.getRto(), milliseconds(300));
+
+  // retransmitted Data does not give RTT sample
+  window.onInterestSent();
+  window.onData(milliseconds(3000), false);
+  BOOST_CHECK_EQUAL(window.getRto(), milliseconds(300));
+
+  // timeouts back off, bounded by max RTO
+  window.onInterestSent();
+  window.onTimeout();
+  BOOST_CHECK_EQUAL(window.getRto(), milliseconds(600));
+  for (int i = 0; i < 10; ++i) {
+    window.onInterestSent();
+    window.onTimeout();
+  }
+  BOOST_CHECK_EQUAL(window.getRto(), milliseconds(4000));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace repo
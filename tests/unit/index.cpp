@@ -24,6 +24,7 @@
 
 #include <boost/test/unit_test.hpp>
 #include <iostream>
+#include <boost/lexical_cast.hpp>
 
 namespace repo {
 namespace tests {
@@ -111,6 +112,44 @@ BOOST_AUTO_TEST_CASE(Rightmost)
   BOOST_CHECK_EQUAL(find(), 4);
 }
 
+BOOST_AUTO_TEST_CASE(ExcludeRanges)
+{
+  insert(10, "ndn:/A");
+  for (int i = 1; i <= 9; ++i)
+    insert(i, Name("ndn:/B").append(boost::lexical_cast<std::string>(i)));
+  insert(11, "ndn:/C");
+
+  startInterest("ndn:/B")
+    .setExclude(Exclude().excludeBefore(Name::Component("4")));
+  BOOST_CHECK_EQUAL(find(), 5);
+
+  startInterest("ndn:/B")
+    .setExclude(Exclude().excludeBefore(Name::Component("3"))
+                         .excludeOne(Name::Component("4"))
+                         .excludeRange(Name::Component("5"), Name::Component("7")));
+  BOOST_CHECK_EQUAL(find(), 8);
+
+  startInterest("ndn:/B")
+    .setExclude(Exclude().excludeAfter(Name::Component("1")));
+  BOOST_CHECK_EQUAL(find(), 0);
+
+  startInterest("ndn:/B")
+    .setChildSelector(1)
+    .setExclude(Exclude().excludeAfter(Name::Component("5")));
+  BOOST_CHECK_EQUAL(find(), 4);
+
+  startInterest("ndn:/B")
+    .setChildSelector(1)
+    .setExclude(Exclude().excludeRange(Name::Component("3"), Name::Component("8"))
+                         .excludeAfter(Name::Component("9")));
+  BOOST_CHECK_EQUAL(find(), 2);
+
+  startInterest("ndn:/B")
+    .setChildSelector(1)
+    .setExclude(Exclude().excludeBefore(Name::Component("9")));
+  BOOST_CHECK_EQUAL(find(), 0);
+}
+
 BOOST_AUTO_TEST_CASE(Leftmost_ExactName1)
 {
   insert(1, "ndn:/");
@@ -365,6 +404,193 @@ BOOST_AUTO_TEST_CASE(MaxSuffixComponents32)
 
 BOOST_AUTO_TEST_SUITE_END() // Find
 
+BOOST_FIXTURE_TEST_CASE(UsageDepth, FindFixture)
+{
+  m_index.setUsageDepth(1);
+  insert(1, "ndn:/A/B/C/1");
+  insert(2, "ndn:/A/B/C/2");
+  insert(3, "ndn:/A/D/1");
+
+  // prefixes deeper than the usage depth are summed from the entries under them
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A").nPackets, 3);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B").nPackets, 2);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B/C").nPackets, 2);
+
+  Name fullName = m_index.find(Name("ndn:/A/B/C/1")).second;
+  BOOST_CHECK_EQUAL(m_index.erase(fullName), true);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A").nPackets, 2);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B").nPackets, 1);
+
+  // counters are built for prefixes within a raised depth on their next insert
+  m_index.setUsageDepth(0);
+  insert(4, "ndn:/A/B/C/3");
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B").nPackets, 2);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A").nPackets, 3);
+}
+
+BOOST_FIXTURE_TEST_CASE(Usage, FindFixture)
+{
+  insert(1, "ndn:/A/B/1");
+  insert(2, "ndn:/A/B/2");
+  insert(3, "ndn:/A/C/1");
+  insert(4, "ndn:/D");
+
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/").nPackets, 4);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A").nPackets, 3);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B").nPackets, 2);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B/1").nPackets, 1);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B/3").nPackets, 0);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/E").nPackets, 0);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A").nBytes,
+                    m_index.getUsage("ndn:/A/B").nBytes + m_index.getUsage("ndn:/A/C").nBytes);
+  BOOST_CHECK_GT(m_index.getUsage("ndn:/A/B/1").nBytes, 0);
+
+  Name fullName = m_index.find(Name("ndn:/A/B/1")).second;
+  uint64_t nBytes = m_index.getUsage("ndn:/A/B/1").nBytes;
+  uint64_t nTotalBytes = m_index.getUsage("ndn:/").nBytes;
+  BOOST_CHECK_EQUAL(m_index.erase(fullName), true);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/").nPackets, 3);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/").nBytes, nTotalBytes - nBytes);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B").nPackets, 1);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B/1").nPackets, 0);
+
+  insert(3, "ndn:/A/C/1");
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/C").nPackets, 1);
+
+  // Data named by a prefix of other Data, inserted before and after them
+  insert(5, "ndn:/A/C");
+  insert(6, "ndn:/A/B/1/x");
+  insert(7, "ndn:/A/B/2/x/y");
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/C").nPackets, 2);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B/1").nPackets, 1);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B/2").nPackets, 2);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B/2/x").nPackets, 1);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B").nPackets, 3);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A").nPackets, 5);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/").nPackets, 6);
+
+  insert(8, "ndn:/A/B/1");
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B/1").nPackets, 2);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B").nPackets, 4);
+
+  // counters stay right as the deeper Data and then the Data named by the prefix go
+  BOOST_CHECK_EQUAL(m_index.erase(m_index.find(Name("ndn:/A/B/2/x/y")).second), true);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B/2").nPackets, 1);
+  BOOST_CHECK_EQUAL(m_index.erase(m_index.find(Name("ndn:/A/B/1/x")).second), true);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B/1").nPackets, 1);
+  BOOST_CHECK_EQUAL(m_index.erase(m_index.find(Name("ndn:/A/B/1")).second), true);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B/1").nPackets, 0);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/A/B").nPackets, 1);
+  BOOST_CHECK_EQUAL(m_index.getUsage("ndn:/").nPackets, 4);
+}
+
+BOOST_FIXTURE_TEST_CASE(RemoveDeletedEntries, FindFixture)
+{
+  insert(1, "ndn:/A");
+  insert(2, "ndn:/B");
+  insert(3, "ndn:/C");
+  Name a = m_index.find(Name("ndn:/A")).second;
+  Name b = m_index.find(Name("ndn:/B")).second;
+  BOOST_CHECK_EQUAL(m_index.erase(a), true);
+  BOOST_CHECK_EQUAL(m_index.erase(b), true);
+  insert(2, "ndn:/B");
+
+  // not deleted long enough
+  ndn::time::steady_clock::TimePoint past =
+    ndn::time::steady_clock::now() - ndn::time::seconds(3600);
+  BOOST_CHECK_EQUAL(m_index.removeDeletedEntries(past, 10), 0);
+  BOOST_CHECK_EQUAL(m_index.getStatus(a), DELETED);
+
+  ndn::time::steady_clock::TimePoint future =
+    ndn::time::steady_clock::now() + ndn::time::seconds(1);
+  BOOST_CHECK_EQUAL(m_index.removeDeletedEntries(future, 1), 1);
+  BOOST_CHECK_EQUAL(m_index.getStatus(a), NONE);
+  BOOST_CHECK_EQUAL(m_index.getStatus(b), INSERTED);
+
+  // inserted again since deletion, so kept
+  BOOST_CHECK_EQUAL(m_index.removeDeletedEntries(future, 10), 1);
+  BOOST_CHECK_EQUAL(m_index.getStatus(b), INSERTED);
+  BOOST_CHECK_EQUAL(m_index.find(Name("ndn:/B")).first, 2);
+  BOOST_CHECK_EQUAL(m_index.removeDeletedEntries(future, 10), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(RemoveRedeletedEntries, FindFixture)
+{
+  insert(1, "ndn:/A");
+  Name a = m_index.find(Name("ndn:/A")).second;
+  BOOST_CHECK_EQUAL(m_index.erase(a), true);
+  ndn::time::steady_clock::TimePoint between =
+    ndn::time::steady_clock::now() + ndn::time::milliseconds(1);
+  while (ndn::time::steady_clock::now() <= between)
+    ;
+  insert(1, "ndn:/A");
+  BOOST_CHECK_EQUAL(m_index.erase(a), true);
+  // erasing a DELETED entry again does not queue it again
+  BOOST_CHECK_EQUAL(m_index.erase(a), true);
+  BOOST_CHECK_EQUAL(m_index.size(), 0);
+
+  // the first deletion is old enough, the latest is not
+  BOOST_CHECK_EQUAL(m_index.removeDeletedEntries(between, 10), 1);
+  BOOST_CHECK_EQUAL(m_index.getStatus(a), DELETED);
+
+  ndn::time::steady_clock::TimePoint future =
+    ndn::time::steady_clock::now() + ndn::time::seconds(1);
+  BOOST_CHECK_EQUAL(m_index.removeDeletedEntries(future, 10), 1);
+  BOOST_CHECK_EQUAL(m_index.getStatus(a), NONE);
+  BOOST_CHECK_EQUAL(m_index.removeDeletedEntries(future, 10), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(Segments, FindFixture)
+{
+  insert(1, Name("ndn:/A").appendSegment(0));
+  insert(2, Name("ndn:/A").appendSegment(1));
+  insert(3, Name("ndn:/A").appendSegment(2));
+  insert(4, Name("ndn:/B").appendSegment(0));
+  insert(5, Name("ndn:/B").appendSegment(2));
+  insert(6, Name("ndn:/C/x"));
+
+  std::vector<std::pair<int64_t, Name> > segments = m_index.getSegments("ndn:/A");
+  BOOST_REQUIRE_EQUAL(segments.size(), 3);
+  for (size_t i = 0; i < segments.size(); ++i) {
+    BOOST_CHECK_EQUAL(segments[i].first, static_cast<int64_t>(i + 1));
+    BOOST_CHECK_EQUAL(segments[i].second.get(-2).toSegment(), i);
+  }
+  // missing segment 1, or not segments
+  BOOST_CHECK(m_index.getSegments("ndn:/B").empty());
+  BOOST_CHECK(m_index.getSegments("ndn:/C").empty());
+
+  BOOST_CHECK_EQUAL(m_index.updateId(segments[1].second, -7), true);
+  BOOST_CHECK_EQUAL(m_index.find(segments[1].second).first, -7);
+  BOOST_CHECK_EQUAL(m_index.getStatus(segments[1].second), EXISTED);
+  BOOST_CHECK_EQUAL(m_index.updateId(Name("ndn:/D"), 8), false);
+
+  BOOST_CHECK_EQUAL(m_index.erase(segments[2].second), true);
+  BOOST_CHECK_EQUAL(m_index.getSegments("ndn:/A").size(), 2);
+}
+
+BOOST_FIXTURE_TEST_CASE(LookupFilter, FindFixture)
+{
+  insert(1, "ndn:/A/1");
+  // entries already in the index are added to the filter
+  m_index.setPrefixFilter(4096);
+  insert(2, "ndn:/B/1");
+
+  startInterest("ndn:/A");
+  BOOST_CHECK_EQUAL(find(), 1);
+  startInterest("ndn:/B/1");
+  BOOST_CHECK_EQUAL(find(), 2);
+  startInterest("ndn:/C");
+  BOOST_CHECK_EQUAL(find(), 0);
+  BOOST_CHECK_EQUAL(m_index.find(Name("ndn:/B")).first, 2);
+
+  std::pair<int64_t, Name> found = m_index.find(Name("ndn:/B/1"));
+  BOOST_CHECK_EQUAL(m_index.erase(found.second), true);
+  startInterest("ndn:/B");
+  BOOST_CHECK_EQUAL(find(), 0);
+  insert(3, "ndn:/B/1");
+  BOOST_CHECK_EQUAL(find(), 3);
+}
+
 
 template<class Dataset>
 class Fixture : public Dataset
@@ -423,6 +649,143 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(Bulk, T, Datasets, Fixture<T>)
   //   }
 }
 
+template<class Dataset>
+class DiskFixture : public Dataset
+{
+public:
+  DiskFixture()
+    // a small cache, so that lookups cross and evict pages
+    : index(65535, "unittestindex", 2)
+  {
+  }
+
+  ~DiskFixture()
+  {
+    boost::filesystem::remove_all(boost::filesystem::path("unittestindex"));
+  }
+
+public:
+  std::map<int64_t, shared_ptr<Data> > idToDataMap;
+  repo::Index index;
+};
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(DiskBulk, T, Datasets, DiskFixture<T>)
+{
+  BOOST_TEST_MESSAGE(T::getName());
+
+  for (typename T::DataContainer::iterator i = this->data.begin();
+       i != this->data.end(); ++i)
+    {
+      int64_t id = std::abs(static_cast<int64_t>(ndn::random::generateWord64()));
+      this->idToDataMap.insert(std::make_pair(id, *i));
+
+      BOOST_CHECK_EQUAL(this->index.insert(**i, id), true);
+    }
+
+  BOOST_CHECK_EQUAL(this->index.size(), this->data.size());
+
+  for (typename T::InterestContainer::iterator i = this->interests.begin();
+       i != this->interests.end(); ++i)
+    {
+      std::pair<int64_t, Name> item = this->index.find(i->first);
+
+      BOOST_REQUIRE_GT(item.first, 0);
+      BOOST_REQUIRE(this->idToDataMap.count(item.first) > 0);
+
+      BOOST_TEST_MESSAGE(i->first);
+      BOOST_CHECK_EQUAL(*this->idToDataMap[item.first], *i->second);
+
+      BOOST_CHECK_EQUAL(this->index.hasData(*i->second), true);
+    }
+}
+
+static void
+countEntry(size_t* nEntries, const Name& name, const status& entryStatus)
+{
+  ++*nEntries;
+}
+
+class DiskFindFixture : public FindFixture
+{
+protected:
+  DiskFindFixture()
+    : m_diskIndex(std::numeric_limits<size_t>::max(), "unittestindex", 2)
+  {
+  }
+
+  ~DiskFindFixture()
+  {
+    boost::filesystem::remove_all(boost::filesystem::path("unittestindex"));
+  }
+
+  void
+  insertBoth(int id, const Name& name)
+  {
+    insert(id, name);
+    shared_ptr<Data> data = make_shared<Data>(name);
+    data->setContent(reinterpret_cast<const uint8_t*>(&id), sizeof(id));
+    m_keyChain.signWithSha256(*data);
+    m_diskIndex.insert(*data, id);
+  }
+
+  void
+  checkSameMatch()
+  {
+    BOOST_CHECK_EQUAL(m_diskIndex.find(*m_interest).first, m_index.find(*m_interest).first);
+  }
+
+protected:
+  repo::Index m_diskIndex;
+};
+
+BOOST_FIXTURE_TEST_CASE(DiskFind, DiskFindFixture)
+{
+  // several pages of children, each with a few grandchildren
+  int id = 1;
+  for (int i = 0; i < 100; ++i)
+    for (int j = 0; j < 3; ++j)
+      insertBoth(id++, Name("ndn:/B").appendSegment(i)
+                                      .append(boost::lexical_cast<std::string>(j)));
+  insertBoth(id++, "ndn:/A");
+  insertBoth(id++, "ndn:/C");
+  BOOST_CHECK_EQUAL(m_diskIndex.size(), m_index.size());
+
+  startInterest("ndn:/B");
+  checkSameMatch();
+  startInterest("ndn:/B").setChildSelector(1);
+  checkSameMatch();
+  startInterest(Name("ndn:/B").appendSegment(50)).setChildSelector(1);
+  checkSameMatch();
+  startInterest("ndn:/").setChildSelector(1);
+  checkSameMatch();
+  startInterest("ndn:/B")
+    .setChildSelector(1)
+    .setExclude(Exclude().excludeAfter(Name::Component::fromSegment(30)));
+  checkSameMatch();
+  startInterest("ndn:/B")
+    .setExclude(Exclude().excludeBefore(Name::Component::fromSegment(70)));
+  checkSameMatch();
+  startInterest("ndn:/B").setMinSuffixComponents(4);
+  checkSameMatch();
+
+  BOOST_CHECK_EQUAL(m_diskIndex.find(Name("ndn:/B")).first, m_index.find(Name("ndn:/B")).first);
+  BOOST_CHECK_EQUAL(m_diskIndex.getUsage(Name("ndn:/B").appendSegment(7)).nPackets, 3);
+
+  // erased entries stop matching, and entries in the same page stay visible
+  startInterest("ndn:/B").setChildSelector(1);
+  std::pair<int64_t, Name> last = m_diskIndex.find(*m_interest);
+  BOOST_CHECK_EQUAL(m_diskIndex.erase(last.second), true);
+  BOOST_CHECK_EQUAL(m_index.erase(last.second), true);
+  BOOST_CHECK_EQUAL(m_diskIndex.hasEntry(last.second), false);
+  checkSameMatch();
+  BOOST_CHECK_EQUAL(m_diskIndex.getStatus(last.second), DELETED);
+  BOOST_CHECK_EQUAL(m_diskIndex.size(), m_index.size());
+
+  size_t nEntries = 0;
+  m_diskIndex.entryEnumeration(bind(&countEntry, &nEntries, _1, _2));
+  BOOST_CHECK_EQUAL(nEntries, 302);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace tests
@@ -0,0 +1,70 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "storage/prefix-filter.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+namespace repo {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(PrefixFilterTest)
+
+BOOST_AUTO_TEST_CASE(InsertRemove)
+{
+  PrefixFilter disabled;
+  BOOST_CHECK_EQUAL(disabled.mayContain(Name("ndn:/A")), true);
+
+  PrefixFilter filter(4096);
+  filter.insert(Name("ndn:/A/B/1"));
+  filter.insert(Name("ndn:/A/C"));
+
+  BOOST_CHECK_EQUAL(filter.mayContain(Name()), true);
+  BOOST_CHECK_EQUAL(filter.mayContain(Name("ndn:/A")), true);
+  BOOST_CHECK_EQUAL(filter.mayContain(Name("ndn:/A/B")), true);
+  BOOST_CHECK_EQUAL(filter.mayContain(Name("ndn:/A/B/1")), true);
+  BOOST_CHECK_EQUAL(filter.mayContain(Name("ndn:/A/B/2")), false);
+  BOOST_CHECK_EQUAL(filter.mayContain(Name("ndn:/B")), false);
+  // component boundaries are part of a prefix
+  BOOST_CHECK_EQUAL(filter.mayContain(Name("ndn:/AB")), false);
+
+  filter.remove(Name("ndn:/A/B/1"));
+  BOOST_CHECK_EQUAL(filter.mayContain(Name("ndn:/A/B")), false);
+  BOOST_CHECK_EQUAL(filter.mayContain(Name("ndn:/A")), true);
+  BOOST_CHECK_EQUAL(filter.mayContain(Name("ndn:/A/C")), true);
+}
+
+BOOST_AUTO_TEST_CASE(Saturation)
+{
+  PrefixFilter filter(64);
+  for (int i = 0; i < 300; ++i)
+    filter.insert(Name("ndn:/A"));
+  filter.insert(Name("ndn:/B"));
+  for (int i = 0; i < 300; ++i)
+    filter.remove(Name("ndn:/A"));
+
+  // saturated counters are kept, so removals cannot hide names still inserted
+  BOOST_CHECK_EQUAL(filter.mayContain(Name("ndn:/A")), true);
+  BOOST_CHECK_EQUAL(filter.mayContain(Name("ndn:/B")), true);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace repo
@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "storage/quota.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+namespace repo {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(Quota)
+
+BOOST_AUTO_TEST_CASE(FindQuota)
+{
+  QuotaManager manager;
+  repo::Quota outer;
+  outer.prefix = Name("ndn:/A");
+  manager.addQuota(outer);
+  repo::Quota inner;
+  inner.prefix = Name("ndn:/A/B");
+  manager.addQuota(inner);
+
+  BOOST_REQUIRE(manager.findQuota(Name("ndn:/A/B/1")) != 0);
+  BOOST_CHECK_EQUAL(manager.findQuota(Name("ndn:/A/B/1"))->prefix, Name("ndn:/A/B"));
+  BOOST_REQUIRE(manager.findQuota(Name("ndn:/A/C/1")) != 0);
+  BOOST_CHECK_EQUAL(manager.findQuota(Name("ndn:/A/C/1"))->prefix, Name("ndn:/A"));
+  BOOST_CHECK(manager.findQuota(Name("ndn:/C")) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(EvictOldest)
+{
+  QuotaManager manager;
+  repo::Quota quota;
+  quota.prefix = Name("ndn:/A");
+  quota.policy = repo::Quota::EVICT_OLDEST;
+  manager.addQuota(quota);
+  const repo::Quota& added = manager.getQuotas().front();
+
+  Name candidate;
+  BOOST_CHECK_EQUAL(manager.getEvictionCandidate(added, candidate), false);
+
+  manager.onInsert(Name("ndn:/A/1"));
+  manager.onInsert(Name("ndn:/A/2"));
+  manager.onInsert(Name("ndn:/B/1"));
+  manager.onRead(Name("ndn:/A/1"));
+  BOOST_CHECK_EQUAL(manager.getEvictionCandidate(added, candidate), true);
+  BOOST_CHECK_EQUAL(candidate, Name("ndn:/A/1"));
+
+  manager.onErase(Name("ndn:/A/1"));
+  BOOST_CHECK_EQUAL(manager.getEvictionCandidate(added, candidate), true);
+  BOOST_CHECK_EQUAL(candidate, Name("ndn:/A/2"));
+
+  manager.onErase(Name("ndn:/A/2"));
+  BOOST_CHECK_EQUAL(manager.getEvictionCandidate(added, candidate), false);
+}
+
+BOOST_AUTO_TEST_CASE(EvictLru)
+{
+  QuotaManager manager;
+  repo::Quota quota;
+  quota.prefix = Name("ndn:/A");
+  quota.policy = repo::Quota::EVICT_LRU;
+  manager.addQuota(quota);
+  const repo::Quota& added = manager.getQuotas().front();
+
+  manager.onInsert(Name("ndn:/A/1"));
+  manager.onInsert(Name("ndn:/A/2"));
+  manager.onInsert(Name("ndn:/A/3"));
+  manager.onRead(Name("ndn:/A/1"));
+
+  Name candidate;
+  BOOST_CHECK_EQUAL(manager.getEvictionCandidate(added, candidate), true);
+  BOOST_CHECK_EQUAL(candidate, Name("ndn:/A/2"));
+
+  manager.onRead(Name("ndn:/A/2"));
+  BOOST_CHECK_EQUAL(manager.getEvictionCandidate(added, candidate), true);
+  BOOST_CHECK_EQUAL(candidate, Name("ndn:/A/3"));
+}
+
+BOOST_AUTO_TEST_CASE(Reject)
+{
+  QuotaManager manager;
+  repo::Quota quota;
+  quota.prefix = Name("ndn:/A");
+  quota.maxPackets = 2;
+  quota.maxBytes = 1000;
+  manager.addQuota(quota);
+  const repo::Quota& added = manager.getQuotas().front();
+
+  BOOST_CHECK_EQUAL(added.isExceeded(2, 1000), false);
+  BOOST_CHECK_EQUAL(added.isExceeded(3, 1000), true);
+  BOOST_CHECK_EQUAL(added.isExceeded(2, 1001), true);
+
+  // Data under a rejecting quota are not tracked for eviction
+  manager.onInsert(Name("ndn:/A/1"));
+  Name candidate;
+  BOOST_CHECK_EQUAL(manager.getEvictionCandidate(added, candidate), false);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace repo
@@ -0,0 +1,185 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "handles/read-ahead.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+namespace repo {
+namespace tests {
+
+class ReadAheadFixture
+{
+protected:
+  ReadAheadFixture()
+    : m_readAhead(16, 64)
+    , m_object("ndn:/A/v1")
+  {
+  }
+
+  Interest
+  makeInterest(uint64_t segment)
+  {
+    return Interest(Name(m_object).appendSegment(segment));
+  }
+
+  bool
+  request(uint64_t segment, bool isCacheHit = false)
+  {
+    Name object;
+    return m_readAhead.onInterest(makeInterest(segment), isCacheHit, object);
+  }
+
+  /**
+   * @brief read ahead like ReadHandle, with storage holding segments below nSegments
+   * @return number of segments read ahead
+   */
+  size_t
+  readAhead(uint64_t nSegments = 1000)
+  {
+    size_t nRead = 0;
+    Name name;
+    while (m_readAhead.getNextSegment(m_object, name)) {
+      if (name.get(-1).toSegment() >= nSegments) {
+        m_readAhead.onSegmentMissing(name);
+        break;
+      }
+      shared_ptr<Data> data = make_shared<Data>(name);
+      m_keyChain.signWithSha256(*data);
+      m_readAhead.onSegmentRead(name, data);
+      ++nRead;
+    }
+    return nRead;
+  }
+
+protected:
+  ReadAhead m_readAhead;
+  Name m_object;
+  KeyChain m_keyChain;
+};
+
+BOOST_FIXTURE_TEST_SUITE(ReadAheadTest, ReadAheadFixture)
+
+BOOST_AUTO_TEST_CASE(Sequential)
+{
+  // in-order requests are detected on the second segment
+  BOOST_CHECK_EQUAL(request(0), false);
+  BOOST_CHECK_EQUAL(request(1), true);
+  BOOST_CHECK_EQUAL(m_readAhead.getDepth(m_object), 4);
+  BOOST_CHECK_EQUAL(readAhead(), 4);
+
+  shared_ptr<const Data> data = m_readAhead.find(makeInterest(2));
+  BOOST_REQUIRE(data);
+  BOOST_CHECK_EQUAL(data->getName(), makeInterest(2).getName());
+
+  // the frontier is kept depth segments ahead
+  BOOST_CHECK_EQUAL(request(2, true), true);
+  BOOST_CHECK_EQUAL(readAhead(), 1);
+
+  // Interests with selectors are not answered from the cache
+  Interest rightmost = makeInterest(3);
+  rightmost.setChildSelector(1);
+  BOOST_CHECK(!m_readAhead.find(rightmost));
+}
+
+BOOST_AUTO_TEST_CASE(AdaptDepth)
+{
+  request(0);
+  request(1);
+  readAhead();
+
+  // a consumer window wider than the read-ahead reaches past the frontier
+  for (uint64_t segment = 2; segment <= 6; ++segment)
+    request(segment, segment < 6);
+  BOOST_CHECK_EQUAL(m_readAhead.getDepth(m_object), 8);
+  BOOST_CHECK_EQUAL(readAhead(), 8);
+
+  for (uint64_t segment = 7; segment <= 15; ++segment)
+    request(segment, segment < 15);
+  BOOST_CHECK_EQUAL(m_readAhead.getDepth(m_object), 16);
+  BOOST_CHECK_EQUAL(readAhead(), 16);
+
+  // bounded by the limit
+  for (uint64_t segment = 16; segment <= 32; ++segment)
+    request(segment, segment < 32);
+  BOOST_CHECK_EQUAL(m_readAhead.getDepth(m_object), 16);
+  BOOST_CHECK_EQUAL(readAhead(), 16);
+
+  // a segment read ahead but dropped from the cache shrinks the read-ahead
+  shared_ptr<const Data> data = m_readAhead.find(makeInterest(33));
+  BOOST_REQUIRE(data);
+  m_readAhead.erase(data->getFullName());
+  request(33, false);
+  BOOST_CHECK_EQUAL(m_readAhead.getDepth(m_object), 8);
+}
+
+BOOST_AUTO_TEST_CASE(EndOfObject)
+{
+  request(0);
+  request(1);
+  BOOST_CHECK_EQUAL(readAhead(3), 1);
+  BOOST_CHECK_EQUAL(request(2, true), false);
+
+  // a jump restarts detection
+  BOOST_CHECK_EQUAL(request(100), false);
+  BOOST_CHECK_EQUAL(m_readAhead.getDepth(m_object), 0);
+  BOOST_CHECK_EQUAL(request(101), true);
+}
+
+BOOST_AUTO_TEST_CASE(Erase)
+{
+  request(0);
+  request(1);
+  BOOST_CHECK_EQUAL(readAhead(), 4);
+  shared_ptr<const Data> data = m_readAhead.find(makeInterest(2));
+  BOOST_REQUIRE(data);
+
+  // other Data with the same name leave the cached Data in place
+  shared_ptr<Data> other = make_shared<Data>(data->getName());
+  other->setContent(reinterpret_cast<const uint8_t*>("other"), 5);
+  m_keyChain.signWithSha256(*other);
+  m_readAhead.erase(other->getFullName());
+  BOOST_CHECK(m_readAhead.find(makeInterest(2)));
+
+  m_readAhead.erase(data->getFullName());
+  BOOST_CHECK(!m_readAhead.find(makeInterest(2)));
+  BOOST_CHECK(m_readAhead.find(makeInterest(3)));
+}
+
+BOOST_AUTO_TEST_CASE(CacheCapacity)
+{
+  m_readAhead.setLimits(16, 2);
+  request(0);
+  request(1);
+  BOOST_CHECK_EQUAL(readAhead(), 4);
+  BOOST_CHECK_EQUAL(m_readAhead.getNCachedPackets(), 2);
+
+  // the oldest Data are evicted first
+  BOOST_CHECK(!m_readAhead.find(makeInterest(2)));
+  BOOST_CHECK(m_readAhead.find(makeInterest(5)));
+
+  m_readAhead.setLimits(0, 2);
+  BOOST_CHECK_EQUAL(m_readAhead.getNCachedPackets(), 0);
+  BOOST_CHECK_EQUAL(request(2), false);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace repo
@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sync/reply-cache.hpp"
+#include "sync/repo-sync.hpp"
+#include "response-signer.hpp"
+
+#include "../repo-storage-fixture.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace repo {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(ReplyCache)
+
+class ReplyFixture
+{
+protected:
+  ReplyFixture()
+    : m_signer(m_keyChain)
+  {
+    SigningPolicy policy;
+    policy.method = SigningPolicy::SIGN_WITH_DIGEST_SHA256;
+    m_signer.setPolicy(policy);
+  }
+
+  /**
+   * @brief make a signed reply the way RepoSync::sendData does
+   */
+  shared_ptr<Data>
+  makeReply(const Name& name)
+  {
+    static const uint8_t content[] = {0x01, 0x02, 0x03, 0x04};
+    shared_ptr<Data> reply = make_shared<Data>(name);
+    reply->setContent(content, sizeof(content));
+    m_signer.sign(*reply);
+    return reply;
+  }
+
+protected:
+  KeyChain m_keyChain;
+  repo::ResponseSigner m_signer;
+};
+
+BOOST_FIXTURE_TEST_CASE(ReuseSameDigest, ReplyFixture)
+{
+  repo::ReplyCache cache(2);
+  Name first("/ndn/broadcast/sync/digest1");
+  Name second("/ndn/broadcast/sync/digest2");
+  BOOST_CHECK(!cache.find(first));
+
+  shared_ptr<Data> reply = makeReply(first);
+  cache.insert(reply);
+  // a repeated interest for the same digest gets the same signed Data
+  BOOST_CHECK(cache.find(first) == reply);
+  BOOST_CHECK(cache.find(first) == reply);
+  BOOST_CHECK(!cache.find(second));
+
+  cache.insert(makeReply(second));
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK(cache.find(first) == reply);
+
+  // a full cache is emptied before the next reply is kept
+  cache.insert(makeReply("/ndn/broadcast/sync/digest3"));
+  BOOST_CHECK_EQUAL(cache.size(), 1);
+  BOOST_CHECK(!cache.find(first));
+
+  cache.clear();
+  BOOST_CHECK_EQUAL(cache.size(), 0);
+}
+
+class RepoSyncFixture : public RepoStorageFixture, public ReplyFixture
+{
+protected:
+  RepoSyncFixture()
+    : m_face(m_ioService)
+    , m_validator(m_face)
+    , m_sync("/ndn/broadcast", "/repo/0", "unittestdb_replycache", m_face, m_keyChain,
+             m_validator, *handle)
+  {
+  }
+
+  ~RepoSyncFixture()
+  {
+    boost::filesystem::remove_all(boost::filesystem::path("unittestdb_replycache"));
+  }
+
+protected:
+  boost::asio::io_service m_ioService;
+  ndn::Face m_face;
+  ValidatorConfig m_validator;
+  RepoSync m_sync;
+};
+
+BOOST_FIXTURE_TEST_CASE(InvalidatedOnSyncStateChange, RepoSyncFixture)
+{
+  repo::ReplyCache& cache = m_sync.getReplyCache();
+  Name name("/ndn/broadcast/sync/digest1");
+
+  // inserting an action changes both the sync tree and the action list
+  cache.insert(makeReply(name));
+  m_sync.insertAction("/example/data/1", "insertion");
+  BOOST_CHECK(!cache.find(name));
+  BOOST_CHECK_EQUAL(cache.size(), 0);
+
+  cache.insert(makeReply(name));
+  m_sync.insertAction("/example/data/1", "deletion");
+  BOOST_CHECK_EQUAL(cache.size(), 0);
+
+  // replies signed under another policy are not put again
+  cache.insert(makeReply(name));
+  m_sync.setSigningPolicy(SigningPolicy());
+  BOOST_CHECK_EQUAL(cache.size(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace repo
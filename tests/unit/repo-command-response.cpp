@@ -61,6 +61,31 @@ BOOST_AUTO_TEST_CASE(EncodeDecode)
   BOOST_CHECK_EQUAL(decoded.getProcessId(), response.getProcessId());
   BOOST_CHECK_EQUAL(decoded.getInsertNum(), response.getInsertNum());
   BOOST_CHECK_EQUAL(decoded.getDeleteNum(), response.getDeleteNum());
+  BOOST_CHECK_EQUAL(decoded.hasDataNum(), false);
+  BOOST_CHECK_EQUAL(decoded.hasDataSize(), false);
+}
+
+BOOST_AUTO_TEST_CASE(Usage)
+{
+  repo::RepoCommandResponse response;
+  response.setStatusCode(200);
+  response.setDataNum(3);
+  response.setDataSize(1000);
+
+  ndn::Block wire = response.wireEncode();
+
+  static const uint8_t expected[] = {
+    0xcf, 0x0a, 0xd0, 0x01, 0xc8, 0xd5, 0x01, 0x03, 0xd6, 0x02,
+    0x03, 0xe8
+  };
+
+  BOOST_REQUIRE_EQUAL_COLLECTIONS(expected, expected + sizeof(expected),
+                                  wire.begin(), wire.end());
+
+  repo::RepoCommandResponse decoded(wire);
+  BOOST_CHECK_EQUAL(decoded.getStatusCode(), 200);
+  BOOST_CHECK_EQUAL(decoded.getDataNum(), 3);
+  BOOST_CHECK_EQUAL(decoded.getDataSize(), 1000);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
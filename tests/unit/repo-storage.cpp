@@ -19,6 +19,7 @@
 
 #include "storage/repo-storage.hpp"
 #include "storage/sqlite-storage.hpp"
+#include "handles/read-ahead.hpp"
 #include "../dataset-fixtures.hpp"
 #include "../repo-storage-fixture.hpp"
 
@@ -73,6 +74,179 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(Bulk, T, Datasets, Fixture<T>)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(BatchInsert, T, CommonDatasets, Fixture<T>)
+{
+  BOOST_TEST_MESSAGE(T::getName());
+
+  std::vector<shared_ptr<const Data> > batch(this->data.begin(), this->data.end());
+  std::vector<bool> isInserted = this->handle->insertData(batch);
+  BOOST_REQUIRE_EQUAL(isInserted.size(), batch.size());
+  BOOST_CHECK_EQUAL(static_cast<size_t>(std::count(isInserted.begin(), isInserted.end(), true)),
+                    batch.size());
+  BOOST_CHECK_EQUAL(this->store->size(), this->data.size());
+
+  // full names from batched digests must match the ones computed by Data
+  for (size_t i = 0; i < batch.size(); ++i)
+    BOOST_CHECK_EQUAL(this->handle->getDataStatus(batch[i]->getFullName()), EXISTED);
+
+  for (typename T::InterestContainer::iterator i = this->interests.begin();
+       i != this->interests.end(); ++i)
+    {
+      BOOST_CHECK_EQUAL(*this->handle->readData(i->first), *i->second);
+    }
+
+  isInserted = this->handle->insertData(batch);
+  BOOST_CHECK_EQUAL(std::count(isInserted.begin(), isInserted.end(), true), 0);
+  BOOST_CHECK_EQUAL(this->store->size(), this->data.size());
+}
+
+BOOST_FIXTURE_TEST_CASE(BatchInsertIndexFull, Fixture<BasicDataset>)
+{
+  repo::RepoStorage small(2, *store);
+  std::vector<shared_ptr<const Data> > batch;
+  batch.push_back(createData("ndn:/a/1"));
+  batch.push_back(createData("ndn:/a/2"));
+  batch.push_back(createData("ndn:/a/3"));
+
+  // the Data inserted before the index filled up stay inserted
+  std::vector<bool> isInserted = small.insertData(batch);
+  BOOST_REQUIRE_EQUAL(isInserted.size(), 3);
+  BOOST_CHECK_EQUAL(isInserted[0], true);
+  BOOST_CHECK_EQUAL(isInserted[1], true);
+  BOOST_CHECK_EQUAL(isInserted[2], false);
+  BOOST_CHECK_EQUAL(small.size(), 2);
+  BOOST_CHECK_EQUAL(store->size(), 2);
+  BOOST_CHECK(small.readData(Interest("ndn:/a/2")));
+}
+
+static void
+ignoreAction(const Name& name, const std::string& action)
+{
+}
+
+BOOST_FIXTURE_TEST_CASE(NestedQuotas, Fixture<BasicDataset>)
+{
+  Quota outer;
+  outer.prefix = Name("ndn:/a");
+  outer.maxPackets = 2;
+  outer.policy = Quota::EVICT_OLDEST;
+  handle->addQuota(outer);
+
+  Quota inner;
+  inner.prefix = Name("ndn:/a/b");
+  inner.policy = Quota::REJECT;
+  handle->addQuota(inner);
+
+  BOOST_CHECK_EQUAL(handle->insertData(*createData("ndn:/a/x/1")), true);
+  BOOST_CHECK_EQUAL(handle->insertData(*createData("ndn:/a/x/2")), true);
+  for (int i = 0; i < 5; ++i)
+    BOOST_CHECK_EQUAL(handle->insertData(*createData(Name("ndn:/a/b").appendNumber(i))), true);
+
+  // Data under /a/b count against the nested quota only
+  BOOST_CHECK_EQUAL(handle->getUsage("ndn:/a").nPackets, 7);
+  BOOST_CHECK_EQUAL(handle->evictOverQuota(10, &ignoreAction), 0);
+
+  BOOST_CHECK_EQUAL(handle->insertData(*createData("ndn:/a/x/3")), true);
+  BOOST_CHECK_EQUAL(handle->evictOverQuota(10, &ignoreAction), 1);
+  BOOST_CHECK(!handle->readData(Interest("ndn:/a/x/1")));
+  BOOST_CHECK(handle->readData(Interest("ndn:/a/x/3")));
+  BOOST_CHECK_EQUAL(handle->getUsage("ndn:/a/b").nPackets, 5);
+}
+
+BOOST_FIXTURE_TEST_CASE(PrefetchAndRecordedReads, Fixture<BasicDataset>)
+{
+  Quota quota;
+  quota.prefix = Name("ndn:/a");
+  quota.maxPackets = 2;
+  quota.policy = Quota::EVICT_LRU;
+  handle->addQuota(quota);
+  shared_ptr<Data> first = createData("ndn:/a/1");
+  shared_ptr<Data> second = createData("ndn:/a/2");
+  BOOST_CHECK_EQUAL(handle->insertData(*first), true);
+  BOOST_CHECK_EQUAL(handle->insertData(*second), true);
+
+  // Data read ahead are not made recently read
+  BOOST_CHECK(handle->readData(Interest("ndn:/a/2")));
+  BOOST_CHECK(handle->readData(Interest("ndn:/a/1"), true));
+  BOOST_CHECK_EQUAL(handle->insertData(*createData("ndn:/a/3")), true);
+  BOOST_CHECK_EQUAL(handle->evictOverQuota(10, &ignoreAction), 1);
+  BOOST_CHECK(!handle->readData(Interest("ndn:/a/1"), true));
+
+  // a read served from a cache is recorded by full name
+  handle->recordRead(second->getFullName());
+  BOOST_CHECK_EQUAL(handle->insertData(*createData("ndn:/a/4")), true);
+  BOOST_CHECK_EQUAL(handle->evictOverQuota(10, &ignoreAction), 1);
+  BOOST_CHECK(!handle->readData(Interest("ndn:/a/3"), true));
+  BOOST_CHECK(handle->readData(Interest("ndn:/a/2"), true));
+}
+
+BOOST_FIXTURE_TEST_CASE(PackObjects, Fixture<BasicDataset>)
+{
+  Name object("ndn:/a/v1");
+  for (uint64_t segment = 0; segment < 7; ++segment)
+    BOOST_CHECK_EQUAL(handle->insertData(*createData(Name(object).appendSegment(segment))),
+                      true);
+  Name other("ndn:/b/v1");
+  for (uint64_t segment = 0; segment < 4; ++segment)
+    BOOST_CHECK_EQUAL(handle->insertData(*createData(Name(other).appendSegment(segment))),
+                      true);
+  BOOST_CHECK_EQUAL(handle->addObjectToPack(object), true);
+  BOOST_CHECK_EQUAL(handle->addObjectToPack(other), true);
+  BOOST_CHECK_EQUAL(handle->addObjectToPack("ndn:/c"), false);
+
+  // segments are moved a bounded run at a time, and stay readable in between
+  BOOST_CHECK_EQUAL(handle->packObjects(3), 3);
+  BOOST_CHECK_EQUAL(handle->packObjects(3), 4);
+  for (uint64_t segment = 0; segment < 7; ++segment) {
+    Name name = Name(object).appendSegment(segment);
+    shared_ptr<Data> data = handle->readData(Interest(name));
+    BOOST_REQUIRE(data);
+    BOOST_CHECK_EQUAL(*data, *createData(name));
+  }
+
+  // a segment deleted since the object was queued ends its packing
+  BOOST_CHECK_EQUAL(handle->deleteData(Name(other).appendSegment(3)), 1);
+  BOOST_CHECK_EQUAL(handle->packObjects(10), 4);
+  BOOST_CHECK_EQUAL(handle->packObjects(10), 0);
+  BOOST_CHECK(handle->readData(Interest(Name(other).appendSegment(2))));
+}
+
+BOOST_FIXTURE_TEST_CASE(EraseWhileReadAhead, Fixture<BasicDataset>)
+{
+  ReadAhead readAhead(16, 64);
+  handle->addEraseCallback(bind(&ReadAhead::erase, &readAhead, _1));
+
+  Name object("ndn:/a/v1");
+  handle->addRetention(Name(object).appendSegment(4), ndn::time::milliseconds(0));
+  Quota quota;
+  quota.prefix = Name(object).appendSegment(3);
+  quota.maxPackets = 0;
+  quota.policy = Quota::EVICT_OLDEST;
+  handle->addQuota(quota);
+  for (uint64_t segment = 0; segment < 8; ++segment)
+    BOOST_CHECK_EQUAL(handle->insertData(*createData(Name(object).appendSegment(segment))),
+                      true);
+
+  // read segments 2 to 5 ahead, like ReadHandle
+  Name streamObject;
+  readAhead.onInterest(Interest(Name(object).appendSegment(0)), false, streamObject);
+  BOOST_REQUIRE(readAhead.onInterest(Interest(Name(object).appendSegment(1)), false,
+                                     streamObject));
+  Name name;
+  while (readAhead.getNextSegment(object, name))
+    readAhead.onSegmentRead(name, handle->readData(Interest(name), true));
+  for (uint64_t segment = 2; segment < 6; ++segment)
+    BOOST_CHECK(readAhead.find(Interest(Name(object).appendSegment(segment))));
+
+  // Data deleted, evicted or expired while cached are no longer served from the cache
+  BOOST_CHECK_EQUAL(handle->deleteData(Name(object).appendSegment(2)), 1);
+  BOOST_CHECK_EQUAL(handle->evictOverQuota(10, &ignoreAction), 1);
+  BOOST_CHECK_EQUAL(handle->removeExpiredData(10, &ignoreAction), 1);
+  for (uint64_t segment = 2; segment < 5; ++segment)
+    BOOST_CHECK(!readAhead.find(Interest(Name(object).appendSegment(segment))));
+  BOOST_CHECK(readAhead.find(Interest(Name(object).appendSegment(5))));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace tests
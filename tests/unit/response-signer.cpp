@@ -0,0 +1,63 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "response-signer.hpp"
+
+#include <ndn-cxx/security/validator.hpp>
+#include <ndn-cxx/security/digest-sha256.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+namespace repo {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(ResponseSigner)
+
+BOOST_AUTO_TEST_CASE(DigestSha256)
+{
+  KeyChain keyChain;
+  repo::ResponseSigner signer(keyChain);
+  SigningPolicy policy;
+  policy.method = SigningPolicy::SIGN_WITH_DIGEST_SHA256;
+  signer.setPolicy(policy);
+  BOOST_CHECK_EQUAL(signer.getPolicy().method, SigningPolicy::SIGN_WITH_DIGEST_SHA256);
+
+  static const uint8_t content[] = {0x01, 0x02, 0x03, 0x04};
+  Data reply("/ndn/broadcast/sync/digest");
+  reply.setContent(content, sizeof(content));
+  signer.sign(reply);
+
+  BOOST_REQUIRE_EQUAL(reply.getSignature().getType(), ndn::Tlv::DigestSha256);
+  ndn::DigestSha256 signature(reply.getSignature());
+  BOOST_CHECK(ndn::Validator::verifySignature(reply, signature));
+
+  // the decoded reply verifies as a receiving repo sees it
+  Data received(reply.wireEncode());
+  BOOST_CHECK(ndn::Validator::verifySignature(received,
+                                              ndn::DigestSha256(received.getSignature())));
+
+  // a reply whose content changed after signing does not
+  reply.setContent(content, sizeof(content) - 1);
+  BOOST_CHECK(!ndn::Validator::verifySignature(reply, signature));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace repo
@@ -0,0 +1,93 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "handles/segment-tracker.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+namespace repo {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(SegmentTracker)
+
+BOOST_AUTO_TEST_CASE(InOrder)
+{
+  repo::SegmentTracker tracker(10, 64);
+  BOOST_CHECK_EQUAL(tracker.getBase(), 10);
+  BOOST_CHECK(!tracker.canTrack(9));
+  BOOST_CHECK(tracker.canTrack(73));
+  BOOST_CHECK(!tracker.canTrack(74));
+
+  for (SegmentNo segment = 10; segment < 20; ++segment) {
+    tracker.markPending(segment);
+    BOOST_CHECK(tracker.isPending(segment));
+    BOOST_CHECK_EQUAL(tracker.markReceived(segment), true);
+    BOOST_CHECK(!tracker.isPending(segment));
+  }
+  BOOST_CHECK_EQUAL(tracker.getBase(), 20);
+  BOOST_CHECK_EQUAL(tracker.getNReceived(), 10);
+  BOOST_CHECK(tracker.canTrack(83));
+}
+
+BOOST_AUTO_TEST_CASE(OutOfOrderAndDuplicates)
+{
+  repo::SegmentTracker tracker(0, 64);
+  for (SegmentNo segment = 0; segment < 64; ++segment)
+    tracker.markPending(segment);
+
+  // window cannot slide past missing segment 0
+  for (SegmentNo segment = 63; segment > 0; --segment)
+    BOOST_CHECK_EQUAL(tracker.markReceived(segment), true);
+  BOOST_CHECK_EQUAL(tracker.getBase(), 0);
+  BOOST_CHECK(!tracker.canTrack(64));
+  BOOST_CHECK_EQUAL(tracker.markReceived(5), false);
+  BOOST_CHECK(tracker.isPending(0));
+
+  tracker.incrementRetryCount(0);
+  tracker.incrementRetryCount(0);
+  BOOST_CHECK_EQUAL(tracker.getRetryCount(0), 2);
+  tracker.addWaitTime(0, ndn::time::milliseconds(1000));
+  tracker.addWaitTime(0, ndn::time::milliseconds(2000));
+  BOOST_CHECK_EQUAL(tracker.getWaitTime(0).count(), 3000);
+
+  BOOST_CHECK_EQUAL(tracker.markReceived(0), true);
+  BOOST_CHECK_EQUAL(tracker.getBase(), 64);
+  BOOST_CHECK_EQUAL(tracker.getNReceived(), 64);
+
+  // slots are reused with clean state
+  BOOST_CHECK(tracker.isReceived(0));
+  BOOST_CHECK_EQUAL(tracker.markReceived(0), false);
+  BOOST_CHECK(!tracker.isReceived(64));
+  BOOST_CHECK(!tracker.isPending(64));
+  BOOST_CHECK_EQUAL(tracker.getRetryCount(64), 0);
+  BOOST_CHECK_EQUAL(tracker.getWaitTime(64).count(), 0);
+  BOOST_CHECK_EQUAL(tracker.getNReceived(), 64);
+}
+
+BOOST_AUTO_TEST_CASE(Capacity)
+{
+  repo::SegmentTracker tracker(0, 100);
+  BOOST_CHECK(tracker.canTrack(127));
+  BOOST_CHECK(!tracker.canTrack(128));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace repo
@@ -0,0 +1,79 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "storage/sha256-batch.hpp"
+
+#include <ndn-cxx/util/crypto.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+namespace repo {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(Sha256BatchTest)
+
+BOOST_AUTO_TEST_CASE(KnownDigest)
+{
+  static const uint8_t MESSAGE[] = {'a', 'b', 'c'};
+  static const uint8_t DIGEST[] = {
+    0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+    0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+  };
+
+  Sha256Batch batch;
+  BOOST_CHECK_EQUAL(batch.add(MESSAGE, sizeof(MESSAGE)), 0);
+  batch.compute();
+  BOOST_CHECK_EQUAL_COLLECTIONS(batch.getDigest(0)->begin(), batch.getDigest(0)->end(),
+                                DIGEST, DIGEST + sizeof(DIGEST));
+}
+
+BOOST_AUTO_TEST_CASE(MixedLengths)
+{
+  // lengths around block and padding boundaries, in groups large enough for parallel lanes
+  std::vector<std::vector<uint8_t> > messages;
+  for (size_t size = 0; size < 300; ++size) {
+    std::vector<uint8_t> message(size);
+    for (size_t i = 0; i < size; ++i)
+      message[i] = static_cast<uint8_t>(size * 31 + i);
+    messages.push_back(message);
+  }
+  messages.push_back(std::vector<uint8_t>(8800, 0xA5));
+
+  Sha256Batch batch;
+  for (size_t i = 0; i < messages.size(); ++i)
+    batch.add(messages[i].empty() ? 0 : &messages[i][0], messages[i].size());
+  batch.compute();
+
+  BOOST_REQUIRE_EQUAL(batch.size(), messages.size());
+  for (size_t i = 0; i < messages.size(); ++i) {
+    ndn::ConstBufferPtr expected =
+      ndn::crypto::sha256(messages[i].empty() ? 0 : &messages[i][0], messages[i].size());
+    BOOST_CHECK_EQUAL_COLLECTIONS(batch.getDigest(i)->begin(), batch.getDigest(i)->end(),
+                                  expected->begin(), expected->end());
+  }
+
+  batch.clear();
+  BOOST_CHECK_EQUAL(batch.size(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace repo
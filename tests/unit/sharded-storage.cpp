@@ -0,0 +1,126 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "storage/sharded-storage.hpp"
+#include "storage/index.hpp"
+
+#include "../sqlite-fixture.hpp"
+#include "../dataset-fixtures.hpp"
+
+#include <boost/lexical_cast.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace repo {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(ShardedStorage)
+
+template<class Dataset>
+class Fixture : public SqliteFixture, public Dataset
+{
+public:
+  Fixture()
+  {
+    // shards live under the directory of the fixture database, which is removed with it
+    for (int i = 0; i < 3; ++i)
+      storage.addShard(make_shared<repo::SqliteStorage>("unittestdb/shard" +
+                                                        boost::lexical_cast<std::string>(i)),
+                       i < 2);
+  }
+
+public:
+  repo::ShardedStorage storage;
+  std::map<int64_t, shared_ptr<Data> > idToDataMap;
+};
+
+static void
+appendItem(std::vector<Storage::ItemMeta>* items, const Storage::ItemMeta& item)
+{
+  items->push_back(item);
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(InsertReadDelete, T, CommonDatasets, Fixture<T>)
+{
+  BOOST_TEST_MESSAGE(T::getName());
+
+  std::vector<int64_t> ids;
+  for (typename T::DataContainer::iterator i = this->data.begin();
+       i != this->data.end(); ++i)
+    {
+      int64_t id = -1;
+      BOOST_REQUIRE_NO_THROW(id = this->storage.insert(**i));
+      BOOST_CHECK_EQUAL(this->idToDataMap.count(id), 0);
+      BOOST_CHECK_NE(this->storage.findShard((*i)->getName()), 2);
+      this->idToDataMap.insert(std::make_pair(id, *i));
+      ids.push_back(id);
+    }
+  BOOST_CHECK_EQUAL(this->storage.size(), this->data.size());
+
+  for (std::vector<int64_t>::iterator i = ids.begin(); i != ids.end(); ++i) {
+    shared_ptr<Data> data = this->storage.read(*i);
+    BOOST_REQUIRE(static_cast<bool>(data));
+    BOOST_CHECK_EQUAL(*this->idToDataMap[*i], *data);
+  }
+
+  std::vector<Storage::ItemMeta> items;
+  this->storage.fullEnumerate(bind(&appendItem, &items, _1));
+  BOOST_REQUIRE_EQUAL(items.size(), this->data.size());
+  for (size_t i = 0; i < items.size(); ++i) {
+    BOOST_REQUIRE(this->idToDataMap.count(items[i].id) > 0);
+    BOOST_CHECK_EQUAL(items[i].fullName, this->idToDataMap[items[i].id]->getFullName());
+  }
+
+  BOOST_CHECK_EQUAL(this->storage.erase(ids), ids.size());
+  BOOST_CHECK_EQUAL(this->storage.size(), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(Placement, Fixture<BasicDataset>)
+{
+  storage.addPrefix("ndn:/a/b", 2);
+  BOOST_CHECK_EQUAL(storage.findShard("ndn:/a/b"), 2);
+  BOOST_CHECK_EQUAL(storage.findShard("ndn:/a/b/c"), 2);
+  BOOST_CHECK_THROW(storage.addPrefix("ndn:/c", 3), repo::ShardedStorage::Error);
+
+  // all segments of an object are in one shard
+  size_t shard = storage.findShard(Name("ndn:/a/c").appendSegment(0));
+  for (uint64_t segment = 1; segment < 32; ++segment)
+    BOOST_CHECK_EQUAL(storage.findShard(Name("ndn:/a/c").appendSegment(segment)), shard);
+
+  // expired entries of every shard are found
+  KeyChain keyChain;
+  for (int i = 0; i < 16; ++i) {
+    Name name("ndn:/expiring");
+    name.appendNumber(i);
+    shared_ptr<Data> data = make_shared<Data>(name);
+    keyChain.signWithSha256(*data);
+    Index::Entry entry(*data, 0);
+    Storage::ItemMeta item;
+    item.fullName = entry.getName();
+    item.keyLocatorHash = entry.getKeyLocatorHash();
+    item.dataSize = entry.getDataSize();
+    BOOST_CHECK_GT(storage.insert(*data, item, 1000), 0);
+  }
+  BOOST_CHECK_EQUAL(storage.getExpired(1000, 100).size(), 16);
+  BOOST_CHECK_EQUAL(storage.getExpired(1000, 5).size(), 5);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace repo
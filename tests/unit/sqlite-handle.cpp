@@ -23,6 +23,7 @@
 #include "../dataset-fixtures.hpp"
 
 #include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
 
 namespace repo {
 namespace tests {
@@ -73,6 +74,252 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(InsertReadDelete, T, CommonDatasets, Fixture<T>
   BOOST_CHECK_EQUAL(this->handle->size(), 0);
 }
 
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(Expiry, T, CommonDatasets, Fixture<T>)
+{
+  BOOST_TEST_MESSAGE(T::getName());
+
+  // every other Data expires, at times 1000, 1002, 1004...
+  size_t nExpiring = 0;
+  int64_t expiry = 1000;
+  for (typename T::DataContainer::iterator i = this->data.begin();
+       i != this->data.end(); ++i, ++expiry)
+    {
+      bool isExpiring = (expiry % 2 == 0);
+      BOOST_REQUIRE_NO_THROW(this->handle->insert(**i, isExpiring ? expiry : 0));
+      if (isExpiring)
+        ++nExpiring;
+    }
+
+  BOOST_CHECK_EQUAL(this->handle->getExpired(999, 1000000).size(), 0);
+  BOOST_CHECK_EQUAL(this->handle->getExpired(1000000, 1000000).size(), nExpiring);
+
+  std::vector<std::pair<int64_t, Name> > expired = this->handle->getExpired(1000000, 2);
+  BOOST_REQUIRE_EQUAL(expired.size(), std::min<size_t>(nExpiring, 2));
+  if (expired.size() == 2)
+    BOOST_CHECK(expired[0].first < expired[1].first);
+
+  std::vector<int64_t> ids;
+  expired = this->handle->getExpired(1000000, 1000000);
+  for (size_t i = 0; i < expired.size(); ++i)
+    ids.push_back(expired[i].first);
+  BOOST_CHECK_EQUAL(this->handle->erase(ids), nExpiring);
+  BOOST_CHECK_EQUAL(this->handle->getExpired(1000000, 1000000).size(), 0);
+  BOOST_CHECK_EQUAL(this->handle->size(), this->data.size() - nExpiring);
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(Deduplication, T, CommonDatasets, Fixture<T>)
+{
+  BOOST_TEST_MESSAGE(T::getName());
+
+  // Data of every dataset carry the same 1500-byte Content
+  delete this->handle;
+  this->handle = new repo::SqliteStorage("unittestdb", 1000);
+
+  std::vector<int64_t> ids;
+  for (typename T::DataContainer::iterator i = this->data.begin();
+       i != this->data.end(); ++i)
+    {
+      int64_t id = -1;
+      BOOST_REQUIRE_NO_THROW(id = this->handle->insert(**i));
+      this->idToDataMap.insert(std::make_pair(id, *i));
+      ids.push_back(id);
+    }
+
+  sqlite3* db = 0;
+  BOOST_REQUIRE_EQUAL(sqlite3_open("unittestdb/ndn_repo.db", &db), SQLITE_OK);
+  sqlite3_stmt* countStmt = 0;
+  BOOST_REQUIRE_EQUAL(sqlite3_prepare_v2(db, "SELECT count(*) FROM NDN_REPO_CONTENT;", -1,
+                                         &countStmt, 0), SQLITE_OK);
+  BOOST_REQUIRE_EQUAL(sqlite3_step(countStmt), SQLITE_ROW);
+  BOOST_CHECK_EQUAL(sqlite3_column_int(countStmt, 0), this->data.empty() ? 0 : 1);
+  sqlite3_reset(countStmt);
+
+  // each Data is reassembled with its own name and signature
+  for (std::vector<int64_t>::iterator i = ids.begin(); i != ids.end(); ++i) {
+    shared_ptr<Data> data = this->handle->read(*i);
+    BOOST_REQUIRE(static_cast<bool>(data));
+    BOOST_CHECK_EQUAL(*this->idToDataMap[*i], *data);
+  }
+
+  // the shared Content outlives all but the last Data referring to it
+  if (!ids.empty()) {
+    std::vector<int64_t> allButLast(ids.begin(), ids.end() - 1);
+    BOOST_CHECK_EQUAL(this->handle->erase(allButLast), allButLast.size());
+    BOOST_CHECK_EQUAL(*this->idToDataMap[ids.back()], *this->handle->read(ids.back()));
+    BOOST_CHECK_EQUAL(this->handle->erase(ids.back()), true);
+  }
+  BOOST_REQUIRE_EQUAL(sqlite3_step(countStmt), SQLITE_ROW);
+  BOOST_CHECK_EQUAL(sqlite3_column_int(countStmt, 0), 0);
+  sqlite3_finalize(countStmt);
+  sqlite3_close(db);
+}
+
+static void
+appendItem(std::vector<Storage::ItemMeta>* items, const Storage::ItemMeta& item)
+{
+  items->push_back(item);
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(CompressedRecords, T, CommonDatasets, Fixture<T>)
+{
+  BOOST_TEST_MESSAGE(T::getName());
+
+  repo::Compression compression;
+  compression.addPrefix(Name("ndn:/"), 6);
+  delete this->handle;
+  this->handle = new repo::SqliteStorage("unittestdb", 0, compression);
+
+  std::map<Name, size_t> sizes;
+  std::vector<int64_t> ids;
+  for (typename T::DataContainer::iterator i = this->data.begin();
+       i != this->data.end(); ++i)
+    {
+      int64_t id = -1;
+      BOOST_REQUIRE_NO_THROW(id = this->handle->insert(**i));
+      this->idToDataMap.insert(std::make_pair(id, *i));
+      ids.push_back(id);
+      sizes[(*i)->getFullName()] = (*i)->wireEncode().size();
+    }
+
+  for (std::vector<int64_t>::iterator i = ids.begin(); i != ids.end(); ++i) {
+    shared_ptr<Data> data = this->handle->read(*i);
+    BOOST_REQUIRE(static_cast<bool>(data));
+    BOOST_CHECK_EQUAL(*this->idToDataMap[*i], *data);
+  }
+
+  // sizes seen when rebuilding the index are sizes before compression
+  std::vector<Storage::ItemMeta> items;
+  this->handle->fullEnumerate(bind(&appendItem, &items, _1));
+  BOOST_REQUIRE_EQUAL(items.size(), this->data.size());
+  for (size_t i = 0; i < items.size(); ++i)
+    BOOST_CHECK_EQUAL(items[i].dataSize, sizes[items[i].fullName]);
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(PackedObject, T, CommonDatasets, Fixture<T>)
+{
+  BOOST_TEST_MESSAGE(T::getName());
+
+  std::vector<int64_t> ids;
+  for (typename T::DataContainer::iterator i = this->data.begin();
+       i != this->data.end(); ++i)
+    {
+      // the object expires with the first Data
+      int64_t id = -1;
+      BOOST_REQUIRE_NO_THROW(id = this->handle->insert(**i, ids.empty() ? 1000 : 2000));
+      ids.push_back(id);
+    }
+
+  std::vector<int64_t> segmentIds = this->handle->packObject(ids);
+  if (ids.size() < 2) {
+    BOOST_CHECK(segmentIds.empty());
+    return;
+  }
+  BOOST_REQUIRE_EQUAL(segmentIds.size(), ids.size());
+  BOOST_CHECK_EQUAL(this->handle->size(), this->data.size());
+  BOOST_CHECK(this->handle->packObject(segmentIds).empty());
+
+  std::map<Name, int64_t> nameToId;
+  typename T::DataContainer::iterator data = this->data.begin();
+  for (size_t i = 0; i < segmentIds.size(); ++i, ++data) {
+    BOOST_CHECK(!static_cast<bool>(this->handle->read(ids[i])));
+    shared_ptr<Data> segment = this->handle->read(segmentIds[i]);
+    BOOST_REQUIRE(static_cast<bool>(segment));
+    BOOST_CHECK_EQUAL(**data, *segment);
+    nameToId[(*data)->getFullName()] = segmentIds[i];
+  }
+
+  std::vector<Storage::ItemMeta> items;
+  this->handle->fullEnumerate(bind(&appendItem, &items, _1));
+  BOOST_REQUIRE_EQUAL(items.size(), this->data.size());
+  for (size_t i = 0; i < items.size(); ++i)
+    BOOST_CHECK_EQUAL(items[i].id, nameToId[items[i].fullName]);
+
+  BOOST_CHECK(this->handle->getExpired(999, 1).empty());
+  std::vector<std::pair<int64_t, Name> > expired = this->handle->getExpired(1000, 1);
+  BOOST_REQUIRE_EQUAL(expired.size(), 1);
+  BOOST_CHECK_EQUAL(expired[0].first, segmentIds[0]);
+
+  BOOST_CHECK_EQUAL(this->handle->erase(segmentIds[0]), true);
+  BOOST_CHECK_EQUAL(this->handle->erase(segmentIds[0]), false);
+  BOOST_CHECK(!static_cast<bool>(this->handle->read(segmentIds[0])));
+  BOOST_CHECK_EQUAL(*this->handle->read(segmentIds[1]), **(++this->data.begin()));
+  segmentIds.erase(segmentIds.begin());
+  BOOST_CHECK_EQUAL(this->handle->erase(segmentIds), segmentIds.size());
+  BOOST_CHECK_EQUAL(this->handle->size(), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(Maintenance, T, CommonDatasets, Fixture<T>)
+{
+  BOOST_TEST_MESSAGE(T::getName());
+
+  std::vector<int64_t> ids;
+  for (typename T::DataContainer::iterator i = this->data.begin();
+       i != this->data.end(); ++i)
+    {
+      int64_t id = -1;
+      BOOST_REQUIRE_NO_THROW(id = this->handle->insert(**i));
+      ids.push_back(id);
+    }
+  BOOST_CHECK_EQUAL(this->handle->erase(ids), ids.size());
+
+  // the first run reclaims pages freed by erase, which writes to the log again
+  this->handle->prepareMaintenance();
+  this->handle->maintain(16, ndn::time::milliseconds(1));
+  Storage::MaintenanceStatus status = this->handle->reclaimSpace(0, 1000000);
+  BOOST_CHECK_EQUAL(status.nFreePages, 0);
+  this->handle->prepareMaintenance();
+  this->handle->maintain(16, ndn::time::milliseconds(1));
+  status = this->handle->reclaimSpace(0, 1000000);
+  BOOST_CHECK_EQUAL(status.walSize, 0);
+  BOOST_CHECK_EQUAL(status.nFreePages, 0);
+  BOOST_CHECK_EQUAL(status.nReclaimedPages, 0);
+
+  // inserts still work once checkpoints are left to maintain
+  for (typename T::DataContainer::iterator i = this->data.begin();
+       i != this->data.end(); ++i)
+    {
+      int64_t id = -1;
+      BOOST_REQUIRE_NO_THROW(id = this->handle->insert(**i));
+      BOOST_CHECK_EQUAL(*this->handle->read(id), **i);
+    }
+  BOOST_CHECK_EQUAL(this->handle->size(), this->data.size());
+}
+
+static void
+runMaintenance(Storage* storage, Storage::MaintenanceStatus* status)
+{
+  *status = storage->maintain(1, ndn::time::milliseconds(1));
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(MaintenanceThread, T, CommonDatasets, Fixture<T>)
+{
+  BOOST_TEST_MESSAGE(T::getName());
+
+  std::vector<int64_t> ids;
+  for (typename T::DataContainer::iterator i = this->data.begin();
+       i != this->data.end(); ++i)
+    {
+      int64_t id = -1;
+      BOOST_REQUIRE_NO_THROW(id = this->handle->insert(**i));
+      ids.push_back(id);
+    }
+  BOOST_CHECK_EQUAL(this->handle->erase(ids), ids.size());
+
+  // inserts and reads go on while a slow checkpoint runs on another thread
+  this->handle->prepareMaintenance();
+  Storage::MaintenanceStatus status;
+  boost::thread maintenance(bind(&runMaintenance, this->handle, &status));
+  for (typename T::DataContainer::iterator i = this->data.begin();
+       i != this->data.end(); ++i)
+    {
+      int64_t id = -1;
+      BOOST_REQUIRE_NO_THROW(id = this->handle->insert(**i));
+      BOOST_CHECK_EQUAL(*this->handle->read(id), **i);
+    }
+  maintenance.join();
+  BOOST_CHECK_EQUAL(this->handle->size(), this->data.size());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace tests
@@ -18,6 +18,7 @@
  */
 
 #include "handles/tcp-bulk-insert-handle.hpp"
+#include "repo-command-response.hpp"
 #include "storage/sqlite-storage.hpp"
 #include "../repo-storage-fixture.hpp"
 #include "../dataset-fixtures.hpp"
@@ -173,6 +174,85 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(BulkInsertAndRead, T, CommonDatasets, TcpBulkIn
   }
 }
 
+template<class Dataset>
+class TcpBulkInsertConfirmFixture : public TcpBulkInsertFixture<Dataset>
+{
+public:
+  TcpBulkInsertConfirmFixture()
+    : confirmInterest(Name("/confirm"))
+    , nBytesReceived(0)
+    , isConfirmed(false)
+  {
+  }
+
+  virtual void
+  onSuccessfullConnect(const boost::system::error_code& error)
+  {
+    TcpClient::onSuccessfullConnect(error);
+
+    this->socket.set_option(boost::asio::socket_base::send_buffer_size(100000));
+
+    for (typename Dataset::DataContainer::iterator i = this->data.begin();
+         i != this->data.end(); ++i) {
+      this->socket.async_send(boost::asio::buffer((*i)->wireEncode().wire(),
+                                                  (*i)->wireEncode().size()),
+                              bind(&TcpBulkInsertConfirmFixture::onSendFinished, this, _1, false));
+    }
+
+    // Interest after the Data requests the confirmation
+    this->socket.async_send(boost::asio::buffer(confirmInterest.wireEncode().wire(),
+                                                confirmInterest.wireEncode().size()),
+                            bind(&TcpBulkInsertConfirmFixture::onSendFinished, this, _1, false));
+
+    this->socket.async_receive(boost::asio::buffer(responseBuffer, sizeof(responseBuffer)),
+                               bind(&TcpBulkInsertConfirmFixture::onReceive, this, _1, _2));
+  }
+
+  void
+  onReceive(const boost::system::error_code& error, std::size_t nBytes)
+  {
+    if (error) {
+      BOOST_FAIL("TCP connection aborted");
+      return;
+    }
+
+    nBytesReceived += nBytes;
+    Block block;
+    if (!Block::fromBuffer(responseBuffer, nBytesReceived, block)) {
+      this->socket.async_receive(boost::asio::buffer(responseBuffer + nBytesReceived,
+                                                     sizeof(responseBuffer) - nBytesReceived),
+                                 bind(&TcpBulkInsertConfirmFixture::onReceive, this, _1, _2));
+      return;
+    }
+
+    response.wireDecode(block);
+    isConfirmed = true;
+
+    this->scheduler.cancelEvent(this->guardEvent);
+    this->stop();
+  }
+
+public:
+  Interest confirmInterest;
+  uint8_t responseBuffer[1024];
+  std::size_t nBytesReceived;
+  bool isConfirmed;
+  RepoCommandResponse response;
+};
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(BulkInsertAndConfirm, T, CommonDatasets,
+                                 TcpBulkInsertConfirmFixture<T>)
+{
+  BOOST_TEST_MESSAGE(T::getName());
+
+  this->bulkInserter.listen("localhost", "17376");
+  this->start("localhost", "17376");
+  this->ioService.run();
+
+  BOOST_REQUIRE(this->isConfirmed);
+  BOOST_CHECK_EQUAL(this->response.getStatusCode(), 200);
+  BOOST_CHECK_EQUAL(this->response.getInsertNum(), this->data.size());
+}
 
 BOOST_AUTO_TEST_SUITE_END()
 
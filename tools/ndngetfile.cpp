@@ -19,6 +19,7 @@
 
 #include "ndngetfile.hpp"
 #include <boost/lexical_cast.hpp>
+#include <cmath>
 #include <fstream>
 
 namespace repo {
@@ -26,6 +27,7 @@ namespace repo {
 using namespace ndn;
 
 static const int MAX_RETRY = 3;
+static const time::milliseconds MIN_RTO(200);
 
 void
 Consumer::fetchData(const Name& name)
@@ -57,11 +59,14 @@ Consumer::run()
   // Send the first Interest
   Name name(m_dataName);
 
-  m_nextSegment++;
+  m_startTime = time::steady_clock::now();
   fetchData(name);
 
   // processEvents will block until the requested data received or timeout occurs
   m_face.processEvents(m_timeout);
+
+  if (!m_isSingle)
+    printSummary();
 }
 
 void
@@ -88,7 +93,8 @@ Consumer::onVersionedData(const Interest& interest, Data& data)
         }
         m_isFirst = false;
       }
-      fetchNextData(name, data);
+      startPipeline(m_dataName, data);
+      return;
     }
     else {
       std::cerr << "ERROR: Data is not stored in a single packet" << std::endl;
@@ -125,7 +131,8 @@ Consumer::onUnversionedData(const Interest& interest, Data& data)
         }
         m_isFirst = false;
       }
-      fetchNextData(name, data);
+      startPipeline(name.getPrefix(-1), data);
+      return;
     }
     else {
       std::cerr << "ERROR: Data is not stored in a single packet" << std::endl;
@@ -145,37 +152,18 @@ Consumer::readData(const Data& data)
   const Block& content = data.getContent();
   m_os.write(reinterpret_cast<const char*>(content.value()), content.value_size());
   m_totalSize += content.value_size();
+  ++m_nSegments;
   if (m_verbose)
   {
     std::cerr << "LOG: received data = " << data.getName() << std::endl;
   }
   if (m_isFinished || m_isSingle) {
     std::cerr << "INFO: End of file is reached." << std::endl;
-    std::cerr << "INFO: Total # of segments received: " << m_nextSegment  << std::endl;
+    std::cerr << "INFO: Total # of segments received: " << m_nSegments  << std::endl;
     std::cerr << "INFO: Total # bytes of content received: " << m_totalSize << std::endl;
   }
 }
 
-void
-Consumer::fetchNextData(const Name& name, const Data& data)
-{
-  uint64_t segment = name[-1].toSegment();
-  BOOST_ASSERT(segment == (m_nextSegment - 1));
-  const name::Component& finalBlockId = data.getMetaInfo().getFinalBlockId();
-  if (finalBlockId == name[-1]) {
-    m_isFinished = true;
-  }
-  else
-  {
-    // Reset retry counter
-    m_retryCount = 0;
-    if (m_hasVersion)
-      fetchData(Name(m_dataName).appendSegment(m_nextSegment++));
-    else
-      fetchData(Name(m_dataName).append(name[-2]).appendSegment(m_nextSegment++));
-  }
-}
-
 void
 Consumer::onTimeout(const Interest& interest)
 {
@@ -190,24 +178,207 @@ Consumer::onTimeout(const Interest& interest)
     }
   else
     {
-      std::cerr << "TIMEOUT: last interest sent for segment #" << (m_nextSegment - 1) << std::endl;
+      std::cerr << "TIMEOUT: last interest sent for " << interest.getName() << std::endl;
       std::cerr << "TIMEOUT: abort fetching after " << MAX_RETRY
                 << " times of retry" << std::endl;
     }
 }
 
+void
+Consumer::startPipeline(const Name& prefix, const Data& data)
+{
+  m_prefix = prefix;
+  m_nextSegment = 0;
+  m_nextToSend = 1;
+  receiveSegment(0, data);
+  sendSegments();
+}
+
+void
+Consumer::sendSegments()
+{
+  // segments are not requested too far beyond the oldest missing one,
+  // so that the reorder buffer stays bounded
+  uint64_t reorderLimit = m_nextSegment + 2 * m_maxWindow;
+  while (!m_isFinished &&
+         static_cast<double>(m_pending.size()) < m_window &&
+         m_nextToSend < reorderLimit &&
+         (!m_hasFinalBlock || m_nextToSend <= m_finalBlock))
+    {
+      SegmentInfo& info = m_pending[m_nextToSend];
+      info.retryCount = 0;
+      sendSegmentInterest(m_nextToSend);
+      ++m_nextToSend;
+    }
+}
+
+void
+Consumer::sendSegmentInterest(uint64_t segment)
+{
+  Interest interest(Name(m_prefix).appendSegment(segment));
+  interest.setInterestLifetime(m_rto);
+  interest.setMustBeFresh(m_hasVersion ? m_mustBeFresh : true);
+
+  m_pending[segment].sendTime = time::steady_clock::now();
+  m_face.expressInterest(interest,
+                         bind(&Consumer::onSegmentData, this, _1, _2),
+                         bind(&Consumer::onSegmentTimeout, this, _1));
+}
+
+void
+Consumer::onSegmentData(const Interest& interest, Data& data)
+{
+  uint64_t segment = interest.getName()[-1].toSegment();
+  std::map<uint64_t, SegmentInfo>::iterator it = m_pending.find(segment);
+  if (m_isFinished || it == m_pending.end())
+    return;
+
+  // RTT of a retransmitted segment is ambiguous (Karn's algorithm)
+  if (it->second.retryCount == 0)
+    addRttSample(time::duration_cast<time::milliseconds>(time::steady_clock::now() -
+                                                         it->second.sendTime));
+  m_pending.erase(it);
+
+  if (m_window < m_ssthresh)
+    m_window += 1;
+  else
+    m_window += 1 / m_window;
+  m_window = std::min(m_window, static_cast<double>(m_maxWindow));
+
+  receiveSegment(segment, data);
+  sendSegments();
+}
+
+void
+Consumer::onSegmentTimeout(const Interest& interest)
+{
+  uint64_t segment = interest.getName()[-1].toSegment();
+  std::map<uint64_t, SegmentInfo>::iterator it = m_pending.find(segment);
+  if (m_isFinished || it == m_pending.end())
+    return;
+
+  // sent before the final segment was known
+  if (m_hasFinalBlock && segment > m_finalBlock) {
+    m_pending.erase(it);
+    sendSegments();
+    return;
+  }
+
+  if (it->second.retryCount >= MAX_RETRY) {
+    std::cerr << "TIMEOUT: last interest sent for segment #" << segment << std::endl;
+    std::cerr << "TIMEOUT: abort fetching after " << MAX_RETRY
+              << " times of retry" << std::endl;
+    stop();
+    return;
+  }
+
+  // halve the window once per loss event
+  if (segment >= m_recoveryPoint) {
+    m_ssthresh = std::max(m_window / 2, 1.0);
+    m_window = m_ssthresh;
+    m_recoveryPoint = m_nextToSend;
+  }
+  m_rto = std::min(m_rto * 2, m_interestLifetime);
+
+  ++it->second.retryCount;
+  ++m_nRetransmissions;
+  if (m_verbose)
+    {
+      std::cerr << "TIMEOUT: retransmit interest for " << interest.getName() << std::endl;
+    }
+  sendSegmentInterest(segment);
+}
+
+void
+Consumer::receiveSegment(uint64_t segment, const Data& data)
+{
+  const name::Component& finalBlockId = data.getMetaInfo().getFinalBlockId();
+  if (!finalBlockId.empty()) {
+    uint64_t finalBlock = finalBlockId.toSegment();
+    if (!m_hasFinalBlock || finalBlock < m_finalBlock) {
+      m_hasFinalBlock = true;
+      m_finalBlock = finalBlock;
+    }
+  }
+
+  if (segment < m_nextSegment || (m_hasFinalBlock && segment > m_finalBlock))
+    return;
+  m_reorderBuffer[segment] = make_shared<Data>(data);
+
+  while (!m_reorderBuffer.empty() && m_reorderBuffer.begin()->first == m_nextSegment) {
+    if (m_hasFinalBlock && m_nextSegment == m_finalBlock)
+      m_isFinished = true;
+    readData(*m_reorderBuffer.begin()->second);
+    m_reorderBuffer.erase(m_reorderBuffer.begin());
+    ++m_nextSegment;
+  }
+
+  if (m_isFinished)
+    stop();
+}
+
+void
+Consumer::addRttSample(const time::milliseconds& rtt)
+{
+  double sample = static_cast<double>(rtt.count());
+  if (!m_hasRttSample) {
+    m_srtt = sample;
+    m_rttVar = sample / 2;
+    m_hasRttSample = true;
+    m_rttMin = sample;
+    m_rttMax = sample;
+  }
+  else {
+    m_rttVar = 0.75 * m_rttVar + 0.25 * std::abs(m_srtt - sample);
+    m_srtt = 0.875 * m_srtt + 0.125 * sample;
+    m_rttMin = std::min(m_rttMin, sample);
+    m_rttMax = std::max(m_rttMax, sample);
+  }
+  ++m_nRttSamples;
+  m_rttSum += sample;
+
+  time::milliseconds rto(static_cast<time::milliseconds::rep>(m_srtt + 4 * m_rttVar));
+  m_rto = std::min(std::max(rto, MIN_RTO), m_interestLifetime);
+}
+
+void
+Consumer::stop()
+{
+  m_pending.clear();
+  m_reorderBuffer.clear();
+  m_face.shutdown();
+}
+
+void
+Consumer::printSummary()
+{
+  time::milliseconds elapsed =
+    time::duration_cast<time::milliseconds>(time::steady_clock::now() - m_startTime);
+  double seconds = std::max(elapsed.count(), static_cast<time::milliseconds::rep>(1)) / 1000.0;
+
+  std::cerr << "INFO: Segments written: " << m_nSegments
+            << ", retransmissions: " << m_nRetransmissions << std::endl;
+  std::cerr << "INFO: Elapsed time: " << elapsed.count() << " ms, throughput: "
+            << m_totalSize * 8 / seconds / 1000000 << " Mbit/s" << std::endl;
+  if (m_nRttSamples > 0)
+    std::cerr << "INFO: RTT min/avg/max: " << m_rttMin << "/" << m_rttSum / m_nRttSamples
+              << "/" << m_rttMax << " ms, final window: " << m_window << std::endl;
+}
+
 
 int
 usage(const std::string& filename)
 {
   std::cerr << "Usage: \n    "
-            << filename << " [-v] [-s] [-u] [-l lifetime] [-w timeout] [-o filename] ndn-name\n\n"
+            << filename << " [-v] [-s] [-u] [-l lifetime] [-w timeout] [-p window] [-o filename]"
+            << " ndn-name\n\n"
             << "-v: be verbose\n"
             << "-s: only get single data packet\n"
             << "-u: versioned: ndn-name contains version component\n"
             << "    if -u is not specified, this command will return the rightmost child for the prefix\n"
             << "-l: InterestLifetime in milliseconds\n"
             << "-w: timeout in milliseconds for whole process (default unlimited)\n"
+            << "-p: maximum number of segments fetched in parallel (default 64)\n"
             << "-o: write to local file name instead of stdout\n"
             << "ndn-name: NDN Name prefix for Data to be read\n";
   return 1;
@@ -222,9 +393,10 @@ main(int argc, char** argv)
   bool verbose = false, versioned = false, single = false;
   int interestLifetime = 4000;  // in milliseconds
   int timeout = 0;  // in milliseconds
+  int maxWindow = 64;
 
   int opt;
-  while ((opt = getopt(argc, argv, "vsul:w:o:")) != -1)
+  while ((opt = getopt(argc, argv, "vsul:w:p:o:")) != -1)
     {
       switch (opt) {
       case 'v':
@@ -260,6 +432,18 @@ main(int argc, char** argv)
           }
         timeout = std::max(timeout, 0);
         break;
+      case 'p':
+        try
+          {
+            maxWindow = boost::lexical_cast<int>(optarg);
+          }
+        catch (boost::bad_lexical_cast&)
+          {
+            std::cerr << "ERROR: -p option should be an integer." << std::endl;
+            return 1;
+          }
+        maxWindow = std::max(maxWindow, 1);
+        break;
       case 'o':
         outputFile = optarg;
         break;
@@ -299,7 +483,7 @@ main(int argc, char** argv)
   std::ostream os(buf);
 
   Consumer consumer(name, os, verbose, versioned, single,
-                    interestLifetime, timeout);
+                    interestLifetime, timeout, false, maxWindow);
 
   try
     {
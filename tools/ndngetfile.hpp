@@ -22,6 +22,8 @@
 
 #include <ndn-cxx/face.hpp>
 
+#include <map>
+
 namespace repo {
 
 class Consumer : boost::noncopyable
@@ -30,7 +32,7 @@ public:
   Consumer(const std::string& dataName, std::ostream& os,
            bool verbose, bool versioned, bool single,
            int interestLifetime, int timeout,
-           bool mustBeFresh = false)
+           bool mustBeFresh = false, int maxWindow = 64)
     : m_dataName(dataName)
     , m_os(os)
     , m_verbose(verbose)
@@ -44,6 +46,23 @@ public:
     , m_totalSize(0)
     , m_retryCount(0)
     , m_mustBeFresh(mustBeFresh)
+    , m_maxWindow(std::max(maxWindow, 1))
+    , m_window(1)
+    , m_ssthresh(m_maxWindow)
+    , m_nextToSend(0)
+    , m_hasFinalBlock(false)
+    , m_finalBlock(0)
+    , m_recoveryPoint(0)
+    , m_hasRttSample(false)
+    , m_srtt(0)
+    , m_rttVar(0)
+    , m_rto(std::min(ndn::time::milliseconds(1000), m_interestLifetime))
+    , m_nSegments(0)
+    , m_nRetransmissions(0)
+    , m_nRttSamples(0)
+    , m_rttSum(0)
+    , m_rttMin(0)
+    , m_rttMax(0)
   {
   }
 
@@ -66,10 +85,49 @@ private:
   void
   readData(const ndn::Data& data);
 
+  /**
+   * @brief start fetching segments after the first segment of the object is known
+   * @param prefix name of the object without segment component
+   */
+  void
+  startPipeline(const ndn::Name& prefix, const ndn::Data& data);
+
+  /**
+   * @brief express interests for next segments while the window allows
+   */
+  void
+  sendSegments();
+
+  void
+  sendSegmentInterest(uint64_t segment);
+
+  void
+  onSegmentData(const ndn::Interest& interest, ndn::Data& data);
+
+  void
+  onSegmentTimeout(const ndn::Interest& interest);
+
+  /**
+   * @brief store one segment and write every segment that is now in order
+   */
   void
-  fetchNextData(const ndn::Name& name, const ndn::Data& data);
+  receiveSegment(uint64_t segment, const ndn::Data& data);
+
+  void
+  addRttSample(const ndn::time::milliseconds& rtt);
+
+  void
+  stop();
+
+  void
+  printSummary();
 
 private:
+  struct SegmentInfo
+  {
+    ndn::time::steady_clock::TimePoint sendTime;
+    int retryCount;
+  };
 
   ndn::Face m_face;
   ndn::Name m_dataName;
@@ -81,10 +139,36 @@ private:
   bool m_isFirst;
   ndn::time::milliseconds m_interestLifetime;
   ndn::time::milliseconds m_timeout;
-  uint64_t m_nextSegment;
-  int m_totalSize;
+  uint64_t m_nextSegment;  ///< next segment to be written
+  uint64_t m_totalSize;
   int m_retryCount;
   bool m_mustBeFresh;
+
+  // pipelined fetching of segments
+  int m_maxWindow;
+  double m_window;
+  double m_ssthresh;
+  ndn::Name m_prefix;
+  uint64_t m_nextToSend;
+  bool m_hasFinalBlock;
+  uint64_t m_finalBlock;
+  uint64_t m_recoveryPoint;  ///< window is not decreased again for segments below it
+  std::map<uint64_t, SegmentInfo> m_pending;
+  std::map<uint64_t, ndn::shared_ptr<const ndn::Data> > m_reorderBuffer;
+
+  bool m_hasRttSample;
+  double m_srtt;
+  double m_rttVar;
+  ndn::time::milliseconds m_rto;
+
+  // statistics
+  ndn::time::steady_clock::TimePoint m_startTime;
+  uint64_t m_nSegments;
+  uint64_t m_nRetransmissions;
+  uint64_t m_nRttSamples;
+  double m_rttSum;
+  double m_rttMin;
+  double m_rttMax;
 };
 
 } // namespace repo
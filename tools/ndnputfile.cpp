@@ -31,8 +31,12 @@
 #include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/asio.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/iostreams/operations.hpp>
 #include <boost/iostreams/read.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 
 namespace repo {
 
@@ -43,6 +47,349 @@ static const uint64_t DEFAULT_INTEREST_LIFETIME = 4000;
 static const uint64_t DEFAULT_FRESHNESS_PERIOD = 10000;
 static const uint64_t DEFAULT_CHECK_PERIOD = 1000;
 static const size_t PRE_SIGN_DATA_COUNT = 11;
+static const size_t READ_BLOCK_SIZE = 1048576;
+static const size_t SIGNED_DATA_RING_SIZE = 1024;
+static const size_t TCP_WRITE_SIZE = 262144;
+static const size_t MAX_RESPONSE_SIZE = 8800;
+
+/**
+ * @brief SegmentSource cuts the input into segment contents
+ *
+ * A regular file is memory mapped, so any segment can be read again. Other input is
+ * read sequentially in large blocks.
+ */
+class SegmentSource : ndn::noncopyable
+{
+public:
+  class Error : public std::runtime_error
+  {
+  public:
+    explicit
+    Error(const std::string& what)
+      : std::runtime_error(what)
+    {
+    }
+  };
+
+  explicit
+  SegmentSource(const std::string& fileName)
+    : m_stream(0)
+    , m_offset(0)
+    , m_bufferPos(0)
+    , m_bufferEnd(0)
+  {
+    if (boost::filesystem::file_size(fileName) == 0)
+      throw Error("Error reading from the input stream");
+    m_file.open(fileName);
+    if (!m_file.is_open())
+      throw Error("Cannot map " + fileName);
+  }
+
+  explicit
+  SegmentSource(std::istream& is)
+    : m_stream(&is)
+    , m_offset(0)
+    , m_bufferPos(0)
+    , m_bufferEnd(0)
+  {
+  }
+
+  bool
+  isRandomAccess() const
+  {
+    return m_file.is_open();
+  }
+
+  /**
+   * @brief read the content of the next segment
+   * @param[out] isLast whether the input ends with this segment
+   */
+  void
+  readNext(std::vector<uint8_t>& content, bool& isLast)
+  {
+    if (isRandomAccess()) {
+      readAt(m_offset / DEFAULT_BLOCK_SIZE, content, isLast);
+      m_offset += content.size();
+      return;
+    }
+
+    content.clear();
+    while (content.size() < DEFAULT_BLOCK_SIZE) {
+      if (m_bufferPos == m_bufferEnd && !fillBuffer())
+        break;
+      size_t nBytes = std::min(DEFAULT_BLOCK_SIZE - content.size(), m_bufferEnd - m_bufferPos);
+      content.insert(content.end(), m_buffer.begin() + m_bufferPos,
+                     m_buffer.begin() + m_bufferPos + nBytes);
+      m_bufferPos += nBytes;
+    }
+
+    if (content.empty())
+      throw Error("Error reading from the input stream");
+    isLast = m_bufferPos == m_bufferEnd && !fillBuffer();
+  }
+
+  /**
+   * @brief read the content of any segment
+   * @pre isRandomAccess()
+   */
+  void
+  readAt(uint64_t segment, std::vector<uint8_t>& content, bool& isLast) const
+  {
+    BOOST_ASSERT(isRandomAccess());
+    size_t begin = segment * DEFAULT_BLOCK_SIZE;
+    size_t end = std::min(begin + DEFAULT_BLOCK_SIZE, m_file.size());
+    if (begin >= end)
+      throw Error("Segment is beyond the end of input");
+    content.assign(m_file.data() + begin, m_file.data() + end);
+    isLast = end == m_file.size();
+  }
+
+private:
+  bool
+  fillBuffer()
+  {
+    m_buffer.resize(READ_BLOCK_SIZE);
+    std::streamsize readSize = boost::iostreams::read(*m_stream, &m_buffer[0], READ_BLOCK_SIZE);
+    m_bufferPos = 0;
+    m_bufferEnd = readSize > 0 ? readSize : 0;
+    return m_bufferEnd > 0;
+  }
+
+private:
+  boost::iostreams::mapped_file_source m_file;
+  std::istream* m_stream;
+  size_t m_offset;
+  std::vector<char> m_buffer;
+  size_t m_bufferPos;
+  size_t m_bufferEnd;
+};
+
+/**
+ * @brief SigningPipeline prepares signed segments ahead of the requests of repo
+ *
+ * Signed segments are kept in a bounded ring. The ring keeps half of its slots behind
+ * the latest requested segment for retransmissions, and the other half is filled ahead
+ * of it by signing threads, each signing with its own KeyChain.
+ *
+ * Without signing threads, segments are signed on demand on the caller's thread.
+ */
+class SigningPipeline : ndn::noncopyable
+{
+public:
+  class Error : public std::runtime_error
+  {
+  public:
+    explicit
+    Error(const std::string& what)
+      : std::runtime_error(what)
+    {
+    }
+  };
+
+  typedef ndn::function<void(ndn::KeyChain&, ndn::Data&)> SignCallback;
+
+  SigningPipeline(SegmentSource& source, const ndn::Name& prefix,
+                  const milliseconds& freshnessPeriod, const SignCallback& sign)
+    : m_source(source)
+    , m_prefix(prefix)
+    , m_freshnessPeriod(freshnessPeriod)
+    , m_sign(sign)
+    , m_ring(SIGNED_DATA_RING_SIZE)
+    , m_ringSegments(SIGNED_DATA_RING_SIZE)
+    , m_base(0)
+    , m_nextSegment(0)
+    , m_hasEnd(false)
+    , m_nSegments(0)
+    , m_isStopping(false)
+  {
+  }
+
+  ~SigningPipeline()
+  {
+    stop();
+  }
+
+  void
+  start(size_t nThreads)
+  {
+    for (size_t i = 0; i < nThreads; ++i)
+      m_workers.create_thread(ndn::bind(&SigningPipeline::signSegments, this));
+  }
+
+  void
+  stop()
+  {
+    {
+      boost::lock_guard<boost::mutex> lock(m_mutex);
+      m_isStopping = true;
+    }
+    m_space.notify_all();
+    m_workers.join_all();
+  }
+
+  /**
+   * @brief get signed segment, waiting for signing threads if necessary
+   * @return signed Data, or null if segment does not exist or cannot be read again
+   */
+  ndn::shared_ptr<ndn::Data>
+  get(uint64_t segment)
+  {
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+
+    if (segment > m_base + SIGNED_DATA_RING_SIZE / 2) {
+      m_base = segment - SIGNED_DATA_RING_SIZE / 2;
+      m_space.notify_all();
+    }
+
+    if (segment < m_base) {
+      // segment has left the ring
+      lock.unlock();
+      if (!m_source.isRandomAccess())
+        return ndn::shared_ptr<ndn::Data>();
+      std::vector<uint8_t> content;
+      bool isLast = false;
+      m_source.readAt(segment, content, isLast);
+      return makeData(m_keyChain, segment, content, isLast);
+    }
+
+    if (m_workers.size() == 0) {
+      std::vector<uint8_t> content;
+      while (!m_hasEnd && m_nextSegment <= segment + PRE_SIGN_DATA_COUNT &&
+             m_nextSegment < m_base + SIGNED_DATA_RING_SIZE) {
+        bool isLast = false;
+        uint64_t next = reserveNext(content, isLast);
+        store(next, makeData(m_keyChain, next, content, isLast));
+      }
+    }
+
+    while (!isStored(segment)) {
+      if (!m_error.empty())
+        throw Error(m_error);
+      if (m_hasEnd && segment >= m_nSegments)
+        return ndn::shared_ptr<ndn::Data>();
+      m_produced.wait(lock);
+    }
+    return m_ring[segment % SIGNED_DATA_RING_SIZE];
+  }
+
+  /**
+   * @brief get the total number of segments
+   * @return false if the end of input has not been reached yet
+   */
+  bool
+  getSegmentCount(uint64_t& nSegments)
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    nSegments = m_nSegments;
+    return m_hasEnd;
+  }
+
+private:
+  void
+  signSegments()
+  {
+    ndn::KeyChain keyChain;
+    std::vector<uint8_t> content;
+    try {
+      while (true) {
+        uint64_t segment = 0;
+        bool isLast = false;
+        {
+          boost::unique_lock<boost::mutex> lock(m_mutex);
+          while (!m_isStopping && !m_hasEnd &&
+                 m_nextSegment >= m_base + SIGNED_DATA_RING_SIZE)
+            m_space.wait(lock);
+          if (m_isStopping || m_hasEnd)
+            return;
+          segment = reserveNext(content, isLast);
+        }
+
+        ndn::shared_ptr<ndn::Data> data = makeData(keyChain, segment, content, isLast);
+
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+        store(segment, data);
+      }
+    }
+    catch (const std::exception& e) {
+      boost::lock_guard<boost::mutex> lock(m_mutex);
+      m_error = e.what();
+      m_isStopping = true;
+      m_produced.notify_all();
+      m_space.notify_all();
+    }
+  }
+
+  /**
+   * @brief read the next segment from input
+   * @pre m_mutex is held
+   */
+  uint64_t
+  reserveNext(std::vector<uint8_t>& content, bool& isLast)
+  {
+    m_source.readNext(content, isLast);
+    uint64_t segment = m_nextSegment++;
+    if (isLast) {
+      m_hasEnd = true;
+      m_nSegments = m_nextSegment;
+    }
+    return segment;
+  }
+
+  /**
+   * @pre m_mutex is held
+   */
+  void
+  store(uint64_t segment, const ndn::shared_ptr<ndn::Data>& data)
+  {
+    if (segment >= m_base) {
+      m_ring[segment % SIGNED_DATA_RING_SIZE] = data;
+      m_ringSegments[segment % SIGNED_DATA_RING_SIZE] = segment;
+    }
+    m_produced.notify_all();
+  }
+
+  bool
+  isStored(uint64_t segment) const
+  {
+    size_t slot = segment % SIGNED_DATA_RING_SIZE;
+    return static_cast<bool>(m_ring[slot]) && m_ringSegments[slot] == segment;
+  }
+
+  ndn::shared_ptr<ndn::Data>
+  makeData(ndn::KeyChain& keyChain, uint64_t segment,
+           const std::vector<uint8_t>& content, bool isLast)
+  {
+    ndn::shared_ptr<ndn::Data> data =
+      ndn::make_shared<ndn::Data>(ndn::Name(m_prefix).appendSegment(segment));
+    if (isLast)
+      data->setFinalBlockId(ndn::name::Component::fromSegment(segment));
+    data->setContent(content.empty() ? 0 : &content[0], content.size());
+    data->setFreshnessPeriod(m_freshnessPeriod);
+    m_sign(keyChain, *data);
+    return data;
+  }
+
+private:
+  SegmentSource& m_source;
+  ndn::Name m_prefix;
+  milliseconds m_freshnessPeriod;
+  SignCallback m_sign;
+  ndn::KeyChain m_keyChain;  ///< used on the caller's thread only
+
+  boost::mutex m_mutex;
+  boost::condition_variable m_produced;
+  boost::condition_variable m_space;
+  boost::thread_group m_workers;
+
+  std::vector<ndn::shared_ptr<ndn::Data> > m_ring;
+  std::vector<uint64_t> m_ringSegments;
+  uint64_t m_base;  ///< lowest segment kept in the ring
+  uint64_t m_nextSegment;  ///< next segment to read from input
+  bool m_hasEnd;
+  uint64_t m_nSegments;
+  bool m_isStopping;
+  std::string m_error;
+};
 
 class NdnPutFile : ndn::noncopyable
 {
@@ -66,6 +413,9 @@ public:
     , hasTimeout(false)
     , timeout(0)
     , insertStream(0)
+    , nSigningThreads(0)
+    , useTcpBulkInsert(false)
+    , shouldConfirm(false)
     , isVerbose(false)
 
     , m_scheduler(m_face.getIoService())
@@ -81,8 +431,14 @@ public:
   run();
 
 private:
+  /**
+   * @brief stream signed Data to the TCP bulk insert endpoint of repo
+   */
   void
-  prepareNextData(uint64_t referenceSegmentNo);
+  insertOverTcp();
+
+  ndn::shared_ptr<ndn::Data>
+  prepareSingleData();
 
   void
   startInsertCommand();
@@ -111,6 +467,9 @@ private:
   void
   signData(ndn::Data& data);
 
+  void
+  signData(ndn::KeyChain& keyChain, ndn::Data& data) const;
+
   void
   startCheckCommand();
 
@@ -137,6 +496,12 @@ public:
   ndn::Name repoPrefix;
   ndn::Name ndnName;
   std::istream* insertStream;
+  std::string insertFileName;  ///< set if input is a regular file, which is memory mapped
+  size_t nSigningThreads;
+  bool useTcpBulkInsert;
+  std::string bulkInsertHost;
+  std::string bulkInsertPort;
+  bool shouldConfirm;
   bool isVerbose;
 
 private:
@@ -151,59 +516,10 @@ private:
   bool m_isFinished;
   ndn::Name m_dataPrefix;
 
-  typedef std::map<uint64_t, ndn::shared_ptr<ndn::Data> > DataContainer;
-  DataContainer m_data;
+  ndn::shared_ptr<SegmentSource> m_source;
+  ndn::shared_ptr<SigningPipeline> m_pipeline;
 };
 
-void
-NdnPutFile::prepareNextData(uint64_t referenceSegmentNo)
-{
-  // make sure m_data has [referenceSegmentNo, referenceSegmentNo + PRE_SIGN_DATA_COUNT] Data
-  if (m_isFinished)
-    return;
-
-  size_t nDataToPrepare = PRE_SIGN_DATA_COUNT;
-
-  if (!m_data.empty()) {
-    uint64_t maxSegmentNo = m_data.rbegin()->first;
-
-    if (maxSegmentNo - referenceSegmentNo >= nDataToPrepare) {
-      // nothing to prepare
-      return;
-    }
-
-    nDataToPrepare -= maxSegmentNo - referenceSegmentNo;
-  }
-
-  for (size_t i = 0; i < nDataToPrepare && !m_isFinished; ++i) {
-    uint8_t buffer[DEFAULT_BLOCK_SIZE];
-
-    std::streamsize readSize =
-      boost::iostreams::read(*insertStream, reinterpret_cast<char*>(buffer), DEFAULT_BLOCK_SIZE);
-
-    if (readSize <= 0) {
-      throw Error("Error reading from the input stream");
-    }
-
-    ndn::shared_ptr<ndn::Data> data =
-      ndn::make_shared<ndn::Data>(Name(m_dataPrefix)
-                                    .appendSegment(m_currentSegmentNo));
-
-    if (insertStream->peek() == std::istream::traits_type::eof()) {
-      data->setFinalBlockId(ndn::name::Component::fromSegment(m_currentSegmentNo));
-      m_isFinished = true;
-    }
-
-    data->setContent(buffer, readSize);
-    data->setFreshnessPeriod(freshnessPeriod);
-    signData(*data);
-
-    m_data.insert(std::make_pair(m_currentSegmentNo, data));
-
-    ++m_currentSegmentNo;
-  }
-}
-
 void
 NdnPutFile::run()
 {
@@ -211,6 +527,25 @@ NdnPutFile::run()
   if (!isUnversioned)
     m_dataPrefix.appendVersion(m_timestampVersion);
 
+  if (!isSingle) {
+    if (!insertFileName.empty())
+      m_source = ndn::make_shared<SegmentSource>(insertFileName);
+    else
+      m_source = ndn::make_shared<SegmentSource>(ndn::ref(*insertStream));
+    m_pipeline = ndn::make_shared<SigningPipeline>(ndn::ref(*m_source), m_dataPrefix,
+                                                   freshnessPeriod,
+                                                   ndn::bind(&NdnPutFile::signData, this,
+                                                             _1, _2));
+    m_pipeline->start(nSigningThreads);
+  }
+
+  if (useTcpBulkInsert) {
+    insertOverTcp();
+    if (m_pipeline)
+      m_pipeline->stop();
+    return;
+  }
+
   if (isVerbose)
     std::cerr << "setInterestFilter for " << m_dataPrefix << std::endl;
   m_face.setInterestFilter(m_dataPrefix,
@@ -221,11 +556,82 @@ NdnPutFile::run()
                            ndn::bind(&NdnPutFile::onRegisterSuccess, this, _1),
                            ndn::bind(&NdnPutFile::onRegisterFailed, this, _1, _2));
 
-
   if (hasTimeout)
     m_scheduler.scheduleEvent(timeout, ndn::bind(&NdnPutFile::stopProcess, this));
 
   m_face.processEvents();
+
+  if (m_pipeline)
+    m_pipeline->stop();
+}
+
+void
+NdnPutFile::insertOverTcp()
+{
+  using namespace boost::asio;
+
+  ip::tcp::resolver resolver(m_face.getIoService());
+  ip::tcp::resolver::query query(bulkInsertHost, bulkInsertPort);
+  ip::tcp::socket socket(m_face.getIoService());
+  boost::system::error_code error;
+  boost::asio::connect(socket, resolver.resolve(query), error);
+  if (error)
+    throw Error("Cannot connect to [" + bulkInsertHost + ":" + bulkInsertPort + "]: " +
+                error.message());
+
+  // segments are written in large batches rather than one packet per write
+  std::vector<uint8_t> buffer;
+  buffer.reserve(TCP_WRITE_SIZE + MAX_RESPONSE_SIZE);
+  uint64_t nData = 0;
+  while (true) {
+    ndn::shared_ptr<ndn::Data> data = isSingle ?
+      (nData == 0 ? prepareSingleData() : ndn::shared_ptr<ndn::Data>()) :
+      m_pipeline->get(nData);
+    if (!static_cast<bool>(data))
+      break;
+
+    const ndn::Block& wire = data->wireEncode();
+    buffer.insert(buffer.end(), wire.wire(), wire.wire() + wire.size());
+    ++nData;
+    if (buffer.size() >= TCP_WRITE_SIZE) {
+      boost::asio::write(socket, boost::asio::buffer(buffer));
+      buffer.clear();
+    }
+  }
+
+  if (shouldConfirm) {
+    // an Interest after the Data asks repo to confirm what has been inserted
+    ndn::Interest confirmInterest(m_dataPrefix);
+    const ndn::Block& wire = confirmInterest.wireEncode();
+    buffer.insert(buffer.end(), wire.wire(), wire.wire() + wire.size());
+  }
+  boost::asio::write(socket, boost::asio::buffer(buffer));
+
+  if (isVerbose)
+    std::cerr << "Sent " << nData << " Data to " << socket.remote_endpoint() << std::endl;
+
+  if (shouldConfirm) {
+    uint8_t responseBuffer[MAX_RESPONSE_SIZE];
+    size_t nBytesReceived = 0;
+    ndn::Block block;
+    do {
+      if (nBytesReceived == MAX_RESPONSE_SIZE)
+        throw Error("Malformed bulk insert confirmation");
+      nBytesReceived += socket.read_some(boost::asio::buffer(responseBuffer + nBytesReceived,
+                                                             MAX_RESPONSE_SIZE - nBytesReceived));
+    } while (!ndn::Block::fromBuffer(responseBuffer, nBytesReceived, block));
+
+    RepoCommandResponse response(block);
+    if (response.getStatusCode() >= 400 || response.getInsertNum() != nData)
+      throw Error("bulk insert failed: " +
+                  boost::lexical_cast<std::string>(response.getInsertNum()) + " of " +
+                  boost::lexical_cast<std::string>(nData) + " Data inserted");
+    if (isVerbose)
+      std::cerr << "Repo confirmed " << response.getInsertNum() << " Data" << std::endl;
+  }
+
+  socket.shutdown(ip::tcp::socket::shutdown_both, error);
+  socket.close(error);
 }
 
 void
@@ -294,22 +700,22 @@ NdnPutFile::onInterest(const ndn::Name& prefix, const ndn::Interest& interest)
     return;
   }
 
-  prepareNextData(segmentNo);
+  ndn::shared_ptr<ndn::Data> data = m_pipeline->get(segmentNo);
 
-  DataContainer::iterator item = m_data.find(segmentNo);
-  if (item == m_data.end()) {
+  uint64_t nSegments = 0;
+  if (m_pipeline->getSegmentCount(nSegments)) {
+    m_isFinished = true;
+    m_currentSegmentNo = nSegments;
+  }
+
+  if (!static_cast<bool>(data)) {
     if (isVerbose) {
       std::cerr << "Requested segment [" << segmentNo << "] does not exist" << std::endl;
     }
     return;
   }
 
-  if (m_isFinished) {
-    uint64_t final = m_currentSegmentNo - 1;
-    item->second->setFinalBlockId(ndn::name::Component::fromSegment(final));
-
-  }
-  m_face.put(*item->second);
+  m_face.put(*data);
 }
 
 void
@@ -324,6 +730,14 @@ NdnPutFile::onSingleInterest(const ndn::Name& prefix, const ndn::Interest& inter
     return;
   }
 
+  m_face.put(*prepareSingleData());
+
+  m_isFinished = true;
+}
+
+ndn::shared_ptr<ndn::Data>
+NdnPutFile::prepareSingleData()
+{
   uint8_t buffer[DEFAULT_BLOCK_SIZE];
   std::streamsize readSize =
     boost::iostreams::read(*insertStream, reinterpret_cast<char*>(buffer), DEFAULT_BLOCK_SIZE);
@@ -340,9 +754,7 @@ NdnPutFile::onSingleInterest(const ndn::Name& prefix, const ndn::Interest& inter
   data->setContent(buffer, readSize);
   data->setFreshnessPeriod(freshnessPeriod);
   signData(*data);
-  m_face.put(*data);
-
-  m_isFinished = true;
+  return data;
 }
 
 void
@@ -359,17 +771,23 @@ NdnPutFile::stopProcess()
 
 void
 NdnPutFile::signData(ndn::Data& data)
+{
+  signData(m_keyChain, data);
+}
+
+void
+NdnPutFile::signData(ndn::KeyChain& keyChain, ndn::Data& data) const
 {
   if (useDigestSha256) {
-    m_keyChain.signWithSha256(data);
+    keyChain.signWithSha256(data);
   }
   else {
     if (identityForData.empty())
-      m_keyChain.sign(data);
+      keyChain.sign(data);
     else {
-      ndn::Name keyName = m_keyChain.getDefaultKeyNameForIdentity(ndn::Name(identityForData));
-      ndn::Name certName = m_keyChain.getDefaultCertificateNameForKey(keyName);
-      m_keyChain.sign(data, certName);
+      ndn::Name keyName = keyChain.getDefaultKeyNameForIdentity(ndn::Name(identityForData));
+      ndn::Name certName = keyChain.getDefaultCertificateNameForKey(keyName);
+      keyChain.sign(data, certName);
     }
   }
 }
@@ -446,7 +864,8 @@ usage()
 {
   fprintf(stderr,
           "ndnputfile [-u] [-s] [-D] [-d] [-i identity] [-I identity]"
-          "  [-x freshness] [-l lifetime] [-w timeout] repo-prefix ndn-name filename\n"
+          "  [-x freshness] [-l lifetime] [-w timeout] [-t threads]"
+          "  [-T host:port] [-C] repo-prefix ndn-name filename\n"
           "\n"
           " Write a file into a repo.\n"
           "  -u: unversioned: do not add a version component\n"
@@ -457,8 +876,13 @@ usage()
           "  -x: FreshnessPeriod in milliseconds\n"
           "  -l: InterestLifetime in milliseconds for each command\n"
           "  -w: timeout in milliseconds for whole process (default unlimited)\n"
+          "  -t: number of threads signing segments ahead of requests\n"
+          "      (default 0: sign on demand)\n"
+          "  -T: stream Data directly to the TCP bulk insert endpoint of repo\n"
+          "      (port defaults to 7376) instead of using insert commands\n"
+          "  -C: with -T, wait for repo to confirm that every Data is inserted\n"
           "  -v: be verbose\n"
-          "  repo-prefix: repo command prefix\n"
+          "  repo-prefix: repo command prefix (not used with -T)\n"
           "  ndn-name: NDN Name prefix for written Data\n"
           "  filename: local file name; \"-\" reads from stdin\n"
           );
@@ -470,7 +894,7 @@ main(int argc, char** argv)
 {
   NdnPutFile ndnPutFile;
   int opt;
-  while ((opt = getopt(argc, argv, "usDi:I:x:l:w:vh")) != -1) {
+  while ((opt = getopt(argc, argv, "usDi:I:x:l:w:t:T:Cvh")) != -1) {
     switch (opt) {
     case 'u':
       ndnPutFile.isUnversioned = true;
@@ -515,6 +939,28 @@ main(int argc, char** argv)
         return 1;
       }
       break;
+    case 't':
+      try {
+        ndnPutFile.nSigningThreads = boost::lexical_cast<size_t>(optarg);
+      }
+      catch (boost::bad_lexical_cast&) {
+        std::cerr << "-t option should be an integer.";
+        return 1;
+      }
+      break;
+    case 'T':
+      {
+        ndnPutFile.useTcpBulkInsert = true;
+        std::string endpoint(optarg);
+        size_t colon = endpoint.rfind(':');
+        ndnPutFile.bulkInsertHost = endpoint.substr(0, colon);
+        ndnPutFile.bulkInsertPort = colon == std::string::npos ? "7376" :
+                                                                 endpoint.substr(colon + 1);
+      }
+      break;
+    case 'C':
+      ndnPutFile.shouldConfirm = true;
+      break;
     case 'v':
       ndnPutFile.isVerbose = true;
       break;
@@ -547,6 +993,8 @@ main(int argc, char** argv)
     }
 
     ndnPutFile.insertStream = &inputFileStream;
+    if (boost::filesystem::is_regular_file(argv[2]))
+      ndnPutFile.insertFileName = argv[2];
     ndnPutFile.run();
   }
 
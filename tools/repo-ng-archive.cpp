@@ -0,0 +1,1075 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California.
+ *
+ * This file is part of NDN repo-ng (Next generation of NDN repository).
+ * See AUTHORS.md for complete list of repo-ng authors and contributors.
+ *
+ * repo-ng is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * repo-ng is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * repo-ng, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../src/common.hpp"
+#include "../src/storage/compression.hpp"
+#include "../src/storage/shard-placement.hpp"
+#include "config.hpp"
+#include <ndn-cxx/util/crypto.hpp>
+#include <string>
+#include <fstream>
+#include <map>
+#include <cstring>
+#include <sqlite3.h>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/info_parser.hpp>
+
+namespace repo {
+
+using namespace ndn::time;
+
+static const size_t READ_BLOCK_SIZE = 1048576;
+static const size_t MAX_PACKET_SIZE = 8800;
+static const size_t DEFAULT_BATCH_SIZE = 50000;
+
+/**
+ * @brief bind a nameKey, which may be empty
+ *
+ * An empty buffer may have a null pointer, which sqlite would bind as NULL, matching nothing.
+ */
+static int
+bindKey(sqlite3_stmt* stmt, int index, const uint8_t* key, size_t size)
+{
+  if (size == 0)
+    return sqlite3_bind_zeroblob(stmt, index, 0);
+  return sqlite3_bind_blob(stmt, index, key, size, SQLITE_TRANSIENT);
+}
+
+/**
+ * @brief fill nameKey of records written before it existed, as the repo does on start
+ */
+static bool
+fillNameKeys(sqlite3* db)
+{
+  sqlite3_stmt* selectStmt = 0;
+  sqlite3_stmt* updateStmt = 0;
+  string selectSql("SELECT id, name FROM NDN_REPO WHERE nameKey IS NULL;");
+  string updateSql("UPDATE NDN_REPO SET nameKey = ? WHERE id = ?;");
+  if (sqlite3_prepare_v2(db, selectSql.c_str(), -1, &selectStmt, 0) != SQLITE_OK ||
+      sqlite3_prepare_v2(db, updateSql.c_str(), -1, &updateStmt, 0) != SQLITE_OK) {
+    sqlite3_finalize(selectStmt);
+    sqlite3_finalize(updateStmt);
+    return false;
+  }
+
+  sqlite3_exec(db, "BEGIN TRANSACTION;", 0, 0, 0);
+  int rc = SQLITE_DONE;
+  while ((rc = sqlite3_step(selectStmt)) == SQLITE_ROW) {
+    Block nameBlock(sqlite3_column_blob(selectStmt, 1), sqlite3_column_bytes(selectStmt, 1));
+    if (bindKey(updateStmt, 1, nameBlock.value(), nameBlock.value_size()) != SQLITE_OK ||
+        sqlite3_bind_int64(updateStmt, 2, sqlite3_column_int64(selectStmt, 0)) != SQLITE_OK ||
+        sqlite3_step(updateStmt) != SQLITE_DONE) {
+      rc = SQLITE_ERROR;
+      break;
+    }
+    sqlite3_reset(updateStmt);
+  }
+  sqlite3_finalize(selectStmt);
+  sqlite3_finalize(updateStmt);
+  if (rc != SQLITE_DONE) {
+    sqlite3_exec(db, "ROLLBACK;", 0, 0, 0);
+    return false;
+  }
+  sqlite3_exec(db, "COMMIT;", 0, 0, 0);
+  return true;
+}
+
+/**
+ * @brief get the prefix shared by every name in [first, last)
+ *
+ * A name not under the common prefix of first and last is ordered before first or after
+ * last, and [first, successor of first) holds exactly the names under first.
+ */
+static Name
+getRangePrefix(const Name& first, const Name& last, bool isLastInfinite)
+{
+  if (isLastInfinite)
+    return Name();
+  if (last == first.getSuccessor())
+    return first;
+  size_t length = 0;
+  while (length < first.size() && length < last.size() && first[length] == last[length])
+    ++length;
+  return first.getPrefix(length);
+}
+
+void
+printUsage(const char* programName)
+{
+
+  std::cout
+    << "Usage:\n"
+    << "  " << programName << " [-c <path/to/repo-ng.conf>] [-b batch] -i <file>\n"
+    << "  " << programName << " [-c <path/to/repo-ng.conf>] -e <prefix> [-E <end>] [-o <file>]\n"
+    << "\n"
+    << "Import or export Data packets of NDN repository while repo-ng is not running.\n"
+    << "Data are placed in the shards configured in storage.shards as repo-ng places them.\n"
+    << "Imported Data are not validated, and expire as configured in retention.\n"
+    << "\n"
+    << "Options:\n"
+    << "  -h: show help message\n"
+    << "  -c: set config file path\n"
+    << "  -i: import a stream of Data TLVs from file (\"-\" reads from stdin)\n"
+    << "  -b: number of Data inserted per transaction on import (default 50000)\n"
+    << "  -e: export Data whose names are at or after this name, or under it without -E\n"
+    << "  -E: export Data whose names are before this name\n"
+    << "  -o: write exported Data TLVs to file instead of stdout\n"
+    << std::endl;
+}
+
+class RepoArchiver
+{
+public:
+  class Error : public std::runtime_error
+  {
+  public:
+    explicit
+    Error(const std::string& what)
+      : std::runtime_error(what)
+    {
+    }
+  };
+
+public:
+  RepoArchiver(const std::string& configFile);
+
+  ~RepoArchiver();
+
+  /**
+   * @brief insert a stream of Data TLVs into storage
+   *
+   * Data go to shards by the rule of the repo. They are inserted in batches of batchSize
+   * per transaction of each shard, each batch sorted by full name so that record IDs follow
+   * name order. Data already stored are skipped, looked up by nameKey in their shard.
+   *
+   * @return number of inserted Data
+   */
+  uint64_t
+  import(std::istream& is, size_t batchSize);
+
+  /**
+   * @brief write Data whose full names are in [first, last) as a stream of TLVs,
+   *        in name order
+   * @return number of exported Data
+   */
+  uint64_t
+  exportRange(const Name& first, const Name& last, bool isLastInfinite, std::ostream& os);
+
+private:
+  void
+  readConfig(const std::string& configFile);
+
+  /**
+   * @brief add the database at path as a shard, unless it is one already
+   */
+  void
+  addDatabase(const std::string& path, bool isHashed, std::map<std::string, size_t>& shards);
+
+  /**
+   * @brief open the database at path, creating the tables the tool writes
+   */
+  sqlite3*
+  openDatabase(const std::string& path);
+
+  /**
+   * @brief get expiry time of Data imported now, 0 if no retention applies
+   *
+   * As in the repo, Data are governed by the retention with the longest prefix of their name.
+   */
+  int64_t
+  computeExpiry(const Name& name) const;
+
+  /**
+   * @brief get the number of Data stored in the current database, packed segments included
+   */
+  uint64_t
+  countStored();
+
+  /**
+   * @brief prepare the statements of isStored for every shard
+   */
+  void
+  prepareLookups();
+
+  /**
+   * @brief determine whether Data with fullName is stored in a shard
+   *
+   * Records are found through the nameKey index. An object is keyed by the prefix its
+   * segments share, so the objects keyed by each prefix of fullName are looked up.
+   */
+  bool
+  isStored(size_t shardIndex, const Name& fullName);
+
+  /**
+   * @brief prepare a statement selecting columns of rows of table under prefix
+   *
+   * Rows are selected through the nameKey index, whose range for a prefix is
+   * [value of prefix, successor of value). Returns false if the statement cannot be
+   * prepared, e.g. the table has no nameKey column.
+   */
+  bool
+  prepareRange(const std::string& columns, const Name& prefix, sqlite3_stmt*& stmt,
+               const std::string& table = "NDN_REPO");
+
+  /// full name, shard index and ID in the shard of a stored Data
+  typedef std::pair<Name, std::pair<size_t, int64_t> > Entry;
+
+  /**
+   * @brief add Data of a shard whose full names are in [first, last) to entries
+   * @param  prefix  prefix shared by every name in [first, last)
+   */
+  void
+  loadRange(const Name& first, const Name& last, bool isLastInfinite, const Name& prefix,
+            size_t shardIndex, std::vector<Entry>& entries);
+
+  /**
+   * @brief add live segments in [first, last) of objects of the current database to entries
+   *
+   * Objects are selected as in repo-ng-ls, by their nameKey: either under prefix, or one of
+   * the shorter prefixes of prefix. Segments are identified as in the repo, by the negated
+   * object ID shifted left by 32 bits and combined with the segment index.
+   */
+  void
+  loadObjectSegments(const Name& first, const Name& last, bool isLastInfinite,
+                     const Name& prefix, size_t shardIndex, std::vector<Entry>& entries);
+
+  /**
+   * @brief add live segments in [first, last) of the objects selected by stmt to entries
+   * @return false on a database error
+   */
+  bool
+  loadObjectRows(sqlite3_stmt* stmt, const Name& first, const Name& last, bool isLastInfinite,
+                 size_t shardIndex, std::vector<Entry>& entries);
+
+  /**
+   * @brief write the encoding of a packed segment, read from the extent of its object
+   */
+  void
+  exportSegment(int64_t id, std::ostream& os);
+
+  /**
+   * @brief insert a batch into a shard, dropping repeated Data
+   * @return number of inserted Data
+   */
+  size_t
+  insertBatch(size_t shardIndex, std::vector<shared_ptr<Data> >& batch);
+
+  void
+  execute(const std::string& sql);
+
+private:
+  /// database being read or written, one of m_dbs
+  sqlite3* m_db;
+  /// main database and shards, in the order the repo adds them
+  std::vector<sqlite3*> m_dbs;
+  std::vector<std::string> m_dbPaths;
+  ShardPlacement m_placement;
+  uint64_t m_nMaxPackets;
+  std::map<Name, milliseconds> m_retentions;
+  Compression m_compression;
+  /// per shard, lookup of a record by nameKey
+  std::vector<sqlite3_stmt*> m_findStmts;
+  /// per shard, lookup of objects by nameKey, or null if the shard has no objects
+  std::vector<sqlite3_stmt*> m_findObjectStmts;
+  ndn::Buffer m_lower;
+  ndn::Buffer m_upper;
+};
+
+RepoArchiver::RepoArchiver(const std::string& configFile)
+  : m_db(0)
+{
+  readConfig(configFile);
+  for (size_t i = 0; i < m_dbPaths.size(); ++i) {
+    try {
+      m_dbs.push_back(openDatabase(m_dbPaths[i]));
+    }
+    catch (Error&) {
+      for (size_t j = 0; j < m_dbs.size(); ++j)
+        sqlite3_close(m_dbs[j]);
+      throw;
+    }
+  }
+  m_db = m_dbs[0];
+}
+
+RepoArchiver::~RepoArchiver()
+{
+  for (size_t i = 0; i < m_findStmts.size(); ++i)
+    sqlite3_finalize(m_findStmts[i]);
+  for (size_t i = 0; i < m_findObjectStmts.size(); ++i)
+    sqlite3_finalize(m_findObjectStmts[i]);
+  for (size_t i = 0; i < m_dbs.size(); ++i)
+    sqlite3_close(m_dbs[i]);
+}
+
+sqlite3*
+RepoArchiver::openDatabase(const std::string& path)
+{
+  sqlite3* db = 0;
+  char* errMsg = 0;
+  int rc = sqlite3_open_v2(path.c_str(), &db,
+                           SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+   #ifdef DISABLE_SQLITE3_FS_LOCKING
+                            "unix-dotfile"
+   #else
+                            0
+   #endif
+                          );
+  if (rc != SQLITE_OK) {
+    sqlite3_close(db);
+    throw Error("Database file '" + path + "' open failure");
+  }
+  sqlite3_exec(db, "CREATE TABLE NDN_REPO ("
+                   "id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+                   "name BLOB, "
+                   "data BLOB, "
+                   "keylocatorHash BLOB, "
+                   "nameKey BLOB, "
+                   "expiry INTEGER);\n "
+               , 0, 0, &errMsg);
+  // Ignore errors (when database already exists, errors are expected)
+  sqlite3_exec(db, "PRAGMA synchronous = OFF", 0, 0, &errMsg);
+  sqlite3_exec(db, "PRAGMA journal_mode = WAL", 0, 0, &errMsg);
+  // nameKey of older records is filled here, as the repo does when it opens the database,
+  // since duplicates and exported ranges are looked up by it
+  sqlite3_exec(db, "ALTER TABLE NDN_REPO ADD COLUMN nameKey BLOB;", 0, 0, &errMsg);
+  sqlite3_exec(db, "CREATE INDEX IF NOT EXISTS NDN_REPO_NAME_KEY ON NDN_REPO (nameKey);",
+               0, 0, &errMsg);
+  if (!fillNameKeys(db)) {
+    sqlite3_close(db);
+    throw Error("Database file '" + path + "' nameKey update failure");
+  }
+  sqlite3_exec(db, "ALTER TABLE NDN_REPO ADD COLUMN expiry INTEGER;", 0, 0, &errMsg);
+  sqlite3_exec(db, "CREATE INDEX IF NOT EXISTS NDN_REPO_EXPIRY ON NDN_REPO (expiry);",
+               0, 0, &errMsg);
+  // imported records are stored whole; the columns are only read on export
+  sqlite3_exec(db, "ALTER TABLE NDN_REPO ADD COLUMN contentHash BLOB;", 0, 0, &errMsg);
+  sqlite3_exec(db, "ALTER TABLE NDN_REPO ADD COLUMN contentOffset INTEGER;", 0, 0, &errMsg);
+  sqlite3_exec(db, "ALTER TABLE NDN_REPO ADD COLUMN rawSize INTEGER;", 0, 0, &errMsg);
+  sqlite3_exec(db, "CREATE TABLE IF NOT EXISTS NDN_REPO_CONTENT ("
+                   "hash BLOB NOT NULL PRIMARY KEY, "
+                   "content BLOB, "
+                   "refCount INTEGER NOT NULL);",
+               0, 0, &errMsg);
+  return db;
+}
+
+void
+RepoArchiver::addDatabase(const std::string& path, bool isHashed,
+                          std::map<std::string, size_t>& shards)
+{
+  if (shards.count(path) != 0)
+    return;
+  shards[path] = m_placement.addShard(isHashed);
+  m_dbPaths.push_back(path + "/ndn_repo.db");
+}
+
+void
+RepoArchiver::readConfig(const std::string& configFile)
+{
+  if (configFile.empty()) {
+    throw Error("Invalid configuration file name");
+  }
+
+  std::ifstream fin(configFile.c_str());
+  if (!fin.is_open())
+    throw Error("failed to open configuration file '" + configFile + "'");
+
+  using namespace boost::property_tree;
+  ptree propertyTree;
+  try {
+    read_info(fin, propertyTree);
+  }
+  catch (ptree_error& e) {
+    throw Error("failed to read configuration file '" + configFile + "'");
+  }
+  ptree repoConf = propertyTree.get_child("repo");
+  m_nMaxPackets = repoConf.get<uint64_t>("storage.max-packets");
+
+  // shards are added in the order of the repo, so that hashed placement agrees with it:
+  // storage.path, then shard paths, then paths of prefixes
+  std::map<std::string, size_t> shards;
+  addDatabase(repoConf.get<std::string>("storage.path"), true, shards);
+  boost::optional<ptree&> shardsConf = repoConf.get_child_optional("storage.shards");
+  if (shardsConf) {
+    for (ptree::const_iterator it = shardsConf->begin(); it != shardsConf->end(); ++it) {
+      if (it->first == "path")
+        addDatabase(it->second.get_value<std::string>(), true, shards);
+    }
+    for (ptree::const_iterator it = shardsConf->begin(); it != shardsConf->end(); ++it) {
+      if (it->first != "prefix")
+        continue;
+      std::string path = it->second.get<std::string>("path");
+      addDatabase(path, false, shards);
+      m_placement.addPrefix(Name(it->second.get<std::string>("name")), shards[path]);
+    }
+  }
+
+  // imported Data expire as those inserted by the repo
+  boost::optional<ptree&> retentionConf = repoConf.get_child_optional("retention");
+  if (retentionConf) {
+    for (ptree::const_iterator it = retentionConf->begin();
+         it != retentionConf->end();
+         ++it)
+    {
+      if (it->first != "prefix")
+        continue;
+      boost::optional<std::string> name = it->second.get_optional<std::string>("name");
+      boost::optional<uint64_t> maxAge = it->second.get_optional<uint64_t>("max-age");
+      if (!name || !maxAge)
+        throw Error("'retention.prefix' section requires 'name' and 'max-age' options in "
+                    "configuration file '" + configFile + "'");
+      m_retentions[Name(*name)] = milliseconds(*maxAge * 1000);
+    }
+  }
+
+  // dictionaries are needed to decompress exported Data
+  boost::optional<ptree&> compressionConf = repoConf.get_child_optional("compression");
+  if (compressionConf) {
+    for (ptree::const_iterator it = compressionConf->begin();
+         it != compressionConf->end();
+         ++it)
+    {
+      boost::optional<std::string> dictionary =
+        it->second.get_optional<std::string>("dictionary");
+      if (dictionary)
+        m_compression.addDictionary(Compression::readDictionary(*dictionary));
+    }
+  }
+}
+
+int64_t
+RepoArchiver::computeExpiry(const Name& name) const
+{
+  if (m_retentions.empty())
+    return 0;
+
+  for (ssize_t length = name.size(); length >= 0; --length) {
+    std::map<Name, milliseconds>::const_iterator retention =
+      m_retentions.find(name.getPrefix(length));
+    if (retention != m_retentions.end())
+      return (toUnixTimestamp(system_clock::now()) + retention->second).count();
+  }
+  return 0;
+}
+
+void
+RepoArchiver::execute(const std::string& sql)
+{
+  char* errMsg = 0;
+  if (sqlite3_exec(m_db, sql.c_str(), 0, 0, &errMsg) != SQLITE_OK) {
+    std::string message = errMsg != 0 ? errMsg : "";
+    sqlite3_free(errMsg);
+    throw Error("'" + sql + "' failed: " + message);
+  }
+}
+
+uint64_t
+RepoArchiver::countStored()
+{
+  uint64_t nStored = 0;
+  sqlite3_stmt* stmt = 0;
+  string sql("SELECT count(*) FROM NDN_REPO;");
+  if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &stmt, 0) != SQLITE_OK ||
+      sqlite3_step(stmt) != SQLITE_ROW) {
+    sqlite3_finalize(stmt);
+    throw Error("Count Entries error");
+  }
+  nStored += sqlite3_column_int64(stmt, 0);
+  sqlite3_finalize(stmt);
+
+  stmt = 0;
+  sql = "SELECT total(nLive) FROM NDN_REPO_OBJECT;";
+  // no table in a database written before objects were packed
+  if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &stmt, 0) == SQLITE_OK &&
+      sqlite3_step(stmt) == SQLITE_ROW)
+    nStored += sqlite3_column_int64(stmt, 0);
+  sqlite3_finalize(stmt);
+  return nStored;
+}
+
+void
+RepoArchiver::prepareLookups()
+{
+  m_findStmts.resize(m_dbs.size(), static_cast<sqlite3_stmt*>(0));
+  m_findObjectStmts.resize(m_dbs.size(), static_cast<sqlite3_stmt*>(0));
+  for (size_t i = 0; i < m_dbs.size(); ++i) {
+    string sql("SELECT 1 FROM NDN_REPO WHERE nameKey = ? LIMIT 1;");
+    if (sqlite3_prepare_v2(m_dbs[i], sql.c_str(), -1, &m_findStmts[i], 0) != SQLITE_OK)
+      throw Error("Lookup prepare error");
+
+    sqlite3_stmt* stmt = 0;
+    sql = "SELECT 1 FROM NDN_REPO_OBJECT LIMIT 1;";
+    bool hasObjects = sqlite3_prepare_v2(m_dbs[i], sql.c_str(), -1, &stmt, 0) == SQLITE_OK &&
+                      sqlite3_step(stmt) == SQLITE_ROW;
+    sqlite3_finalize(stmt);
+    if (!hasObjects)
+      continue;
+    sql = "SELECT names, live FROM NDN_REPO_OBJECT WHERE nameKey = ?;";
+    if (sqlite3_prepare_v2(m_dbs[i], sql.c_str(), -1, &m_findObjectStmts[i], 0) != SQLITE_OK)
+      throw Error("Objects of '" + m_dbPaths[i] + "' have no nameKey, "
+                  "start repo-ng on it once before importing");
+  }
+}
+
+bool
+RepoArchiver::isStored(size_t shardIndex, const Name& fullName)
+{
+  const Block& nameWire = fullName.wireEncode();
+  sqlite3_stmt* stmt = m_findStmts[shardIndex];
+  if (bindKey(stmt, 1, nameWire.value(), nameWire.value_size()) != SQLITE_OK)
+    throw Error("Lookup bind error");
+  int rc = sqlite3_step(stmt);
+  sqlite3_reset(stmt);
+  if (rc == SQLITE_ROW)
+    return true;
+  if (rc != SQLITE_DONE)
+    throw Error("Lookup error");
+
+  stmt = m_findObjectStmts[shardIndex];
+  if (stmt == 0)
+    return false;
+  for (size_t length = 0; length <= fullName.size(); ++length) {
+    Name prefix = fullName.getPrefix(length);
+    const Block& prefixWire = prefix.wireEncode();
+    if (bindKey(stmt, 1, prefixWire.value(), prefixWire.value_size()) != SQLITE_OK)
+      throw Error("Object lookup bind error");
+    bool isFound = false;
+    while (!isFound && (rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+      const uint8_t* names = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 0));
+      size_t namesSize = sqlite3_column_bytes(stmt, 0);
+      const uint8_t* live = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 1));
+      size_t nSegments = sqlite3_column_bytes(stmt, 1);
+
+      size_t nameOffset = 0;
+      Block nameBlock;
+      for (size_t i = 0; !isFound && i < nSegments &&
+             Block::fromBuffer(names + nameOffset, namesSize - nameOffset, nameBlock); ++i) {
+        nameOffset += nameBlock.size();
+        isFound = live[i] != 0 && nameBlock.size() == nameWire.size() &&
+                  std::memcmp(nameBlock.wire(), nameWire.wire(), nameWire.size()) == 0;
+      }
+    }
+    sqlite3_reset(stmt);
+    if (isFound)
+      return true;
+    if (rc != SQLITE_DONE)
+      throw Error("Object lookup error");
+  }
+  return false;
+}
+
+bool
+RepoArchiver::prepareRange(const std::string& columns, const Name& prefix,
+                           sqlite3_stmt*& stmt, const std::string& table)
+{
+  const Block& prefixWire = prefix.wireEncode();
+  m_lower.assign(prefixWire.value_begin(), prefixWire.value_end());
+  m_upper = m_lower;
+  // the smallest key larger than every key starting with m_lower
+  while (!m_upper.empty() && m_upper.back() == 0xFF)
+    m_upper.pop_back();
+  if (!m_upper.empty())
+    ++m_upper.back();
+
+  string sql = "SELECT " + columns + " FROM " + table + " WHERE nameKey >= ?";
+  if (!m_upper.empty())
+    sql += " AND nameKey < ?";
+  sql += ";";
+  if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &stmt, 0) != SQLITE_OK) {
+    sqlite3_finalize(stmt);
+    stmt = 0;
+    return false;
+  }
+  if (bindKey(stmt, 1, m_lower.buf(), m_lower.size()) != SQLITE_OK ||
+      (!m_upper.empty() &&
+       bindKey(stmt, 2, m_upper.buf(), m_upper.size()) != SQLITE_OK)) {
+    sqlite3_finalize(stmt);
+    throw Error("Range bind error");
+  }
+  return true;
+}
+
+void
+RepoArchiver::loadObjectSegments(const Name& first, const Name& last, bool isLastInfinite,
+                                 const Name& prefix, size_t shardIndex,
+                                 std::vector<Entry>& entries)
+{
+  sqlite3_stmt* stmt = 0;
+  bool isRange = prepareRange("id, names, live", prefix, stmt, "NDN_REPO_OBJECT");
+  if (!isRange) {
+    string sql("SELECT id, names, live FROM NDN_REPO_OBJECT;");
+    if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &stmt, 0) != SQLITE_OK) {
+      // database written before objects were packed
+      sqlite3_finalize(stmt);
+      return;
+    }
+    std::cerr << "nameKey is not available, scanning all objects" << std::endl;
+  }
+  bool isOk = loadObjectRows(stmt, first, last, isLastInfinite, shardIndex, entries);
+  sqlite3_finalize(stmt);
+  if (!isOk)
+    throw Error("Read Objects error");
+  if (!isRange)
+    return;
+
+  // an object keyed by a shorter prefix of prefix may have segments in the range
+  string sql("SELECT id, names, live FROM NDN_REPO_OBJECT WHERE nameKey = ?;");
+  if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &stmt, 0) != SQLITE_OK) {
+    sqlite3_finalize(stmt);
+    throw Error("Read Objects prepare error");
+  }
+  for (size_t length = 0; length < prefix.size() && isOk; ++length) {
+    Name shorter = prefix.getPrefix(length);
+    const Block& shorterWire = shorter.wireEncode();
+    if (bindKey(stmt, 1, shorterWire.value(), shorterWire.value_size()) != SQLITE_OK) {
+      sqlite3_finalize(stmt);
+      throw Error("Read Objects bind error");
+    }
+    isOk = loadObjectRows(stmt, first, last, isLastInfinite, shardIndex, entries);
+    sqlite3_reset(stmt);
+  }
+  sqlite3_finalize(stmt);
+  if (!isOk)
+    throw Error("Read Objects error");
+}
+
+bool
+RepoArchiver::loadObjectRows(sqlite3_stmt* stmt, const Name& first, const Name& last,
+                             bool isLastInfinite, size_t shardIndex,
+                             std::vector<Entry>& entries)
+{
+  int rc = SQLITE_DONE;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    int64_t objectId = sqlite3_column_int64(stmt, 0);
+    const uint8_t* names = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 1));
+    size_t namesSize = sqlite3_column_bytes(stmt, 1);
+    const uint8_t* live = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 2));
+    size_t nSegments = sqlite3_column_bytes(stmt, 2);
+
+    size_t nameOffset = 0;
+    Block nameBlock;
+    for (size_t i = 0; i < nSegments &&
+           Block::fromBuffer(names + nameOffset, namesSize - nameOffset, nameBlock); ++i) {
+      nameOffset += nameBlock.size();
+      if (live[i] == 0)
+        continue;
+      Name name(nameBlock);
+      if (name >= first && (isLastInfinite || name < last))
+        entries.push_back(Entry(name,
+                                std::make_pair(shardIndex,
+                                               -((objectId << 32) | static_cast<int64_t>(i)))));
+    }
+  }
+  return rc == SQLITE_DONE;
+}
+
+void
+RepoArchiver::exportSegment(int64_t id, std::ostream& os)
+{
+  int64_t objectId = (-id) >> 32;
+  size_t index = static_cast<size_t>((-id) & 0xFFFFFFFF);
+
+  sqlite3_stmt* stmt = 0;
+  string sql("SELECT offsets FROM NDN_REPO_OBJECT WHERE id = ?;");
+  if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &stmt, 0) != SQLITE_OK ||
+      sqlite3_bind_int64(stmt, 1, objectId) != SQLITE_OK ||
+      sqlite3_step(stmt) != SQLITE_ROW ||
+      static_cast<size_t>(sqlite3_column_bytes(stmt, 0)) < (index + 2) * 8) {
+    sqlite3_finalize(stmt);
+    throw Error("Object query failure");
+  }
+  // offsets are 8-byte big-endian, one more than segments
+  const uint8_t* offsets = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 0));
+  uint64_t begin = 0;
+  uint64_t end = 0;
+  for (size_t j = 0; j < 8; ++j) {
+    begin = (begin << 8) | offsets[index * 8 + j];
+    end = (end << 8) | offsets[(index + 1) * 8 + j];
+  }
+  sqlite3_finalize(stmt);
+
+  std::vector<char> wire(end - begin);
+  sqlite3_blob* extent = 0;
+  if (sqlite3_blob_open(m_db, "main", "NDN_REPO_OBJECT", "extent", objectId, 0, &extent)
+        != SQLITE_OK ||
+      sqlite3_blob_read(extent, &wire[0], wire.size(), begin) != SQLITE_OK) {
+    sqlite3_blob_close(extent);
+    throw Error("Object extent read failure");
+  }
+  sqlite3_blob_close(extent);
+  os.write(&wire[0], wire.size());
+}
+
+static bool
+compareFullName(const shared_ptr<Data>& lhs, const shared_ptr<Data>& rhs)
+{
+  return lhs->getFullName() < rhs->getFullName();
+}
+
+static bool
+isSameFullName(const shared_ptr<Data>& lhs, const shared_ptr<Data>& rhs)
+{
+  return lhs->getFullName() == rhs->getFullName();
+}
+
+uint64_t
+RepoArchiver::import(std::istream& is, size_t batchSize)
+{
+  uint64_t nStored = 0;
+  for (size_t i = 0; i < m_dbs.size(); ++i) {
+    m_db = m_dbs[i];
+    nStored += countStored();
+  }
+  prepareLookups();
+
+  std::vector<char> buffer(READ_BLOCK_SIZE + MAX_PACKET_SIZE);
+  size_t bufferSize = 0;
+  std::vector<std::vector<shared_ptr<Data> > > batches(m_dbs.size());
+  uint64_t nInserted = 0;
+  uint64_t nPending = 0;
+  uint64_t nSkipped = 0;
+  bool isFull = false;
+
+  while (!isFull) {
+    is.read(&buffer[bufferSize], buffer.size() - bufferSize);
+    std::streamsize readSize = is.gcount();
+    if (readSize <= 0)
+      break;
+    bufferSize += readSize;
+
+    size_t offset = 0;
+    Block element;
+    while (offset < bufferSize &&
+           Block::fromBuffer(reinterpret_cast<const uint8_t*>(&buffer[offset]),
+                             bufferSize - offset, element)) {
+      offset += element.size();
+      if (element.type() != ndn::Tlv::Data) {
+        ++nSkipped;
+        continue;
+      }
+
+      shared_ptr<Data> data = make_shared<Data>(element);
+      size_t shardIndex = m_placement.findShard(data->getName());
+      if (isStored(shardIndex, data->getFullName())) {
+        ++nSkipped;
+        continue;
+      }
+      // Data repeated within a batch are counted until the batch is inserted
+      if (nStored + nInserted + nPending >= m_nMaxPackets) {
+        std::cerr << "Storage is full (max-packets " << m_nMaxPackets << ")" << std::endl;
+        isFull = true;
+        break;
+      }
+
+      std::vector<shared_ptr<Data> >& batch = batches[shardIndex];
+      batch.push_back(data);
+      ++nPending;
+      if (batch.size() >= batchSize) {
+        size_t nInBatch = batch.size();
+        size_t nBatchInserted = insertBatch(shardIndex, batch);
+        nInserted += nBatchInserted;
+        nSkipped += nInBatch - nBatchInserted;
+        nPending -= nInBatch;
+        batch.clear();
+      }
+    }
+
+    if (offset == 0 && bufferSize == buffer.size())
+      throw Error("Malformed Data TLV in input");
+    std::copy(buffer.begin() + offset, buffer.begin() + bufferSize, buffer.begin());
+    bufferSize -= offset;
+  }
+
+  if (!isFull && bufferSize > 0)
+    std::cerr << "Ignored " << bufferSize << " trailing bytes of input" << std::endl;
+
+  for (size_t i = 0; i < batches.size(); ++i) {
+    size_t nInBatch = batches[i].size();
+    size_t nBatchInserted = insertBatch(i, batches[i]);
+    nInserted += nBatchInserted;
+    nSkipped += nInBatch - nBatchInserted;
+  }
+
+  if (nSkipped > 0)
+    std::cerr << "Skipped " << nSkipped << " duplicate or non-Data elements" << std::endl;
+  return nInserted;
+}
+
+size_t
+RepoArchiver::insertBatch(size_t shardIndex, std::vector<shared_ptr<Data> >& batch)
+{
+  if (batch.empty())
+    return 0;
+  m_db = m_dbs[shardIndex];
+
+  std::sort(batch.begin(), batch.end(), &compareFullName);
+  batch.erase(std::unique(batch.begin(), batch.end(), &isSameFullName), batch.end());
+
+  sqlite3_stmt* insertStmt = 0;
+  string insertSql = string("INSERT INTO NDN_REPO "
+                            "(id, name, data, keylocatorHash, nameKey, expiry) "
+                            "VALUES (?, ?, ?, ?, ?, ?)");
+  if (sqlite3_prepare_v2(m_db, insertSql.c_str(), -1, &insertStmt, 0) != SQLITE_OK) {
+    sqlite3_finalize(insertStmt);
+    throw Error("insert sql not prepared");
+  }
+
+  execute("BEGIN TRANSACTION;");
+  for (std::vector<shared_ptr<Data> >::const_iterator it = batch.begin();
+       it != batch.end(); ++it) {
+    const Data& data = **it;
+    const Block& nameWire = data.getFullName().wireEncode();
+    const Block& dataWire = data.wireEncode();
+    ndn::ConstBufferPtr keyLocatorHash;
+    if (data.getSignature().hasKeyLocator()) {
+      const Block& keyLocatorWire = data.getSignature().getKeyLocator().wireEncode();
+      keyLocatorHash = ndn::crypto::sha256(keyLocatorWire.wire(), keyLocatorWire.size());
+    }
+    int64_t expiry = computeExpiry(data.getName());
+
+    if (sqlite3_bind_null(insertStmt, 1) != SQLITE_OK ||
+        sqlite3_bind_blob(insertStmt, 2, nameWire.wire(), nameWire.size(), 0) != SQLITE_OK ||
+        sqlite3_bind_blob(insertStmt, 3, dataWire.wire(), dataWire.size(), 0) != SQLITE_OK ||
+        sqlite3_bind_blob(insertStmt, 4,
+                          keyLocatorHash ? keyLocatorHash->buf() : 0,
+                          keyLocatorHash ? keyLocatorHash->size() : 0, 0) != SQLITE_OK ||
+        sqlite3_bind_blob(insertStmt, 5, nameWire.value(), nameWire.value_size(), 0)
+          != SQLITE_OK ||
+        (expiry == 0 ? sqlite3_bind_null(insertStmt, 6) :
+                       sqlite3_bind_int64(insertStmt, 6, expiry)) != SQLITE_OK ||
+        sqlite3_step(insertStmt) != SQLITE_DONE) {
+      sqlite3_finalize(insertStmt);
+      execute("ROLLBACK;");
+      throw Error("Insert failed: " + std::string(sqlite3_errmsg(m_db)));
+    }
+    sqlite3_reset(insertStmt);
+  }
+  execute("COMMIT;");
+  sqlite3_finalize(insertStmt);
+  return batch.size();
+}
+
+void
+RepoArchiver::loadRange(const Name& first, const Name& last, bool isLastInfinite,
+                        const Name& prefix, size_t shardIndex, std::vector<Entry>& entries)
+{
+  m_db = m_dbs[shardIndex];
+  sqlite3_stmt* stmt = 0;
+  if (!prepareRange("id, name", prefix, stmt))
+    throw Error("Read Entries prepare error");
+  int rc = SQLITE_DONE;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    Name name;
+    name.wireDecode(Block(sqlite3_column_blob(stmt, 1), sqlite3_column_bytes(stmt, 1)));
+    if (name >= first && (isLastInfinite || name < last))
+      entries.push_back(Entry(name, std::make_pair(shardIndex, sqlite3_column_int64(stmt, 0))));
+  }
+  sqlite3_finalize(stmt);
+  if (rc != SQLITE_DONE)
+    throw Error("Read Entries error");
+
+  loadObjectSegments(first, last, isLastInfinite, prefix, shardIndex, entries);
+}
+
+static void
+finalizeStatements(std::vector<sqlite3_stmt*>& stmts)
+{
+  for (size_t i = 0; i < stmts.size(); ++i)
+    sqlite3_finalize(stmts[i]);
+}
+
+uint64_t
+RepoArchiver::exportRange(const Name& first, const Name& last, bool isLastInfinite,
+                          std::ostream& os)
+{
+  // names are stored as TLV, whose byte order is not the canonical order of names,
+  // so rows under the prefix shared by the range are selected through nameKey, then
+  // filtered on decoded names and sorted across shards
+  Name prefix = getRangePrefix(first, last, isLastInfinite);
+  std::vector<Entry> entries;
+  for (size_t i = 0; i < m_dbs.size(); ++i)
+    loadRange(first, last, isLastInfinite, prefix, i, entries);
+  std::sort(entries.begin(), entries.end());
+
+  // a compressed record is decompressed first; a shared payload is kept once in
+  // NDN_REPO_CONTENT and goes back at contentOffset
+  std::vector<sqlite3_stmt*> queryStmts(m_dbs.size(), static_cast<sqlite3_stmt*>(0));
+  string sql("SELECT NDN_REPO.data, NDN_REPO.contentOffset, NDN_REPO_CONTENT.content, "
+             "NDN_REPO.rawSize FROM NDN_REPO LEFT JOIN NDN_REPO_CONTENT "
+             "ON NDN_REPO.contentHash = NDN_REPO_CONTENT.hash WHERE NDN_REPO.id = ?;");
+  for (size_t i = 0; i < m_dbs.size(); ++i) {
+    if (sqlite3_prepare_v2(m_dbs[i], sql.c_str(), -1, &queryStmts[i], 0) != SQLITE_OK) {
+      finalizeStatements(queryStmts);
+      throw Error("select statement prepared failed");
+    }
+  }
+  ndn::Buffer decompressed;
+  for (std::vector<Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+    size_t shardIndex = it->second.first;
+    int64_t id = it->second.second;
+    if (id < 0) {
+      m_db = m_dbs[shardIndex];
+      try {
+        exportSegment(id, os);
+      }
+      catch (Error&) {
+        finalizeStatements(queryStmts);
+        throw;
+      }
+      continue;
+    }
+    sqlite3_stmt* queryStmt = queryStmts[shardIndex];
+    if (sqlite3_bind_int64(queryStmt, 1, id) != SQLITE_OK ||
+        sqlite3_step(queryStmt) != SQLITE_ROW) {
+      finalizeStatements(queryStmts);
+      throw Error("Database query failure");
+    }
+    const char* stored = static_cast<const char*>(sqlite3_column_blob(queryStmt, 0));
+    int storedSize = sqlite3_column_bytes(queryStmt, 0);
+    if (sqlite3_column_type(queryStmt, 3) != SQLITE_NULL) {
+      try {
+        m_compression.decompress(reinterpret_cast<const uint8_t*>(stored), storedSize,
+                                 sqlite3_column_int64(queryStmt, 3), decompressed);
+      }
+      catch (Compression::Error& e) {
+        finalizeStatements(queryStmts);
+        throw Error("Cannot export " + it->first.toUri() + ": " + e.what());
+      }
+      stored = reinterpret_cast<const char*>(decompressed.buf());
+      storedSize = decompressed.size();
+    }
+    if (sqlite3_column_type(queryStmt, 2) != SQLITE_NULL) {
+      int offset = std::min<int>(sqlite3_column_int(queryStmt, 1), storedSize);
+      os.write(stored, offset);
+      os.write(static_cast<const char*>(sqlite3_column_blob(queryStmt, 2)),
+               sqlite3_column_bytes(queryStmt, 2));
+      os.write(stored + offset, storedSize - offset);
+    }
+    else {
+      // stored wire encoding is written as is
+      os.write(stored, storedSize);
+    }
+    sqlite3_reset(queryStmt);
+  }
+  finalizeStatements(queryStmts);
+  os.flush();
+  if (!os)
+    throw Error("Error writing exported Data");
+  return entries.size();
+}
+
+int
+main(int argc, char** argv)
+{
+  string configPath = DEFAULT_CONFIG_FILE;
+  const char* importFile = 0;
+  const char* outputFile = 0;
+  const char* firstName = 0;
+  const char* lastName = 0;
+  size_t batchSize = DEFAULT_BATCH_SIZE;
+  int opt;
+  while ((opt = getopt(argc, argv, "hc:i:b:e:E:o:")) != -1) {
+    switch (opt) {
+    case 'h':
+      printUsage(argv[0]);
+      return 0;
+    case 'c':
+      configPath = string(optarg);
+      break;
+    case 'i':
+      importFile = optarg;
+      break;
+    case 'b':
+      batchSize = std::max(atoi(optarg), 1);
+      break;
+    case 'e':
+      firstName = optarg;
+      break;
+    case 'E':
+      lastName = optarg;
+      break;
+    case 'o':
+      outputFile = optarg;
+      break;
+    default:
+      break;
+    }
+  }
+
+  if ((importFile == 0) == (firstName == 0)) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  RepoArchiver instance(configPath);
+
+  if (importFile != 0) {
+    uint64_t count = 0;
+    if (strcmp(importFile, "-") == 0) {
+      count = instance.import(std::cin, batchSize);
+    }
+    else {
+      std::ifstream is(importFile, std::ios::in | std::ios::binary);
+      if (!is.is_open())
+        throw RepoArchiver::Error("cannot open " + string(importFile));
+      count = instance.import(is, batchSize);
+    }
+    std::cerr << "Total number of imported data = " << count << std::endl;
+    return 0;
+  }
+
+  Name first(firstName);
+  Name last = lastName != 0 ? Name(lastName) : first.getSuccessor();
+  // the successor of the empty name does not bound anything
+  bool isLastInfinite = lastName == 0 && first.empty();
+
+  std::ofstream of;
+  std::vector<char> outputBuffer(READ_BLOCK_SIZE);
+  std::ostream* os = &std::cout;
+  if (outputFile != 0) {
+    of.rdbuf()->pubsetbuf(&outputBuffer[0], outputBuffer.size());
+    of.open(outputFile, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!of.is_open())
+      throw RepoArchiver::Error("cannot open " + string(outputFile));
+    os = &of;
+  }
+  else {
+    std::ios::sync_with_stdio(false);
+  }
+
+  uint64_t count = instance.exportRange(first, last, isLastInfinite, *os);
+  std::cerr << "Total number of exported data = " << count << std::endl;
+  return 0;
+}
+
+} // namespace repo
+
+
+int
+main(int argc, char** argv)
+{
+  try {
+    return repo::main(argc, argv);
+  }
+  catch (std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 2;
+  }
+}
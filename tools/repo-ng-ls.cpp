@@ -20,6 +20,7 @@
 #include "../src/common.hpp"
 #include "config.hpp"
 #include <string>
+#include <algorithm>
 #include <sqlite3.h>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/info_parser.hpp>
@@ -28,13 +29,28 @@ namespace repo {
 
 using namespace ndn::time;
 
+static const size_t OUTPUT_BUFFER_SIZE = 1048576;
+
+/**
+ * @brief bind a nameKey, which may be empty
+ *
+ * An empty buffer may have a null pointer, which sqlite would bind as NULL, matching nothing.
+ */
+static int
+bindKey(sqlite3_stmt* stmt, int index, const uint8_t* key, size_t size)
+{
+  if (size == 0)
+    return sqlite3_bind_zeroblob(stmt, index, 0);
+  return sqlite3_bind_blob(stmt, index, key, size, SQLITE_TRANSIENT);
+}
+
 void
 printUsage(const char* programName)
 {
 
   std::cout
     << "Usage:\n"
-    << "  " << programName << " [-c <path/to/repo-ng.conf>] [-n] [-h]\n"
+    << "  " << programName << " [-c <path/to/repo-ng.conf>] [-n] [-p <prefix>] [-C|-s] [-h]\n"
     << "\n"
     << "List names of Data packets in NDN repository. "
     << "By default, all names will include the implicit digest of Data packets\n"
@@ -43,6 +59,9 @@ printUsage(const char* programName)
     << "  -h: show help message\n"
     << "  -c: set config file path\n"
     << "  -n: do not show implicit digest\n"
+    << "  -p: only list Data under this prefix\n"
+    << "  -C: only count Data\n"
+    << "  -s: only count Data and sum up their encoded size\n"
     << std::endl;
   ;
 }
@@ -63,35 +82,102 @@ public:
 public:
   RepoEnumerator(const std::string& configFile);
 
+  ~RepoEnumerator();
+
+  /**
+   * @brief print names of Data under prefix
+   * @return number of Data
+   */
   uint64_t
-  enumerate(bool showImplicitDigest);
+  enumerate(const Name& prefix, bool showImplicitDigest, std::ostream& os);
+
+  /**
+   * @brief count Data under prefix without reading them
+   * @return number of Data and total size of their encoding
+   */
+  std::pair<uint64_t, uint64_t>
+  summarize(const Name& prefix);
 
 private:
   void
   readConfig(const std::string& configFile);
 
+  uint64_t
+  enumerateDatabase(const Name& prefix, bool showImplicitDigest, std::ostream& os);
+
+  std::pair<uint64_t, uint64_t>
+  summarizeDatabase(const Name& prefix);
+
+  /**
+   * @brief prepare a statement selecting columns of rows of table under prefix
+   *
+   * Rows are selected through the nameKey index, whose range for a prefix is
+   * [value of prefix, successor of value). Returns false if the table has no nameKey
+   * column yet, i.e. it has not been opened by a repo that maintains it.
+   */
+  bool
+  prepareRange(const std::string& columns, const Name& prefix, sqlite3_stmt*& stmt,
+               const std::string& table = "NDN_REPO");
+
+  /**
+   * @brief count, and print if os is given, live segments of packed objects under prefix
+   *
+   * An object is found through the nameKey index by the prefix its segments share: that
+   * prefix is either under prefix, or one of the shorter prefixes of prefix.
+   * @return number of segments and total size of their encoding
+   */
+  std::pair<uint64_t, uint64_t>
+  scanObjects(const Name& prefix, bool showImplicitDigest, std::ostream* os);
+
+  /**
+   * @brief add live segments under prefix of the objects selected by stmt to summary
+   *
+   * stmt is finalized if an error is thrown, and otherwise if shouldFinalize
+   */
+  void
+  scanObjectRows(sqlite3_stmt* stmt, const Name& prefix, bool showImplicitDigest,
+                 std::ostream* os, std::pair<uint64_t, uint64_t>& summary,
+                 bool shouldFinalize = true);
+
 private:
+  /// database being read, one of m_dbs
   sqlite3* m_db;
-  std::string m_dbPath;
+  /// main database and shards
+  std::vector<sqlite3*> m_dbs;
+  std::vector<std::string> m_dbPaths;
+  ndn::Buffer m_lower;
+  ndn::Buffer m_upper;
 };
 
 RepoEnumerator::RepoEnumerator(const std::string& configFile)
 {
   readConfig(configFile);
-  char* errMsg = 0;
-  int rc = sqlite3_open_v2(m_dbPath.c_str(), &m_db,
-                           SQLITE_OPEN_READONLY,
-   #ifdef DISABLE_SQLITE3_FS_LOCKING
-                            "unix-dotfile"
-   #else
-                            0
-   #endif
-                          );
-  if (rc != SQLITE_OK) {
-    throw Error("Database file open failure");
-  }
-  sqlite3_exec(m_db, "PRAGMA synchronous = OFF", 0, 0, &errMsg);
-  sqlite3_exec(m_db, "PRAGMA journal_mode = WAL", 0, 0, &errMsg);
+  for (size_t i = 0; i < m_dbPaths.size(); ++i) {
+    char* errMsg = 0;
+    int rc = sqlite3_open_v2(m_dbPaths[i].c_str(), &m_db,
+                             SQLITE_OPEN_READONLY,
+     #ifdef DISABLE_SQLITE3_FS_LOCKING
+                              "unix-dotfile"
+     #else
+                              0
+     #endif
+                            );
+    if (rc != SQLITE_OK) {
+      sqlite3_close(m_db);
+      for (size_t j = 0; j < m_dbs.size(); ++j)
+        sqlite3_close(m_dbs[j]);
+      throw Error("Database file '" + m_dbPaths[i] + "' open failure");
+    }
+    sqlite3_exec(m_db, "PRAGMA synchronous = OFF", 0, 0, &errMsg);
+    sqlite3_exec(m_db, "PRAGMA journal_mode = WAL", 0, 0, &errMsg);
+    m_dbs.push_back(m_db);
+  }
+}
+
+RepoEnumerator::~RepoEnumerator()
+{
+  for (size_t i = 0; i < m_dbs.size(); ++i)
+    sqlite3_close(m_dbs[i]);
 }
 
 void
@@ -114,19 +200,185 @@ RepoEnumerator::readConfig(const std::string& configFile)
     throw Error("failed to read configuration file '" + configFile + "'");
   }
   ptree repoConf = propertyTree.get_child("repo");
-  m_dbPath = repoConf.get<std::string>("storage.path");
-  m_dbPath += "/ndn_repo.db";
+  m_dbPaths.push_back(repoConf.get<std::string>("storage.path"));
+
+  // shards are listed as in the repo, possibly more than once
+  boost::optional<ptree&> shardsConf = repoConf.get_child_optional("storage.shards");
+  if (shardsConf) {
+    for (ptree::const_iterator it = shardsConf->begin(); it != shardsConf->end(); ++it) {
+      std::string path = it->first == "prefix" ? it->second.get<std::string>("path") :
+                                                  it->second.get_value<std::string>();
+      if (std::find(m_dbPaths.begin(), m_dbPaths.end(), path) == m_dbPaths.end())
+        m_dbPaths.push_back(path);
+    }
+  }
+  for (size_t i = 0; i < m_dbPaths.size(); ++i)
+    m_dbPaths[i] += "/ndn_repo.db";
+}
+
+bool
+RepoEnumerator::prepareRange(const std::string& columns, const Name& prefix,
+                             sqlite3_stmt*& stmt, const std::string& table)
+{
+  const Block& prefixWire = prefix.wireEncode();
+  m_lower.assign(prefixWire.value_begin(), prefixWire.value_end());
+  m_upper = m_lower;
+  // the smallest key larger than every key starting with m_lower
+  while (!m_upper.empty() && m_upper.back() == 0xFF)
+    m_upper.pop_back();
+  if (!m_upper.empty())
+    ++m_upper.back();
+
+  string sql = "SELECT " + columns + " FROM " + table + " WHERE nameKey >= ?";
+  if (!m_upper.empty())
+    sql += " AND nameKey < ?";
+  sql += ";";
+  if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &stmt, 0) != SQLITE_OK) {
+    sqlite3_finalize(stmt);
+    stmt = 0;
+    return false;
+  }
+  if (bindKey(stmt, 1, m_lower.buf(), m_lower.size()) != SQLITE_OK ||
+      (!m_upper.empty() &&
+       bindKey(stmt, 2, m_upper.buf(), m_upper.size()) != SQLITE_OK)) {
+    sqlite3_finalize(stmt);
+    throw Error("Range bind error");
+  }
+  return true;
+}
+
+std::pair<uint64_t, uint64_t>
+RepoEnumerator::scanObjects(const Name& prefix, bool showImplicitDigest, std::ostream* os)
+{
+  std::pair<uint64_t, uint64_t> summary(0, 0);
+  sqlite3_stmt* stmt = 0;
+  // an object is keyed by the prefix its segments share, so it is either in the range of
+  // prefix, or keyed by a shorter prefix of prefix
+  if (!prepareRange("names, offsets, live", prefix, stmt, "NDN_REPO_OBJECT")) {
+    string sql("SELECT names, offsets, live FROM NDN_REPO_OBJECT;");
+    if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &stmt, 0) != SQLITE_OK) {
+      // database written before objects were packed
+      sqlite3_finalize(stmt);
+      return summary;
+    }
+    std::cerr << "nameKey is not available, scanning all objects" << std::endl;
+    scanObjectRows(stmt, prefix, showImplicitDigest, os, summary);
+    return summary;
+  }
+  scanObjectRows(stmt, prefix, showImplicitDigest, os, summary);
+
+  string sql("SELECT names, offsets, live FROM NDN_REPO_OBJECT WHERE nameKey = ?;");
+  if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &stmt, 0) != SQLITE_OK) {
+    sqlite3_finalize(stmt);
+    throw Error("Read Objects prepare error");
+  }
+  for (size_t length = 0; length < prefix.size(); ++length) {
+    const Block& shorterWire = prefix.getPrefix(length).wireEncode();
+    if (bindKey(stmt, 1, shorterWire.value(), shorterWire.value_size()) != SQLITE_OK) {
+      sqlite3_finalize(stmt);
+      throw Error("Read Objects bind error");
+    }
+    scanObjectRows(stmt, prefix, showImplicitDigest, os, summary, false);
+    sqlite3_reset(stmt);
+  }
+  sqlite3_finalize(stmt);
+  return summary;
+}
+
+void
+RepoEnumerator::scanObjectRows(sqlite3_stmt* stmt, const Name& prefix, bool showImplicitDigest,
+                               std::ostream* os, std::pair<uint64_t, uint64_t>& summary,
+                               bool shouldFinalize)
+{
+  int rc = SQLITE_DONE;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    const uint8_t* names = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 0));
+    size_t namesSize = sqlite3_column_bytes(stmt, 0);
+    const uint8_t* offsets = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 1));
+    const uint8_t* live = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 2));
+    size_t nOffsets = sqlite3_column_bytes(stmt, 1) / 8;
+    size_t nSegments = std::min<size_t>(sqlite3_column_bytes(stmt, 2),
+                                        nOffsets > 0 ? nOffsets - 1 : 0);
+
+    size_t nameOffset = 0;
+    Block nameBlock;
+    for (size_t i = 0; i < nSegments &&
+           Block::fromBuffer(names + nameOffset, namesSize - nameOffset, nameBlock); ++i) {
+      nameOffset += nameBlock.size();
+      Name name(nameBlock);
+      if (live[i] == 0 || !prefix.isPrefixOf(name))
+        continue;
+
+      // offsets are 8-byte big-endian, one more than segments
+      uint64_t begin = 0;
+      uint64_t end = 0;
+      for (size_t j = 0; j < 8; ++j) {
+        begin = (begin << 8) | offsets[i * 8 + j];
+        end = (end << 8) | offsets[(i + 1) * 8 + j];
+      }
+      ++summary.first;
+      summary.second += end - begin;
+      if (os == 0)
+        continue;
+      try {
+        if (showImplicitDigest)
+          *os << name << '\n';
+        else
+          *os << name.getPrefix(-1) << '\n';
+      }
+      catch (...) {
+        sqlite3_finalize(stmt);
+        throw;
+      }
+    }
+  }
+  if (rc != SQLITE_DONE) {
+    sqlite3_finalize(stmt);
+    throw Error("Read Objects error");
+  }
+  if (shouldFinalize)
+    sqlite3_finalize(stmt);
+}
+
+uint64_t
+RepoEnumerator::enumerate(const Name& prefix, bool showImplicitDigest, std::ostream& os)
+{
+  uint64_t entryNumber = 0;
+  for (size_t i = 0; i < m_dbs.size(); ++i) {
+    m_db = m_dbs[i];
+    entryNumber += enumerateDatabase(prefix, showImplicitDigest, os);
+  }
+  return entryNumber;
+}
+
+std::pair<uint64_t, uint64_t>
+RepoEnumerator::summarize(const Name& prefix)
+{
+  std::pair<uint64_t, uint64_t> summary(0, 0);
+  for (size_t i = 0; i < m_dbs.size(); ++i) {
+    m_db = m_dbs[i];
+    std::pair<uint64_t, uint64_t> databaseSummary = summarizeDatabase(prefix);
+    summary.first += databaseSummary.first;
+    summary.second += databaseSummary.second;
+  }
+  return summary;
 }
 
 uint64_t
-RepoEnumerator::enumerate(bool showImplicitDigest)
+RepoEnumerator::enumerateDatabase(const Name& prefix, bool showImplicitDigest,
+                                  std::ostream& os)
 {
   sqlite3_stmt* m_stmt = 0;
   int rc = SQLITE_DONE;
-  string sql = string("SELECT id, name, keylocatorHash FROM NDN_REPO;");
-  rc = sqlite3_prepare_v2(m_db, sql.c_str(), -1, &m_stmt, 0);
-  if (rc != SQLITE_OK)
-    throw Error("Initiation Read Entries from Database Prepare error");
+  // without nameKey, fall back to scanning all records
+  bool isRange = prepareRange("id, name", prefix, m_stmt);
+  if (!isRange) {
+    std::cerr << "nameKey is not available, scanning all Data" << std::endl;
+    string sql = string("SELECT id, name FROM NDN_REPO;");
+    rc = sqlite3_prepare_v2(m_db, sql.c_str(), -1, &m_stmt, 0);
+    if (rc != SQLITE_OK)
+      throw Error("Initiation Read Entries from Database Prepare error");
+  }
   uint64_t entryNumber = 0;
   while (true) {
     rc = sqlite3_step(m_stmt);
@@ -134,12 +386,14 @@ RepoEnumerator::enumerate(bool showImplicitDigest)
       Name name;
       name.wireDecode(Block(sqlite3_column_blob(m_stmt, 1),
                             sqlite3_column_bytes(m_stmt, 1)));
+      if (!isRange && !prefix.isPrefixOf(name))
+        continue;
       try {
         if (showImplicitDigest) {
-          std::cout << name << std::endl;
+          os << name << '\n';
         }
         else {
-          std::cout << name.getPrefix(-1) << std::endl;
+          os << name.getPrefix(-1) << '\n';
         }
       }
       catch (...){
@@ -157,16 +411,67 @@ RepoEnumerator::enumerate(bool showImplicitDigest)
       throw Error("Initiation Read Entries error");
     }
   }
+  entryNumber += scanObjects(prefix, showImplicitDigest, &os).first;
+  os.flush();
   return entryNumber;
 }
 
+std::pair<uint64_t, uint64_t>
+RepoEnumerator::summarizeDatabase(const Name& prefix)
+{
+  sqlite3_stmt* m_stmt = 0;
+  std::pair<uint64_t, uint64_t> summary(0, 0);
+  // sizes are before compression; shared payloads are stored once in NDN_REPO_CONTENT,
+  // but count toward every Data
+  if (prepareRange("count(*), total(ifnull(rawSize, length(data)) + "
+                   "ifnull((SELECT length(content) FROM NDN_REPO_CONTENT "
+                   "WHERE hash = NDN_REPO.contentHash), 0))",
+                   prefix, m_stmt) ||
+      prepareRange("count(*), total(length(data))", prefix, m_stmt)) {
+    if (sqlite3_step(m_stmt) != SQLITE_ROW) {
+      sqlite3_finalize(m_stmt);
+      throw Error("Database query failure");
+    }
+    summary.first = sqlite3_column_int64(m_stmt, 0);
+    summary.second = sqlite3_column_int64(m_stmt, 1);
+    sqlite3_finalize(m_stmt);
+  }
+  else {
+    std::cerr << "nameKey is not available, scanning all Data" << std::endl;
+    string sql = string("SELECT name, length(data) FROM NDN_REPO;");
+    if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &m_stmt, 0) != SQLITE_OK)
+      throw Error("Initiation Read Entries from Database Prepare error");
+    int rc = SQLITE_DONE;
+    while ((rc = sqlite3_step(m_stmt)) == SQLITE_ROW) {
+      Name name;
+      name.wireDecode(Block(sqlite3_column_blob(m_stmt, 0),
+                            sqlite3_column_bytes(m_stmt, 0)));
+      if (prefix.isPrefixOf(name)) {
+        ++summary.first;
+        summary.second += sqlite3_column_int64(m_stmt, 1);
+      }
+    }
+    sqlite3_finalize(m_stmt);
+    if (rc != SQLITE_DONE)
+      throw Error("Initiation Read Entries error");
+  }
+
+  std::pair<uint64_t, uint64_t> objects = scanObjects(prefix, false, 0);
+  summary.first += objects.first;
+  summary.second += objects.second;
+  return summary;
+}
+
 int
 main(int argc, char** argv)
 {
   string configPath = DEFAULT_CONFIG_FILE;
   bool showImplicitDigest = true;
+  bool isCountOnly = false;
+  bool isSizeSummary = false;
+  Name prefix;
   int opt;
-  while ((opt = getopt(argc, argv, "hc:n")) != -1) {
+  while ((opt = getopt(argc, argv, "hc:np:Cs")) != -1) {
     switch (opt) {
     case 'h':
       printUsage(argv[0]);
@@ -177,13 +482,35 @@ main(int argc, char** argv)
     case 'n':
       showImplicitDigest = false;
       break;
+    case 'p':
+      prefix = Name(optarg);
+      break;
+    case 'C':
+      isCountOnly = true;
+      break;
+    case 's':
+      isSizeSummary = true;
+      break;
     default:
       break;
     }
   }
 
   RepoEnumerator instance(configPath);
-  uint64_t count = instance.enumerate(showImplicitDigest);
+
+  if (isCountOnly || isSizeSummary) {
+    std::pair<uint64_t, uint64_t> summary = instance.summarize(prefix);
+    std::cout << "Total number of data = " << summary.first << std::endl;
+    if (isSizeSummary)
+      std::cout << "Total size of data = " << summary.second << " bytes" << std::endl;
+    return 0;
+  }
+
+  // names are written through a large buffer instead of flushing each line
+  static char outputBuffer[OUTPUT_BUFFER_SIZE];
+  std::ios::sync_with_stdio(false);
+  std::cout.rdbuf()->pubsetbuf(outputBuffer, OUTPUT_BUFFER_SIZE);
+  uint64_t count = instance.enumerate(prefix, showImplicitDigest, std::cout);
   std::cerr << "Total number of data = " << count << std::endl;
   return 0;
 }
@@ -19,6 +19,10 @@
 
 #include "../src/common.hpp"
 #include "config.hpp"
+#include "../src/repo-command-parameter.hpp"
+#include "../src/repo-command-response.hpp"
+#include <ndn-cxx/util/command-interest-generator.hpp>
+#include <boost/lexical_cast.hpp>
 #include <string>
 #include <sqlite3.h>
 #include <boost/property_tree/ptree.hpp>
@@ -35,12 +39,15 @@ printUsage(const char* programName)
   std::cout
     << "Usage:\n"
     << "  " << programName << " [-c <path/to/repo-ng.conf>] [-h]\n"
+    << "  " << programName << " -u <repo-prefix> [-n <prefix>]\n"
     << "\n"
     << "List all the creators and their sequence numbers in Repo Sync Tree Database. "
     << "\n"
     << "Options:\n"
     << "  -h: show help message\n"
     << "  -c: set config file path\n"
+    << "  -u: ask the running repo with this command prefix for the usage of a prefix\n"
+    << "  -n: prefix whose number and size of Data are shown (default ndn:/)\n"
     << std::endl;
   ;
 }
@@ -162,13 +169,82 @@ RepoEnumerator::enumerate()
   return entryNumber;
 }
 
+/**
+ * @brief query usage of a prefix with the status command of a running repo
+ */
+class RepoUsageQuery : noncopyable
+{
+public:
+  class Error : public std::runtime_error
+  {
+  public:
+    explicit
+    Error(const std::string& what)
+      : std::runtime_error(what)
+    {
+    }
+  };
+
+public:
+  void
+  run(const Name& repoPrefix, const Name& prefix);
+
+private:
+  void
+  onData(const Interest& interest, Data& data);
+
+  void
+  onTimeout(const Interest& interest);
+
+private:
+  Face m_face;
+  ndn::CommandInterestGenerator m_generator;
+  Name m_prefix;
+};
+
+void
+RepoUsageQuery::run(const Name& repoPrefix, const Name& prefix)
+{
+  m_prefix = prefix;
+  RepoCommandParameter parameter;
+  parameter.setName(prefix);
+  Interest interest(Name(repoPrefix).append("status").append(parameter.wireEncode()));
+  interest.setInterestLifetime(milliseconds(4000));
+  m_generator.generate(interest);
+
+  m_face.expressInterest(interest,
+                         bind(&RepoUsageQuery::onData, this, _1, _2),
+                         bind(&RepoUsageQuery::onTimeout, this, _1));
+  m_face.processEvents();
+}
+
+void
+RepoUsageQuery::onData(const Interest& interest, Data& data)
+{
+  RepoCommandResponse response(data.getContent().blockFromValue());
+  if (response.getStatusCode() != 200 || !response.hasDataNum())
+    throw Error("status command failed with status code " +
+                boost::lexical_cast<std::string>(response.getStatusCode()));
+  std::cout << "prefix = " << m_prefix
+            << " data = " << response.getDataNum()
+            << " size = " << response.getDataSize() << " bytes" << std::endl;
+}
+
+void
+RepoUsageQuery::onTimeout(const Interest& interest)
+{
+  throw Error("status command timeout");
+}
+
 int
 main(int argc, char** argv)
 {
   string configPath = "unittestdb_synctree";
   bool isPath = false;
+  const char* repoPrefix = 0;
+  Name prefix;
   int opt;
-  while ((opt = getopt(argc, argv, "hc:p")) != -1) {
+  while ((opt = getopt(argc, argv, "hc:pu:n:")) != -1) {
     switch (opt) {
     case 'h':
       printUsage(argv[0]);
@@ -179,11 +255,23 @@ main(int argc, char** argv)
     case 'p':
       isPath = true;
       break;
+    case 'u':
+      repoPrefix = optarg;
+      break;
+    case 'n':
+      prefix = Name(optarg);
+      break;
     default:
       break;
     }
   }
 
+  if (repoPrefix != 0) {
+    RepoUsageQuery query;
+    query.run(Name(repoPrefix), prefix);
+    return 0;
+  }
+
   RepoEnumerator instance(configPath, isPath);
   uint64_t count = instance.enumerate();
   std::cerr << "Total number of data = " << count << std::endl;